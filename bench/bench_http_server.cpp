@@ -0,0 +1,229 @@
+// Serves representative controller routes through EpollHttpServer for load generators, e.g.
+//
+//   http_server_bench serve 8080
+//   wrk -t2 -c64 -d10s http://127.0.0.1:8080/api/status
+//
+// "self" mode runs a built-in keep-alive client instead (for hosts without wrk):
+//
+//   http_server_bench self [path] [connections] [pipeline depth] [seconds]
+//
+// "parse" mode times HttpRequestParser plus MockWebServer::handle() without sockets, for a
+// route read in place (onView) and the same route through the HttpRequest compatibility form,
+// and for the status and log routes with and without the response cache (".../cached").
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EpollHttpServer.h"
+#include "HttpRequestParser.h"
+#include "Logger.h"
+#include "MockSystemMetrics.h"
+#include "MockWebServer.h"
+
+namespace {
+
+std::atomic<bool> g_interrupted{false};
+
+void onSignal(int) {
+    g_interrupted = true;
+}
+
+void registerRoutes(MockWebServer& server, MockSystemMetrics& metrics, Logger& logger) {
+    server.onGet("/api/status", [&metrics](const MockWebServer::HttpRequest&) {
+        return MockWebServer::createJsonResponse(metrics.toJson());
+    });
+    server.onGet("/api/logs", [&logger](const MockWebServer::HttpRequest&) {
+        return MockWebServer::createJsonResponse(logger.exportToJson(Logger::Level::INFO));
+    });
+    // Same responses, reused until the producer's version changes.
+    server.onGet("/api/status/cached", [&metrics](const MockWebServer::HttpRequest&) {
+        return MockWebServer::createJsonResponse(metrics.toJson());
+    });
+    server.cacheRoute("/api/status/cached", [&metrics]() { return metrics.getVersion(); });
+    server.onGet("/api/logs/cached", [&logger](const MockWebServer::HttpRequest&) {
+        return MockWebServer::createJsonResponse(logger.exportToJson(Logger::Level::INFO));
+    });
+    server.cacheRoute("/api/logs/cached", [&logger]() { return logger.getVersion(); });
+    server.onGet("/api/sensors/{index:uint}", [](const MockWebServer::HttpRequest& request) {
+        return MockWebServer::createJsonResponse("{\"index\":" + request.getPathParam("index") + ",\"temp\":21.5}");
+    });
+    server.onView("GET", "/ping", [](const MockWebServer::RequestView&) {
+        return MockWebServer::createTextResponse("pong");
+    });
+    server.onGet("/ping-compat", [](const MockWebServer::HttpRequest&) {
+        return MockWebServer::createTextResponse("pong");
+    });
+}
+
+void runParseBench(MockWebServer& server, const char* path) {
+    const std::string raw = std::string("GET ") + path +
+                            "?verbose=1 HTTP/1.1\r\nHost: coop.local\r\nUser-Agent: bench/1.0\r\n"
+                            "Accept: application/json\r\nAccept-Encoding: gzip, br\r\nConnection: keep-alive\r\n\r\n";
+    const int iterations = 1000000;
+    HttpRequestParser parser;
+    size_t bytes = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        parser.reset();
+        parser.feed(raw.data(), raw.size());
+        bytes += server.handle(parser.view()).body.size();
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-18s parse + dispatch: %6.1f ns/request (%zu bytes)\n", path, ns / iterations, bytes);
+}
+
+// Counts complete responses in `data` from `pos`, using Content-Length; advances pos.
+size_t countResponses(const std::string& data, size_t& pos) {
+    size_t count = 0;
+    for (;;) {
+        const size_t headEnd = data.find("\r\n\r\n", pos);
+        if (headEnd == std::string::npos) {
+            return count;
+        }
+        const size_t lengthAt = data.find("Content-Length: ", pos);
+        const size_t length = std::strtoul(data.c_str() + lengthAt + 16, nullptr, 10);
+        if (data.size() < headEnd + 4 + length) {
+            return count;
+        }
+        pos = headEnd + 4 + length;
+        ++count;
+    }
+}
+
+uint64_t runClient(uint16_t port, const std::string& path, int depth, std::chrono::steady_clock::time_point until) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        return 0;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    const std::string request = "GET " + path + " HTTP/1.1\r\nHost: bench\r\n\r\n";
+    std::string batch;
+    for (int i = 0; i < depth; ++i) {
+        batch += request;
+    }
+
+    uint64_t completed = 0;
+    std::string data;
+    char buffer[64 * 1024];
+    while (std::chrono::steady_clock::now() < until) {
+        if (::send(fd, batch.data(), batch.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(batch.size())) {
+            break;
+        }
+        size_t pos = 0;
+        size_t received = 0;
+        data.clear();
+        while (received < static_cast<size_t>(depth)) {
+            ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                ::close(fd);
+                return completed;
+            }
+            data.append(buffer, static_cast<size_t>(n));
+            received += countResponses(data, pos);
+        }
+        completed += received;
+    }
+    ::close(fd);
+    return completed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string mode = (argc > 1) ? argv[1] : "self";
+
+    MockWebServer server;
+    MockSystemMetrics metrics;
+    Logger logger(256);
+    for (int i = 0; i < 256; ++i) {
+        logger.info("sensor tick temp=21." + std::to_string(i % 10), "sensor");
+    }
+    registerRoutes(server, metrics, logger);
+    server.setRequestHistoryLimit(0);
+
+    if (mode == "parse") {
+        server.begin();
+        runParseBench(server, "/ping");
+        runParseBench(server, "/ping-compat");
+        runParseBench(server, "/api/status");
+        runParseBench(server, "/api/status/cached");
+        runParseBench(server, "/api/logs");
+        runParseBench(server, "/api/logs/cached");
+        return 0;
+    }
+
+    EpollHttpServer backend(server);
+    EpollHttpServer::Config config;
+
+    if (mode == "serve") {
+        config.port = static_cast<uint16_t>((argc > 2) ? std::atoi(argv[2]) : 8080);
+        config.bindAddress = (argc > 3) ? argv[3] : "127.0.0.1";
+        if (!backend.open(config)) {
+            std::fprintf(stderr, "cannot listen on %s:%u\n", config.bindAddress.c_str(), config.port);
+            return 1;
+        }
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        std::printf("listening on http://%s:%u (routes: /api/status[/cached] /api/logs[/cached] /api/sensors/{index} /ping /ping-compat)\n",
+                    config.bindAddress.c_str(), backend.getPort());
+        std::fflush(stdout);
+        while (!g_interrupted) {
+            backend.runOnce(200);
+        }
+        EpollHttpServer::Stats stats = backend.getStats();
+        std::printf("served %llu requests on %llu connections\n",
+                    static_cast<unsigned long long>(stats.requestsServed),
+                    static_cast<unsigned long long>(stats.connectionsAccepted));
+        return 0;
+    }
+
+    const std::string path = (argc > 2) ? argv[2] : "/api/status";
+    const int connections = (argc > 3) ? std::atoi(argv[3]) : 4;
+    const int depth = (argc > 4) ? std::atoi(argv[4]) : 1;
+    const int seconds = (argc > 5) ? std::atoi(argv[5]) : 3;
+
+    if (!backend.start(config)) {
+        std::fprintf(stderr, "cannot start server\n");
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto until = start + std::chrono::seconds(seconds);
+    std::vector<std::thread> clients;
+    std::vector<uint64_t> completed(static_cast<size_t>(connections), 0);
+    for (int c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c]() { completed[static_cast<size_t>(c)] = runClient(backend.getPort(), path, depth, until); });
+    }
+    uint64_t total = 0;
+    for (int c = 0; c < connections; ++c) {
+        clients[static_cast<size_t>(c)].join();
+        total += completed[static_cast<size_t>(c)];
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    backend.stop();
+
+    std::printf("%s: %d connections, pipeline depth %d: %llu requests in %.2fs = %.0f req/s\n", path.c_str(),
+                connections, depth, static_cast<unsigned long long>(total), elapsed, total / elapsed);
+    return 0;
+}
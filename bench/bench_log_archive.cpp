@@ -0,0 +1,69 @@
+// Log history density: bytes per entry in the hot ring versus the compressed archive tier,
+// for a repetitive controller-style message mix, plus the cost of decoding it back.
+//
+// "hot" is one Logger::Record slot. "archive" counts compressed block bytes per archived
+// entry; "with overhead" divides everything the archive allocates (blocks, block headers,
+// encoder window) by the entries it holds.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "Logger.h"
+
+namespace {
+
+void logTraffic(Logger& logger, int count) {
+    for (int i = 0; i < count; ++i) {
+        switch (i % 8) {
+            case 0: logger.infof("sensor", "temp=%.1f humidity=%d%%", 18.0 + (i % 40) / 10.0, 40 + i % 13); break;
+            case 1: logger.debug("pump cycle complete", "pump"); break;
+            case 2: logger.info("light level " + std::to_string(100 + i % 17), "light"); break;
+            case 3: logger.warnf("wifi", "rssi %d dBm, retry %d", -60 - i % 9, i % 3); break;
+            case 4: logger.debugf("sensor", "ds18b20 raw=0x%04x", 0x0150 + i % 64); break;
+            case 5: logger.info("heap free " + std::to_string(180000 - (i * 37) % 5000), "system"); break;
+            case 6: logger.debug("mqtt keepalive sent", "net"); break;
+            default: logger.error("door sensor timeout after " + std::to_string(i % 7) + " tries", "door");
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t archiveBytes = (argc > 1) ? static_cast<size_t>(std::atoi(argv[1])) : 32 * 1024;
+    const int entries = (argc > 2) ? std::atoi(argv[2]) : 20000;
+
+    Logger logger(64, Logger::Mode::SINGLE_THREADED, archiveBytes);
+    logTraffic(logger, entries);
+
+    const LogArchive::Stats stats = logger.getArchiveStats();
+    if (stats.entries == 0) {
+        std::printf("nothing archived; log more than the hot capacity\n");
+        return 1;
+    }
+
+    const double hot = static_cast<double>(Logger::hotEntryBytes());
+    const double compressed = static_cast<double>(stats.usedBytes) / stats.entries;
+    const double withOverhead = static_cast<double>(stats.memoryBytes) / stats.entries;
+    const double raw = static_cast<double>(stats.rawBytes) / stats.entries;
+
+    auto start = std::chrono::steady_clock::now();
+    const size_t decoded = logger.getEntries().size();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("archive budget        %zu bytes, %zu blocks of %zu\n", archiveBytes, stats.blocks,
+                LogArchive::kBlockBytes);
+    std::printf("archived entries      %llu (dropped %llu)\n", static_cast<unsigned long long>(stats.entries),
+                static_cast<unsigned long long>(stats.entriesDropped));
+    std::printf("hot ring              %8.1f bytes/entry\n", hot);
+    std::printf("message text (raw)    %8.1f bytes/entry\n", raw);
+    std::printf("archive               %8.1f bytes/entry  (%.1fx denser than hot)\n", compressed, hot / compressed);
+    std::printf("archive with overhead %8.1f bytes/entry  (%.1fx denser than hot)\n", withOverhead,
+                hot / withOverhead);
+    std::printf("full query            %zu entries in %.2f ms (%.0f entries/s)\n", decoded, elapsed * 1e3,
+                decoded / elapsed);
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Logger throughput: log() calls per second from 1..N producer threads.
+//
+// "locked" is today's single-threaded Logger shared behind a std::mutex, which is what
+// callers on both ESP32 cores would need without concurrent mode. "concurrent" is
+// Logger::Mode::CONCURRENT with one consumer thread draining the ring.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Logger.h"
+
+namespace {
+
+const size_t kCapacity = 256;
+
+struct Result {
+    double callsPerSecond = 0.0;
+    uint64_t dropped = 0;
+};
+
+template <typename LogFn>
+double runProducers(int threads, int callsPerThread, LogFn logFn) {
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&, t]() {
+            const std::string tag = "bench" + std::to_string(t);
+            ready.fetch_add(1);
+            while (!go.load()) {
+            }
+            for (int i = 0; i < callsPerThread; ++i) {
+                logFn("sensor tick temp=21.5", tag);
+            }
+        });
+    }
+
+    while (ready.load() != threads) {
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true);
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return (static_cast<double>(threads) * callsPerThread) / elapsed;
+}
+
+Result benchLocked(int threads, int callsPerThread) {
+    Logger logger(kCapacity);
+    std::mutex mutex;
+
+    Result result;
+    result.callsPerSecond = runProducers(threads, callsPerThread, [&](const char* msg, const std::string& tag) {
+        std::lock_guard<std::mutex> lock(mutex);
+        logger.info(msg, tag);
+    });
+    return result;
+}
+
+Result benchConcurrent(int threads, int callsPerThread) {
+    Logger logger(kCapacity, Logger::Mode::CONCURRENT);
+    std::atomic<bool> stop{false};
+    std::thread consumer([&]() {
+        while (!stop.load()) {
+            logger.drain();
+        }
+    });
+
+    Result result;
+    result.callsPerSecond = runProducers(threads, callsPerThread, [&](const char* msg, const std::string& tag) {
+        logger.info(msg, tag);
+    });
+
+    stop.store(true);
+    consumer.join();
+    result.dropped = logger.droppedCount();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (maxThreads < 4) {
+        maxThreads = 4;
+    }
+    if (argc > 1) {
+        maxThreads = std::atoi(argv[1]);
+    }
+    const int callsPerThread = (argc > 2) ? std::atoi(argv[2]) : 200000;
+
+    std::printf("%-8s %16s %16s %12s\n", "threads", "locked calls/s", "concurrent/s", "dropped");
+    for (int threads = 1; threads <= maxThreads; ++threads) {
+        Result locked = benchLocked(threads, callsPerThread);
+        Result concurrent = benchConcurrent(threads, callsPerThread);
+        std::printf("%-8d %16.0f %16.0f %12llu\n", threads, locked.callsPerSecond, concurrent.callsPerSecond,
+                    static_cast<unsigned long long>(concurrent.dropped));
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Cost of one settings read, as a control loop would do it every iteration.
+//
+// "raw map" is the old path every string-keyed read took: a std::map lookup plus a
+// std::stringstream parse (still used for keys outside the schema). "string key" is the
+// compatibility path for a schema key: name lookup plus conversion from the typed slot.
+// "typed" is get<SettingId>(), a plain member read.
+//
+// The second table reads one field through the whole struct, as a tick on another thread
+// would: getSettings() copies it (strings and recipient list included), snapshot() pins
+// the published copy.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "MockSettingsManager.h"
+
+namespace {
+
+volatile double g_sink = 0.0;
+
+template <typename Fn>
+double nsPerRead(int iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        g_sink = g_sink + fn();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int scale = (argc > 1) ? std::atoi(argv[1]) : 1;
+    const int iterations = 1000000 * scale;
+    using Id = MockSettingsManager::SettingId;
+
+    MockSettingsManager settings;
+    settings.setTestMode(true);
+    settings.setSettingFloat("pump.freezeThreshold", 1.1f); // Old-style key: raw map
+    settings.setSettingUInt("pump.onDuration", 300u);
+    for (int i = 0; i < 40; ++i) {
+        // A realistically populated map, so lookups are not into a near-empty tree.
+        settings.setSettingUInt("extra.key" + std::to_string(i), static_cast<unsigned int>(i));
+    }
+
+    std::printf("%-12s %12s %12s %12s\n", "setting", "raw map ns", "string ns", "typed ns");
+
+    const double rawFloat = nsPerRead(iterations, [&]() { return settings.getSettingFloat("pump.freezeThreshold"); });
+    const double keyFloat = nsPerRead(iterations, [&]() { return settings.getSettingFloat("freezeThreshold"); });
+    const double typedFloat = nsPerRead(iterations, [&]() { return settings.get<Id::freezeThreshold>(); });
+    std::printf("%-12s %12.1f %12.1f %12.2f\n", "float", rawFloat, keyFloat, typedFloat);
+
+    const double rawUInt = nsPerRead(iterations, [&]() { return settings.getSettingUInt("pump.onDuration"); });
+    const double keyUInt = nsPerRead(iterations, [&]() { return settings.getSettingUInt("pumpOnDuration"); });
+    const double typedUInt = nsPerRead(iterations, [&]() { return settings.get<Id::pumpOnDuration>(); });
+    std::printf("%-12s %12.1f %12.1f %12.2f\n", "uint", rawUInt, keyUInt, typedUInt);
+
+    MockSettingsManager::Settings full = settings.getSettings();
+    full.wifiSSID = "coop-network-upstairs";
+    full.wifiPassword = "a-long-enough-passphrase";
+    full.emailRecipients = {"farmer@example.com", "neighbour@example.com"};
+    settings.setSettings(full);
+
+    const double copyRead = nsPerRead(iterations, [&]() { return settings.getSettings().freezeThreshold; });
+    const double snapshotRead =
+        nsPerRead(iterations, [&]() { return settings.snapshot()->settings.freezeThreshold; });
+    std::printf("\n%-12s %12s %12s\n", "struct", "copy ns", "snapshot ns");
+    std::printf("%-12s %12.1f %12.1f\n", "float", copyRead, snapshotRead);
+    return 0;
+}
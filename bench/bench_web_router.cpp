@@ -0,0 +1,88 @@
+// Route lookup latency at 10, 100 and 1000 registered routes.
+//
+// "linear" is the old MockWebServer::findRoute: a walk over every route with full method and
+// path compares (static paths only; it had no parameters). "radix" is HttpRouter::find on the
+// same table plus one parameterised route per resource.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "HttpRouter.h"
+
+namespace {
+
+struct LinearRoute {
+    std::string method;
+    std::string path;
+};
+
+volatile int g_sink = 0;
+
+template <typename Fn>
+double nsPerLookup(const std::vector<std::string>& paths, int iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto& path : paths) {
+            g_sink = g_sink + fn(path);
+        }
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / (static_cast<double>(iterations) * paths.size());
+}
+
+void run(size_t routeCount, int iterations) {
+    HttpRouter router;
+    std::vector<LinearRoute> linear;
+    std::vector<std::string> staticPaths;
+    std::vector<std::string> paramPaths;
+
+    // Half static status routes, half parameterised item routes, spread over resources.
+    for (size_t i = 0; linear.size() + paramPaths.size() < routeCount; ++i) {
+        const std::string base = "/api/v1/resource" + std::to_string(i);
+        router.add("GET", base + "/status", static_cast<int>(i * 2));
+        linear.push_back({"GET", base + "/status"});
+        staticPaths.push_back(base + "/status");
+
+        if (linear.size() + paramPaths.size() < routeCount) {
+            router.add("GET", base + "/items/{id:uint}", static_cast<int>(i * 2 + 1));
+            paramPaths.push_back(base + "/items/" + std::to_string(i * 7));
+        }
+    }
+
+    const std::vector<std::string> misses = {"/api/v1/unknown", "/api/v1/resource0/nothing", "/favicon.ico"};
+
+    const double linearNs = nsPerLookup(staticPaths, iterations, [&](const std::string& path) {
+        for (size_t r = 0; r < linear.size(); ++r) {
+            if (linear[r].method == "GET" && linear[r].path == path) {
+                return static_cast<int>(r);
+            }
+        }
+        return -1;
+    });
+
+    HttpRouter::Match match;
+    auto radix = [&](const std::string& path) {
+        router.find("GET", path, match);
+        return match.route;
+    };
+    const double staticNs = nsPerLookup(staticPaths, iterations, radix);
+    const double paramNs = paramPaths.empty() ? 0.0 : nsPerLookup(paramPaths, iterations, radix);
+    const double missNs = nsPerLookup(misses, iterations, radix);
+
+    std::printf("%-8zu %14.1f %14.1f %14.1f %14.1f\n", router.size(), linearNs, staticNs, paramNs, missNs);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int scale = (argc > 1) ? std::atoi(argv[1]) : 1;
+
+    std::printf("%-8s %14s %14s %14s %14s\n", "routes", "linear ns", "radix ns", "radix param ns", "radix miss ns");
+    run(10, 20000 * scale);
+    run(100, 2000 * scale);
+    run(1000, 200 * scale);
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "Crc32.h"
+
+namespace {
+struct Crc32Table {
+    uint32_t values[256];
+
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            values[i] = c;
+        }
+    }
+};
+
+const Crc32Table& table() {
+    static const Crc32Table instance;
+    return instance;
+}
+} // namespace
+
+uint32_t Crc32::compute(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint32_t* values = table().values;
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = values[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
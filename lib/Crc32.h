@@ -0,0 +1,14 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, reflected, same as zlib) for detecting torn or corrupted records.
+class Crc32 {
+public:
+    // Pass the previous result as `crc` to checksum data in pieces.
+    static uint32_t compute(const void* data, size_t length, uint32_t crc = 0);
+};
+
+#endif // CRC32_H
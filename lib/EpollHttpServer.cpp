@@ -0,0 +1,814 @@
+#include "EpollHttpServer.h"
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Sha1.h"
+
+namespace {
+const size_t kReadChunk = 16 * 1024;
+const size_t kMaxReadPerEvent = 64 * 1024; // Fairness between busy connections
+const size_t kCompactThreshold = 64 * 1024;
+const int kMaxEvents = 64;
+const size_t kMaxWebSocketPayload = 4096; // Clients only send control frames here
+const size_t kMaxStreamChunksPerFlush = 16; // Fairness: a fast reader yields to the loop between batches
+const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+uint64_t nowMs() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+bool isHeader(const std::string& name, const char* expected) {
+    return strcasecmp(name.c_str(), expected) == 0;
+}
+
+bool containsToken(const MockWebServer::Slice& value, const char* token) {
+    const size_t n = std::strlen(token);
+    for (size_t i = 0; i + n <= value.length; ++i) {
+        if (strncasecmp(value.data + i, token, n) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string base64(const uint8_t* data, size_t length) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < length; i += 3) {
+        const uint32_t chunk = (static_cast<uint32_t>(data[i]) << 16) |
+                               (i + 1 < length ? static_cast<uint32_t>(data[i + 1]) << 8 : 0) |
+                               (i + 2 < length ? static_cast<uint32_t>(data[i + 2]) : 0);
+        out += kAlphabet[(chunk >> 18) & 0x3F];
+        out += kAlphabet[(chunk >> 12) & 0x3F];
+        out += i + 1 < length ? kAlphabet[(chunk >> 6) & 0x3F] : '=';
+        out += i + 2 < length ? kAlphabet[chunk & 0x3F] : '=';
+    }
+    return out;
+}
+} // namespace
+
+EpollHttpServer::EpollHttpServer(MockWebServer& server) : server_(server) {
+}
+
+EpollHttpServer::~EpollHttpServer() {
+    stop();
+    close();
+    if (pushHub_) {
+        pushHub_->setNotify(nullptr);
+    }
+}
+
+void EpollHttpServer::servePush(const std::string& path, PushHub* hub) {
+    if (pushHub_) {
+        pushHub_->setNotify(nullptr);
+    }
+    pushPath_ = path;
+    pushHub_ = hub;
+    if (pushHub_) {
+        // Publishers run on other threads; one wakeup covers any number of publishes.
+        pushHub_->setNotify([this]() {
+            if (!pushSignal_.exchange(true)) {
+                wake();
+            }
+        });
+    }
+}
+
+void EpollHttpServer::wake() {
+    const uint64_t one = 1;
+    if (wakeFd_ >= 0 && ::write(wakeFd_, &one, sizeof(one)) < 0) {
+        // Already signalled (counter saturated) or closing; either way the loop wakes.
+    }
+}
+
+bool EpollHttpServer::open(const Config& config) {
+    close();
+    config_ = config;
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config_.port);
+    if (inet_pton(AF_INET, config_.bindAddress.c_str(), &addr.sin_addr) != 1) {
+        return false;
+    }
+
+    listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    socklen_t addrLength = sizeof(addr);
+    if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd_, config_.backlog) != 0 ||
+        getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &addrLength) != 0) {
+        close();
+        return false;
+    }
+    boundPort_ = ntohs(addr.sin_port);
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        close();
+        return false;
+    }
+
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.fd = wakeFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    if (!server_.isRunning()) {
+        server_.begin();
+    }
+    lastSweepMs_ = nowMs();
+    return true;
+}
+
+void EpollHttpServer::close() {
+    while (!connections_.empty()) {
+        closeConnection(connections_.begin()->first);
+    }
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+    }
+    if (wakeFd_ >= 0) {
+        ::close(wakeFd_);
+        wakeFd_ = -1;
+    }
+    if (epollFd_ >= 0) {
+        ::close(epollFd_);
+        epollFd_ = -1;
+    }
+    boundPort_ = 0;
+}
+
+bool EpollHttpServer::start(const Config& config) {
+    if (isRunning() || !open(config)) {
+        return false;
+    }
+
+    stopRequested_ = false;
+    loop_ = std::thread([this]() {
+        while (!stopRequested_.load()) {
+            if (runOnce(1000) < 0) {
+                break;
+            }
+        }
+    });
+    return true;
+}
+
+void EpollHttpServer::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    stopRequested_ = true;
+    wake();
+    loop_.join();
+    close();
+}
+
+EpollHttpServer::Stats EpollHttpServer::getStats() const {
+    Stats stats;
+    stats.connectionsAccepted = stats_.connectionsAccepted.load();
+    stats.connectionsRejected = stats_.connectionsRejected.load();
+    stats.connectionsClosed = stats_.connectionsClosed.load();
+    stats.requestsServed = stats_.requestsServed.load();
+    stats.parseErrors = stats_.parseErrors.load();
+    stats.bytesRead = stats_.bytesRead.load();
+    stats.bytesWritten = stats_.bytesWritten.load();
+    stats.streamsStarted = stats_.streamsStarted.load();
+    stats.streamChunks = stats_.streamChunks.load();
+    return stats;
+}
+
+int EpollHttpServer::runOnce(int timeoutMs) {
+    if (epollFd_ < 0) {
+        return -1;
+    }
+
+    if (!pushConnections_.empty()) {
+        const uint64_t now = nowMs();
+        const uint64_t untilPush = nextPushDueMs_ > now ? nextPushDueMs_ - now : 0;
+        if (timeoutMs < 0 || untilPush < static_cast<uint64_t>(timeoutMs)) {
+            timeoutMs = static_cast<int>(untilPush);
+        }
+    }
+
+    epoll_event events[kMaxEvents];
+    const int n = epoll_wait(epollFd_, events, kMaxEvents, timeoutMs);
+    if (n < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        const int fd = events[i].data.fd;
+        const uint32_t ready = events[i].events;
+
+        if (fd == listenFd_) {
+            acceptConnections();
+            continue;
+        }
+        if (fd == wakeFd_) {
+            uint64_t value;
+            while (::read(wakeFd_, &value, sizeof(value)) > 0) {
+            }
+            continue;
+        }
+
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) {
+            continue;
+        }
+        Connection& connection = *it->second;
+
+        bool keep = true;
+        if ((ready & (EPOLLERR | EPOLLHUP)) && !(ready & EPOLLIN)) {
+            keep = false;
+        }
+        if (keep && (ready & EPOLLIN)) {
+            keep = handleReadable(connection);
+        }
+        if (keep && (ready & EPOLLOUT)) {
+            keep = handleWritable(connection);
+        }
+        if (keep) {
+            updateInterest(connection);
+        } else {
+            closeConnection(fd);
+        }
+    }
+
+    const uint64_t now = nowMs();
+    if (!pushConnections_.empty() && (pushSignal_.exchange(false) || now >= nextPushDueMs_)) {
+        pumpPush(now);
+    }
+    if (now - lastSweepMs_ >= 1000) {
+        sweepIdle(now);
+        lastSweepMs_ = now;
+    }
+    return n;
+}
+
+void EpollHttpServer::acceptConnections() {
+    for (;;) {
+        sockaddr_in addr;
+        socklen_t addrLength = sizeof(addr);
+        const int fd = accept4(listenFd_, reinterpret_cast<sockaddr*>(&addr), &addrLength,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return; // EAGAIN, or a transient error; the next readiness event retries
+        }
+
+        if (connections_.size() >= config_.maxConnections) {
+            ::close(fd);
+            stats_.connectionsRejected.fetch_add(1);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->fd = fd;
+        connection->parser.setLimits(config_.limits);
+        char ip[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        connection->clientIP = ip;
+        connection->clientPort = ntohs(addr.sin_port);
+        connection->lastActivityMs = nowMs();
+        connection->events = EPOLLIN | EPOLLRDHUP;
+
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = connection->events;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            ::close(fd);
+            continue;
+        }
+
+        connections_[fd] = std::move(connection);
+        connectionCount_.store(connections_.size());
+        stats_.connectionsAccepted.fetch_add(1);
+    }
+}
+
+bool EpollHttpServer::handleReadable(Connection& connection) {
+    bool peerClosed = false;
+    size_t total = 0;
+    char buffer[kReadChunk];
+
+    while (total < kMaxReadPerEvent) {
+        const ssize_t n = ::read(connection.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            connection.in.append(buffer, static_cast<size_t>(n));
+            total += static_cast<size_t>(n);
+            continue;
+        }
+        if (n == 0) {
+            peerClosed = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        }
+        break;
+    }
+
+    stats_.bytesRead.fetch_add(total);
+    connection.lastActivityMs = nowMs();
+
+    processRequests(connection);
+    if (peerClosed) {
+        // Half-close: answer what was received, then drop the connection.
+        connection.closeAfterWrite = true;
+    }
+    return flush(connection);
+}
+
+bool EpollHttpServer::handleWritable(Connection& connection) {
+    if (!flush(connection)) {
+        return false;
+    }
+
+    if (connection.pushId != PushHub::kInvalidSubscriber) {
+        // A stream held back by a slow client catches up with the newest state.
+        if (connection.out.size() - connection.outStart < config_.maxPendingOutput / 2 &&
+            pushHub_->collect(connection.pushId, nowMs(), connection.out)) {
+            return flush(connection);
+        }
+        return true;
+    }
+
+    // Output drained below the limit (and any stream finished): resume parsing requests that
+    // were held back.
+    if (connection.readPaused && !connection.stream &&
+        connection.out.size() - connection.outStart < config_.maxPendingOutput / 2) {
+        connection.readPaused = false;
+        processRequests(connection);
+        return flush(connection);
+    }
+    return true;
+}
+
+void EpollHttpServer::processRequests(Connection& connection) {
+    while (!connection.closeAfterWrite && !connection.stream && connection.pushId == PushHub::kInvalidSubscriber) {
+        if (connection.out.size() - connection.outStart > config_.maxPendingOutput) {
+            connection.readPaused = true;
+            break;
+        }
+
+        const HttpRequestParser::Result result =
+            connection.parser.feed(connection.in.data() + connection.inStart, connection.in.size() - connection.inStart);
+
+        if (result == HttpRequestParser::Result::NEED_MORE) {
+            break;
+        }
+
+        if (result == HttpRequestParser::Result::ERROR) {
+            stats_.parseErrors.fetch_add(1);
+            const int status = connection.parser.errorStatus();
+            serializeResponse(MockWebServer::createErrorResponse(status, reasonPhrase(status)), false, false,
+                              connection.out);
+            connection.closeAfterWrite = true;
+            break;
+        }
+
+        // Handlers see the request in place in connection.in; nothing is copied unless a
+        // handler or middleware asks for the HttpRequest form.
+        MockWebServer::RequestView& request = connection.parser.view();
+        request.clientIP = MockWebServer::Slice(connection.clientIP);
+        request.clientPort = connection.clientPort;
+        const size_t consumed = connection.parser.consumed();
+        const bool headOnly = request.method.equals("HEAD");
+
+        if (pushHub_ && request.method.equals("GET") && request.path.equals(pushPath_.c_str())) {
+            if (startPush(connection, request)) {
+                stats_.requestsServed.fetch_add(1);
+                connection.inStart += consumed;
+                connection.parser.reset();
+                break;
+            }
+            connection.closeAfterWrite = true;
+            break;
+        }
+
+        MockWebServer::HttpResponse response = server_.handle(request);
+        if (request.holdsSlot()) {
+            ++connection.heldSlots;
+        }
+        const int status = response.statusCode;
+        const bool streaming = response.stream && !headOnly && status >= 200 && status != 204 && status != 304;
+        const bool chunked = !connection.parser.isHttp10();
+        // Without chunking the end of the body is the end of the connection.
+        const bool keepAlive = connection.parser.keepAlive() && response.keepAlive && (chunked || !streaming);
+        serializeResponse(response, keepAlive, headOnly, connection.out, chunked);
+        stats_.requestsServed.fetch_add(1);
+
+        connection.inStart += consumed;
+        connection.parser.reset();
+        if (!keepAlive) {
+            connection.closeAfterWrite = true;
+        }
+        if (streaming) {
+            // flush() pulls the body; reading stops until it is done (see handleWritable()).
+            connection.stream.swap(response.stream);
+            connection.streamDone.swap(response.streamDone);
+            connection.streamBytes = 0;
+            connection.streamStatus = status;
+            connection.streamChunked = chunked;
+            connection.readPaused = true;
+            stats_.streamsStarted.fetch_add(1);
+        } else if (response.streamDone) {
+            response.streamDone(0, status); // HEAD, 204, 304: the generator never runs
+        }
+    }
+
+    if (connection.pushId != PushHub::kInvalidSubscriber) {
+        handlePushInput(connection);
+    }
+
+    // The parser works on offsets relative to inStart, so compacting between calls is safe.
+    if (connection.inStart == connection.in.size()) {
+        connection.in.clear();
+        connection.inStart = 0;
+    } else if (connection.inStart > kCompactThreshold) {
+        connection.in.erase(0, connection.inStart);
+        connection.inStart = 0;
+    }
+}
+
+bool EpollHttpServer::flush(Connection& connection) {
+    size_t pulls = 0;
+    do {
+        if (connection.stream) {
+            pullStream(connection);
+        }
+        while (connection.outStart < connection.out.size()) {
+            const ssize_t n = ::send(connection.fd, connection.out.data() + connection.outStart,
+                                     connection.out.size() - connection.outStart, MSG_NOSIGNAL);
+            if (n > 0) {
+                connection.outStart += static_cast<size_t>(n);
+                stats_.bytesWritten.fetch_add(static_cast<uint64_t>(n));
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                break;
+            }
+            return false;
+        }
+    } while (connection.stream && connection.outStart == connection.out.size() && ++pulls < kMaxStreamChunksPerFlush);
+
+    if (connection.outStart == connection.out.size()) {
+        connection.out.clear();
+        connection.outStart = 0;
+        if (connection.stream) {
+            return true; // EPOLLOUT stays armed for the rest of the body
+        }
+        server_.releaseSlots(connection.heldSlots);
+        connection.heldSlots = 0;
+        return !connection.closeAfterWrite;
+    }
+    if (connection.outStart > kCompactThreshold) {
+        connection.out.erase(0, connection.outStart);
+        connection.outStart = 0;
+    }
+    return true;
+}
+
+void EpollHttpServer::pullStream(Connection& connection) {
+    // Backpressure: nothing more is generated while a chunk's worth is still unsent.
+    if (connection.out.size() - connection.outStart >= config_.streamChunkBytes) {
+        return;
+    }
+
+    streamChunk_.clear();
+    bool more = false;
+    try {
+        more = connection.stream(streamChunk_, config_.streamChunkBytes);
+    } catch (const std::exception&) {
+        // Too late for an error status: end the connection without the terminating chunk so
+        // the client sees a truncated body.
+        endStream(connection);
+        connection.closeAfterWrite = true;
+        return;
+    }
+
+    if (!streamChunk_.empty()) {
+        if (connection.streamChunked) {
+            char size[20];
+            const int n = std::snprintf(size, sizeof(size), "%zx\r\n", streamChunk_.size());
+            connection.out.append(size, static_cast<size_t>(n));
+            connection.out += streamChunk_;
+            connection.out += "\r\n";
+        } else {
+            connection.out += streamChunk_;
+        }
+        connection.streamBytes += streamChunk_.size();
+        stats_.streamChunks.fetch_add(1);
+    }
+    if (!more) {
+        if (connection.streamChunked) {
+            connection.out += "0\r\n\r\n";
+        }
+        endStream(connection);
+    }
+    connection.lastActivityMs = nowMs();
+}
+
+void EpollHttpServer::endStream(Connection& connection) {
+    connection.stream = nullptr;
+    MockWebServer::StreamDone done;
+    done.swap(connection.streamDone);
+    if (done) {
+        done(connection.streamBytes, connection.streamStatus);
+    }
+}
+
+void EpollHttpServer::updateInterest(Connection& connection) {
+    uint32_t events = EPOLLRDHUP;
+    if (!connection.readPaused && !connection.closeAfterWrite) {
+        events |= EPOLLIN;
+    }
+    // A paused connection with nothing queued still needs one writable event to resume.
+    if (connection.outStart < connection.out.size() || connection.stream || connection.readPaused) {
+        events |= EPOLLOUT;
+    }
+    if (events == connection.events) {
+        return;
+    }
+
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = connection.fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &ev);
+    connection.events = events;
+}
+
+void EpollHttpServer::closeConnection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    if (epollFd_ >= 0) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    if (it->second->pushId != PushHub::kInvalidSubscriber) {
+        pushHub_->unsubscribe(it->second->pushId);
+        pushConnections_.erase(std::find(pushConnections_.begin(), pushConnections_.end(), fd));
+        pushConnectionCount_.store(pushConnections_.size());
+    }
+    if (it->second->stream) {
+        endStream(*it->second); // Abandoned by the client: count what was produced
+    }
+    server_.releaseSlots(it->second->heldSlots);
+    ::close(fd);
+    connections_.erase(it);
+    connectionCount_.store(connections_.size());
+    stats_.connectionsClosed.fetch_add(1);
+}
+
+void EpollHttpServer::sweepIdle(uint64_t now) {
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        const int fd = it->first;
+        // Streams are quiet by design; their heartbeats surface dead peers as write errors.
+        const bool idle = it->second->pushId == PushHub::kInvalidSubscriber &&
+                          now - it->second->lastActivityMs > config_.idleTimeoutMs;
+        ++it;
+        if (idle) {
+            closeConnection(fd);
+        }
+    }
+}
+
+bool EpollHttpServer::startPush(Connection& connection, const MockWebServer::RequestView& request) {
+    const bool webSocket = containsToken(request.header("Upgrade"), "websocket");
+    const MockWebServer::Slice key = request.header("Sec-WebSocket-Key");
+    if (webSocket && (key.empty() || !request.header("Sec-WebSocket-Version").equals("13"))) {
+        MockWebServer::HttpResponse response = MockWebServer::createErrorResponse(400, "Bad WebSocket handshake");
+        response.headers["Sec-WebSocket-Version"] = "13";
+        serializeResponse(response, false, false, connection.out);
+        return false;
+    }
+
+    uint32_t intervalMs = 0;
+    const MockWebServer::Slice interval = request.queryParam("interval");
+    for (size_t i = 0; i < interval.length && i < 9 && interval.data[i] >= '0' && interval.data[i] <= '9'; ++i) {
+        intervalMs = intervalMs * 10 + static_cast<uint32_t>(interval.data[i] - '0');
+    }
+
+    const PushHub::SubscriberId id =
+        pushHub_->subscribe(webSocket ? PushHub::Format::WEBSOCKET : PushHub::Format::SSE, intervalMs);
+    if (id == PushHub::kInvalidSubscriber) {
+        serializeResponse(MockWebServer::createErrorResponse(503, "Too many subscribers"), false, false,
+                          connection.out);
+        return false;
+    }
+
+    if (webSocket) {
+        std::string accept = key.str() + kWebSocketGuid;
+        uint8_t digest[Sha1::kDigestBytes];
+        Sha1::compute(accept.data(), accept.size(), digest);
+        connection.out += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Accept: ";
+        connection.out += base64(digest, sizeof(digest));
+        connection.out += "\r\n\r\n";
+    } else {
+        connection.out += "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                          "Connection: keep-alive\r\n\r\n";
+    }
+
+    connection.pushId = id;
+    connection.webSocket = webSocket;
+    pushConnections_.push_back(connection.fd);
+    pushConnectionCount_.store(pushConnections_.size());
+    pushHub_->collect(id, nowMs(), connection.out); // Current state right away
+    nextPushDueMs_ = 0;
+    return true;
+}
+
+void EpollHttpServer::handlePushInput(Connection& connection) {
+    if (!connection.webSocket) {
+        connection.inStart = connection.in.size(); // Nothing meaningful arrives on an SSE stream
+        return;
+    }
+
+    while (!connection.closeAfterWrite) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(connection.in.data() + connection.inStart);
+        const size_t available = connection.in.size() - connection.inStart;
+        if (available < 2) {
+            return;
+        }
+
+        const uint8_t opcode = p[0] & 0x0F;
+        const bool masked = (p[1] & 0x80) != 0;
+        uint64_t length = p[1] & 0x7F;
+        size_t header = 2;
+        if (length == 126) {
+            if (available < 4) {
+                return;
+            }
+            length = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+            header = 4;
+        } else if (length == 127) {
+            if (available < 10) {
+                return;
+            }
+            length = 0;
+            for (int i = 0; i < 8; ++i) {
+                length = (length << 8) | p[2 + i];
+            }
+            header = 10;
+        }
+
+        if (!masked || length > kMaxWebSocketPayload) {
+            const char status[2] = {static_cast<char>(1002 >> 8), static_cast<char>(1002 & 0xFF)}; // Protocol error
+            PushHub::appendWebSocketFrame(0x8, status, sizeof(status), connection.out);
+            connection.closeAfterWrite = true;
+            connection.inStart = connection.in.size();
+            return;
+        }
+        if (available < header + 4 + length) {
+            return;
+        }
+
+        const uint8_t* mask = p + header;
+        std::string payload(reinterpret_cast<const char*>(p + header + 4), static_cast<size_t>(length));
+        for (size_t i = 0; i < payload.size(); ++i) {
+            payload[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+        }
+        connection.inStart += header + 4 + static_cast<size_t>(length);
+
+        if (opcode == 0x8) {
+            // Echo the status code back and close once it is written.
+            PushHub::appendWebSocketFrame(0x8, payload.data(), payload.size() < 2 ? 0 : 2, connection.out);
+            connection.closeAfterWrite = true;
+        } else if (opcode == 0x9) {
+            PushHub::appendWebSocketFrame(0xA, payload.data(), payload.size(), connection.out);
+        }
+        // Pongs and data frames are ignored: subscriptions are read-only.
+    }
+}
+
+void EpollHttpServer::pumpPush(uint64_t now) {
+    bool blocked = false;
+    const std::vector<int> fds = pushConnections_;
+    for (int fd : fds) {
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) {
+            continue;
+        }
+        Connection& connection = *it->second;
+        if (connection.out.size() - connection.outStart > config_.maxPendingOutput) {
+            blocked = true; // Resumed from handleWritable() once the socket drains
+            continue;
+        }
+        if (!pushHub_->collect(connection.pushId, now, connection.out)) {
+            continue;
+        }
+        if (flush(connection)) {
+            updateInterest(connection);
+        } else {
+            closeConnection(fd);
+        }
+    }
+
+    nextPushDueMs_ = pushHub_->nextDueMs(now);
+    if (blocked && nextPushDueMs_ <= now) {
+        nextPushDueMs_ = now + pushHub_->getConfig().minIntervalMs;
+    }
+}
+
+const char* EpollHttpServer::reasonPhrase(int statusCode) {
+    switch (statusCode) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 406: return "Not Acceptable";
+        case 408: return "Request Timeout";
+        case 413: return "Payload Too Large";
+        case 416: return "Range Not Satisfiable";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Unknown";
+    }
+}
+
+void EpollHttpServer::serializeResponse(const MockWebServer::HttpResponse& response, bool keepAlive, bool headOnly,
+                                        std::string& out, bool chunked) {
+    out += "HTTP/1.1 ";
+    out += std::to_string(response.statusCode);
+    out += ' ';
+    out += reasonPhrase(response.statusCode);
+    out += "\r\n";
+
+    for (const auto& header : response.headers) {
+        if (isHeader(header.first, "Content-Length") || isHeader(header.first, "Connection") ||
+            isHeader(header.first, "Transfer-Encoding")) {
+            continue;
+        }
+        out += header.first;
+        out += ": ";
+        out += header.second;
+        out += "\r\n";
+    }
+
+    // 1xx, 204 and 304 carry no body; a Content-Length on a 304 would describe the 200.
+    const int status = response.statusCode;
+    const bool hasBody = status >= 200 && status != 204 && status != 304;
+    if (hasBody && response.stream) {
+        if (chunked) {
+            out += "Transfer-Encoding: chunked\r\n";
+        }
+    } else if (hasBody) {
+        out += "Content-Length: ";
+        out += std::to_string(response.body.size());
+        out += "\r\n";
+    }
+    out += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    if (!headOnly && hasBody && !response.stream) {
+        out += response.body;
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,166 @@
+#ifndef EPOLL_HTTP_SERVER_H
+#define EPOLL_HTTP_SERVER_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HttpRequestParser.h"
+#include "MockWebServer.h"
+#include "PushHub.h"
+
+// Real HTTP/1.1 listener for a MockWebServer, so the routes and middleware registered with
+// on()/onGet()/addMiddleware() can be served over a socket (desktop load tests only).
+// One thread runs an epoll loop over non-blocking sockets: requests are parsed incrementally,
+// connections are kept alive, and pipelined requests are answered in order with their
+// responses batched into one write. Handlers run on the loop thread, so register routes
+// before start().
+//
+// A response with a body generator (MockWebServer::createStreamResponse()) goes out with
+// chunked transfer encoding, pulling one chunk of at most streamChunkBytes whenever the
+// connection's pending output falls below that; a slow reader therefore stalls the generator
+// rather than buffering the document. Requests pipelined behind a stream wait for it to end.
+//
+// A GET of the servePush() path becomes a long-lived telemetry stream instead: Server-Sent
+// Events, or a WebSocket when the request asks to upgrade. "?interval=<ms>" sets that
+// client's maximum update rate (see PushHub).
+class EpollHttpServer {
+public:
+    struct Config {
+        std::string bindAddress = "127.0.0.1";
+        uint16_t port = 0;                       // 0 picks a free port; see getPort()
+        int backlog = 128;
+        size_t maxConnections = 1024;
+        uint32_t idleTimeoutMs = 30000;
+        size_t maxPendingOutput = 256 * 1024;    // Stop reading a connection above this
+        size_t streamChunkBytes = 4096;          // Per generator pull for streamed bodies
+        HttpRequestParser::Limits limits;
+    };
+
+    struct Stats {
+        uint64_t connectionsAccepted = 0;
+        uint64_t connectionsRejected = 0;
+        uint64_t connectionsClosed = 0;
+        uint64_t requestsServed = 0;
+        uint64_t parseErrors = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t streamsStarted = 0;
+        uint64_t streamChunks = 0;
+    };
+
+    explicit EpollHttpServer(MockWebServer& server);
+    ~EpollHttpServer();
+
+    EpollHttpServer(const EpollHttpServer&) = delete;
+    EpollHttpServer& operator=(const EpollHttpServer&) = delete;
+
+    // Stream `hub` to clients that GET `path`. Call before open()/start(); nullptr detaches.
+    void servePush(const std::string& path, PushHub* hub);
+    size_t getPushConnectionCount() const { return pushConnectionCount_.load(); }
+
+    // Bind and listen without starting a thread; drive the loop with runOnce().
+    bool open(const Config& config);
+    // Process ready events, waiting at most timeoutMs. Returns events handled, -1 if closed.
+    int runOnce(int timeoutMs);
+    void close();
+
+    // open() plus a loop thread until stop().
+    bool start(const Config& config);
+    void stop();
+    bool isRunning() const { return loop_.joinable(); }
+
+    uint16_t getPort() const { return boundPort_; }
+    size_t getConnectionCount() const { return connectionCount_.load(); }
+    Stats getStats() const;
+
+    static const char* reasonPhrase(int statusCode);
+    // A streamed response gets only its head here: "Transfer-Encoding: chunked", or with
+    // `chunked` false (HTTP/1.0) no length at all, the body then ending with the connection.
+    static void serializeResponse(const MockWebServer::HttpResponse& response, bool keepAlive, bool headOnly,
+                                  std::string& out, bool chunked = true);
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string in;
+        size_t inStart = 0;
+        std::string out;
+        size_t outStart = 0;
+        HttpRequestParser parser;
+        std::string clientIP;
+        uint16_t clientPort = 0;
+        bool closeAfterWrite = false;
+        bool readPaused = false;
+        uint32_t events = 0; // Current epoll interest
+        uint64_t lastActivityMs = 0;
+        PushHub::SubscriberId pushId = PushHub::kInvalidSubscriber; // Set once upgraded to a stream
+        bool webSocket = false;
+        size_t heldSlots = 0; // Admitted requests whose responses are still in `out`
+        MockWebServer::BodyGenerator stream; // Body still being produced, if any
+        MockWebServer::StreamDone streamDone;
+        uint64_t streamBytes = 0; // Body bytes generated so far
+        int streamStatus = 0;
+        bool streamChunked = true;
+    };
+
+    MockWebServer& server_;
+    Config config_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    uint16_t boundPort_ = 0;
+    std::map<int, std::unique_ptr<Connection>> connections_;
+    std::atomic<size_t> connectionCount_{0};
+    uint64_t lastSweepMs_ = 0;
+
+    std::string pushPath_;
+    PushHub* pushHub_ = nullptr;
+    std::vector<int> pushConnections_;
+    std::atomic<size_t> pushConnectionCount_{0};
+    std::atomic<bool> pushSignal_{false};
+    uint64_t nextPushDueMs_ = UINT64_MAX;
+    std::string streamChunk_; // Scratch for generator output, reused across pulls
+
+    std::thread loop_;
+    std::atomic<bool> stopRequested_{false};
+
+    struct AtomicStats {
+        std::atomic<uint64_t> connectionsAccepted{0};
+        std::atomic<uint64_t> connectionsRejected{0};
+        std::atomic<uint64_t> connectionsClosed{0};
+        std::atomic<uint64_t> requestsServed{0};
+        std::atomic<uint64_t> parseErrors{0};
+        std::atomic<uint64_t> bytesRead{0};
+        std::atomic<uint64_t> bytesWritten{0};
+        std::atomic<uint64_t> streamsStarted{0};
+        std::atomic<uint64_t> streamChunks{0};
+    } stats_;
+
+    void acceptConnections();
+    bool handleReadable(Connection& connection);
+    bool handleWritable(Connection& connection);
+    void processRequests(Connection& connection);
+    bool flush(Connection& connection);
+    void pullStream(Connection& connection);
+    void endStream(Connection& connection);
+    void updateInterest(Connection& connection);
+    void closeConnection(int fd);
+    void sweepIdle(uint64_t nowMs);
+    void wake();
+
+    bool startPush(Connection& connection, const MockWebServer::RequestView& request);
+    void handlePushInput(Connection& connection);
+    void pumpPush(uint64_t nowMs);
+};
+
+#endif // __linux__
+
+#endif // EPOLL_HTTP_SERVER_H
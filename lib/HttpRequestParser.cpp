@@ -0,0 +1,226 @@
+#include "HttpRequestParser.h"
+
+#include <cstring>
+#include <strings.h>
+
+namespace {
+const char kHeaderTerminator[] = "\r\n\r\n";
+const size_t kTerminatorLength = 4;
+
+bool isTokenChar(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           (c != '\0' && std::strchr("!#$%&'*+-.^_`|~", c) != nullptr);
+}
+
+bool containsIgnoreCase(const MockWebServer::Slice& haystack, const char* needle) {
+    const size_t n = std::strlen(needle);
+    for (size_t i = 0; i + n <= haystack.length; ++i) {
+        if (strncasecmp(haystack.data + i, needle, n) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void trim(const char*& begin, const char*& end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) {
+        --end;
+    }
+}
+} // namespace
+
+void HttpRequestParser::reset() {
+    view_.clear();
+    scanned_ = 0;
+    headBytes_ = 0;
+    contentLength_ = 0;
+    headParsed_ = false;
+    keepAlive_ = true;
+    http10_ = false;
+    errorStatus_ = 0;
+}
+
+HttpRequestParser::Result HttpRequestParser::fail(int status) {
+    errorStatus_ = status;
+    keepAlive_ = false;
+    return Result::ERROR;
+}
+
+HttpRequestParser::Result HttpRequestParser::feed(const char* data, size_t length) {
+    if (errorStatus_ != 0) {
+        return Result::ERROR;
+    }
+
+    if (!headParsed_) {
+        // Resume just before where the last search stopped, in case the terminator straddles.
+        const size_t from = scanned_ >= kTerminatorLength ? scanned_ - (kTerminatorLength - 1) : 0;
+        const size_t limit = length < limits_.maxHeaderBytes ? length : limits_.maxHeaderBytes;
+        const char* end = nullptr;
+        for (size_t i = from; i + kTerminatorLength <= limit; ++i) {
+            if (data[i] == '\r' && std::memcmp(data + i, kHeaderTerminator, kTerminatorLength) == 0) {
+                end = data + i;
+                break;
+            }
+        }
+        scanned_ = limit;
+
+        if (!end) {
+            return length >= limits_.maxHeaderBytes ? fail(431) : Result::NEED_MORE;
+        }
+
+        headBytes_ = static_cast<size_t>(end - data) + kTerminatorLength;
+        if (!parseHead(data, static_cast<size_t>(end - data))) {
+            return Result::ERROR;
+        }
+        headParsed_ = true;
+    } else if (length - headBytes_ >= contentLength_) {
+        // The body completed in a later call; the caller's buffer may have moved since the
+        // head was parsed, so point the view at the current bytes.
+        parseHead(data, headBytes_ - kTerminatorLength);
+    }
+
+    if (length - headBytes_ < contentLength_) {
+        return Result::NEED_MORE;
+    }
+
+    view_.body = MockWebServer::Slice(data + headBytes_, contentLength_);
+    return Result::COMPLETE;
+}
+
+bool HttpRequestParser::parseHead(const char* data, size_t length) {
+    typedef MockWebServer::Slice Slice;
+
+    view_.clear();
+    const char* end = data + length;
+    const char* lineEnd = static_cast<const char*>(std::memchr(data, '\r', length));
+    if (!lineEnd) {
+        lineEnd = end;
+    } else if (lineEnd[1] != '\n') {
+        fail(400); // Bare CR
+        return false;
+    }
+
+    // Request line: METHOD SP request-target SP HTTP-version
+    const char* sp1 = static_cast<const char*>(std::memchr(data, ' ', static_cast<size_t>(lineEnd - data)));
+    const char* sp2 = sp1 ? static_cast<const char*>(std::memchr(sp1 + 1, ' ', static_cast<size_t>(lineEnd - sp1 - 1)))
+                          : nullptr;
+    if (!sp1 || !sp2 || sp1 == data || sp2 == sp1 + 1) {
+        fail(400);
+        return false;
+    }
+    for (const char* p = data; p < sp1; ++p) {
+        if (!isTokenChar(*p)) {
+            fail(400);
+            return false;
+        }
+    }
+
+    const Slice version(sp2 + 1, static_cast<size_t>(lineEnd - sp2 - 1));
+    if (version.equals("HTTP/1.1")) {
+        keepAlive_ = true;
+    } else if (version.equals("HTTP/1.0")) {
+        keepAlive_ = false;
+        http10_ = true;
+    } else {
+        fail(version.length >= 5 && std::memcmp(version.data, "HTTP/", 5) == 0 ? 505 : 400);
+        return false;
+    }
+
+    view_.method = Slice(data, static_cast<size_t>(sp1 - data));
+    view_.target = Slice(sp1 + 1, static_cast<size_t>(sp2 - sp1 - 1));
+    if (view_.target.data[0] != '/' && !view_.target.equals("*")) {
+        fail(400);
+        return false;
+    }
+    const char* query = static_cast<const char*>(std::memchr(view_.target.data, '?', view_.target.length));
+    if (query) {
+        view_.path = Slice(view_.target.data, static_cast<size_t>(query - view_.target.data));
+        view_.query = Slice(query + 1, static_cast<size_t>(sp2 - query - 1));
+    } else {
+        view_.path = view_.target;
+    }
+
+    const size_t maxHeaders =
+        limits_.maxHeaders < MockWebServer::kMaxRequestHeaders ? limits_.maxHeaders : MockWebServer::kMaxRequestHeaders;
+    bool haveLength = false;
+    const char* line = lineEnd + 2;
+    while (line < end) {
+        const char* next = static_cast<const char*>(std::memchr(line, '\r', static_cast<size_t>(end - line)));
+        if (!next) {
+            next = end;
+        } else if (next[1] != '\n') {
+            // A bare CR would swallow the next byte; front ends that split lines differently
+            // would see other headers than we do.
+            fail(400);
+            return false;
+        }
+
+        const char* colon = static_cast<const char*>(std::memchr(line, ':', static_cast<size_t>(next - line)));
+        if (!colon || colon == line || view_.headerCount == maxHeaders) {
+            fail(colon && colon != line ? 431 : 400);
+            return false;
+        }
+        for (const char* p = line; p < colon; ++p) {
+            if (!isTokenChar(*p)) {
+                fail(400); // Includes whitespace before the colon and obsolete line folding
+                return false;
+            }
+        }
+
+        const char* valueBegin = colon + 1;
+        const char* valueEnd = next;
+        for (const char* p = valueBegin; p < valueEnd; ++p) {
+            if (*p == '\n' || *p == '\0') {
+                fail(400); // A bare LF must not hide a second header inside this value
+                return false;
+            }
+        }
+        trim(valueBegin, valueEnd);
+
+        MockWebServer::HeaderField& field = view_.headers[view_.headerCount++];
+        field.name = Slice(line, static_cast<size_t>(colon - line));
+        field.value = Slice(valueBegin, static_cast<size_t>(valueEnd - valueBegin));
+
+        if (field.name.equalsIgnoreCase("Content-Length")) {
+            if (field.value.empty() || field.value.length > 9) {
+                fail(400);
+                return false;
+            }
+            size_t contentLength = 0;
+            for (size_t i = 0; i < field.value.length; ++i) {
+                const char c = field.value.data[i];
+                if (c < '0' || c > '9') {
+                    fail(400);
+                    return false;
+                }
+                contentLength = contentLength * 10 + static_cast<size_t>(c - '0');
+            }
+            if (haveLength && contentLength != contentLength_) {
+                fail(400);
+                return false;
+            }
+            haveLength = true;
+            contentLength_ = contentLength;
+            if (contentLength_ > limits_.maxBodyBytes) {
+                fail(413);
+                return false;
+            }
+        } else if (field.name.equalsIgnoreCase("Transfer-Encoding")) {
+            fail(501); // Chunked request bodies are not supported
+            return false;
+        } else if (field.name.equalsIgnoreCase("Connection")) {
+            if (containsIgnoreCase(field.value, "close")) {
+                keepAlive_ = false;
+            } else if (containsIgnoreCase(field.value, "keep-alive")) {
+                keepAlive_ = true;
+            }
+        }
+
+        line = next + 2;
+    }
+
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef HTTP_REQUEST_PARSER_H
+#define HTTP_REQUEST_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "MockWebServer.h"
+
+// Incremental HTTP/1.x request parser, one instance per connection. feed() is handed the
+// connection's unconsumed bytes each time more arrive; it resumes the header-terminator
+// search where the previous call stopped, parses the head once, then waits for the body
+// (Content-Length only). After COMPLETE, consumed() bytes belong to this request and the
+// rest (a pipelined request) stays in the caller's buffer; call reset() before the next.
+// Nothing is copied: view() slices the bytes passed to the completing feed() call and is
+// valid until that buffer changes. Headers go into a flat array, in arrival order.
+class HttpRequestParser {
+public:
+    enum class Result {
+        NEED_MORE,
+        COMPLETE,
+        ERROR
+    };
+
+    struct Limits {
+        size_t maxHeaderBytes = 8192;
+        size_t maxBodyBytes = 64 * 1024;
+        size_t maxHeaders = 32;
+    };
+
+    HttpRequestParser() = default;
+    explicit HttpRequestParser(const Limits& limits) : limits_(limits) {}
+
+    void setLimits(const Limits& limits) { limits_ = limits; }
+
+    Result feed(const char* data, size_t length);
+    void reset();
+
+    // Valid after COMPLETE.
+    const MockWebServer::RequestView& view() const { return view_; }
+    MockWebServer::RequestView& view() { return view_; }
+    // Materialized copy of view(), built on first use.
+    const MockWebServer::HttpRequest& request() const { return view_.request(); }
+    size_t consumed() const { return headBytes_ + contentLength_; }
+    bool keepAlive() const { return keepAlive_; }
+    // HTTP/1.0 clients cannot take a chunked response body.
+    bool isHttp10() const { return http10_; }
+
+    // Valid after ERROR: the status to answer with before closing (400, 413, 431, 501, 505).
+    int errorStatus() const { return errorStatus_; }
+
+private:
+    Limits limits_;
+    MockWebServer::RequestView view_;
+    size_t scanned_ = 0;
+    size_t headBytes_ = 0;
+    size_t contentLength_ = 0;
+    bool headParsed_ = false;
+    bool keepAlive_ = true;
+    bool http10_ = false;
+    int errorStatus_ = 0;
+
+    Result fail(int status);
+    bool parseHead(const char* data, size_t length);
+};
+
+#endif // HTTP_REQUEST_PARSER_H
@@ -0,0 +1,346 @@
+#include "HttpRouter.h"
+
+#include <cstring>
+
+const size_t HttpRouter::kMaxParams;
+const size_t HttpRouter::kParamTypeCount;
+
+HttpRouter::Node::Node() {
+    for (size_t i = 0; i < METHOD_COUNT; ++i) {
+        routes[i] = -1;
+    }
+}
+
+HttpRouter::HttpRouter() : root_(new Node()) {
+}
+
+HttpRouter::~HttpRouter() = default;
+
+void HttpRouter::clear() {
+    root_.reset(new Node());
+    routeCount_ = 0;
+}
+
+HttpRouter::MethodId HttpRouter::methodId(const char* method, size_t length) {
+    switch (length) {
+        case 3:
+            if (std::memcmp(method, "GET", 3) == 0) return METHOD_GET;
+            if (std::memcmp(method, "PUT", 3) == 0) return METHOD_PUT;
+            break;
+        case 4:
+            if (std::memcmp(method, "POST", 4) == 0) return METHOD_POST;
+            if (std::memcmp(method, "HEAD", 4) == 0) return METHOD_HEAD;
+            break;
+        case 5:
+            if (std::memcmp(method, "PATCH", 5) == 0) return METHOD_PATCH;
+            break;
+        case 6:
+            if (std::memcmp(method, "DELETE", 6) == 0) return METHOD_DELETE;
+            break;
+        case 7:
+            if (std::memcmp(method, "OPTIONS", 7) == 0) return METHOD_OPTIONS;
+            break;
+    }
+    return METHOD_OTHER;
+}
+
+const char* HttpRouter::methodName(MethodId id) {
+    switch (id) {
+        case METHOD_GET: return "GET";
+        case METHOD_POST: return "POST";
+        case METHOD_PUT: return "PUT";
+        case METHOD_DELETE: return "DELETE";
+        case METHOD_PATCH: return "PATCH";
+        case METHOD_HEAD: return "HEAD";
+        case METHOD_OPTIONS: return "OPTIONS";
+        default: return "";
+    }
+}
+
+bool HttpRouter::matchesType(ParamType type, const char* segment, size_t length) {
+    if (length == 0) {
+        return false;
+    }
+
+    size_t i = 0;
+    switch (type) {
+        case ParamType::INT:
+            if (segment[0] == '-') {
+                if (length == 1) {
+                    return false;
+                }
+                i = 1;
+            }
+            // fallthrough
+        case ParamType::UINT:
+            for (; i < length; ++i) {
+                if (segment[i] < '0' || segment[i] > '9') {
+                    return false;
+                }
+            }
+            return true;
+        case ParamType::STRING:
+        case ParamType::REST:
+            return true;
+    }
+    return false;
+}
+
+HttpRouter::Node* HttpRouter::insertStatic(Node* node, const std::string& text) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t slot = node->children.size();
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            if (node->children[i]->label[0] == text[pos]) {
+                slot = i;
+                break;
+            }
+        }
+
+        if (slot == node->children.size()) {
+            std::unique_ptr<Node> child(new Node());
+            child->label = text.substr(pos);
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+
+        Node* child = node->children[slot].get();
+        size_t common = 0;
+        while (common < child->label.size() && pos + common < text.size() &&
+               child->label[common] == text[pos + common]) {
+            ++common;
+        }
+
+        if (common < child->label.size()) {
+            // Split the edge: the shared prefix becomes a new node above the old child.
+            std::unique_ptr<Node> split(new Node());
+            split->label = child->label.substr(0, common);
+            node->children[slot]->label.erase(0, common);
+            split->children.push_back(std::move(node->children[slot]));
+            node->children[slot] = std::move(split);
+            child = node->children[slot].get();
+        }
+
+        node = child;
+        pos += common;
+    }
+    return node;
+}
+
+bool HttpRouter::add(const std::string& method, const std::string& pattern, int routeId,
+                     std::vector<std::string>* paramNames) {
+    if (pattern.empty() || pattern[0] != '/' || method.empty() || routeId < 0) {
+        return false;
+    }
+
+    std::vector<std::string> names;
+    Node* node = root_.get();
+    size_t pos = 0;
+
+    while (pos < pattern.size()) {
+        const size_t open = pattern.find('{', pos);
+        if (open == std::string::npos) {
+            node = insertStatic(node, pattern.substr(pos));
+            break;
+        }
+
+        // A parameter must be a whole segment: "/{name}" followed by "/" or the end.
+        const size_t close = pattern.find('}', open);
+        if (close == std::string::npos || pattern[open - 1] != '/' ||
+            (close + 1 < pattern.size() && pattern[close + 1] != '/')) {
+            return false;
+        }
+        if (open > pos) {
+            node = insertStatic(node, pattern.substr(pos, open - pos));
+        }
+
+        std::string name = pattern.substr(open + 1, close - open - 1);
+        std::string type = "str";
+        const size_t colon = name.find(':');
+        if (colon != std::string::npos) {
+            type = name.substr(colon + 1);
+            name.erase(colon);
+        }
+        if (name.empty() || names.size() == kMaxParams) {
+            return false;
+        }
+
+        if (type == "*") {
+            if (close + 1 != pattern.size()) {
+                return false;
+            }
+            if (!node->rest) {
+                node->rest.reset(new Node());
+            }
+            node = node->rest.get();
+        } else {
+            ParamType paramType;
+            if (type == "uint") {
+                paramType = ParamType::UINT;
+            } else if (type == "int") {
+                paramType = ParamType::INT;
+            } else if (type == "str") {
+                paramType = ParamType::STRING;
+            } else {
+                return false;
+            }
+
+            std::unique_ptr<Node>& child = node->params[static_cast<size_t>(paramType)];
+            if (!child) {
+                child.reset(new Node());
+            }
+            node = child.get();
+        }
+
+        names.push_back(name);
+        pos = close + 1;
+    }
+
+    const MethodId id = methodId(method.data(), method.size());
+    if (id == METHOD_OTHER) {
+        for (const auto& other : node->otherRoutes) {
+            if (other.first == method) {
+                return false;
+            }
+        }
+        node->otherRoutes.push_back(std::make_pair(method, routeId));
+    } else {
+        if (node->routes[id] >= 0) {
+            return false;
+        }
+        node->routes[id] = routeId;
+    }
+
+    node->hasRoutes = true;
+    ++routeCount_;
+    if (paramNames) {
+        paramNames->insert(paramNames->end(), names.begin(), names.end());
+    }
+    return true;
+}
+
+int HttpRouter::routeFor(const Node* node, MethodId method, const Text& methodText) {
+    if (method != METHOD_OTHER) {
+        return node->routes[method];
+    }
+    for (const auto& other : node->otherRoutes) {
+        if (other.first.size() == methodText.length &&
+            std::memcmp(other.first.data(), methodText.data, methodText.length) == 0) {
+            return other.second;
+        }
+    }
+    return -1;
+}
+
+std::string HttpRouter::allowedMethods(const Node* node) {
+    std::string allow;
+    for (size_t i = 0; i < METHOD_COUNT; ++i) {
+        if (node->routes[i] >= 0) {
+            if (!allow.empty()) {
+                allow += ", ";
+            }
+            allow += methodName(static_cast<MethodId>(i));
+        }
+    }
+    for (const auto& other : node->otherRoutes) {
+        if (!allow.empty()) {
+            allow += ", ";
+        }
+        allow += other.first;
+    }
+    return allow;
+}
+
+bool HttpRouter::match(const Node* node, const Text& path, size_t pos, MethodId method, const Text& methodText,
+                       Match& result, const Node*& pathOnly) const {
+    if (pos == path.length) {
+        if (!node->hasRoutes) {
+            return false;
+        }
+        result.route = routeFor(node, method, methodText);
+        if (result.route >= 0) {
+            return true;
+        }
+        if (!pathOnly) {
+            pathOnly = node;
+        }
+        return false;
+    }
+
+    // Radix property: at most one static child starts with this character.
+    for (const auto& child : node->children) {
+        const std::string& label = child->label;
+        if (label[0] == path.data[pos]) {
+            if (label.size() <= path.length - pos && std::memcmp(path.data + pos, label.data(), label.size()) == 0 &&
+                match(child.get(), path, pos + label.size(), method, methodText, result, pathOnly)) {
+                return true;
+            }
+            break;
+        }
+    }
+
+    if (result.paramCount == kMaxParams) {
+        return false;
+    }
+
+    const char* slash = static_cast<const char*>(std::memchr(path.data + pos, '/', path.length - pos));
+    const size_t end = slash ? static_cast<size_t>(slash - path.data) : path.length;
+
+    Param& param = result.params[result.paramCount];
+    for (size_t type = 0; type < kParamTypeCount; ++type) {
+        const Node* child = node->params[type].get();
+        if (!child || !matchesType(static_cast<ParamType>(type), path.data + pos, end - pos)) {
+            continue;
+        }
+        param.offset = static_cast<uint16_t>(pos);
+        param.length = static_cast<uint16_t>(end - pos);
+        ++result.paramCount;
+        if (match(child, path, end, method, methodText, result, pathOnly)) {
+            return true;
+        }
+        --result.paramCount;
+    }
+
+    if (node->rest) {
+        param.offset = static_cast<uint16_t>(pos);
+        param.length = static_cast<uint16_t>(path.length - pos);
+        ++result.paramCount;
+        if (match(node->rest.get(), path, path.length, method, methodText, result, pathOnly)) {
+            return true;
+        }
+        --result.paramCount;
+    }
+
+    return false;
+}
+
+bool HttpRouter::find(const std::string& method, const std::string& path, Match& result) const {
+    return find(method.data(), method.size(), path.data(), path.size(), result);
+}
+
+bool HttpRouter::find(const char* method, size_t methodLength, const char* path, size_t pathLength,
+                      Match& result) const {
+    result.route = -1;
+    result.pathMatched = false;
+    result.paramCount = 0;
+    result.allow.clear();
+
+    if (pathLength == 0 || pathLength > 0xFFFF) {
+        return false;
+    }
+
+    const Text pathText = {path, pathLength};
+    const Text methodText = {method, methodLength};
+    const Node* pathOnly = nullptr;
+    if (match(root_.get(), pathText, 0, methodId(method, methodLength), methodText, result, pathOnly)) {
+        result.pathMatched = true;
+        return true;
+    }
+
+    result.paramCount = 0;
+    if (pathOnly) {
+        result.pathMatched = true;
+        result.allow = allowedMethods(pathOnly);
+    }
+    return false;
+}
@@ -0,0 +1,116 @@
+#ifndef HTTP_ROUTER_H
+#define HTTP_ROUTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef HTTP_ROUTER_MAX_PARAMS
+#define HTTP_ROUTER_MAX_PARAMS 8
+#endif
+
+// Radix tree over route patterns, built as routes are registered. Static path text is stored
+// on compressed edges; a segment may instead be a typed parameter:
+//
+//   /api/sensors/{index:uint}     unsigned decimal
+//   /api/offset/{delta:int}       signed decimal
+//   /api/tags/{name} or {name:str} any non-empty segment
+//   /static/{file:*}              the rest of the path (last segment only)
+//
+// Each node keeps its own method table, so the method is resolved in O(1) once the path is
+// matched. Static edges win over parameters, and int/uint over str. Lookups do not allocate;
+// captured parameters are returned as offsets into the request path.
+class HttpRouter {
+public:
+    static const size_t kMaxParams = HTTP_ROUTER_MAX_PARAMS;
+
+    enum class ParamType : uint8_t {
+        UINT,
+        INT,
+        STRING,
+        REST
+    };
+
+    struct Param {
+        uint16_t offset = 0;
+        uint16_t length = 0;
+    };
+
+    struct Match {
+        int route = -1;           // Route id passed to add(), or -1
+        bool pathMatched = false; // A pattern matched the path, maybe not for this method
+        size_t paramCount = 0;
+        Param params[kMaxParams];
+        std::string allow;        // Methods the path accepts, filled when route == -1 but pathMatched
+    };
+
+    HttpRouter();
+    ~HttpRouter();
+
+    HttpRouter(const HttpRouter&) = delete;
+    HttpRouter& operator=(const HttpRouter&) = delete;
+
+    // Register `pattern` for `method` under `routeId`. Parameter names are appended to
+    // paramNames in path order. Returns false if the pattern is malformed or the
+    // method/pattern pair is already taken (the first registration is kept).
+    bool add(const std::string& method, const std::string& pattern, int routeId,
+             std::vector<std::string>* paramNames = nullptr);
+
+    bool find(const std::string& method, const std::string& path, Match& match) const;
+    // Same lookup over unowned bytes, e.g. slices of a receive buffer.
+    bool find(const char* method, size_t methodLength, const char* path, size_t pathLength, Match& match) const;
+
+    size_t size() const { return routeCount_; }
+    void clear();
+
+    enum MethodId : uint8_t {
+        METHOD_GET,
+        METHOD_POST,
+        METHOD_PUT,
+        METHOD_DELETE,
+        METHOD_PATCH,
+        METHOD_HEAD,
+        METHOD_OPTIONS,
+        METHOD_COUNT,
+        METHOD_OTHER = METHOD_COUNT
+    };
+
+    static MethodId methodId(const char* method, size_t length);
+    static const char* methodName(MethodId id); // "" for METHOD_OTHER
+
+private:
+    static const size_t kParamTypeCount = 3; // UINT, INT, STRING; REST has its own slot
+
+    struct Node {
+        std::string label; // Static text consumed on the edge into this node
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> params[kParamTypeCount];
+        std::unique_ptr<Node> rest;
+        int routes[METHOD_COUNT];
+        std::vector<std::pair<std::string, int>> otherRoutes;
+        bool hasRoutes = false;
+
+        Node();
+    };
+
+    std::unique_ptr<Node> root_;
+    size_t routeCount_ = 0;
+
+    struct Text {
+        const char* data;
+        size_t length;
+    };
+
+    static bool matchesType(ParamType type, const char* segment, size_t length);
+
+    Node* insertStatic(Node* node, const std::string& text);
+    bool match(const Node* node, const Text& path, size_t pos, MethodId method, const Text& methodText, Match& match,
+               const Node*& pathOnly) const;
+    static int routeFor(const Node* node, MethodId method, const Text& methodText);
+    static std::string allowedMethods(const Node* node);
+};
+
+#endif // HTTP_ROUTER_H
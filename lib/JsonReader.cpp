@@ -0,0 +1,377 @@
+#include "JsonReader.h"
+
+#include <cstring>
+
+const size_t JsonReader::kMaxDepth;
+
+namespace {
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+void appendUtf8(uint32_t codepoint, std::string& out) {
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+} // namespace
+
+bool JsonReader::Token::is(const char* s) const {
+    return std::strlen(s) == length && std::memcmp(text, s, length) == 0;
+}
+
+bool JsonReader::parse(const char* data, size_t length, const Handler& handler) {
+    data_ = data;
+    length_ = length;
+    pos_ = 0;
+    handler_ = &handler;
+    error_ = Error();
+
+    skipWhitespace();
+    if (!parseValue(0)) {
+        return false;
+    }
+    skipWhitespace();
+    if (pos_ != length_) {
+        return fail(pos_, "unexpected data after the document");
+    }
+    return true;
+}
+
+std::string JsonReader::errorString() const {
+    if (!error_.message) {
+        return std::string();
+    }
+    return "offset " + std::to_string(error_.offset) + ": " + error_.message;
+}
+
+bool JsonReader::fail(size_t offset, const char* message) {
+    error_.offset = offset;
+    error_.message = message;
+    return false;
+}
+
+bool JsonReader::emit(Token& token) {
+    const char* message = (*handler_)(token);
+    return message ? fail(token.offset, message) : true;
+}
+
+void JsonReader::skipWhitespace() {
+    while (pos_ < length_) {
+        const char c = data_[pos_];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            return;
+        }
+        ++pos_;
+    }
+}
+
+bool JsonReader::parseValue(size_t depth) {
+    if (pos_ >= length_) {
+        return fail(pos_, "unexpected end of input");
+    }
+    switch (data_[pos_]) {
+        case '{': return parseObject(depth);
+        case '[': return parseArray(depth);
+        case '"': return parseString(depth, Event::STRING);
+        case 't':
+        case 'f':
+        case 'n': return parseLiteral(depth);
+        default:
+            if (data_[pos_] == '-' || isDigit(data_[pos_])) {
+                return parseNumber(depth);
+            }
+            return fail(pos_, "expected a value");
+    }
+}
+
+bool JsonReader::parseObject(size_t depth) {
+    if (depth >= kMaxDepth) {
+        return fail(pos_, "nesting too deep");
+    }
+    Token token;
+    token.event = Event::OBJECT_START;
+    token.offset = pos_++;
+    token.depth = depth;
+    if (!emit(token)) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (pos_ < length_ && data_[pos_] == '}') {
+        token.event = Event::OBJECT_END;
+        token.offset = pos_++;
+        return emit(token);
+    }
+
+    for (;;) {
+        skipWhitespace();
+        if (pos_ >= length_ || data_[pos_] != '"') {
+            return fail(pos_, "expected a key");
+        }
+        if (!parseString(depth + 1, Event::KEY)) {
+            return false;
+        }
+        skipWhitespace();
+        if (pos_ >= length_ || data_[pos_] != ':') {
+            return fail(pos_, "expected ':'");
+        }
+        ++pos_;
+        skipWhitespace();
+        if (!parseValue(depth + 1)) {
+            return false;
+        }
+        skipWhitespace();
+        if (pos_ >= length_) {
+            return fail(pos_, "unexpected end of input");
+        }
+        if (data_[pos_] == ',') {
+            ++pos_;
+            continue;
+        }
+        if (data_[pos_] != '}') {
+            return fail(pos_, "expected ',' or '}'");
+        }
+        token.event = Event::OBJECT_END;
+        token.offset = pos_++;
+        return emit(token);
+    }
+}
+
+bool JsonReader::parseArray(size_t depth) {
+    if (depth >= kMaxDepth) {
+        return fail(pos_, "nesting too deep");
+    }
+    Token token;
+    token.event = Event::ARRAY_START;
+    token.offset = pos_++;
+    token.depth = depth;
+    if (!emit(token)) {
+        return false;
+    }
+
+    skipWhitespace();
+    if (pos_ < length_ && data_[pos_] == ']') {
+        token.event = Event::ARRAY_END;
+        token.offset = pos_++;
+        return emit(token);
+    }
+
+    for (;;) {
+        skipWhitespace();
+        if (!parseValue(depth + 1)) {
+            return false;
+        }
+        skipWhitespace();
+        if (pos_ >= length_) {
+            return fail(pos_, "unexpected end of input");
+        }
+        if (data_[pos_] == ',') {
+            ++pos_;
+            continue;
+        }
+        if (data_[pos_] != ']') {
+            return fail(pos_, "expected ',' or ']'");
+        }
+        token.event = Event::ARRAY_END;
+        token.offset = pos_++;
+        return emit(token);
+    }
+}
+
+bool JsonReader::parseString(size_t depth, Event event) {
+    Token token;
+    token.event = event;
+    token.offset = pos_++;
+    token.depth = depth;
+
+    // Strings without escapes are handed out in place; only escapes go through scratch_.
+    const size_t start = pos_;
+    bool escaped = false;
+    scratch_.clear();
+
+    while (pos_ < length_) {
+        const char c = data_[pos_];
+        if (c == '"') {
+            if (escaped) {
+                token.text = scratch_.data();
+                token.length = scratch_.size();
+            } else {
+                token.text = data_ + start;
+                token.length = pos_ - start;
+            }
+            ++pos_;
+            return emit(token);
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            return fail(pos_, "control character in string");
+        }
+        if (c != '\\') {
+            if (escaped) {
+                scratch_ += c;
+            }
+            ++pos_;
+            continue;
+        }
+
+        if (!escaped) {
+            scratch_.assign(data_ + start, pos_ - start);
+            escaped = true;
+        }
+        const size_t escapeAt = pos_;
+        if (++pos_ >= length_) {
+            break;
+        }
+        switch (data_[pos_++]) {
+            case '"': scratch_ += '"'; break;
+            case '\\': scratch_ += '\\'; break;
+            case '/': scratch_ += '/'; break;
+            case 'b': scratch_ += '\b'; break;
+            case 'f': scratch_ += '\f'; break;
+            case 'n': scratch_ += '\n'; break;
+            case 'r': scratch_ += '\r'; break;
+            case 't': scratch_ += '\t'; break;
+            case 'u': {
+                uint32_t codepoint = 0;
+                for (int half = 0; half < 2; ++half) {
+                    if (pos_ + 4 > length_) {
+                        return fail(escapeAt, "truncated \\u escape");
+                    }
+                    uint32_t unit = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        const int digit = hexValue(data_[pos_ + i]);
+                        if (digit < 0) {
+                            return fail(escapeAt, "invalid \\u escape");
+                        }
+                        unit = (unit << 4) | static_cast<uint32_t>(digit);
+                    }
+                    pos_ += 4;
+
+                    if (half == 0) {
+                        if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                            return fail(escapeAt, "unpaired surrogate");
+                        }
+                        if (unit < 0xD800 || unit > 0xDBFF) {
+                            codepoint = unit;
+                            break;
+                        }
+                        // High surrogate: a low one must follow.
+                        codepoint = unit;
+                        if (pos_ + 2 > length_ || data_[pos_] != '\\' || data_[pos_ + 1] != 'u') {
+                            return fail(escapeAt, "unpaired surrogate");
+                        }
+                        pos_ += 2;
+                    } else {
+                        if (unit < 0xDC00 || unit > 0xDFFF) {
+                            return fail(escapeAt, "unpaired surrogate");
+                        }
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (unit - 0xDC00);
+                    }
+                }
+                appendUtf8(codepoint, scratch_);
+                break;
+            }
+            default:
+                return fail(escapeAt, "invalid escape");
+        }
+    }
+    return fail(token.offset, "unterminated string");
+}
+
+bool JsonReader::parseNumber(size_t depth) {
+    Token token;
+    token.event = Event::NUMBER;
+    token.offset = pos_;
+    token.depth = depth;
+
+    if (data_[pos_] == '-') {
+        ++pos_;
+    }
+    if (pos_ >= length_ || !isDigit(data_[pos_])) {
+        return fail(token.offset, "invalid number");
+    }
+    if (data_[pos_] == '0') {
+        ++pos_;
+        if (pos_ < length_ && isDigit(data_[pos_])) {
+            return fail(token.offset, "leading zero in number");
+        }
+    } else {
+        while (pos_ < length_ && isDigit(data_[pos_])) {
+            ++pos_;
+        }
+    }
+    if (pos_ < length_ && data_[pos_] == '.') {
+        ++pos_;
+        if (pos_ >= length_ || !isDigit(data_[pos_])) {
+            return fail(token.offset, "invalid number");
+        }
+        while (pos_ < length_ && isDigit(data_[pos_])) {
+            ++pos_;
+        }
+    }
+    if (pos_ < length_ && (data_[pos_] == 'e' || data_[pos_] == 'E')) {
+        ++pos_;
+        if (pos_ < length_ && (data_[pos_] == '+' || data_[pos_] == '-')) {
+            ++pos_;
+        }
+        if (pos_ >= length_ || !isDigit(data_[pos_])) {
+            return fail(token.offset, "invalid number");
+        }
+        while (pos_ < length_ && isDigit(data_[pos_])) {
+            ++pos_;
+        }
+    }
+
+    token.text = data_ + token.offset;
+    token.length = pos_ - token.offset;
+    return emit(token);
+}
+
+bool JsonReader::parseLiteral(size_t depth) {
+    static const struct {
+        const char* text;
+        Event event;
+        bool value;
+    } kLiterals[] = {{"true", Event::BOOL, true}, {"false", Event::BOOL, false}, {"null", Event::NULL_VALUE, false}};
+
+    for (const auto& literal : kLiterals) {
+        const size_t n = std::strlen(literal.text);
+        if (length_ - pos_ >= n && std::memcmp(data_ + pos_, literal.text, n) == 0) {
+            Token token;
+            token.event = literal.event;
+            token.boolean = literal.value;
+            token.text = data_ + pos_;
+            token.length = n;
+            token.offset = pos_;
+            token.depth = depth;
+            pos_ += n;
+            return emit(token);
+        }
+    }
+    return fail(pos_, "expected a value");
+}
@@ -0,0 +1,75 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Single-pass, SAX-style JSON reader (RFC 8259). parse() walks the document once and hands
+// each token to a handler as it is recognised; nothing is built up, so memory use is one
+// reusable buffer for unescaped strings however large the input. Errors carry the byte
+// offset where the document went wrong. Inputs are untrusted (settings uploads), so the
+// reader bounds nesting and never reads past `length`; see test/fuzz for the fuzz target.
+class JsonReader {
+public:
+    enum class Event : uint8_t {
+        OBJECT_START,
+        OBJECT_END,
+        ARRAY_START,
+        ARRAY_END,
+        KEY,
+        STRING,
+        NUMBER,
+        BOOL,
+        NULL_VALUE
+    };
+
+    struct Token {
+        Event event;
+        const char* text = nullptr; // KEY/STRING: unescaped UTF-8; NUMBER: the literal as written
+        size_t length = 0;          // Valid only during the handler call
+        bool boolean = false;       // BOOL
+        size_t offset = 0;          // Byte offset of the token in the input
+        size_t depth = 0;           // Containers enclosing the token
+
+        bool is(const char* s) const;
+    };
+
+    struct Error {
+        size_t offset = 0;
+        const char* message = nullptr; // nullptr after a successful parse
+    };
+
+    // Returns nullptr to continue, or a message to stop with an error at the token.
+    using Handler = std::function<const char*(const Token& token)>;
+
+    static const size_t kMaxDepth = 32;
+
+    bool parse(const char* data, size_t length, const Handler& handler);
+    bool parse(const std::string& json, const Handler& handler) { return parse(json.data(), json.size(), handler); }
+
+    const Error& error() const { return error_; }
+    // "offset 12: expected ':'", or "" after success.
+    std::string errorString() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t length_ = 0;
+    size_t pos_ = 0;
+    const Handler* handler_ = nullptr;
+    std::string scratch_;
+    Error error_;
+
+    bool fail(size_t offset, const char* message);
+    bool emit(Token& token);
+    void skipWhitespace();
+    bool parseValue(size_t depth);
+    bool parseObject(size_t depth);
+    bool parseArray(size_t depth);
+    bool parseString(size_t depth, Event event);
+    bool parseNumber(size_t depth);
+    bool parseLiteral(size_t depth);
+};
+
+#endif // JSON_READER_H
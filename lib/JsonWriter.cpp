@@ -0,0 +1,169 @@
+#include "JsonWriter.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const size_t JsonWriter::kMaxDepth;
+
+void JsonWriter::newline() {
+    if (!pretty_) {
+        return;
+    }
+    out_ += '\n';
+    out_.append(depth_ * 2, ' ');
+}
+
+void JsonWriter::beforeValue() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (depth_ > 0) {
+        if (!first_[depth_]) {
+            out_ += ',';
+        }
+        first_[depth_] = false;
+        newline();
+    }
+}
+
+void JsonWriter::open(char bracket) {
+    beforeValue();
+    out_ += bracket;
+    if (depth_ < kMaxDepth) {
+        ++depth_;
+    }
+    first_[depth_] = true;
+}
+
+void JsonWriter::close(char bracket) {
+    const bool empty = first_[depth_];
+    if (depth_ > 0) {
+        --depth_;
+    }
+    if (!empty) {
+        newline();
+    }
+    out_ += bracket;
+}
+
+void JsonWriter::key(const char* name) {
+    beforeValue();
+    out_ += '"';
+    appendEscaped(name, std::strlen(name), out_);
+    out_ += pretty_ ? "\": " : "\":";
+    afterKey_ = true;
+}
+
+void JsonWriter::key(const std::string& name) {
+    beforeValue();
+    out_ += '"';
+    appendEscaped(name.data(), name.size(), out_);
+    out_ += pretty_ ? "\": " : "\":";
+    afterKey_ = true;
+}
+
+void JsonWriter::value(const char* text) {
+    beforeValue();
+    out_ += '"';
+    appendEscaped(text, std::strlen(text), out_);
+    out_ += '"';
+}
+
+void JsonWriter::value(const std::string& text) {
+    beforeValue();
+    out_ += '"';
+    appendEscaped(text.data(), text.size(), out_);
+    out_ += '"';
+}
+
+void JsonWriter::value(bool boolean) {
+    beforeValue();
+    out_ += boolean ? "true" : "false";
+}
+
+void JsonWriter::value(int number) {
+    value(static_cast<int64_t>(number));
+}
+
+void JsonWriter::value(unsigned int number) {
+    value(static_cast<uint64_t>(number));
+}
+
+void JsonWriter::value(int64_t number) {
+    char text[24];
+    std::snprintf(text, sizeof(text), "%" PRId64, number);
+    appendNumber(text);
+}
+
+void JsonWriter::value(uint64_t number) {
+    char text[24];
+    std::snprintf(text, sizeof(text), "%" PRIu64, number);
+    appendNumber(text);
+}
+
+void JsonWriter::value(float number) {
+    if (!std::isfinite(number)) {
+        null();
+        return;
+    }
+    char text[32];
+    for (int precision = 6; precision <= 9; ++precision) {
+        std::snprintf(text, sizeof(text), "%.*g", precision, static_cast<double>(number));
+        if (std::strtof(text, nullptr) == number) {
+            break;
+        }
+    }
+    appendNumber(text);
+}
+
+void JsonWriter::value(double number) {
+    if (!std::isfinite(number)) {
+        null();
+        return;
+    }
+    char text[32];
+    for (int precision = 15; precision <= 17; ++precision) {
+        std::snprintf(text, sizeof(text), "%.*g", precision, number);
+        if (std::strtod(text, nullptr) == number) {
+            break;
+        }
+    }
+    appendNumber(text);
+}
+
+void JsonWriter::null() {
+    beforeValue();
+    out_ += "null";
+}
+
+void JsonWriter::appendNumber(const char* text) {
+    beforeValue();
+    out_ += text;
+}
+
+void JsonWriter::appendEscaped(const char* text, size_t length, std::string& out) {
+    static const char kHex[] = "0123456789abcdef";
+    for (size_t i = 0; i < length; ++i) {
+        const char c = text[i];
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    const char escaped[6] = {'\\', 'u', '0', '0', kHex[(c >> 4) & 0x0F], kHex[c & 0x0F]};
+                    out.append(escaped, sizeof(escaped));
+                } else {
+                    out += c;
+                }
+        }
+    }
+}
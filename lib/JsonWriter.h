@@ -0,0 +1,53 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Streaming JSON writer, the counterpart of JsonReader: values are appended to a caller's
+// string as they are written, with commas, escaping and (optionally) two-space indentation
+// handled here. Floats are written with the fewest digits that read back to the same value.
+// The caller is trusted to nest calls correctly; nothing is validated beyond depth.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out, bool pretty = false) : out_(out), pretty_(pretty) {}
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    void key(const char* name);
+    void key(const std::string& name);
+
+    void value(const char* text);
+    void value(const std::string& text);
+    void value(bool boolean);
+    void value(int number);
+    void value(unsigned int number);
+    void value(int64_t number);
+    void value(uint64_t number);
+    void value(float number);  // NaN and infinities become null
+    void value(double number);
+    void null();
+
+    static void appendEscaped(const char* text, size_t length, std::string& out);
+
+private:
+    static const size_t kMaxDepth = 32;
+
+    std::string& out_;
+    bool pretty_;
+    size_t depth_ = 0;
+    bool first_[kMaxDepth + 1] = {true};
+    bool afterKey_ = false;
+
+    void beforeValue();
+    void newline();
+    void open(char bracket);
+    void close(char bracket);
+    void appendNumber(const char* text);
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,285 @@
+#include "LogArchive.h"
+
+#include <cstring>
+
+static_assert(LOGGER_ARCHIVE_WINDOW_BYTES >= 256 && LOGGER_ARCHIVE_WINDOW_BYTES < 0xFFFF,
+              "LOGGER_ARCHIVE_WINDOW_BYTES must hold one message and fit a uint16 position");
+
+const size_t LogArchive::kBlockBytes;
+const size_t LogArchive::kWindowBytes;
+const size_t LogArchive::kMaxTextLength;
+const size_t LogArchive::kHashSize;
+
+namespace {
+// Worst case for one encoded entry: varint header fields plus text where every 3-byte match
+// costs a literal count, an offset and a length.
+const size_t kMaxEncodedBytes = 32 + 3 * LogArchive::kMaxTextLength;
+
+static_assert(LOGGER_ARCHIVE_BLOCK_BYTES >= 32 + 3 * 255 && LOGGER_ARCHIVE_BLOCK_BYTES <= 0xFFFF,
+              "LOGGER_ARCHIVE_BLOCK_BYTES must hold one worst-case entry and fit a uint16");
+
+const size_t kMinMatch = 3;
+const uint8_t kTagEscape = 63;
+
+size_t putVarint(uint8_t* out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+uint64_t getVarint(const uint8_t* data, size_t& offset) {
+    uint64_t value = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+        byte = data[offset++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+    } while ((byte & 0x80) && shift < 64);
+    return value;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+size_t hash3(const char* p) {
+    const uint32_t v = static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8) |
+                       (static_cast<uint32_t>(static_cast<uint8_t>(p[2])) << 16);
+    return (v * 2654435761u) >> 22; // Top 10 bits: kHashSize == 1024
+}
+} // namespace
+
+LogArchive::LogArchive(size_t capacityBytes) : window_(kWindowBytes), readWindow_(kWindowBytes) {
+    size_t blockCount = capacityBytes / kBlockBytes;
+    if (blockCount < 2) {
+        blockCount = 2; // One sealed block plus the open one
+    }
+    blocks_.resize(blockCount);
+    data_.resize(blockCount * kBlockBytes);
+    std::memset(hash_, 0, sizeof(hash_));
+}
+
+void LogArchive::clear() {
+    head_ = 0;
+    count_ = 0;
+    entries_ = 0;
+    windowUsed_ = 0;
+}
+
+void LogArchive::rebase(uint64_t delta) {
+    for (size_t i = 0; i < count_; ++i) {
+        Block& block = blocks_[blockAt(i)];
+        block.firstSequence += delta;
+        block.lastSequence += delta;
+    }
+    lastSequence_ += delta;
+}
+
+uint64_t LogArchive::oldestSequence() const {
+    return count_ > 0 ? blocks_[head_].firstSequence : 0;
+}
+
+LogArchive::Stats LogArchive::getStats() const {
+    Stats stats;
+    stats.entries = entries_;
+    stats.entriesDropped = entriesDropped_;
+    stats.blocks = count_;
+    for (size_t i = 0; i < count_; ++i) {
+        const Block& block = blocks_[blockAt(i)];
+        stats.usedBytes += block.used;
+        stats.rawBytes += block.rawBytes;
+    }
+    stats.memoryBytes = data_.size() + blocks_.size() * sizeof(Block) + window_.size() + readWindow_.size() +
+                        sizeof(hash_);
+    return stats;
+}
+
+size_t LogArchive::firstBlockFor(uint64_t sequence) const {
+    // Blocks are in sequence order, so the first one that can hold `sequence` is the first
+    // whose last entry is not older than it.
+    size_t low = 0;
+    size_t high = count_;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (blocks_[blockAt(mid)].lastSequence < sequence) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void LogArchive::openBlock(uint64_t sequence, uint64_t timestampMs) {
+    if (count_ == blocks_.size()) {
+        entries_ -= blocks_[head_].entries;
+        entriesDropped_ += blocks_[head_].entries;
+        head_ = (head_ + 1) % blocks_.size();
+        --count_;
+    }
+
+    Block& block = blocks_[blockAt(count_)];
+    ++count_;
+    std::memset(&block, 0, sizeof(block));
+    block.firstSequence = sequence;
+    block.lastSequence = sequence;
+    block.firstTimestampMs = timestampMs;
+
+    windowUsed_ = 0;
+    std::memset(hash_, 0, sizeof(hash_));
+    lastSequence_ = sequence;
+    lastTimestampMs_ = timestampMs;
+}
+
+void LogArchive::append(uint64_t sequence, uint64_t timestampMs, uint8_t level, uint8_t tagIndex, const char* text,
+                        size_t length) {
+    if (length > kMaxTextLength) {
+        length = kMaxTextLength;
+    }
+
+    if (count_ == 0 || windowUsed_ + length > kWindowBytes) {
+        openBlock(sequence, timestampMs);
+    }
+
+    uint8_t encoded[kMaxEncodedBytes];
+    size_t n = encode(sequence, timestampMs, level, tagIndex, text, length, encoded);
+    if (n > kBlockBytes - blocks_[blockAt(count_ - 1)].used) {
+        openBlock(sequence, timestampMs);
+        n = encode(sequence, timestampMs, level, tagIndex, text, length, encoded);
+    }
+
+    const size_t index = blockAt(count_ - 1);
+    Block& block = blocks_[index];
+    std::memcpy(&data_[index * kBlockBytes + block.used], encoded, n);
+    block.used = static_cast<uint16_t>(block.used + n);
+    ++block.entries;
+    block.lastSequence = sequence;
+    block.rawBytes += static_cast<uint32_t>(length);
+    block.levelMask |= static_cast<uint8_t>(1u << level);
+    block.tagMask |= tagBit(tagIndex);
+
+    lastSequence_ = sequence;
+    lastTimestampMs_ = timestampMs;
+    ++entries_;
+}
+
+size_t LogArchive::encode(uint64_t sequence, uint64_t timestampMs, uint8_t level, uint8_t tagIndex,
+                          const char* text, size_t length, uint8_t* out) {
+    size_t n = 0;
+    n += putVarint(out + n, sequence - lastSequence_);
+    n += putVarint(out + n, zigzag(static_cast<int64_t>(timestampMs - lastTimestampMs_)));
+    if (tagIndex < kTagEscape) {
+        out[n++] = static_cast<uint8_t>((level << 6) | tagIndex);
+    } else {
+        out[n++] = static_cast<uint8_t>((level << 6) | kTagEscape);
+        out[n++] = tagIndex;
+    }
+    n += putVarint(out + n, length);
+
+    // The text joins the block window first so matches may overlap the current position.
+    char* base = window_.data();
+    const size_t pos = windowUsed_;
+    std::memcpy(base + pos, text, length);
+
+    size_t i = 0;
+    size_t literalStart = 0;
+    while (i + kMinMatch <= length) {
+        const size_t at = pos + i;
+        const size_t h = hash3(base + at);
+        const size_t candidate = hash_[h];
+        hash_[h] = static_cast<uint16_t>(at + 1);
+
+        if (candidate == 0 || std::memcmp(base + candidate - 1, base + at, kMinMatch) != 0) {
+            ++i;
+            continue;
+        }
+
+        const size_t from = candidate - 1;
+        size_t match = kMinMatch;
+        while (i + match < length && base[from + match] == base[at + match]) {
+            ++match;
+        }
+
+        n += putVarint(out + n, i - literalStart);
+        std::memcpy(out + n, text + literalStart, i - literalStart);
+        n += i - literalStart;
+        n += putVarint(out + n, at - from);
+        n += putVarint(out + n, match - kMinMatch);
+
+        for (size_t k = 1; k < match && i + k + kMinMatch <= length; ++k) {
+            hash_[hash3(base + at + k)] = static_cast<uint16_t>(at + k + 1);
+        }
+        i += match;
+        literalStart = i;
+    }
+
+    if (literalStart < length) {
+        n += putVarint(out + n, length - literalStart);
+        std::memcpy(out + n, text + literalStart, length - literalStart);
+        n += length - literalStart;
+    }
+
+    windowUsed_ += length;
+    return n;
+}
+
+LogArchive::Reader::Reader(const LogArchive& archive, size_t blockIndex, char* window)
+    : block_(archive.blocks_[blockIndex]),
+      data_(&archive.data_[blockIndex * kBlockBytes]),
+      window_(window),
+      sequence_(archive.blocks_[blockIndex].firstSequence),
+      timestampMs_(archive.blocks_[blockIndex].firstTimestampMs) {}
+
+bool LogArchive::Reader::next(View& view) {
+    if (decoded_ == block_.entries || offset_ >= block_.used) {
+        return false;
+    }
+
+    sequence_ += getVarint(data_, offset_);
+    timestampMs_ += static_cast<uint64_t>(unzigzag(getVarint(data_, offset_)));
+    const uint8_t packed = data_[offset_++];
+    uint8_t tagIndex = packed & kTagEscape;
+    if (tagIndex == kTagEscape) {
+        tagIndex = data_[offset_++];
+    }
+
+    const size_t length = static_cast<size_t>(getVarint(data_, offset_));
+    if (windowUsed_ + length > kWindowBytes) {
+        return false;
+    }
+
+    const size_t start = windowUsed_;
+    const size_t end = start + length;
+    while (windowUsed_ < end) {
+        const size_t literals = static_cast<size_t>(getVarint(data_, offset_));
+        std::memcpy(window_ + windowUsed_, data_ + offset_, literals);
+        offset_ += literals;
+        windowUsed_ += literals;
+
+        if (windowUsed_ < end) {
+            const size_t distance = static_cast<size_t>(getVarint(data_, offset_));
+            const size_t match = static_cast<size_t>(getVarint(data_, offset_)) + kMinMatch;
+            for (size_t k = 0; k < match; ++k, ++windowUsed_) {
+                window_[windowUsed_] = window_[windowUsed_ - distance];
+            }
+        }
+    }
+
+    ++decoded_;
+    view.sequence = sequence_;
+    view.timestampMs = timestampMs_;
+    view.level = packed >> 6;
+    view.tagIndex = tagIndex;
+    view.text = window_ + start;
+    view.length = length;
+    return true;
+}
@@ -0,0 +1,157 @@
+#ifndef LOG_ARCHIVE_H
+#define LOG_ARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef LOGGER_ARCHIVE_BLOCK_BYTES
+#define LOGGER_ARCHIVE_BLOCK_BYTES 1024
+#endif
+
+#ifndef LOGGER_ARCHIVE_WINDOW_BYTES
+#define LOGGER_ARCHIVE_WINDOW_BYTES 8192
+#endif
+
+// Compressed cold tier for Logger history. Entries evicted from the hot ring are appended
+// to fixed-size blocks: sequence and timestamp are delta-encoded varints, level and tag share
+// a byte, and message text is LZ77-compressed against everything already in the block, so
+// repetitive messages mostly become back-references. Blocks are independent, so readers
+// decode only the ones they need; when the archive is full the oldest block is dropped.
+class LogArchive {
+public:
+    static const size_t kBlockBytes = LOGGER_ARCHIVE_BLOCK_BYTES;
+    static const size_t kWindowBytes = LOGGER_ARCHIVE_WINDOW_BYTES; // Raw text per block
+    static const size_t kMaxTextLength = 255;
+
+    // Decoded entry; `text` points into the reader's window and is valid until the next one.
+    struct View {
+        uint64_t sequence = 0;
+        uint64_t timestampMs = 0;
+        uint8_t level = 0;
+        uint8_t tagIndex = 0;
+        const char* text = nullptr;
+        size_t length = 0;
+    };
+
+    struct Stats {
+        uint64_t entries = 0;
+        uint64_t entriesDropped = 0;
+        size_t blocks = 0;
+        size_t usedBytes = 0;     // Compressed bytes in live blocks
+        size_t rawBytes = 0;      // Uncompressed message text in live blocks
+        size_t memoryBytes = 0;   // Everything the archive allocates, including both windows
+    };
+
+    explicit LogArchive(size_t capacityBytes);
+
+    LogArchive(const LogArchive&) = delete;
+    LogArchive& operator=(const LogArchive&) = delete;
+
+    void append(uint64_t sequence, uint64_t timestampMs, uint8_t level, uint8_t tagIndex, const char* text,
+                size_t length);
+    void clear();
+
+    // Shift every stored sequence number up by `delta` (see Logger::advanceSequenceTo).
+    void rebase(uint64_t delta);
+
+    bool empty() const { return entries_ == 0; }
+    uint64_t size() const { return entries_; }
+    uint64_t oldestSequence() const;
+    Stats getStats() const;
+
+    // Visit entries with sequence >= fromSequence and level >= minLevel, oldest first,
+    // optionally limited to one tag index (tagIndex < 0 = all). Decoding starts at the block
+    // holding fromSequence, and blocks that cannot match are skipped without decoding.
+    // fn(const View&) returns false to stop. Decodes into a window owned by the archive, so
+    // callers must not query concurrently (Logger holds its history lock).
+    template <typename Fn>
+    void forEach(uint64_t fromSequence, uint8_t minLevel, int tagIndex, Fn fn) const;
+
+private:
+    struct Block {
+        uint64_t firstSequence;
+        uint64_t lastSequence;
+        uint64_t firstTimestampMs;
+        uint64_t tagMask; // Bit per tag index (indexes >= 63 share the top bit)
+        uint32_t rawBytes;
+        uint16_t used;
+        uint16_t entries;
+        uint8_t levelMask;
+    };
+
+    class Reader {
+    public:
+        Reader(const LogArchive& archive, size_t blockIndex, char* window);
+        bool next(View& view);
+
+    private:
+        const Block& block_;
+        const uint8_t* data_;
+        size_t offset_ = 0;
+        size_t decoded_ = 0;
+        char* window_;
+        size_t windowUsed_ = 0;
+        uint64_t sequence_;
+        uint64_t timestampMs_;
+    };
+
+    static const size_t kHashSize = 1024;
+
+    std::vector<Block> blocks_;
+    std::vector<uint8_t> data_;
+    size_t head_ = 0;   // Oldest block
+    size_t count_ = 0;  // Live blocks; the newest one is open for appends
+    uint64_t entries_ = 0;
+    uint64_t entriesDropped_ = 0;
+
+    // Encoder state for the open block: its raw text and a 3-byte prefix hash into it.
+    std::vector<char> window_;
+    size_t windowUsed_ = 0;
+    uint16_t hash_[kHashSize];
+    uint64_t lastSequence_ = 0;
+    uint64_t lastTimestampMs_ = 0;
+
+    // Decoder window shared by forEach() calls, so queries do not allocate.
+    mutable std::vector<char> readWindow_;
+
+    size_t blockAt(size_t i) const { return (head_ + i) % blocks_.size(); }
+    size_t firstBlockFor(uint64_t sequence) const;
+    void openBlock(uint64_t sequence, uint64_t timestampMs);
+    size_t encode(uint64_t sequence, uint64_t timestampMs, uint8_t level, uint8_t tagIndex, const char* text,
+                  size_t length, uint8_t* out);
+    static uint64_t tagBit(uint8_t tagIndex) { return 1ull << (tagIndex < 63 ? tagIndex : 63); }
+};
+
+template <typename Fn>
+void LogArchive::forEach(uint64_t fromSequence, uint8_t minLevel, int tagIndex, Fn fn) const {
+    if (count_ == 0) {
+        return;
+    }
+
+    const uint8_t levelMask = static_cast<uint8_t>(0xFF << minLevel);
+    const uint64_t tagMask = tagIndex < 0 ? ~0ull : tagBit(static_cast<uint8_t>(tagIndex));
+
+    for (size_t i = firstBlockFor(fromSequence); i < count_; ++i) {
+        const size_t index = blockAt(i);
+        const Block& block = blocks_[index];
+        if (block.entries == 0 || block.lastSequence < fromSequence || !(block.levelMask & levelMask) ||
+            !(block.tagMask & tagMask)) {
+            continue;
+        }
+
+        Reader reader(*this, index, readWindow_.data());
+        View view;
+        while (reader.next(view)) {
+            if (view.sequence < fromSequence || view.level < minLevel ||
+                (tagIndex >= 0 && view.tagIndex != tagIndex)) {
+                continue;
+            }
+            if (!fn(static_cast<const View&>(view))) {
+                return;
+            }
+        }
+    }
+}
+
+#endif // LOG_ARCHIVE_H
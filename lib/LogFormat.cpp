@@ -0,0 +1,290 @@
+#include "LogFormat.h"
+
+#include <cstdio>
+#include <cstring>
+
+void LogArgWriter::put(const char* value) {
+    if (!value) {
+        value = "(null)";
+    }
+    putString(value, std::strlen(value));
+}
+
+void LogArgWriter::putInt(int64_t value) {
+    putRaw(ARG_INT64, &value, sizeof(value));
+}
+
+void LogArgWriter::putUInt(uint64_t value) {
+    putRaw(ARG_UINT64, &value, sizeof(value));
+}
+
+void LogArgWriter::putDouble(double value) {
+    putRaw(ARG_DOUBLE, &value, sizeof(value));
+}
+
+void LogArgWriter::putString(const char* value, size_t length) {
+    if (truncated_ || size_ + 2 > capacity_) {
+        truncated_ = true;
+        return;
+    }
+
+    size_t room = capacity_ - size_ - 2;
+    if (length > room || length > 0xFF) {
+        length = (room < 0xFF) ? room : 0xFF;
+        truncated_ = true;
+    }
+
+    buffer_[size_++] = static_cast<char>(ARG_STRING);
+    buffer_[size_++] = static_cast<char>(static_cast<uint8_t>(length));
+    std::memcpy(buffer_ + size_, value, length);
+    size_ += length;
+}
+
+bool LogArgWriter::putRaw(ArgType type, const void* bytes, size_t length) {
+    if (truncated_ || size_ + 1 + length > capacity_) {
+        truncated_ = true;
+        return false;
+    }
+
+    buffer_[size_++] = static_cast<char>(type);
+    std::memcpy(buffer_ + size_, bytes, length);
+    size_ += length;
+    return true;
+}
+
+namespace {
+
+class ArgReader {
+public:
+    ArgReader(const char* args, size_t length) : args_(args), length_(length) {}
+
+    bool next(uint8_t& type, int64_t& i, uint64_t& u, double& d, const char*& s, size_t& sLength) {
+        if (pos_ >= length_) {
+            return false;
+        }
+
+        type = static_cast<uint8_t>(args_[pos_++]);
+        switch (type) {
+            case LogArgWriter::ARG_INT64: return read(&i, sizeof(i));
+            case LogArgWriter::ARG_UINT64: return read(&u, sizeof(u));
+            case LogArgWriter::ARG_DOUBLE: return read(&d, sizeof(d));
+            case LogArgWriter::ARG_STRING:
+                if (pos_ >= length_) {
+                    return false;
+                }
+                sLength = static_cast<uint8_t>(args_[pos_++]);
+                if (pos_ + sLength > length_) {
+                    return false;
+                }
+                s = args_ + pos_;
+                pos_ += sLength;
+                return true;
+            default:
+                pos_ = length_;
+                return false;
+        }
+    }
+
+private:
+    const char* args_;
+    size_t length_;
+    size_t pos_ = 0;
+
+    bool read(void* out, size_t size) {
+        if (pos_ + size > length_) {
+            pos_ = length_;
+            return false;
+        }
+        std::memcpy(out, args_ + pos_, size);
+        pos_ += size;
+        return true;
+    }
+};
+
+bool isConversion(char c) {
+    return std::strchr("diouxXeEfFgGaAcsp", c) != nullptr;
+}
+
+bool isLengthModifier(char c) {
+    return std::strchr("hljztL", c) != nullptr;
+}
+
+// Flags, width and precision: the only spec characters passed on to snprintf.
+bool isSpecChar(char c) {
+    return c != '\0' && std::strchr("-+ #0123456789.", c) != nullptr;
+}
+
+// Truncating fixed-buffer output with the subset of the std::string interface used below.
+class BufferOut {
+public:
+    BufferOut(char* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+    void push_back(char c) {
+        if (size_ < capacity_) {
+            buffer_[size_++] = c;
+        }
+    }
+
+    void append(const char* data, size_t length) {
+        if (length > capacity_ - size_) {
+            length = capacity_ - size_;
+        }
+        std::memcpy(buffer_ + size_, data, length);
+        size_ += length;
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+};
+
+template <typename Out>
+void renderInto(Out& out, const char* fmt, const char* args, size_t argsLength) {
+    if (!fmt) {
+        return;
+    }
+
+    ArgReader reader(args, argsLength);
+    char spec[32];
+    char piece[128];
+
+    const char* p = fmt;
+    while (*p) {
+        if (*p != '%') {
+            out.push_back(*p++);
+            continue;
+        }
+        if (p[1] == '%') {
+            out.push_back('%');
+            p += 2;
+            continue;
+        }
+
+        // Collect flags/width/precision, dropping length modifiers: the stored argument
+        // type decides those. Anything else (%n, positional $, ', a spec too long for
+        // `spec`) stops the collector and the directive is copied verbatim.
+        const char* start = p++;
+        size_t specLength = 0;
+        spec[specLength++] = '%';
+        while (*p && !isConversion(*p)) {
+            // Leave room for "ll", the conversion and the terminator.
+            const size_t room = sizeof(spec) - 4 - specLength;
+            if (*p == '*') {
+                uint8_t type = 0;
+                int64_t i = 0;
+                uint64_t u = 0;
+                double d = 0.0;
+                const char* s = nullptr;
+                size_t sLength = 0;
+                long long star = 0;
+                if (reader.next(type, i, u, d, s, sLength)) {
+                    star = (type == LogArgWriter::ARG_UINT64) ? static_cast<long long>(u) : static_cast<long long>(i);
+                }
+                const int written = std::snprintf(spec + specLength, room, "%lld", star);
+                if (written < 0 || static_cast<size_t>(written) >= room) {
+                    break;
+                }
+                specLength += static_cast<size_t>(written);
+            } else if (isSpecChar(*p)) {
+                if (room == 0) {
+                    break;
+                }
+                spec[specLength++] = *p;
+            } else if (!isLengthModifier(*p)) {
+                break;
+            }
+            ++p;
+        }
+        if (!*p || !isConversion(*p)) {
+            out.append(start, p - start);
+            continue;
+        }
+        const char conversion = *p++;
+
+        uint8_t type = 0;
+        int64_t i = 0;
+        uint64_t u = 0;
+        double d = 0.0;
+        const char* s = nullptr;
+        size_t sLength = 0;
+        if (!reader.next(type, i, u, d, s, sLength)) {
+            out.append(start, p - start);
+            continue;
+        }
+
+        int written = 0;
+        switch (type) {
+            case LogArgWriter::ARG_INT64:
+            case LogArgWriter::ARG_UINT64: {
+                const bool isSigned = (type == LogArgWriter::ARG_INT64);
+                if (conversion == 'c') {
+                    spec[specLength++] = 'c';
+                    spec[specLength] = '\0';
+                    written = std::snprintf(piece, sizeof(piece), spec, static_cast<int>(isSigned ? i : static_cast<int64_t>(u)));
+                } else if (std::strchr("eEfFgGaA", conversion)) {
+                    spec[specLength++] = conversion;
+                    spec[specLength] = '\0';
+                    written = std::snprintf(piece, sizeof(piece), spec, isSigned ? static_cast<double>(i) : static_cast<double>(u));
+                } else {
+                    char intConversion = conversion;
+                    if (conversion == 's' || conversion == 'p') {
+                        intConversion = isSigned ? 'd' : 'x';
+                    }
+                    spec[specLength++] = 'l';
+                    spec[specLength++] = 'l';
+                    spec[specLength++] = intConversion;
+                    spec[specLength] = '\0';
+                    if (conversion == 'p') {
+                        out.append("0x", 2);
+                    }
+                    if (intConversion == 'd' || intConversion == 'i') {
+                        written = std::snprintf(piece, sizeof(piece), spec, static_cast<long long>(isSigned ? i : static_cast<int64_t>(u)));
+                    } else {
+                        written = std::snprintf(piece, sizeof(piece), spec, static_cast<unsigned long long>(isSigned ? static_cast<uint64_t>(i) : u));
+                    }
+                }
+                break;
+            }
+            case LogArgWriter::ARG_DOUBLE: {
+                spec[specLength++] = std::strchr("eEfFgGaA", conversion) ? conversion : 'g';
+                spec[specLength] = '\0';
+                written = std::snprintf(piece, sizeof(piece), spec, d);
+                break;
+            }
+            case LogArgWriter::ARG_STRING: {
+                spec[specLength++] = 's';
+                spec[specLength] = '\0';
+                char value[256];
+                std::memcpy(value, s, sLength);
+                value[sLength] = '\0';
+                written = std::snprintf(piece, sizeof(piece), spec, value);
+                break;
+            }
+        }
+
+        if (written > 0) {
+            out.append(piece, static_cast<size_t>(written) < sizeof(piece) ? static_cast<size_t>(written) : sizeof(piece) - 1);
+        }
+    }
+}
+
+} // namespace
+
+namespace LogFormat {
+
+std::string render(const char* fmt, const char* args, size_t argsLength) {
+    std::string out;
+    renderInto(out, fmt, args, argsLength);
+    return out;
+}
+
+size_t render(const char* fmt, const char* args, size_t argsLength, char* out, size_t capacity) {
+    BufferOut buffer(out, capacity);
+    renderInto(buffer, fmt, args, argsLength);
+    return buffer.size();
+}
+
+} // namespace LogFormat
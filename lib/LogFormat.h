@@ -0,0 +1,68 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Binary argument encoding for deferred (printf-style) log formatting. logf() packs its
+// arguments with LogArgWriter into the record slab; LogFormat::render() replays them
+// against the format string only when an entry is read.
+class LogArgWriter {
+public:
+    enum ArgType : uint8_t {
+        ARG_INT64 = 1,
+        ARG_UINT64 = 2,
+        ARG_DOUBLE = 3,
+        ARG_STRING = 4 // uint8 length followed by the bytes (truncated to fit)
+    };
+
+    LogArgWriter(char* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+    void put(bool value) { putInt(value ? 1 : 0); }
+    void put(char value) { putInt(value); }
+    void put(signed char value) { putInt(value); }
+    void put(unsigned char value) { putUInt(value); }
+    void put(short value) { putInt(value); }
+    void put(unsigned short value) { putUInt(value); }
+    void put(int value) { putInt(value); }
+    void put(unsigned int value) { putUInt(value); }
+    void put(long value) { putInt(value); }
+    void put(unsigned long value) { putUInt(value); }
+    void put(long long value) { putInt(value); }
+    void put(unsigned long long value) { putUInt(value); }
+    void put(float value) { putDouble(value); }
+    void put(double value) { putDouble(value); }
+    void put(const void* value) { putUInt(reinterpret_cast<uintptr_t>(value)); }
+    void put(const char* value);
+    void put(const std::string& value) { putString(value.data(), value.size()); }
+
+    size_t size() const { return size_; }
+    bool truncated() const { return truncated_; }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+    bool truncated_ = false;
+
+    void putInt(int64_t value);
+    void putUInt(uint64_t value);
+    void putDouble(double value);
+    void putString(const char* value, size_t length);
+    bool putRaw(ArgType type, const void* bytes, size_t length);
+};
+
+namespace LogFormat {
+
+// Format `fmt` using arguments packed by LogArgWriter. Conversions without a matching
+// argument are copied through verbatim.
+std::string render(const char* fmt, const char* args, size_t argsLength);
+
+// Allocation-free variant: renders into `out`, truncating at `capacity`, and returns the
+// number of bytes written (no terminator).
+size_t render(const char* fmt, const char* args, size_t argsLength, char* out, size_t capacity);
+
+} // namespace LogFormat
+
+#endif // LOG_FORMAT_H
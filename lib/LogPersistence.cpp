@@ -0,0 +1,351 @@
+#include "LogPersistence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Crc32.h"
+
+namespace {
+const char* kSegmentSuffix = ".seg";
+
+// Record framing: u16 payload length, u32 CRC of the payload, payload.
+const size_t kRecordHeaderBytes = 6;
+
+void putU16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>((v >> 8) & 0xFF));
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+}
+
+void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64_t getLE(const std::string& data, size_t offset, size_t bytes) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        v |= static_cast<uint64_t>(static_cast<uint8_t>(data[offset + i])) << (8 * i);
+    }
+    return v;
+}
+} // namespace
+
+LogPersistence::LogPersistence(Logger& logger, StorageBackend& storage) : logger_(logger), storage_(storage) {
+}
+
+LogPersistence::~LogPersistence() {
+    stop();
+}
+
+void LogPersistence::setConfig(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    if (config_.pageEntries == 0) {
+        config_.pageEntries = 1;
+    }
+}
+
+std::string LogPersistence::segmentName(uint32_t index) const {
+    char digits[16];
+    std::snprintf(digits, sizeof(digits), "%08u", static_cast<unsigned>(index));
+    return config_.filePrefix + digits + kSegmentSuffix;
+}
+
+bool LogPersistence::parseSegmentIndex(const std::string& name, uint32_t& index) const {
+    const std::string suffix = kSegmentSuffix;
+    if (name.size() <= config_.filePrefix.size() + suffix.size() ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return false;
+    }
+
+    const std::string digits = name.substr(config_.filePrefix.size(),
+                                           name.size() - config_.filePrefix.size() - suffix.size());
+    char* end = nullptr;
+    unsigned long value = std::strtoul(digits.c_str(), &end, 10);
+    if (digits.empty() || *end != '\0') {
+        return false;
+    }
+    index = static_cast<uint32_t>(value);
+    return true;
+}
+
+bool LogPersistence::begin() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    segments_.clear();
+    totalBytes_ = 0;
+    hasPersisted_ = false;
+
+    for (const std::string& name : storage_.listFiles(config_.filePrefix)) {
+        Segment segment;
+        if (!parseSegmentIndex(name, segment.index)) {
+            continue;
+        }
+        segment.name = name;
+        segment.bytes = storage_.fileSize(name);
+        // The previous boot may have died mid-append; always continue in a new segment.
+        segment.sealed = true;
+        segments_.push_back(segment);
+        totalBytes_ += segment.bytes;
+    }
+
+    // Newest segment that still holds a readable record tells us where to continue.
+    for (auto it = segments_.rbegin(); it != segments_.rend() && !hasPersisted_; ++it) {
+        std::vector<Logger::Entry> entries;
+        readSegment(*it, entries);
+        if (!entries.empty()) {
+            lastPersistedSequence_ = entries.back().sequence;
+            hasPersisted_ = true;
+        }
+    }
+
+    if (hasPersisted_) {
+        cursor_ = lastPersistedSequence_ + 1;
+        logger_.advanceSequenceTo(cursor_);
+    } else {
+        cursor_ = 0;
+    }
+    return true;
+}
+
+bool LogPersistence::start() {
+    if (logger_.mode() != Logger::Mode::CONCURRENT || isRunning()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workerMutex_);
+        stopRequested_ = false;
+    }
+    worker_ = std::thread(&LogPersistence::workerLoop, this);
+    return true;
+}
+
+void LogPersistence::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workerMutex_);
+        stopRequested_ = true;
+    }
+    workerWake_.notify_all();
+    worker_.join();
+
+    flush(true);
+}
+
+void LogPersistence::workerLoop() {
+    std::unique_lock<std::mutex> lock(workerMutex_);
+    while (!stopRequested_) {
+        workerWake_.wait_for(lock, std::chrono::milliseconds(config_.flushIntervalMs));
+        if (stopRequested_) {
+            break;
+        }
+
+        lock.unlock();
+        flush(false);
+        lock.lock();
+    }
+}
+
+size_t LogPersistence::flush(bool includePartialPage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t written = 0;
+
+    for (;;) {
+        Logger::TailResult tail = logger_.getEntriesSince(cursor_, config_.pageEntries);
+        stats_.entriesMissed += tail.missed;
+        if (tail.entries.empty()) {
+            cursor_ = tail.nextSequence;
+            break;
+        }
+        if (tail.entries.size() < config_.pageEntries && !includePartialPage) {
+            // Wait for a full page; keep the cursor on the first unwritten entry.
+            cursor_ = tail.entries.front().sequence;
+            break;
+        }
+
+        std::string page;
+        for (const Logger::Entry& entry : tail.entries) {
+            encodeEntry(entry, page);
+        }
+
+        if (!appendPage(page)) {
+            ++stats_.writeErrors;
+            cursor_ = tail.entries.front().sequence;
+            break;
+        }
+
+        cursor_ = tail.nextSequence;
+        lastPersistedSequence_ = tail.entries.back().sequence;
+        hasPersisted_ = true;
+
+        written += tail.entries.size();
+        stats_.entriesPersisted += tail.entries.size();
+        ++stats_.pagesWritten;
+        stats_.bytesWritten += page.size();
+    }
+
+    return written;
+}
+
+bool LogPersistence::appendPage(const std::string& page) {
+    if (segments_.empty() || segments_.back().sealed || segments_.back().bytes >= config_.maxSegmentBytes) {
+        Segment segment;
+        segment.index = segments_.empty() ? 0 : segments_.back().index + 1;
+        segment.name = segmentName(segment.index);
+        segment.bytes = 0;
+        segment.sealed = false;
+        segments_.push_back(segment);
+    }
+
+    Segment& current = segments_.back();
+    if (!storage_.appendFile(current.name, page.data(), page.size())) {
+        // A partial append leaves a torn tail and readers stop at the first bad CRC, so
+        // nothing may be appended after it: resync the size and seal the segment.
+        const size_t actual = storage_.fileSize(current.name);
+        if (actual > current.bytes) {
+            totalBytes_ += actual - current.bytes;
+            current.bytes = actual;
+        }
+        current.sealed = true;
+        return false;
+    }
+
+    current.bytes += page.size();
+    totalBytes_ += page.size();
+    enforceSizeCap();
+    return true;
+}
+
+void LogPersistence::enforceSizeCap() {
+    while (totalBytes_ > config_.maxTotalBytes && segments_.size() > 1) {
+        const Segment& oldest = segments_.front();
+        storage_.removeFile(oldest.name);
+        totalBytes_ -= std::min(totalBytes_, oldest.bytes);
+        segments_.pop_front();
+        ++stats_.segmentsRemoved;
+    }
+}
+
+void LogPersistence::readSegment(const Segment& segment, std::vector<Logger::Entry>& out) const {
+    std::string data;
+    if (!storage_.readFile(segment.name, data)) {
+        return;
+    }
+
+    size_t offset = 0;
+    Logger::Entry entry;
+    while (decodeEntry(data, offset, entry)) {
+        out.push_back(entry);
+    }
+}
+
+std::vector<Logger::Entry> LogPersistence::replay(Logger::Level minLevel) const {
+    std::vector<Logger::Entry> all;
+    uint64_t next = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Segment& segment : segments_) {
+            readSegment(segment, all);
+        }
+        next = hasPersisted_ ? lastPersistedSequence_ + 1 : 0;
+    }
+
+    Logger::TailResult live = logger_.getEntriesSince(next);
+    all.insert(all.end(), live.entries.begin(), live.entries.end());
+
+    std::vector<Logger::Entry> out;
+    out.reserve(all.size());
+    for (Logger::Entry& entry : all) {
+        if (static_cast<int>(entry.level) >= static_cast<int>(minLevel)) {
+            out.push_back(entry);
+        }
+    }
+    return out;
+}
+
+LogPersistence::Stats LogPersistence::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+size_t LogPersistence::getSegmentCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
+
+size_t LogPersistence::getTotalBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return totalBytes_;
+}
+
+void LogPersistence::encodeEntry(const Logger::Entry& entry, std::string& out) {
+    const size_t tagLength = std::min<size_t>(entry.tag.size(), 0xFF);
+    const size_t messageLength = std::min<size_t>(entry.message.size(), 0xFFFF);
+
+    std::string payload;
+    payload.reserve(8 + 8 + 1 + 1 + tagLength + 2 + messageLength);
+    putU64(payload, entry.sequence);
+    putU64(payload, entry.timestampMs);
+    payload.push_back(static_cast<char>(entry.level));
+    payload.push_back(static_cast<char>(tagLength));
+    payload.append(entry.tag, 0, tagLength);
+    putU16(payload, static_cast<uint16_t>(messageLength));
+    payload.append(entry.message, 0, messageLength);
+
+    putU16(out, static_cast<uint16_t>(payload.size()));
+    putU32(out, Crc32::compute(payload.data(), payload.size()));
+    out += payload;
+}
+
+bool LogPersistence::decodeEntry(const std::string& data, size_t& offset, Logger::Entry& entry) {
+    if (offset + kRecordHeaderBytes > data.size()) {
+        return false;
+    }
+
+    const size_t payloadLength = static_cast<size_t>(getLE(data, offset, 2));
+    const uint32_t crc = static_cast<uint32_t>(getLE(data, offset + 2, 4));
+    const size_t start = offset + kRecordHeaderBytes;
+    if (start + payloadLength > data.size() || payloadLength < 20) {
+        return false;
+    }
+    if (Crc32::compute(data.data() + start, payloadLength) != crc) {
+        return false;
+    }
+
+    size_t p = start;
+    entry.sequence = getLE(data, p, 8);
+    p += 8;
+    entry.timestampMs = getLE(data, p, 8);
+    p += 8;
+    const uint8_t level = static_cast<uint8_t>(data[p++]);
+    entry.level = static_cast<Logger::Level>(level <= 3 ? level : 1);
+    const size_t tagLength = static_cast<uint8_t>(data[p++]);
+    if (p + tagLength + 2 > start + payloadLength) {
+        return false;
+    }
+    entry.tag.assign(data, p, tagLength);
+    p += tagLength;
+    const size_t messageLength = static_cast<size_t>(getLE(data, p, 2));
+    p += 2;
+    if (p + messageLength != start + payloadLength) {
+        return false;
+    }
+    entry.message.assign(data, p, messageLength);
+
+    offset = start + payloadLength;
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef LOG_PERSISTENCE_H
+#define LOG_PERSISTENCE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Logger.h"
+#include "StorageBackend.h"
+
+// Optional persistence tier for Logger. Full pages of entries are read through the
+// sequence cursor (Logger::getEntriesSince) and appended as CRC-checked records to
+// segment files; segments rotate at a size limit and the oldest are deleted once the total
+// exceeds the cap. A background flusher does the writes, so log() never waits on flash.
+class LogPersistence {
+public:
+    struct Config {
+        std::string filePrefix = "log_";
+        size_t pageEntries = 32;           // Entries per batched append
+        size_t maxSegmentBytes = 16 * 1024;
+        size_t maxTotalBytes = 128 * 1024; // Oldest segments removed beyond this
+        uint32_t flushIntervalMs = 1000;
+    };
+
+    struct Stats {
+        uint64_t entriesPersisted = 0;
+        uint64_t pagesWritten = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t segmentsRemoved = 0;
+        uint64_t entriesMissed = 0; // Overwritten in the ring before they were flushed
+        uint64_t writeErrors = 0;
+    };
+
+    LogPersistence(Logger& logger, StorageBackend& storage);
+    ~LogPersistence();
+
+    LogPersistence(const LogPersistence&) = delete;
+    LogPersistence& operator=(const LogPersistence&) = delete;
+
+    // Call before begin().
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return config_; }
+
+    // Scan existing segments and continue the logger's sequence numbers after them.
+    bool begin();
+
+    // Background flusher. Requires Logger::Mode::CONCURRENT, since it reads the logger
+    // from its own thread. stop() writes the remaining partial page.
+    bool start();
+    void stop();
+    bool isRunning() const { return worker_.joinable(); }
+
+    // Write every full page waiting in the logger (plus the partial tail if requested).
+    // Returns the number of entries written.
+    size_t flush(bool includePartialPage = false);
+
+    // Persisted entries followed by live entries that are not persisted yet, oldest first.
+    std::vector<Logger::Entry> replay(Logger::Level minLevel = Logger::Level::DEBUG) const;
+
+    Stats getStats() const;
+    size_t getSegmentCount() const;
+    size_t getTotalBytes() const;
+
+private:
+    struct Segment {
+        uint32_t index;
+        std::string name;
+        size_t bytes;
+        bool sealed;
+    };
+
+    Logger& logger_;
+    StorageBackend& storage_;
+    Config config_;
+
+    mutable std::mutex mutex_;
+    std::deque<Segment> segments_;
+    size_t totalBytes_ = 0;
+    uint64_t cursor_ = 0;
+    uint64_t lastPersistedSequence_ = 0;
+    bool hasPersisted_ = false;
+    Stats stats_;
+
+    std::thread worker_;
+    std::mutex workerMutex_;
+    std::condition_variable workerWake_;
+    bool stopRequested_ = false;
+
+    std::string segmentName(uint32_t index) const;
+    bool parseSegmentIndex(const std::string& name, uint32_t& index) const;
+    bool appendPage(const std::string& page);
+    void enforceSizeCap();
+    void readSegment(const Segment& segment, std::vector<Logger::Entry>& out) const;
+    void workerLoop();
+
+    static void encodeEntry(const Logger::Entry& entry, std::string& out);
+    static bool decodeEntry(const std::string& data, size_t& offset, Logger::Entry& entry);
+};
+
+#endif // LOG_PERSISTENCE_H
@@ -0,0 +1,99 @@
+#include "LogTagTable.h"
+
+#include <cstring>
+
+static_assert(LOGGER_MAX_TAGS >= 2 && LOGGER_MAX_TAGS < 255, "LOGGER_MAX_TAGS must fit a uint8 id");
+
+const uint8_t LogTagTable::kEmptyTagId;
+const uint8_t LogTagTable::kOverflowTagId;
+const size_t LogTagTable::kMaxTags;
+const size_t LogTagTable::kMaxTagLength;
+
+LogTagTable::LogTagTable() {
+    for (size_t i = 0; i < kMaxTags; ++i) {
+        slots_[i].state.store(SLOT_EMPTY, std::memory_order_relaxed);
+        slots_[i].length = 0;
+        slots_[i].name[0] = '\0';
+    }
+
+    // Id 0 is always the empty tag.
+    slots_[kEmptyTagId].state.store(SLOT_READY, std::memory_order_release);
+}
+
+bool LogTagTable::matches(const Slot& slot, const char* tag, size_t length) {
+    return slot.length == length && std::memcmp(slot.name, tag, length) == 0;
+}
+
+uint8_t LogTagTable::intern(const char* tag, size_t length) {
+    if (length > kMaxTagLength) {
+        length = kMaxTagLength;
+    }
+
+    bool skipped = false;
+    for (size_t i = 0; i < kMaxTags; ++i) {
+        Slot& slot = slots_[i];
+        uint8_t state = slot.state.load(std::memory_order_acquire);
+
+        if (state == SLOT_EMPTY) {
+            // Claiming past a slot still being filled could intern its tag twice, and
+            // would leave a gap that find() and size() do not expect.
+            if (skipped) {
+                return kOverflowTagId;
+            }
+            if (slot.state.compare_exchange_strong(state, SLOT_WRITING, std::memory_order_acq_rel)) {
+                std::memcpy(slot.name, tag, length);
+                slot.name[length] = '\0';
+                slot.length = static_cast<uint8_t>(length);
+                slot.state.store(SLOT_READY, std::memory_order_release);
+                return static_cast<uint8_t>(i);
+            }
+        }
+
+        // Another producer is publishing this slot. It may be preempted by this very
+        // caller, so never wait for it: look for the tag further on instead.
+        if (state != SLOT_READY) {
+            skipped = true;
+            continue;
+        }
+
+        if (matches(slot, tag, length)) {
+            return static_cast<uint8_t>(i);
+        }
+    }
+
+    return kOverflowTagId;
+}
+
+bool LogTagTable::find(const char* tag, size_t length, uint8_t& id) const {
+    if (length > kMaxTagLength) {
+        length = kMaxTagLength;
+    }
+
+    for (size_t i = 0; i < kMaxTags; ++i) {
+        const Slot& slot = slots_[i];
+        if (slot.state.load(std::memory_order_acquire) != SLOT_READY) {
+            return false;
+        }
+        if (matches(slot, tag, length)) {
+            id = static_cast<uint8_t>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const char* LogTagTable::name(uint8_t id) const {
+    if (id >= kMaxTags || slots_[id].state.load(std::memory_order_acquire) != SLOT_READY) {
+        return "~";
+    }
+    return slots_[id].name;
+}
+
+size_t LogTagTable::size() const {
+    size_t count = 0;
+    while (count < kMaxTags && slots_[count].state.load(std::memory_order_acquire) == SLOT_READY) {
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,59 @@
+#ifndef LOG_TAG_TABLE_H
+#define LOG_TAG_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef LOGGER_MAX_TAGS
+#define LOGGER_MAX_TAGS 32
+#endif
+
+#ifndef LOGGER_MAX_TAG_LENGTH
+#define LOGGER_MAX_TAG_LENGTH 15
+#endif
+
+// Fixed-size intern table mapping log tags to uint8 ids. Storage is inline, so interning
+// never allocates; ids are stable for the lifetime of the table. Safe to call from several
+// threads at once: the first thread to see a new tag claims the next free slot with a CAS.
+// Nobody waits for a slot another thread is still filling; a new tag that would have to
+// be placed after such a slot gets kOverflowTagId for that call instead.
+class LogTagTable {
+public:
+    static const uint8_t kEmptyTagId = 0;
+    static const uint8_t kOverflowTagId = 255; // Table full; rendered as "~"
+    static const size_t kMaxTags = LOGGER_MAX_TAGS;
+    static const size_t kMaxTagLength = LOGGER_MAX_TAG_LENGTH; // Longer tags are truncated
+
+    LogTagTable();
+
+    LogTagTable(const LogTagTable&) = delete;
+    LogTagTable& operator=(const LogTagTable&) = delete;
+
+    uint8_t intern(const char* tag, size_t length);
+    bool find(const char* tag, size_t length, uint8_t& id) const;
+
+    const char* name(uint8_t id) const;
+    size_t size() const;
+
+private:
+    friend struct LogTagTableProbe; // Tests: parks a slot mid-publish
+
+    enum SlotState : uint8_t {
+        SLOT_EMPTY = 0,
+        SLOT_WRITING = 1,
+        SLOT_READY = 2
+    };
+
+    struct Slot {
+        std::atomic<uint8_t> state;
+        uint8_t length;
+        char name[kMaxTagLength + 1];
+    };
+
+    Slot slots_[kMaxTags];
+
+    static bool matches(const Slot& slot, const char* tag, size_t length);
+};
+
+#endif // LOG_TAG_TABLE_H
@@ -3,7 +3,14 @@
 #include <algorithm>
 #include <chrono>
 #include <cctype>
-#include <sstream>
+#include <cstring>
+
+static_assert(LOGGER_MAX_MESSAGE_LENGTH > 0 && LOGGER_MAX_MESSAGE_LENGTH <= 0xFFFF,
+              "LOGGER_MAX_MESSAGE_LENGTH must fit Record::length");
+
+const size_t Logger::kMaxMessageLength;
+const size_t Logger::kJsonChunkSize;
+const uint64_t Logger::kNoSequence;
 
 namespace {
 uint64_t defaultNowMs() {
@@ -18,40 +25,134 @@ std::string toUpper(std::string value) {
     return value;
 }
 
-std::string escapeJson(const std::string& s) {
-    std::ostringstream out;
-    for (char c : s) {
-        switch (c) {
-            case '"': out << "\\\""; break;
-            case '\\': out << "\\\\"; break;
-            case '\b': out << "\\b"; break;
-            case '\f': out << "\\f"; break;
-            case '\n': out << "\\n"; break;
-            case '\r': out << "\\r"; break;
-            case '\t': out << "\\t"; break;
-            default:
-                if (static_cast<unsigned char>(c) < 0x20) {
-                    out << "\\u";
-                    out << std::hex << std::uppercase;
-                    out.width(4);
-                    out.fill('0');
-                    out << static_cast<int>(static_cast<unsigned char>(c));
-                    out << std::dec;
-                } else {
-                    out << c;
-                }
-        }
-    }
-    return out.str();
+// Buffers JSON output in a fixed caller-provided chunk and hands full chunks to the sink.
+class JsonChunkWriter {
+public:
+    JsonChunkWriter(char* buffer, size_t capacity, const Logger::JsonSink& sink)
+        : buffer_(buffer), capacity_(capacity), sink_(sink) {}
+
+    bool ok() const { return ok_; }
+    size_t size() const { return size_; }
+
+    void put(char c) {
+        if (size_ == capacity_) {
+            flush();
+        }
+        if (ok_) {
+            buffer_[size_++] = c;
+        }
+    }
+
+    void put(const char* data, size_t length) {
+        while (ok_ && length > 0) {
+            if (size_ == capacity_) {
+                flush();
+                continue;
+            }
+            size_t n = std::min(length, capacity_ - size_);
+            std::memcpy(buffer_ + size_, data, n);
+            size_ += n;
+            data += n;
+            length -= n;
+        }
+    }
+
+    void put(const char* s) { put(s, std::strlen(s)); }
+
+    void putUInt(uint64_t value) {
+        char digits[20];
+        size_t n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (n > 0) {
+            put(digits[--n]);
+        }
+    }
+
+    void putEscaped(const char* data, size_t length) {
+        static const char kHex[] = "0123456789ABCDEF";
+        for (size_t i = 0; i < length && ok_; ++i) {
+            const char c = data[i];
+            switch (c) {
+                case '"': put("\\\"", 2); break;
+                case '\\': put("\\\\", 2); break;
+                case '\b': put("\\b", 2); break;
+                case '\f': put("\\f", 2); break;
+                case '\n': put("\\n", 2); break;
+                case '\r': put("\\r", 2); break;
+                case '\t': put("\\t", 2); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        const char escaped[6] = {'\\', 'u', '0', '0', kHex[(c >> 4) & 0x0F], kHex[c & 0x0F]};
+                        put(escaped, sizeof(escaped));
+                    } else {
+                        put(c);
+                    }
+            }
+        }
+    }
+
+    bool flush() {
+        if (ok_ && size_ > 0) {
+            ok_ = sink_(buffer_, size_);
+            size_ = 0;
+        }
+        return ok_;
+    }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    const Logger::JsonSink& sink_;
+    size_t size_ = 0;
+    bool ok_ = true;
+};
+
+bool writeJsonEntry(JsonChunkWriter& writer, bool& first, uint64_t timestampMs, uint8_t level, const char* tag,
+                    const char* text, size_t length) {
+    if (!first) {
+        writer.put(',');
+    }
+    first = false;
+
+    writer.put("{\"ts\":");
+    writer.putUInt(timestampMs);
+    writer.put(",\"level\":\"");
+    writer.put(Logger::levelToString(static_cast<Logger::Level>(level)));
+    writer.put("\",\"tag\":\"");
+    writer.putEscaped(tag, std::strlen(tag));
+    writer.put("\",\"msg\":\"");
+    writer.putEscaped(text, length);
+    writer.put("\"}");
+    return writer.ok();
 }
 } // namespace
 
-Logger::Logger(size_t capacity) : capacity_(capacity), buffer_(capacity) {
+Logger::Logger(size_t capacity, Mode mode, size_t archiveBytes) : capacity_(capacity), mode_(mode), buffer_(capacity) {
+    for (size_t i = 0; i < kLevelCount; ++i) {
+        levelHeads_[i] = kNoSequence;
+        levelCounts_[i] = 0;
+    }
+    for (size_t i = 0; i <= LogTagTable::kMaxTags; ++i) {
+        tagHeads_[i] = kNoSequence;
+        std::memset(&tagSuppression_[i], 0, sizeof(TagSuppression));
+        tagSuppression_[i].lastSequence = kNoSequence;
+    }
+
     if (capacity_ == 0) {
         capacity_ = 1;
         buffer_.resize(capacity_);
     }
 
+    if (mode_ == Mode::CONCURRENT) {
+        pending_.reset(new MpscRing<Record>(capacity_));
+    }
+    if (archiveBytes > 0) {
+        archive_.reset(new LogArchive(archiveBytes));
+    }
+
     timeProvider_ = defaultNowMs;
 }
 
@@ -60,85 +161,660 @@ void Logger::setTimeProvider(TimeProvider provider) {
 }
 
 void Logger::setEnabled(bool enabled) {
-    enabled_ = enabled;
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Logger::setMinLevel(Level level) {
+    minLevel_.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
 }
 
 void Logger::clear() {
+    std::unique_lock<std::mutex> lock = syncHistory();
     writeIndex_ = 0;
     count_ = 0;
+    ++clearCount_;
+    for (size_t i = 0; i < kLevelCount; ++i) {
+        levelCounts_[i] = 0;
+    }
+    if (archive_) {
+        archive_->clear();
+    }
+}
+
+size_t Logger::getLevelCount(Level level) const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    const size_t index = static_cast<size_t>(level);
+    return index < kLevelCount ? levelCounts_[index] : 0;
+}
+
+size_t Logger::size() const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return count_;
+}
+
+uint64_t Logger::archivedCount() const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return archive_ ? archive_->size() : 0;
+}
+
+LogArchive::Stats Logger::getArchiveStats() const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return archive_ ? archive_->getStats() : LogArchive::Stats();
+}
+
+void Logger::drain() {
+    std::unique_lock<std::mutex> lock = syncHistory();
 }
 
 uint64_t Logger::nowMs() const {
     return timeProvider_ ? timeProvider_() : defaultNowMs();
 }
 
-void Logger::log(Level level, const std::string& message, const std::string& tag) {
-    if (!enabled_) {
-        return;
+void Logger::fillRecord(Record& record, uint64_t timestampMs, Level level, uint8_t tagId, uint8_t flags,
+                        const char* format, const char* bytes, size_t length) const {
+    if (length > kMaxMessageLength) {
+        length = kMaxMessageLength;
     }
 
+    record.timestampMs = timestampMs;
+    record.format = format;
+    record.level = static_cast<uint8_t>(level);
+    record.tagId = tagId;
+    record.flags = flags;
+    record.length = static_cast<uint16_t>(length);
+    std::memcpy(record.message, bytes, length);
+}
+
+Logger::Entry Logger::toEntry(const Record& record) const {
     Entry entry;
-    entry.timestampMs = nowMs();
-    entry.level = level;
-    entry.tag = tag;
-    entry.message = message;
+    entry.sequence = record.sequence;
+    entry.timestampMs = record.timestampMs;
+    entry.level = static_cast<Level>(record.level);
+    entry.tag = tags_.name(record.tagId);
+    if (record.flags & RECORD_DEFERRED) {
+        char rendered[kMaxRenderedLength];
+        const size_t length = LogFormat::render(record.format, record.message, record.length, rendered, sizeof(rendered));
+        entry.message.assign(rendered, length);
+    } else {
+        entry.message.assign(record.message, record.length);
+    }
+    return entry;
+}
+
+void Logger::appendToHistory(const Record& record) const {
+    if (suppressionEnabled() &&
+        !admit(record.timestampMs, static_cast<Level>(record.level), record.tagId, record.flags, record.format,
+               record.message, record.length)) {
+        return;
+    }
+
+    Record& slot = claimSlot();
+    slot.timestampMs = record.timestampMs;
+    slot.format = record.format;
+    slot.level = record.level;
+    slot.tagId = record.tagId;
+    slot.flags = record.flags;
+    slot.length = record.length;
+    std::memcpy(slot.message, record.message, record.length);
+    commitSlot();
+    noteStored(record.tagId);
+}
+
+Logger::Record& Logger::claimSlot() const {
+    Record& slot = buffer_[writeIndex_];
+    if (count_ == capacity_) {
+        // Overwriting the oldest entry. Chains that still point at it stop at the
+        // oldest-sequence bound, so only the level counter needs fixing.
+        --levelCounts_[slot.level];
+        if (archive_) {
+            archiveRecord(slot);
+        }
+    }
+    return slot;
+}
+
+void Logger::commitSlot() const {
+    Record& slot = buffer_[writeIndex_];
+    const uint64_t sequence = nextSequence_++;
+    slot.sequence = sequence;
+
+    uint64_t& tagHead = tagHeads_[tagIndex(slot.tagId)];
+    slot.prevSameTag = chainDistance(tagHead, sequence);
+    tagHead = sequence;
+
+    uint64_t& levelHead = levelHeads_[slot.level];
+    slot.prevSameLevel = chainDistance(levelHead, sequence);
+    levelHead = sequence;
+    ++levelCounts_[slot.level];
 
-    buffer_[writeIndex_] = entry;
     writeIndex_ = (writeIndex_ + 1) % capacity_;
     count_ = std::min(capacity_, count_ + 1);
 }
 
+uint32_t Logger::chainDistance(uint64_t previous, uint64_t sequence) const {
+    if (previous == kNoSequence || sequence - previous > capacity_) {
+        return 0;
+    }
+    return static_cast<uint32_t>(sequence - previous);
+}
+
+size_t Logger::tagIndex(uint8_t tagId) {
+    return tagId < LogTagTable::kMaxTags ? tagId : LogTagTable::kMaxTags;
+}
+
+uint8_t Logger::tagIdAt(size_t index) {
+    return index < LogTagTable::kMaxTags ? static_cast<uint8_t>(index) : LogTagTable::kOverflowTagId;
+}
+
+void Logger::archiveRecord(const Record& record) const {
+    // Deferred entries are rendered once here; the archive stores plain text.
+    const char* text = record.message;
+    size_t length = record.length;
+    char rendered[kMaxRenderedLength];
+    if (record.flags & RECORD_DEFERRED) {
+        length = LogFormat::render(record.format, record.message, record.length, rendered, sizeof(rendered));
+        text = rendered;
+    }
+    archive_->append(record.sequence, record.timestampMs, record.level, static_cast<uint8_t>(tagIndex(record.tagId)),
+                     text, length);
+}
+
+Logger::Entry Logger::toEntry(const LogArchive::View& view) const {
+    Entry entry;
+    entry.sequence = view.sequence;
+    entry.timestampMs = view.timestampMs;
+    entry.level = static_cast<Level>(view.level);
+    entry.tag = tags_.name(tagIdAt(view.tagIndex));
+    entry.message.assign(view.text, view.length);
+    return entry;
+}
+
+uint64_t Logger::oldestSequence() const {
+    if (archive_ && !archive_->empty()) {
+        return archive_->oldestSequence();
+    }
+    return nextSequence_ - count_;
+}
+
+const Logger::Record& Logger::recordAt(uint64_t sequence) const {
+    const size_t back = static_cast<size_t>(nextSequence_ - sequence);
+    return buffer_[(writeIndex_ + capacity_ - back) % capacity_];
+}
+
+void Logger::drainPendingLocked() const {
+    while (pending_->tryPop([this](const Record& record) { appendToHistory(record); })) {
+    }
+}
+
+std::unique_lock<std::mutex> Logger::syncHistory() const {
+    if (mode_ != Mode::CONCURRENT) {
+        return std::unique_lock<std::mutex>();
+    }
+
+    std::unique_lock<std::mutex> lock(historyMutex_);
+    drainPendingLocked();
+    return lock;
+}
+
+void Logger::log(Level level, const std::string& message, const std::string& tag) {
+    logRaw(level, message.data(), message.size(), tag.data(), tag.size());
+}
+
+void Logger::log(Level level, const char* message, const char* tag) {
+    if (!message) {
+        message = "";
+    }
+    if (!tag) {
+        tag = "";
+    }
+    logRaw(level, message, std::strlen(message), tag, std::strlen(tag));
+}
+
+void Logger::logRaw(Level level, const char* message, size_t messageLength, const char* tag, size_t tagLength) {
+    if (!isLoggable(level)) {
+        return;
+    }
+    store(level, 0, nullptr, message, messageLength, tag, tagLength);
+}
+
+void Logger::logDeferred(Level level, const char* tag, const char* fmt, const char* args, size_t argsLength) {
+    if (!tag) {
+        tag = "";
+    }
+    store(level, RECORD_DEFERRED, fmt ? fmt : "", args, argsLength, tag, std::strlen(tag));
+}
+
+void Logger::store(Level level, uint8_t flags, const char* format, const char* bytes, size_t length,
+                   const char* tag, size_t tagLength) {
+    const uint64_t timestampMs = nowMs();
+    const uint8_t tagId = tags_.intern(tag, tagLength);
+
+    if (mode_ == Mode::CONCURRENT) {
+        const bool pushed = pending_->tryPush([&](Record& record) {
+            fillRecord(record, timestampMs, level, tagId, flags, format, bytes, length);
+        });
+        if (!pushed) {
+            droppedCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // Suppression runs before the copy, so a flooding tag costs a compare, not a store.
+    if (suppressionEnabled() && !admit(timestampMs, level, tagId, flags, format, bytes, length)) {
+        return;
+    }
+
+    fillRecord(claimSlot(), timestampMs, level, tagId, flags, format, bytes, length);
+    commitSlot();
+    noteStored(tagId);
+}
+
+void Logger::setSuppression(const SuppressionConfig& config) {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    suppressionConfig_ = config;
+}
+
+Logger::SuppressionConfig Logger::getSuppression() const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return suppressionConfig_;
+}
+
+Logger::SuppressionStats Logger::getSuppressionStats() const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return suppressionStats_;
+}
+
+uint64_t Logger::getSuppressedCount(const std::string& tag) const {
+    uint8_t tagId = 0;
+    if (!tags_.find(tag.data(), tag.size(), tagId)) {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return tagSuppression_[tagIndex(tagId)].suppressed;
+}
+
+void Logger::flushSuppressed() {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    const uint64_t now = nowMs();
+    for (size_t i = 0; i <= LogTagTable::kMaxTags; ++i) {
+        const uint8_t tagId = tagIdAt(i);
+        logRepeatSummary(tagId, tagSuppression_[i]);
+        logRateSummary(tagId, tagSuppression_[i], now);
+    }
+}
+
+bool Logger::admit(uint64_t timestampMs, Level level, uint8_t tagId, uint8_t flags, const char* format,
+                   const char* bytes, size_t length) const {
+    TagSuppression& state = tagSuppression_[tagIndex(tagId)];
+
+    if (suppressionConfig_.coalesceRepeats && isRepeat(state, level, flags, format, bytes, length)) {
+        if (state.repeats == 0) {
+            state.firstRepeatMs = timestampMs;
+            state.repeatLevel = static_cast<uint8_t>(level);
+        }
+        ++state.repeats;
+        ++state.suppressed;
+        ++suppressionStats_.repeatsCoalesced;
+        state.lastRepeatMs = timestampMs;
+
+        if (timestampMs - state.firstRepeatMs >= suppressionConfig_.repeatFlushMs) {
+            logRepeatSummary(tagId, state);
+        }
+        return false;
+    }
+
+    if (suppressionConfig_.tagMessagesPerSecond > 0) {
+        const uint64_t capacity = static_cast<uint64_t>(suppressionConfig_.tagBurst) * 1000;
+        if (!state.refillStarted) {
+            state.refillStarted = true;
+            state.tokens = static_cast<uint32_t>(capacity);
+        } else if (timestampMs > state.lastRefillMs) {
+            const uint64_t refill = (timestampMs - state.lastRefillMs) * suppressionConfig_.tagMessagesPerSecond;
+            state.tokens = static_cast<uint32_t>(std::min<uint64_t>(capacity, state.tokens + refill));
+        }
+        state.lastRefillMs = std::max(state.lastRefillMs, timestampMs);
+
+        if (state.tokens < 1000) {
+            if (state.rateDropped == 0 || static_cast<uint8_t>(level) > state.rateDroppedLevel) {
+                state.rateDroppedLevel = static_cast<uint8_t>(level);
+            }
+            ++state.rateDropped;
+            ++state.suppressed;
+            ++suppressionStats_.rateLimited;
+            return false;
+        }
+        state.tokens -= 1000;
+    }
+
+    logRepeatSummary(tagId, state);
+    logRateSummary(tagId, state, timestampMs);
+    return true;
+}
+
+bool Logger::isRepeat(const TagSuppression& state, Level level, uint8_t flags, const char* format,
+                      const char* bytes, size_t length) const {
+    // Only compare against the tag's last entry while it is still in the ring.
+    if (state.lastSequence == kNoSequence || state.lastSequence >= nextSequence_ ||
+        state.lastSequence < nextSequence_ - count_) {
+        return false;
+    }
+
+    const Record& last = recordAt(state.lastSequence);
+    length = std::min(length, kMaxMessageLength);
+    return last.level == static_cast<uint8_t>(level) && last.flags == flags && last.length == length &&
+           (!(flags & RECORD_DEFERRED) || last.format == format) && std::memcmp(last.message, bytes, length) == 0;
+}
+
+void Logger::logRepeatSummary(uint8_t tagId, TagSuppression& state) const {
+    if (state.repeats == 0) {
+        return;
+    }
+    logSummary(tagId, static_cast<Level>(state.repeatLevel), state.lastRepeatMs, "last message repeated %u times",
+               state.repeats);
+    state.repeats = 0;
+}
+
+void Logger::logRateSummary(uint8_t tagId, TagSuppression& state, uint64_t timestampMs) const {
+    if (state.rateDropped == 0) {
+        return;
+    }
+    logSummary(tagId, static_cast<Level>(state.rateDroppedLevel), timestampMs, "%u messages suppressed by rate limit",
+               state.rateDropped);
+    state.rateDropped = 0;
+}
+
+void Logger::logSummary(uint8_t tagId, Level level, uint64_t timestampMs, const char* format, uint32_t count) const {
+    char packed[16];
+    LogArgWriter writer(packed, sizeof(packed));
+    writer.put(static_cast<unsigned int>(count));
+
+    fillRecord(claimSlot(), timestampMs, level, tagId, RECORD_DEFERRED, format, packed, writer.size());
+    commitSlot();
+    ++suppressionStats_.summariesLogged;
+}
+
+void Logger::noteStored(uint8_t tagId) const {
+    tagSuppression_[tagIndex(tagId)].lastSequence = nextSequence_ - 1;
+}
+
+template <typename Fn>
+void Logger::forEachRecord(Level minLevel, Fn fn) const {
+    // Oldest entry index in circular buffer
+    size_t start = (count_ == capacity_) ? writeIndex_ : 0;
+
+    for (size_t i = 0; i < count_; ++i) {
+        const Record& record = buffer_[(start + i) % capacity_];
+        if (record.level < static_cast<uint8_t>(minLevel)) {
+            continue;
+        }
+        if (!fn(record)) {
+            return;
+        }
+    }
+}
+
 std::vector<Logger::Entry> Logger::getEntries(Level minLevel) const {
     return getEntries(minLevel, std::string());
 }
 
 std::vector<Logger::Entry> Logger::getEntries(Level minLevel, const std::string& tagFilter) const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+
     std::vector<Entry> out;
-    out.reserve(count_);
 
     const bool filterByTag = !tagFilter.empty();
+    uint8_t tagId = LogTagTable::kEmptyTagId;
+    if (filterByTag && !tags_.find(tagFilter.data(), tagFilter.size(), tagId)) {
+        return out;
+    }
 
-    // Oldest entry index in circular buffer
-    size_t start = (count_ == capacity_) ? writeIndex_ : 0;
+    // Archived entries are all older than the hot ring, so they go first.
+    if (archive_) {
+        archive_->forEach(0, static_cast<uint8_t>(minLevel), filterByTag ? static_cast<int>(tagIndex(tagId)) : -1,
+                          [&](const LogArchive::View& view) {
+                              out.push_back(toEntry(view));
+                              return true;
+                          });
+    }
+    const size_t hotStart = out.size();
 
-    for (size_t i = 0; i < count_; ++i) {
-        const size_t idx = (start + i) % capacity_;
-        const Entry& entry = buffer_[idx];
+    const uint64_t oldest = nextSequence_ - count_;
 
-        if (static_cast<int>(entry.level) < static_cast<int>(minLevel)) {
-            continue;
+    if (filterByTag) {
+        // Walk the tag chain newest to oldest; only entries with this tag are visited.
+        uint64_t sequence = tagHeads_[tagIndex(tagId)];
+        while (sequence != kNoSequence && sequence >= oldest) {
+            const Record& record = recordAt(sequence);
+            if (record.level >= static_cast<uint8_t>(minLevel)) {
+                out.push_back(toEntry(record));
+            }
+            if (record.prevSameTag == 0) {
+                break;
+            }
+            sequence -= record.prevSameTag;
         }
+        std::reverse(out.begin() + hotStart, out.end());
+        return out;
+    }
 
-        if (filterByTag && entry.tag != tagFilter) {
-            continue;
+    if (minLevel == Level::DEBUG) {
+        forEachRecord(minLevel, [&](const Record& record) {
+            out.push_back(toEntry(record));
+            return true;
+        });
+        return out;
+    }
+
+    // Merge the per-level chains for every level >= minLevel, newest first.
+    uint64_t cursors[kLevelCount];
+    for (size_t level = 0; level < kLevelCount; ++level) {
+        const bool wanted = level >= static_cast<size_t>(minLevel);
+        const uint64_t head = levelHeads_[level];
+        cursors[level] = (wanted && head != kNoSequence && head >= oldest) ? head : kNoSequence;
+    }
+
+    for (;;) {
+        size_t newest = kLevelCount;
+        for (size_t level = 0; level < kLevelCount; ++level) {
+            if (cursors[level] != kNoSequence && (newest == kLevelCount || cursors[level] > cursors[newest])) {
+                newest = level;
+            }
+        }
+        if (newest == kLevelCount) {
+            break;
         }
 
-        out.push_back(entry);
+        const Record& record = recordAt(cursors[newest]);
+        out.push_back(toEntry(record));
+
+        const uint64_t previous = cursors[newest] - record.prevSameLevel;
+        cursors[newest] = (record.prevSameLevel != 0 && previous >= oldest) ? previous : kNoSequence;
     }
+    std::reverse(out.begin() + hotStart, out.end());
 
     return out;
 }
 
+uint64_t Logger::nextSequence() const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return nextSequence_;
+}
+
+uint64_t Logger::getVersion() const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    return nextSequence_ + clearCount_;
+}
+
+void Logger::advanceSequenceTo(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock = syncHistory();
+    const uint64_t oldest = oldestSequence();
+    if (sequence <= oldest) {
+        return;
+    }
+
+    const uint64_t delta = sequence - oldest;
+    if (archive_) {
+        archive_->rebase(delta);
+    }
+    for (size_t i = 0; i < count_; ++i) {
+        buffer_[i].sequence += delta;
+    }
+    for (size_t i = 0; i <= LogTagTable::kMaxTags; ++i) {
+        if (tagHeads_[i] != kNoSequence) {
+            tagHeads_[i] += delta;
+        }
+        if (tagSuppression_[i].lastSequence != kNoSequence) {
+            tagSuppression_[i].lastSequence += delta;
+        }
+    }
+    for (size_t i = 0; i < kLevelCount; ++i) {
+        if (levelHeads_[i] != kNoSequence) {
+            levelHeads_[i] += delta;
+        }
+    }
+    nextSequence_ += delta;
+}
+
+Logger::TailResult Logger::getEntriesSince(uint64_t sequence, size_t maxCount) const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+
+    TailResult result;
+    const uint64_t oldest = oldestSequence();
+
+    if (sequence > nextSequence_) {
+        // Cursor from a previous boot (or a cleared logger): start over from the oldest entry.
+        sequence = oldest;
+    }
+    if (sequence < oldest) {
+        result.missed = oldest - sequence;
+        sequence = oldest;
+    }
+
+    const uint64_t available = nextSequence_ - sequence;
+    const size_t n = static_cast<size_t>(std::min<uint64_t>(available, maxCount));
+    result.entries.reserve(n);
+
+    const uint64_t hotOldest = nextSequence_ - count_;
+    if (archive_ && n > 0 && sequence < hotOldest) {
+        archive_->forEach(sequence, 0, -1, [&](const LogArchive::View& view) {
+            result.entries.push_back(toEntry(view));
+            return result.entries.size() < n;
+        });
+    }
+    for (uint64_t next = sequence + result.entries.size(); result.entries.size() < n; ++next) {
+        result.entries.push_back(toEntry(recordAt(next)));
+    }
+
+    result.nextSequence = sequence + n;
+    return result;
+}
+
 std::string Logger::exportToJson(Level minLevel) const {
-    std::ostringstream json;
-    json << "[";
+    std::string json;
+    exportToJson([&json](const char* data, size_t length) {
+        json.append(data, length);
+        return true;
+    }, minLevel);
+    return json;
+}
+
+bool Logger::exportToJson(const JsonSink& sink, Level minLevel) const {
+    std::unique_lock<std::mutex> lock = syncHistory();
+
+    char chunk[kJsonChunkSize];
+    JsonChunkWriter writer(chunk, sizeof(chunk), sink);
+    bool first = true;
 
-    std::vector<Entry> entries = getEntries(minLevel);
-    for (size_t i = 0; i < entries.size(); ++i) {
-        const Entry& e = entries[i];
-        if (i != 0) {
-            json << ',';
+    writer.put('[');
+    if (archive_) {
+        archive_->forEach(0, static_cast<uint8_t>(minLevel), -1, [&](const LogArchive::View& view) {
+            return writeJsonEntry(writer, first, view.timestampMs, view.level, tags_.name(tagIdAt(view.tagIndex)),
+                                  view.text, view.length);
+        });
+    }
+    forEachRecord(minLevel, [&](const Record& record) {
+        const char* text = record.message;
+        size_t length = record.length;
+        char rendered[kMaxRenderedLength];
+        if (record.flags & RECORD_DEFERRED) {
+            length = LogFormat::render(record.format, record.message, record.length, rendered, sizeof(rendered));
+            text = rendered;
         }
-        json << '{';
-        json << "\"ts\":" << e.timestampMs << ',';
-        json << "\"level\":\"" << levelToString(e.level) << "\",";
-        json << "\"tag\":\"" << escapeJson(e.tag) << "\",";
-        json << "\"msg\":\"" << escapeJson(e.message) << "\"";
-        json << '}';
+        return writeJsonEntry(writer, first, record.timestampMs, record.level, tags_.name(record.tagId), text, length);
+    });
+    writer.put(']');
+
+    return writer.flush();
+}
+
+bool Logger::exportToJson(JsonCursor& cursor, std::string& out, size_t maxBytes, Level minLevel) const {
+    if (cursor.finished) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock = syncHistory();
+
+    const size_t start = out.size();
+    const JsonSink sink = [&out](const char* data, size_t length) {
+        out.append(data, length);
+        return true;
+    };
+    char chunk[kJsonChunkSize];
+    JsonChunkWriter writer(chunk, sizeof(chunk), sink);
+    bool first = !cursor.started;
+
+    // Whole entries only, and at least one per call so a small budget still makes progress.
+    size_t written = 0;
+    auto full = [&]() { return written > 0 && out.size() + writer.size() - start >= maxBytes; };
+    bool more = false;
+
+    if (!cursor.started) {
+        writer.put('[');
+        cursor.started = true;
+    }
+    if (archive_ && cursor.nextSequence < nextSequence_ - count_) {
+        archive_->forEach(cursor.nextSequence, static_cast<uint8_t>(minLevel), -1, [&](const LogArchive::View& view) {
+            if (full()) {
+                more = true;
+                return false;
+            }
+            writeJsonEntry(writer, first, view.timestampMs, view.level, tags_.name(tagIdAt(view.tagIndex)), view.text,
+                           view.length);
+            cursor.nextSequence = view.sequence + 1;
+            ++written;
+            return true;
+        });
+    }
+    if (!more) {
+        forEachRecord(minLevel, [&](const Record& record) {
+            if (record.sequence < cursor.nextSequence) {
+                return true;
+            }
+            if (full()) {
+                more = true;
+                return false;
+            }
+            const char* text = record.message;
+            size_t length = record.length;
+            char rendered[kMaxRenderedLength];
+            if (record.flags & RECORD_DEFERRED) {
+                length = LogFormat::render(record.format, record.message, record.length, rendered, sizeof(rendered));
+                text = rendered;
+            }
+            writeJsonEntry(writer, first, record.timestampMs, record.level, tags_.name(record.tagId), text, length);
+            cursor.nextSequence = record.sequence + 1;
+            ++written;
+            return true;
+        });
+    }
+    if (!more) {
+        writer.put(']');
+        cursor.finished = true;
     }
 
-    json << "]";
-    return json.str();
+    writer.flush();
+    return !cursor.finished;
 }
 
 const char* Logger::levelToString(Level level) {
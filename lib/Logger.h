@@ -1,12 +1,28 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "LogArchive.h"
+#include "LogFormat.h"
+#include "LogTagTable.h"
+#include "MpscRing.h"
+
+#ifndef LOGGER_MAX_MESSAGE_LENGTH
+#define LOGGER_MAX_MESSAGE_LENGTH 95
+#endif
+
+#ifndef LOGGER_JSON_CHUNK_SIZE
+#define LOGGER_JSON_CHUNK_SIZE 512
+#endif
+
 class Logger {
 public:
     enum class Level {
@@ -16,27 +32,99 @@ public:
         ERROR = 3
     };
 
+    // Messages longer than this are truncated when stored; each slot holds them inline so
+    // steady-state logging never touches the heap.
+    static const size_t kMaxMessageLength = LOGGER_MAX_MESSAGE_LENGTH;
+
     struct Entry {
+        uint64_t sequence = 0; // Monotonic per logger, never reused (not even by clear())
         uint64_t timestampMs = 0;
         Level level = Level::INFO;
         std::string tag;
         std::string message;
     };
 
+    // SINGLE_THREADED writes straight into the history buffer and needs external locking
+    // when shared. CONCURRENT lets any number of threads call log() without locks: entries
+    // go through a bounded MPSC ring and are folded into history by drain() or any reader.
+    enum class Mode {
+        SINGLE_THREADED,
+        CONCURRENT
+    };
+
     using TimeProvider = std::function<uint64_t()>;
 
-    explicit Logger(size_t capacity = 256);
+    // archiveBytes > 0 adds a compressed tier (LogArchive) that keeps entries evicted from the
+    // hot ring. Queries and exports cover both tiers; size() and getLevelCount() are hot only.
+    explicit Logger(size_t capacity = 256, Mode mode = Mode::SINGLE_THREADED, size_t archiveBytes = 0);
 
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    Mode mode() const { return mode_; }
+
+    // Not safe to call while other threads are logging.
     void setTimeProvider(TimeProvider provider);
 
     void setEnabled(bool enabled);
-    bool isEnabled() const { return enabled_; }
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Entries below the minimum level are discarded before any work is done.
+    void setMinLevel(Level level);
+    Level getMinLevel() const { return static_cast<Level>(minLevel_.load(std::memory_order_relaxed)); }
+    bool isLoggable(Level level) const {
+        return isEnabled() && static_cast<uint8_t>(level) >= minLevel_.load(std::memory_order_relaxed);
+    }
 
     void clear();
 
-    size_t size() const { return count_; }
+    size_t size() const;
     size_t capacity() const { return capacity_; }
-    bool empty() const { return count_ == 0; }
+    bool empty() const { return size() == 0; }
+
+    // Compressed tier; all zero when the logger was built without one.
+    bool hasArchive() const { return archive_ != nullptr; }
+    uint64_t archivedCount() const;
+    LogArchive::Stats getArchiveStats() const;
+
+    // Memory one hot-ring slot costs, for comparing against the archive.
+    static size_t hotEntryBytes() { return sizeof(Record); }
+
+    // Concurrent mode: move pending entries into history (call from the main loop so the
+    // ring does not fill up between reads). No-op in single-threaded mode.
+    void drain();
+
+    // Entries rejected because the concurrent ring was full.
+    uint64_t droppedCount() const { return droppedCount_.load(std::memory_order_relaxed); }
+
+    // Per-tag flood protection, applied before an entry takes a history slot (in concurrent
+    // mode, when it is drained). A message identical to the previous one for its tag is
+    // counted instead of stored and summarised as "last message repeated N times" when the
+    // tag logs something else, or every repeatFlushMs while it keeps repeating. Each tag may
+    // also have a token bucket; entries over the limit are counted and reported by a
+    // summary before the tag's next admitted entry. Both are off by default.
+    struct SuppressionConfig {
+        bool coalesceRepeats = false;
+        uint32_t repeatFlushMs = 30000;
+        uint32_t tagMessagesPerSecond = 0; // 0 = unlimited
+        uint32_t tagBurst = 10;
+    };
+
+    struct SuppressionStats {
+        uint64_t repeatsCoalesced = 0;
+        uint64_t rateLimited = 0;
+        uint64_t summariesLogged = 0;
+    };
+
+    void setSuppression(const SuppressionConfig& config);
+    SuppressionConfig getSuppression() const;
+    SuppressionStats getSuppressionStats() const;
+
+    // Entries coalesced or rate-limited for one tag since the logger was created.
+    uint64_t getSuppressedCount(const std::string& tag) const;
+
+    // Log pending repeat/rate-limit summaries now instead of waiting for the next entry.
+    void flushSuppressed();
 
     void log(Level level, const std::string& message, const std::string& tag = "");
     void debug(const std::string& message, const std::string& tag = "") { log(Level::DEBUG, message, tag); }
@@ -44,24 +132,205 @@ public:
     void warn(const std::string& message, const std::string& tag = "") { log(Level::WARN, message, tag); }
     void error(const std::string& message, const std::string& tag = "") { log(Level::ERROR, message, tag); }
 
+    // Literal-friendly overloads: no std::string temporaries are built.
+    void log(Level level, const char* message, const char* tag = "");
+    void debug(const char* message, const char* tag = "") { log(Level::DEBUG, message, tag); }
+    void info(const char* message, const char* tag = "") { log(Level::INFO, message, tag); }
+    void warn(const char* message, const char* tag = "") { log(Level::WARN, message, tag); }
+    void error(const char* message, const char* tag = "") { log(Level::ERROR, message, tag); }
+
+    // Deferred printf-style logging. The level is checked first; only the format pointer and
+    // the raw argument bytes are stored, and the text is rendered when entries are read.
+    // fmt must outlive the entry (use a string literal). String arguments are copied.
+    template <typename... Args>
+    void logf(Level level, const char* tag, const char* fmt, const Args&... args);
+    template <typename... Args>
+    void debugf(const char* tag, const char* fmt, const Args&... args) { logf(Level::DEBUG, tag, fmt, args...); }
+    template <typename... Args>
+    void infof(const char* tag, const char* fmt, const Args&... args) { logf(Level::INFO, tag, fmt, args...); }
+    template <typename... Args>
+    void warnf(const char* tag, const char* fmt, const Args&... args) { logf(Level::WARN, tag, fmt, args...); }
+    template <typename... Args>
+    void errorf(const char* tag, const char* fmt, const Args&... args) { logf(Level::ERROR, tag, fmt, args...); }
+
+    // Number of stored entries at exactly this level; O(1).
+    size_t getLevelCount(Level level) const;
+
+    // Distinct tags seen so far (including the empty tag).
+    size_t tagCount() const { return tags_.size(); }
+
     std::vector<Entry> getEntries(Level minLevel = Level::DEBUG) const;
     std::vector<Entry> getEntries(Level minLevel, const std::string& tagFilter) const;
 
+    // Incremental tail for polling clients: returns up to maxCount entries with
+    // sequence >= `sequence`, oldest first, in O(returned entries). Feed nextSequence back
+    // in on the next poll. `missed` counts entries overwritten before they were read. A
+    // cursor ahead of the logger (e.g. from before a reboot) restarts at the oldest entry.
+    struct TailResult {
+        std::vector<Entry> entries;
+        uint64_t nextSequence = 0;
+        uint64_t missed = 0;
+    };
+    TailResult getEntriesSince(uint64_t sequence, size_t maxCount = static_cast<size_t>(-1)) const;
+
+    // Sequence number the next stored entry will get.
+    uint64_t nextSequence() const;
+    // Changes whenever the history does (a new entry or clear()), for caching rendered views.
+    uint64_t getVersion() const;
+
+    // Renumber so the oldest live entry (or the next one, if empty) gets at least `sequence`,
+    // e.g. to continue after entries persisted before a reboot. Never lowers sequences.
+    void advanceSequenceTo(uint64_t sequence);
+
     std::string exportToJson(Level minLevel = Level::DEBUG) const;
 
+    // Streaming export: the JSON array is written in chunks of at most kJsonChunkSize bytes
+    // straight from the ring, without an entry vector or a full-document string. Returning
+    // false from the sink aborts the export; the result says whether it completed.
+    // In CONCURRENT mode the sink runs with the history lock held for the whole export, so
+    // it must not block (a socket write) or call back into the logger: readers and drains
+    // wait on it. Slow consumers should use the JsonCursor overload below, which locks
+    // per call.
+    using JsonSink = std::function<bool(const char* data, size_t length)>;
+    static const size_t kJsonChunkSize = LOGGER_JSON_CHUNK_SIZE;
+    bool exportToJson(const JsonSink& sink, Level minLevel = Level::DEBUG) const;
+
+    // Resumable export for paced writers (chunked HTTP responses): each call appends whole
+    // entries to `out` until it has grown by about maxBytes, and returns true while more
+    // follow. The lock is only held per call. Entries that fall out of the history between
+    // calls are skipped, so the result is always valid JSON but may have gaps.
+    struct JsonCursor {
+        uint64_t nextSequence = 0;
+        bool started = false;
+        bool finished = false;
+    };
+    bool exportToJson(JsonCursor& cursor, std::string& out, size_t maxBytes, Level minLevel = Level::DEBUG) const;
+
     static const char* levelToString(Level level);
     static bool tryParseLevel(const std::string& level, Level& out);
 
 private:
+    // Compact, allocation-free storage format for one entry.
+    // With RECORD_DEFERRED set, `message` holds LogArgWriter bytes for `format`.
+    enum RecordFlags : uint8_t {
+        RECORD_DEFERRED = 0x01
+    };
+
+    // prevSameTag / prevSameLevel link each record to the previous one with the same tag or
+    // level (as a sequence distance, 0 = none), so filtered queries skip non-matching entries.
+    struct Record {
+        uint64_t sequence;
+        uint64_t timestampMs;
+        const char* format;
+        uint32_t prevSameTag;
+        uint32_t prevSameLevel;
+        uint8_t level;
+        uint8_t tagId;
+        uint8_t flags;
+        uint16_t length;
+        char message[kMaxMessageLength];
+    };
+
+    // Suppression bookkeeping per tag index. lastSequence is the last entry actually stored
+    // for the tag (repeat candidates are compared against it); tokens are in 1/1000 units.
+    struct TagSuppression {
+        uint64_t lastSequence;
+        uint64_t lastRepeatMs;
+        uint64_t firstRepeatMs;
+        uint64_t lastRefillMs;
+        uint64_t suppressed;
+        uint32_t repeats;
+        uint32_t rateDropped;
+        uint32_t tokens;
+        uint8_t repeatLevel;
+        uint8_t rateDroppedLevel;
+        bool refillStarted;
+    };
+
+    static const size_t kLevelCount = 4;
+    static const uint64_t kNoSequence = static_cast<uint64_t>(-1);
+
+    // Upper bound for one deferred (logf) message, on every read path (entries, JSON, archive).
+    static const size_t kMaxRenderedLength = 256;
+
     size_t capacity_;
-    std::vector<Entry> buffer_;
-    size_t writeIndex_ = 0;
-    size_t count_ = 0;
+    Mode mode_;
+
+    // History is mutable because const readers fold the concurrent ring into it.
+    mutable std::vector<Record> buffer_;
+    mutable size_t writeIndex_ = 0;
+    mutable size_t count_ = 0;
+    mutable uint64_t nextSequence_ = 0;
+    uint64_t clearCount_ = 0;
+
+    // Secondary indexes: newest sequence per tag (overflow tag in the last slot) and per
+    // level, plus live counts per level.
+    mutable uint64_t tagHeads_[LogTagTable::kMaxTags + 1];
+    mutable uint64_t levelHeads_[kLevelCount];
+    mutable size_t levelCounts_[kLevelCount];
+
+    LogTagTable tags_;
+    std::unique_ptr<LogArchive> archive_;
 
-    bool enabled_ = true;
+    mutable TagSuppression tagSuppression_[LogTagTable::kMaxTags + 1];
+    SuppressionConfig suppressionConfig_;
+    mutable SuppressionStats suppressionStats_;
+
+    std::unique_ptr<MpscRing<Record>> pending_;
+    mutable std::mutex historyMutex_;
+    std::atomic<uint64_t> droppedCount_{0};
+
+    std::atomic<bool> enabled_{true};
+    std::atomic<uint8_t> minLevel_{static_cast<uint8_t>(Level::DEBUG)};
     TimeProvider timeProvider_;
 
     uint64_t nowMs() const;
+    void logRaw(Level level, const char* message, size_t messageLength, const char* tag, size_t tagLength);
+    void logDeferred(Level level, const char* tag, const char* fmt, const char* args, size_t argsLength);
+    void store(Level level, uint8_t flags, const char* format, const char* bytes, size_t length,
+               const char* tag, size_t tagLength);
+    void fillRecord(Record& record, uint64_t timestampMs, Level level, uint8_t tagId, uint8_t flags,
+                    const char* format, const char* bytes, size_t length) const;
+    Entry toEntry(const Record& record) const;
+    template <typename Fn>
+    void forEachRecord(Level minLevel, Fn fn) const;
+    void appendToHistory(const Record& record) const;
+    bool suppressionEnabled() const {
+        return suppressionConfig_.coalesceRepeats || suppressionConfig_.tagMessagesPerSecond > 0;
+    }
+    bool admit(uint64_t timestampMs, Level level, uint8_t tagId, uint8_t flags, const char* format,
+               const char* bytes, size_t length) const;
+    bool isRepeat(const TagSuppression& state, Level level, uint8_t flags, const char* format, const char* bytes,
+                  size_t length) const;
+    void logRepeatSummary(uint8_t tagId, TagSuppression& state) const;
+    void logRateSummary(uint8_t tagId, TagSuppression& state, uint64_t timestampMs) const;
+    void logSummary(uint8_t tagId, Level level, uint64_t timestampMs, const char* format, uint32_t count) const;
+    void noteStored(uint8_t tagId) const;
+    Record& claimSlot() const;
+    void commitSlot() const;
+    uint32_t chainDistance(uint64_t previous, uint64_t sequence) const;
+    static size_t tagIndex(uint8_t tagId);
+    static uint8_t tagIdAt(size_t index);
+    void archiveRecord(const Record& record) const;
+    Entry toEntry(const LogArchive::View& view) const;
+    uint64_t oldestSequence() const;
+    const Record& recordAt(uint64_t sequence) const;
+    void drainPendingLocked() const;
+    std::unique_lock<std::mutex> syncHistory() const;
 };
 
+template <typename... Args>
+void Logger::logf(Level level, const char* tag, const char* fmt, const Args&... args) {
+    if (!isLoggable(level)) {
+        return;
+    }
+
+    char packed[kMaxMessageLength];
+    LogArgWriter writer(packed, sizeof(packed));
+    int expand[] = {0, (writer.put(args), 0)...};
+    (void)expand;
+
+    logDeferred(level, tag, fmt, packed, writer.size());
+}
+
 #endif // LOGGER_H
@@ -93,6 +93,13 @@ public:
     void stopSineWaveTransition();
     bool isSineWaveActive() const { return sineWaveActive_; }
 
+    // Callback registration
+    using StateChangeCallback = std::function<void(const LightState&)>;
+    using BrightnessChangeCallback = std::function<void(uint8_t)>;
+
+    void setStateChangeCallback(StateChangeCallback callback) { stateChangeCallback_ = callback; }
+    void setBrightnessChangeCallback(BrightnessChangeCallback callback) { brightnessChangeCallback_ = callback; }
+
 private:
     Config config_;
     LightMode mode_ = LightMode::AUTO;
@@ -125,8 +132,8 @@ private:
     uint32_t accumulatedOffTime_{0};
     
     // Callbacks
-    std::function<void(const LightState&)> stateChangeCallback_;
-    std::function<void(uint8_t)> brightnessChangeCallback_;
+    StateChangeCallback stateChangeCallback_;
+    BrightnessChangeCallback brightnessChangeCallback_;
     
     void updateLightState();
     void startBrightnessTransition(uint8_t targetBrightness);
@@ -1,10 +1,242 @@
 #include "MockSettingsManager.h"
 #include <sstream>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <type_traits>
+
+#include "JsonWriter.h"
+
+const size_t MockSettingsManager::kSettingCount;
+
+namespace {
+template <typename T>
+struct SettingTypeOf;
+template <>
+struct SettingTypeOf<bool> {
+    static const MockSettingsManager::SettingType value = MockSettingsManager::SettingType::BOOL;
+};
+template <>
+struct SettingTypeOf<int> {
+    static const MockSettingsManager::SettingType value = MockSettingsManager::SettingType::INT;
+};
+template <>
+struct SettingTypeOf<uint8_t> {
+    static const MockSettingsManager::SettingType value = MockSettingsManager::SettingType::UINT;
+};
+template <>
+struct SettingTypeOf<uint16_t> {
+    static const MockSettingsManager::SettingType value = MockSettingsManager::SettingType::UINT;
+};
+template <>
+struct SettingTypeOf<uint32_t> {
+    static const MockSettingsManager::SettingType value = MockSettingsManager::SettingType::UINT;
+};
+template <>
+struct SettingTypeOf<float> {
+    static const MockSettingsManager::SettingType value = MockSettingsManager::SettingType::FLOAT;
+};
+template <>
+struct SettingTypeOf<std::string> {
+    static const MockSettingsManager::SettingType value = MockSettingsManager::SettingType::STRING;
+};
+
+const MockSettingsManager::SettingInfo kSettingInfo[] = {
+#define MOCK_SETTINGS_INFO(name, type, min, max) {#name, SettingTypeOf<type>::value, min, max},
+    MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_INFO)
+#undef MOCK_SETTINGS_INFO
+};
+
+// Schema ids ordered by name, for findSetting().
+std::vector<MockSettingsManager::SettingId> buildNameIndex() {
+    std::vector<MockSettingsManager::SettingId> index;
+    for (size_t i = 0; i < MockSettingsManager::kSettingCount; ++i) {
+        index.push_back(static_cast<MockSettingsManager::SettingId>(i));
+    }
+    std::sort(index.begin(), index.end(), [](MockSettingsManager::SettingId a, MockSettingsManager::SettingId b) {
+        return std::strcmp(kSettingInfo[static_cast<size_t>(a)].name, kSettingInfo[static_cast<size_t>(b)].name) < 0;
+    });
+    return index;
+}
+
+std::string formatLimit(double limit) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.10g", limit);
+    return text;
+}
+
+// Key a field is exported under. freezeThreshold keeps the name that backups and the UI
+// have always read ("pumpFreezeThreshold"); import accepts both.
+const char* kLegacyFreezeThresholdKey = "pumpFreezeThreshold";
+
+const char* jsonKey(MockSettingsManager::SettingId id) {
+    return id == MockSettingsManager::SettingId::freezeThreshold ? kLegacyFreezeThresholdKey
+                                                                 : kSettingInfo[static_cast<size_t>(id)].name;
+}
+
+// Stored form of a field: strings verbatim, anything else as its JSON literal, which keeps
+// floats exact.
+std::string storedText(const std::string& value) {
+    return value;
+}
+
+template <typename T>
+std::string storedText(T value) {
+    std::string text;
+    JsonWriter writer(text);
+    writer.value(value);
+    return text;
+}
+
+const char* kStoredRecipientsKey = "emailRecipients";
+const std::string kStoredRawPrefix = "raw:"; // Free-form keys, kept apart from schema names
+
+std::string rangeError(const MockSettingsManager::SettingInfo& info) {
+    if (info.type == MockSettingsManager::SettingType::STRING) {
+        return std::string(info.name) + " must be at most " + formatLimit(info.max) + " characters";
+    }
+    return std::string(info.name) + " must be between " + formatLimit(info.min) + " and " + formatLimit(info.max);
+}
+} // namespace
+
+const MockSettingsManager::SettingInfo& MockSettingsManager::getSettingInfo(SettingId id) {
+    return kSettingInfo[static_cast<size_t>(id)];
+}
+
+bool MockSettingsManager::findSetting(const std::string& key, SettingId& id) {
+    static const std::vector<SettingId> byName = buildNameIndex();
+    auto it = std::lower_bound(byName.begin(), byName.end(), key, [](SettingId candidate, const std::string& name) {
+        return name.compare(kSettingInfo[static_cast<size_t>(candidate)].name) > 0;
+    });
+    if (it == byName.end() || key != kSettingInfo[static_cast<size_t>(*it)].name) {
+        return false;
+    }
+    id = *it;
+    return true;
+}
+
+std::string MockSettingsManager::formatValue(bool value) {
+    return value ? "true" : "false";
+}
+
+std::string MockSettingsManager::formatValue(int value) {
+    return std::to_string(value);
+}
+
+std::string MockSettingsManager::formatValue(unsigned int value) {
+    return std::to_string(value);
+}
+
+std::string MockSettingsManager::formatValue(float value) {
+    return std::to_string(value);
+}
+
+double MockSettingsManager::toNumber(const std::string& value) {
+    return std::strtod(value.c_str(), nullptr);
+}
+
+bool MockSettingsManager::parseText(const char* text, size_t length, const SettingInfo&, bool& out) {
+    const std::string value(text, length);
+    if (value == "true" || value == "1") {
+        out = true;
+    } else if (value == "false" || value == "0") {
+        out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool MockSettingsManager::parseText(const char* text, size_t length, const SettingInfo& info, std::string& out) {
+    if (length < info.min || length > info.max) {
+        return false;
+    }
+    out.assign(text, length);
+    return true;
+}
+
+template <typename T>
+bool MockSettingsManager::parseText(const char* text, size_t length, const SettingInfo& info, T& out) {
+    // Whole text, within range and (for integers) whole, before narrowing to the field type.
+    char buffer[64];
+    if (length == 0 || length >= sizeof(buffer)) {
+        return false;
+    }
+    std::memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    char* end = nullptr;
+    const double value = std::strtod(buffer, &end);
+    if (*end != '\0' || !inRange(value, info) ||
+        (std::is_integral<T>::value && static_cast<double>(static_cast<T>(value)) != value)) {
+        return false;
+    }
+    out = static_cast<T>(value);
+    return true;
+}
+
+template <MockSettingsManager::SettingId Id>
+bool MockSettingsManager::assignText(const std::string& text) {
+    typename Field<Id>::Type value;
+    return parseText(text.data(), text.size(), getSettingInfo(Id), value) && set<Id>(value);
+}
+
+template <MockSettingsManager::SettingId Id>
+bool MockSettingsManager::assignTextTo(Settings& target, const char* text, size_t length) {
+    return parseText(text, length, getSettingInfo(Id), target.*Field<Id>::member());
+}
+
+bool MockSettingsManager::assignTextTo(Settings& target, SettingId id, const char* text, size_t length) {
+    switch (id) {
+#define MOCK_SETTINGS_ASSIGN_TO(name, type, min, max) \
+    case SettingId::name: return assignTextTo<SettingId::name>(target, text, length);
+        MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_ASSIGN_TO)
+#undef MOCK_SETTINGS_ASSIGN_TO
+        case SettingId::COUNT: break;
+    }
+    return false;
+}
+
+std::string MockSettingsManager::getSettingText(SettingId id) const {
+    switch (id) {
+#define MOCK_SETTINGS_TEXT(name, type, min, max) \
+    case SettingId::name: return formatValue(get<SettingId::name>());
+        MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_TEXT)
+#undef MOCK_SETTINGS_TEXT
+        case SettingId::COUNT: break;
+    }
+    return std::string();
+}
+
+double MockSettingsManager::getSettingNumber(SettingId id) const {
+    switch (id) {
+#define MOCK_SETTINGS_NUMBER(name, type, min, max) \
+    case SettingId::name: return toNumber(get<SettingId::name>());
+        MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_NUMBER)
+#undef MOCK_SETTINGS_NUMBER
+        case SettingId::COUNT: break;
+    }
+    return 0.0;
+}
+
+bool MockSettingsManager::setSettingText(SettingId id, const std::string& text) {
+    switch (id) {
+#define MOCK_SETTINGS_ASSIGN(name, type, min, max) \
+    case SettingId::name: return assignText<SettingId::name>(text);
+        MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_ASSIGN)
+#undef MOCK_SETTINGS_ASSIGN
+        case SettingId::COUNT: break;
+    }
+    return false;
+}
 
 // Individual setting accessor implementations
 bool MockSettingsManager::getSettingBool(const std::string& key, bool defaultValue) const {
+    SettingId id;
+    if (findSetting(key, id)) {
+        return getSettingNumber(id) != 0.0 || getSettingText(id) == "true";
+    }
     auto it = rawSettings_.find(key);
     if (it == rawSettings_.end()) {
         return defaultValue;
@@ -13,6 +245,10 @@ bool MockSettingsManager::getSettingBool(const std::string& key, bool defaultVal
 }
 
 int MockSettingsManager::getSettingInt(const std::string& key, int defaultValue) const {
+    SettingId id;
+    if (findSetting(key, id)) {
+        return static_cast<int>(getSettingNumber(id));
+    }
     auto it = rawSettings_.find(key);
     if (it == rawSettings_.end()) {
         return defaultValue;
@@ -24,6 +260,11 @@ int MockSettingsManager::getSettingInt(const std::string& key, int defaultValue)
 }
 
 unsigned int MockSettingsManager::getSettingUInt(const std::string& key, unsigned int defaultValue) const {
+    SettingId id;
+    if (findSetting(key, id)) {
+        const double value = getSettingNumber(id);
+        return value > 0.0 ? static_cast<unsigned int>(value) : 0u;
+    }
     auto it = rawSettings_.find(key);
     if (it == rawSettings_.end()) {
         return defaultValue;
@@ -35,6 +276,10 @@ unsigned int MockSettingsManager::getSettingUInt(const std::string& key, unsigne
 }
 
 float MockSettingsManager::getSettingFloat(const std::string& key, float defaultValue) const {
+    SettingId id;
+    if (findSetting(key, id)) {
+        return static_cast<float>(getSettingNumber(id));
+    }
     auto it = rawSettings_.find(key);
     if (it == rawSettings_.end()) {
         return defaultValue;
@@ -46,6 +291,10 @@ float MockSettingsManager::getSettingFloat(const std::string& key, float default
 }
 
 std::string MockSettingsManager::getSettingString(const std::string& key, const std::string& defaultValue) const {
+    SettingId id;
+    if (findSetting(key, id)) {
+        return getSettingText(id);
+    }
     auto it = rawSettings_.find(key);
     if (it == rawSettings_.end()) {
         return defaultValue;
@@ -54,44 +303,109 @@ std::string MockSettingsManager::getSettingString(const std::string& key, const
 }
 
 bool MockSettingsManager::setSettingBool(const std::string& key, bool value) {
-    std::string oldValue = getSettingRaw(key);
-    setSettingRaw(key, value ? "true" : "false");
-    notifySettingChange(key, oldValue, value ? "true" : "false");
-    return true;
+    return setSettingString(key, value ? "true" : "false");
 }
 
 bool MockSettingsManager::setSettingInt(const std::string& key, int value) {
-    std::string oldValue = getSettingRaw(key);
-    std::string newValue = std::to_string(value);
-    setSettingRaw(key, newValue);
-    notifySettingChange(key, oldValue, newValue);
-    return true;
+    return setSettingString(key, std::to_string(value));
 }
 
 bool MockSettingsManager::setSettingUInt(const std::string& key, unsigned int value) {
-    std::string oldValue = getSettingRaw(key);
-    std::string newValue = std::to_string(value);
-    setSettingRaw(key, newValue);
-    notifySettingChange(key, oldValue, newValue);
-    return true;
+    return setSettingString(key, std::to_string(value));
 }
 
 bool MockSettingsManager::setSettingFloat(const std::string& key, float value) {
-    std::string oldValue = getSettingRaw(key);
-    std::string newValue = std::to_string(value);
-    setSettingRaw(key, newValue);
-    notifySettingChange(key, oldValue, newValue);
-    return true;
+    // Enough digits to read back as the same float.
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", static_cast<double>(value));
+    return setSettingString(key, text);
 }
 
 bool MockSettingsManager::setSettingString(const std::string& key, const std::string& value) {
+    SettingId id;
+    if (findSetting(key, id)) {
+        return setSettingText(id, value);
+    }
     std::string oldValue = getSettingRaw(key);
     setSettingRaw(key, value);
     notifySettingChange(key, oldValue, value);
     return true;
 }
 
+void MockSettingsManager::setStorage(StorageBackend* storage, const SettingsStore::Config& config) {
+    storage_ = storage;
+    store_.reset();
+    if (storage) {
+        store_.reset(new SettingsStore(*storage));
+        store_->setConfig(config);
+    }
+}
+
+SettingsStore::Values MockSettingsManager::storedValues() const {
+    SettingsStore::Values values;
+#define MOCK_SETTINGS_STORE(name, type, min, max) values[#name] = storedText(settings_.name);
+    MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_STORE)
+#undef MOCK_SETTINGS_STORE
+
+    std::string recipients;
+    JsonWriter writer(recipients);
+    writer.beginArray();
+    for (const auto& recipient : settings_.emailRecipients) {
+        writer.value(recipient);
+    }
+    writer.endArray();
+    values[kStoredRecipientsKey] = recipients;
+
+    for (const auto& entry : rawSettings_) {
+        values[kStoredRawPrefix + entry.first] = entry.second;
+    }
+    return values;
+}
+
+void MockSettingsManager::applyStoredValues(const SettingsStore::Values& values) {
+    Settings loaded;
+    std::map<std::string, std::string> raw;
+    for (const auto& entry : values) {
+        SettingId id;
+        if (findSetting(entry.first, id)) {
+            // A value the schema no longer accepts keeps its default.
+            assignTextTo(loaded, id, entry.second.data(), entry.second.size());
+        } else if (entry.first == kStoredRecipientsKey) {
+            std::vector<std::string> recipients;
+            JsonReader reader;
+            const bool parsed = reader.parse(entry.second, [&](const JsonReader::Token& token) -> const char* {
+                if (token.depth == 0) {
+                    return token.event == JsonReader::Event::ARRAY_START || token.event == JsonReader::Event::ARRAY_END
+                               ? nullptr
+                               : "expected an array";
+                }
+                if (token.event != JsonReader::Event::STRING) {
+                    return "expected a string";
+                }
+                recipients.push_back(std::string(token.text, token.length));
+                return nullptr;
+            });
+            if (parsed) {
+                loaded.emailRecipients.swap(recipients);
+            }
+        } else if (entry.first.compare(0, kStoredRawPrefix.size(), kStoredRawPrefix) == 0) {
+            raw[entry.first.substr(kStoredRawPrefix.size())] = entry.second;
+        }
+    }
+
+    settings_ = loaded;
+    rawSettings_.swap(raw);
+    ++version_;
+    unsavedChanges_ = false;
+    publish();
+}
+
 bool MockSettingsManager::loadSettings() {
+    if (store_) {
+        store_->begin();
+        applyStoredValues(store_->values());
+        return true;
+    }
     if (testMode_) {
         // In test mode, use in-memory storage
         return true;
@@ -103,6 +417,13 @@ bool MockSettingsManager::loadSettings() {
 }
 
 bool MockSettingsManager::saveSettings() {
+    if (store_) {
+        if (!store_->save(storedValues())) {
+            return false;
+        }
+        unsavedChanges_ = false;
+        return true;
+    }
     if (testMode_) {
         // In test mode, just mark as saved
         unsavedChanges_ = false;
@@ -115,13 +436,17 @@ bool MockSettingsManager::saveSettings() {
 }
 
 bool MockSettingsManager::resetToDefaults() {
+    // One mutation, one version step (clearAllSettings() would add a second).
     settings_ = Settings{};
-    clearAllSettings();
-    unsavedChanges_ = true;
+    rawSettings_.clear();
+    markChanged();
     return true;
 }
 
 bool MockSettingsManager::settingsFileExists() const {
+    if (store_) {
+        return store_->hasData();
+    }
     if (testMode_) {
         return true; // Simulate file exists in test mode
     }
@@ -132,89 +457,155 @@ bool MockSettingsManager::settingsFileExists() const {
 
 void MockSettingsManager::setSettings(const Settings& settings) {
     settings_ = settings;
-    unsavedChanges_ = true;
+    markChanged();
 }
 
 std::string MockSettingsManager::serializeToJson() const {
-    // Simplified JSON serialization for testing
-    std::ostringstream json;
-    json << "{\n";
-    json << "  \"pumpEnabled\": " << (settings_.pumpEnabled ? "true" : "false") << ",\n";
-    json << "  \"pumpFreezeThreshold\": " << settings_.freezeThreshold << ",\n";
-    json << "  \"pumpOnDuration\": " << settings_.pumpOnDuration << ",\n";
-    json << "  \"pumpOffDuration\": " << settings_.pumpOffDuration << ",\n";
-    json << "  \"lightEnabled\": " << (settings_.lightEnabled ? "true" : "false") << ",\n";
-    json << "  \"lightMaxBrightness\": " << static_cast<int>(settings_.lightMaxBrightness) << ",\n";
-    json << "  \"wifiSSID\": \"" << settings_.wifiSSID << "\",\n";
-    json << "  \"wifiPassword\": \"" << settings_.wifiPassword << "\",\n";
-    json << "  \"tempMeterPin\": " << settings_.tempMeterPin << ",\n";
-    json << "  \"lightPin\": " << settings_.lightPin << ",\n";
-    json << "  \"pulsesPerGallon\": " << settings_.pulsesPerGallon << "\n";
-    json << "}";
-    
-    return json.str();
+    std::string json;
+    JsonWriter writer(json, true);
+    writer.beginObject();
+#define MOCK_SETTINGS_WRITE(name, type, min, max) \
+    writer.key(jsonKey(SettingId::name));        \
+    writer.value(settings_.name);
+    MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_WRITE)
+#undef MOCK_SETTINGS_WRITE
+    writer.key("emailRecipients");
+    writer.beginArray();
+    for (const auto& recipient : settings_.emailRecipients) {
+        writer.value(recipient);
+    }
+    writer.endArray();
+    writer.endObject();
+    return json;
 }
 
 bool MockSettingsManager::deserializeFromJson(const std::string& json) {
-    // Simplified JSON parsing for testing
-    // In real implementation would use ArduinoJson
-    if (json.find("\"pumpEnabled\"") != std::string::npos) {
-        settings_.pumpEnabled = json.find("true") != std::string::npos;
-    }
-    if (json.find("\"lightEnabled\"") != std::string::npos) {
-        settings_.lightEnabled = json.find("true") != std::string::npos;
-    }
-    // Parse other fields as needed...
-    
-    unsavedChanges_ = true;
-    return true;
+    JsonReader::Error error;
+    return deserializeFromJson(json, error);
 }
 
-bool MockSettingsManager::validateSettings() const {
-    // Basic validation for testing
-    if (settings_.freezeThreshold < -55.0f || settings_.freezeThreshold > 125.0f) {
-        return false;
-    }
-    if (settings_.pumpOnDuration == 0 || settings_.pumpOffDuration == 0) {
-        return false;
-    }
-    if (settings_.lightMaxBrightness > 255 || settings_.lightMinBrightness > 255) {
-        return false;
-    }
-    if (settings_.lightMaxBrightness < settings_.lightMinBrightness) {
+bool MockSettingsManager::deserializeFromJson(const std::string& json, JsonReader::Error& error) {
+    using Event = JsonReader::Event;
+
+    // Values land in a copy, which replaces the live settings only if the whole document
+    // was good.
+    Settings staged = settings_;
+    bool haveSetting = false;   // The current key names a schema field
+    SettingId id = SettingId::COUNT;
+    bool recipientsKey = false; // The current key is emailRecipients...
+    bool inRecipients = false;  // ...and its array is being read
+    size_t skipping = 0;        // Depth of an unknown key's container value, or 0
+
+    JsonReader reader;
+    const bool parsed = reader.parse(json, [&](const JsonReader::Token& token) -> const char* {
+        if (token.depth == 0) {
+            if (token.event == Event::OBJECT_END) {
+                // Whole document read: rules spanning fields apply to the result.
+                return crossFieldError(staged);
+            }
+            return token.event == Event::OBJECT_START ? nullptr : "expected an object";
+        }
+        if (skipping) {
+            if ((token.event == Event::OBJECT_END || token.event == Event::ARRAY_END) && token.depth == skipping) {
+                skipping = 0;
+            }
+            return nullptr;
+        }
+        if (inRecipients) {
+            if (token.event == Event::ARRAY_END && token.depth == 1) {
+                inRecipients = false;
+                return nullptr;
+            }
+            if (token.event != Event::STRING) {
+                return "expected a string";
+            }
+            staged.emailRecipients.push_back(std::string(token.text, token.length));
+            return nullptr;
+        }
+
+        if (token.event == Event::KEY) {
+            haveSetting = findSetting(std::string(token.text, token.length), id);
+            if (!haveSetting && token.is(kLegacyFreezeThresholdKey)) {
+                // The name the export uses (see jsonKey).
+                id = SettingId::freezeThreshold;
+                haveSetting = true;
+            }
+            recipientsKey = !haveSetting && token.is("emailRecipients");
+            return nullptr;
+        }
+
+        // A value at depth 1.
+        if (recipientsKey) {
+            recipientsKey = false;
+            if (token.event != Event::ARRAY_START) {
+                return "expected an array";
+            }
+            staged.emailRecipients.clear();
+            inRecipients = true;
+            return nullptr;
+        }
+        if (!haveSetting) {
+            if (token.event == Event::OBJECT_START || token.event == Event::ARRAY_START) {
+                skipping = token.depth;
+            }
+            return nullptr;
+        }
+        haveSetting = false;
+
+        const SettingType type = getSettingInfo(id).type;
+        const bool typeMatches = type == SettingType::STRING ? token.event == Event::STRING
+                                 : type == SettingType::BOOL ? token.event == Event::BOOL
+                                                             : token.event == Event::NUMBER;
+        if (!typeMatches) {
+            return "wrong type for setting";
+        }
+        if (!assignTextTo(staged, id, token.text, token.length)) {
+            return "setting out of range";
+        }
+        return nullptr;
+    });
+
+    error = reader.error();
+    if (!parsed) {
         return false;
     }
+    settings_ = staged;
+    markChanged();
     return true;
 }
 
+const char* MockSettingsManager::crossFieldError(const Settings& settings) {
+    if (settings.lightMaxBrightness < settings.lightMinBrightness) {
+        return "Max brightness must be greater than or equal to min brightness";
+    }
+    return nullptr;
+}
+
+bool MockSettingsManager::validateSettings() const {
+    return getValidationErrors().empty();
+}
+
 std::vector<std::string> MockSettingsManager::getValidationErrors() const {
     std::vector<std::string> errors;
-    
-    if (settings_.freezeThreshold < -55.0f || settings_.freezeThreshold > 125.0f) {
-        errors.push_back("Freeze threshold out of DS18B20 sensor range");
-    }
-    if (settings_.pumpOnDuration == 0) {
-        errors.push_back("Pump on duration cannot be zero");
-    }
-    if (settings_.pumpOffDuration == 0) {
-        errors.push_back("Pump off duration cannot be zero");
-    }
-    if (settings_.lightMaxBrightness > 255) {
-        errors.push_back("Light max brightness exceeds 255");
-    }
-    if (settings_.lightMinBrightness > 255) {
-        errors.push_back("Light min brightness exceeds 255");
+
+#define MOCK_SETTINGS_CHECK(name, type, min, max)                  \
+    if (!inRange(settings_.name, getSettingInfo(SettingId::name))) { \
+        errors.push_back(rangeError(getSettingInfo(SettingId::name))); \
     }
-    if (settings_.lightMaxBrightness < settings_.lightMinBrightness) {
-        errors.push_back("Max brightness must be greater than or equal to min brightness");
+    MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_CHECK)
+#undef MOCK_SETTINGS_CHECK
+
+    if (const char* error = crossFieldError(settings_)) {
+        errors.push_back(error);
     }
     
     return errors;
 }
 
 bool MockSettingsManager::createBackup(const std::string& filename) {
-    (void)filename;
-
+    if (storage_) {
+        return storage_->writeFile(filename, serializeToJson());
+    }
     if (testMode_) {
         // In test mode, just simulate backup creation
         return true;
@@ -225,8 +616,10 @@ bool MockSettingsManager::createBackup(const std::string& filename) {
 }
 
 bool MockSettingsManager::restoreBackup(const std::string& filename) {
-    (void)filename;
-
+    if (storage_) {
+        std::string json;
+        return storage_->readFile(filename, json) && deserializeFromJson(json);
+    }
     if (testMode_) {
         // In test mode, simulate restore
         return true;
@@ -242,12 +635,12 @@ void MockSettingsManager::setSettingsChangeCallback(SettingsChangeCallback callb
 
 void MockSettingsManager::clearAllSettings() {
     rawSettings_.clear();
-    unsavedChanges_ = true;
+    markChanged();
 }
 
 void MockSettingsManager::setSettingRaw(const std::string& key, const std::string& value) {
     rawSettings_[key] = value;
-    unsavedChanges_ = true;
+    markChanged();
 }
 
 std::string MockSettingsManager::getSettingRaw(const std::string& key) const {
@@ -264,6 +657,19 @@ void MockSettingsManager::notifySettingChange(const std::string& key, const std:
     }
 }
 
+void MockSettingsManager::markChanged() {
+    unsavedChanges_ = true;
+    ++version_;
+    publish();
+}
+
+void MockSettingsManager::publish() {
+    snapshots_.publish([this](Snapshot& next) {
+        next.settings = settings_;
+        next.version = version_;
+    });
+}
+
 std::string MockSettingsManager::getSettingKey(const std::string& group, const std::string& name) const {
     return group + "." + name;
 }
\ No newline at end of file
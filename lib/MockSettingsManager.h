@@ -6,6 +6,73 @@
 #include <memory>
 #include <functional>
 #include <map>
+#include <cstddef>
+#include <cstdint>
+
+#include "JsonReader.h"
+#include "SettingsStore.h"
+#include "SnapshotCell.h"
+#include "StorageBackend.h"
+
+// The settings schema: one line per scalar Settings field giving its name (also its string
+// key), its type and the accepted range, which for strings is a length. Defaults are the
+// member initializers in Settings. Each entry becomes a SettingId with typed get<>()/set<>(),
+// range validation and string-key access. emailRecipients is a list and stays outside it.
+#define MOCK_SETTINGS_SCHEMA(X)                                 \
+    X(pumpEnabled, bool, 0, 1)                                  \
+    X(freezeThreshold, float, -55, 125) /* DS18B20 range */     \
+    X(pumpOnDuration, uint32_t, 1, 86400)                       \
+    X(pumpOffDuration, uint32_t, 1, 86400)                      \
+    X(pumpMaxOnTime, uint32_t, 1, 86400)                        \
+    X(pumpFaultTimeout, uint32_t, 1, 3600)                      \
+    X(pumpMinPulsesPerMinute, uint32_t, 0, 100000)              \
+    X(lightEnabled, bool, 0, 1)                                 \
+    X(lightMaxBrightness, uint8_t, 0, 255)                      \
+    X(lightMinBrightness, uint8_t, 0, 255)                      \
+    X(lightFadeInDuration, uint32_t, 0, 86400)                  \
+    X(lightFadeOutDuration, uint32_t, 0, 86400)                 \
+    X(lightDayStartHour, uint32_t, 0, 23)                       \
+    X(lightDayEndHour, uint32_t, 0, 24)                         \
+    X(lightEnableSunriseSunset, bool, 0, 1)                     \
+    X(lightLatitude, float, -90, 90)                            \
+    X(lightLongitude, float, -180, 180)                         \
+    X(lightTimezoneOffset, int, -720, 840)                      \
+    X(wifiSSID, std::string, 0, 32)                             \
+    X(wifiPassword, std::string, 0, 64)                         \
+    X(wifiEnabled, bool, 0, 1)                                  \
+    X(webServerPort, uint16_t, 1, 65535)                        \
+    X(tempMeterPin, uint32_t, 0, 39)                            \
+    X(tempMeter2Pin, uint32_t, 0, 39)                           \
+    X(pumpPin, uint32_t, 0, 39)                                 \
+    X(lightPin, uint32_t, 0, 39)                                \
+    X(pulsesPerGallon, uint32_t, 1, 100000)                     \
+    X(syslogEnabled, bool, 0, 1)                                \
+    X(syslogServer, std::string, 0, 253)                        \
+    X(syslogPort, uint16_t, 1, 65535)                           \
+    X(emailEnabled, bool, 0, 1)                                 \
+    X(emailNotificationsEnabled, bool, 0, 1)                    \
+    X(emailSmtpServer, std::string, 0, 253)                     \
+    X(emailSmtpPort, uint16_t, 1, 65535)                        \
+    X(emailSmtpUseTLS, bool, 0, 1)                              \
+    X(emailFromAddress, std::string, 0, 254)                    \
+    X(emailUsername, std::string, 0, 254)                       \
+    X(emailPassword, std::string, 0, 128)                       \
+    X(doorEnabled, bool, 0, 1)                                  \
+    X(doorOpenTime, uint32_t, 1, 600)                           \
+    X(doorCloseTime, uint32_t, 1, 600)                          \
+    X(doorRetryAttempts, uint32_t, 0, 10)                       \
+    X(telegramEnabled, bool, 0, 1)                              \
+    X(telegramBotToken, std::string, 0, 128)                    \
+    X(telegramChatId, std::string, 0, 32)                       \
+    X(openweatherEnabled, bool, 0, 1)                           \
+    X(openweatherApiKey, std::string, 0, 64)                    \
+    X(openweatherLatitude, float, -90, 90)                      \
+    X(openweatherLongitude, float, -180, 180)                   \
+    X(pushbuttonEnabled, bool, 0, 1)                            \
+    X(pushbuttonPin, uint32_t, 0, 39)                           \
+    X(pushbuttonDebounceMs, uint32_t, 0, 1000)                  \
+    X(systemMetricsLogging, bool, 0, 1)                         \
+    X(lastRebootReason, uint32_t, 0, 4294967295.0)
 
 class MockSettingsManager {
 public:
@@ -88,9 +155,37 @@ public:
         uint32_t lastRebootReason = 0;
     };
 
+    enum class SettingId : uint8_t {
+#define MOCK_SETTINGS_ID(name, type, min, max) name,
+        MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_ID)
+#undef MOCK_SETTINGS_ID
+        COUNT
+    };
+    static const size_t kSettingCount = static_cast<size_t>(SettingId::COUNT);
+
+    enum class SettingType : uint8_t { BOOL, INT, UINT, FLOAT, STRING };
+
+    struct SettingInfo {
+        const char* name;
+        SettingType type;
+        double min; // Value range, or length range for strings
+        double max;
+    };
+
+    // Compile-time description of one field: its C++ type, member and range (specialized
+    // for every SettingId below the class).
+    template <SettingId Id>
+    struct Field;
+
     MockSettingsManager() = default;
     virtual ~MockSettingsManager() = default;
 
+    // Persistence. With storage attached, load/save go through a SettingsStore there (only
+    // changed keys are written, and a save survives power loss whole or not at all) and
+    // backups are JSON files beside it. Without it they are in-memory no-ops.
+    void setStorage(StorageBackend* storage, const SettingsStore::Config& config = SettingsStore::Config());
+    const SettingsStore* getStore() const { return store_.get(); }
+
     // Settings management
     bool loadSettings();
     bool saveSettings();
@@ -100,8 +195,38 @@ public:
     // Settings access
     Settings getSettings() const { return settings_; }
     void setSettings(const Settings& settings);
+
+    // Immutable copy of the settings as of one version.
+    struct Snapshot {
+        Settings settings;
+        uint64_t version = 0;
+    };
+    using SnapshotRef = SnapshotCell<Snapshot>::Ref;
+
+    // The latest published settings, for readers on other threads (pump and light ticks):
+    // a pinned view rather than a copy of every string, consistent for as long as it is
+    // held. Lock-free on both sides (SnapshotCell); each mutation publishes into a spare
+    // snapshot once no reader holds it. Everything else on this class, including every
+    // setter, stays on the owning thread, and no SnapshotRef may outlive the manager.
+    SnapshotRef snapshot() const { return snapshots_.load(); }
     
-    // Individual setting accessors
+    // Typed access: a direct member read, no lookup or parsing. set() rejects values outside
+    // the schema range (returning false and leaving the setting alone); writing the current
+    // value again is not a change.
+    template <SettingId Id>
+    typename Field<Id>::Type get() const {
+        return settings_.*Field<Id>::member();
+    }
+    template <SettingId Id>
+    bool set(const typename Field<Id>::Type& value);
+
+    static const SettingInfo& getSettingInfo(SettingId id);
+    // Schema lookup by name (binary search); false for keys outside the schema.
+    static bool findSetting(const std::string& key, SettingId& id);
+
+    // Individual setting accessors. Keys naming a schema field ("pumpOnDuration") read and
+    // write the typed setting, converting as needed; any other key is a free-form string
+    // value kept on the side.
     bool getSettingBool(const std::string& key, bool defaultValue = false) const;
     int getSettingInt(const std::string& key, int defaultValue = 0) const;
     unsigned int getSettingUInt(const std::string& key, unsigned int defaultValue = 0u) const;
@@ -114,9 +239,13 @@ public:
     bool setSettingFloat(const std::string& key, float value);
     bool setSettingString(const std::string& key, const std::string& value);
     
-    // Serialization
+    // Serialization: every schema field plus emailRecipients, by name. Reading is a single
+    // pass (JsonReader) and all-or-nothing: on a syntax error, a wrong type, an out-of-range
+    // value or a result that breaks a cross-field rule (brightness order) nothing changes
+    // and `error` says where. Unknown keys are skipped.
     std::string serializeToJson() const;
     bool deserializeFromJson(const std::string& json);
+    bool deserializeFromJson(const std::string& json, JsonReader::Error& error);
     
     // Validation
     bool validateSettings() const;
@@ -129,6 +258,8 @@ public:
     // Change tracking
     bool hasUnsavedChanges() const { return unsavedChanges_; }
     void markSaved() { unsavedChanges_ = false; }
+    // Bumped by every mutation (saving does not count); cached responses compare it.
+    uint64_t getVersion() const { return version_; }
     
     // Callback registration
     using SettingsChangeCallback = std::function<void(const std::string& key, const std::string& oldValue, const std::string& newValue)>;
@@ -146,12 +277,83 @@ private:
     Settings settings_;
     std::map<std::string, std::string> rawSettings_;
     bool unsavedChanges_ = false;
+    uint64_t version_ = 0;
     bool testMode_ = false;
     std::string settingsFilePath_ = "/test/user_settings.json";
     SettingsChangeCallback changeCallback_;
+    StorageBackend* storage_ = nullptr;
+    std::unique_ptr<SettingsStore> store_;
+    SnapshotCell<Snapshot> snapshots_;
     
+    void markChanged();
+    void publish();
+    // Rules spanning several fields (per-field ranges are in the schema), or nullptr.
+    static const char* crossFieldError(const Settings& settings);
+    SettingsStore::Values storedValues() const;
+    void applyStoredValues(const SettingsStore::Values& values);
+
+    // String-key path: a switch over the schema into these per-field templates.
+    template <SettingId Id>
+    bool assignText(const std::string& text);
+    template <SettingId Id>
+    static bool assignTextTo(Settings& target, const char* text, size_t length);
+    static bool assignTextTo(Settings& target, SettingId id, const char* text, size_t length);
+    std::string getSettingText(SettingId id) const;
+    double getSettingNumber(SettingId id) const;
+    bool setSettingText(SettingId id, const std::string& text);
+
+    static std::string formatValue(bool value);
+    static std::string formatValue(int value);
+    static std::string formatValue(unsigned int value);
+    static std::string formatValue(float value);
+    static std::string formatValue(const std::string& value) { return value; }
+    static double toNumber(const std::string& value);
+    template <typename T>
+    static double toNumber(T value) {
+        return static_cast<double>(value);
+    }
+    static bool parseText(const char* text, size_t length, const SettingInfo& info, bool& out);
+    static bool parseText(const char* text, size_t length, const SettingInfo& info, std::string& out);
+    template <typename T>
+    static bool parseText(const char* text, size_t length, const SettingInfo& info, T& out);
+    template <typename T>
+    static bool inRange(const T& value, const SettingInfo& info) {
+        return value >= info.min && value <= info.max;
+    }
+    static bool inRange(const std::string& value, const SettingInfo& info) {
+        return value.size() >= info.min && value.size() <= info.max;
+    }
     void notifySettingChange(const std::string& key, const std::string& oldValue, const std::string& newValue);
     std::string getSettingKey(const std::string& group, const std::string& name) const;
 };
 
+#define MOCK_SETTINGS_FIELD(name, type, min, max)                                          \
+    template <>                                                                            \
+    struct MockSettingsManager::Field<MockSettingsManager::SettingId::name> {              \
+        using Type = type;                                                                 \
+        using Member = type MockSettingsManager::Settings::*;                              \
+        static Member member() { return &MockSettingsManager::Settings::name; }            \
+    };
+MOCK_SETTINGS_SCHEMA(MOCK_SETTINGS_FIELD)
+#undef MOCK_SETTINGS_FIELD
+
+template <MockSettingsManager::SettingId Id>
+bool MockSettingsManager::set(const typename Field<Id>::Type& value) {
+    const SettingInfo& info = getSettingInfo(Id);
+    if (!inRange(value, info)) {
+        return false;
+    }
+    typename Field<Id>::Type& slot = settings_.*Field<Id>::member();
+    if (slot == value) {
+        return true;
+    }
+    const typename Field<Id>::Type old = slot;
+    slot = value;
+    markChanged();
+    if (changeCallback_) {
+        notifySettingChange(info.name, formatValue(old), formatValue(value));
+    }
+    return true;
+}
+
 #endif // MOCK_SETTINGS_MANAGER_H
\ No newline at end of file
@@ -12,26 +12,33 @@ void MockSystemMetrics::setHeapSize(uint32_t totalHeap, uint32_t freeHeap) {
     if (totalHeap > 0) {
         stats_.heapUsagePercent = (float)stats_.usedHeapBytes / (float)totalHeap * 100.0f;
     }
+    ++version_;
 }
 
 void MockSystemMetrics::setBootTime(uint64_t bootTimestamp) {
     stats_.bootTimestamp = bootTimestamp;
     bootTime_ = std::chrono::steady_clock::now();
+    ++version_;
 }
 
 void MockSystemMetrics::updateUptime() {
     auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - bootTime_);
+    if (static_cast<uint32_t>(elapsed.count()) == stats_.uptimeSeconds) {
+        return;
+    }
     
     stats_.uptimeSeconds = elapsed.count();
     stats_.uptimeDays = stats_.uptimeSeconds / 86400;
     stats_.uptimeHours = (stats_.uptimeSeconds % 86400) / 3600;
     stats_.uptimeMinutes = (stats_.uptimeSeconds % 3600) / 60;
+    ++version_;
 }
 
 void MockSystemMetrics::setBootReason(uint32_t reasonCode) {
     stats_.bootReasonCode = reasonCode;
     stats_.bootReasonString = getBootReasonName(reasonCode);
+    ++version_;
 }
 
 void MockSystemMetrics::setWiFiStatus(bool connected, uint8_t signalStrength, 
@@ -40,34 +47,41 @@ void MockSystemMetrics::setWiFiStatus(bool connected, uint8_t signalStrength,
     stats_.wifiSignalStrength = signalStrength;
     stats_.wifiRSSI = rssi;
     stats_.wifiSSID = ssid;
+    ++version_;
 }
 
 void MockSystemMetrics::setTemperatureStats(uint32_t sensorCount, float averageTemp) {
     stats_.temperatureSensors = sensorCount;
     stats_.averageTemperature = averageTemp;
+    ++version_;
 }
 
 void MockSystemMetrics::addPumpCycle(uint32_t runTimeSeconds) {
     stats_.pumpRunTimeSeconds += runTimeSeconds;
     stats_.pumpCycles++;
+    ++version_;
 }
 
 void MockSystemMetrics::setPumpStats(uint32_t totalRunSeconds, uint32_t cycleCount) {
     stats_.pumpRunTimeSeconds = totalRunSeconds;
     stats_.pumpCycles = cycleCount;
+    ++version_;
 }
 
 void MockSystemMetrics::addDoorOperation() {
     stats_.doorOperations++;
+    ++version_;
 }
 
 void MockSystemMetrics::addDoorFault() {
     stats_.doorFaults++;
+    ++version_;
 }
 
 void MockSystemMetrics::setDoorStats(uint32_t operations, uint32_t faults) {
     stats_.doorOperations = operations;
     stats_.doorFaults = faults;
+    ++version_;
 }
 
 std::string MockSystemMetrics::toJson() const {
@@ -103,16 +117,19 @@ void MockSystemMetrics::resetStats() {
     stats_.pumpCycles = 0;
     stats_.doorOperations = 0;
     stats_.doorFaults = 0;
+    ++version_;
 }
 
 void MockSystemMetrics::resetPumpStats() {
     stats_.pumpRunTimeSeconds = 0;
     stats_.pumpCycles = 0;
+    ++version_;
 }
 
 void MockSystemMetrics::resetDoorStats() {
     stats_.doorOperations = 0;
     stats_.doorFaults = 0;
+    ++version_;
 }
 
 std::string MockSystemMetrics::getFormattedReport() const {
@@ -65,7 +65,7 @@ public:
     std::string getBootReasonString() const { return stats_.bootReasonString; }
     
     // CPU usage
-    void setCPUUsage(float usagePercent) { stats_.cpuUsagePercent = usagePercent; }
+    void setCPUUsage(float usagePercent) { stats_.cpuUsagePercent = usagePercent; ++version_; }
     float getCPUUsage() const { return stats_.cpuUsagePercent; }
     uint32_t getCPUSpeed() const { return stats_.cpuSpeed; }
     uint32_t getCoreCount() const { return stats_.coreCount; }
@@ -101,6 +101,8 @@ public:
     
     // JSON serialization
     std::string toJson() const;
+    // Bumped whenever a value in toJson() changes, so callers can reuse its output.
+    uint64_t getVersion() const { return version_; }
     
     // Reset statistics
     void resetStats();
@@ -112,6 +114,7 @@ public:
 
 private:
     SystemStats stats_;
+    uint64_t version_ = 0;
     std::chrono::steady_clock::time_point bootTime_;
     
     std::string getBootReasonName(uint32_t reasonCode);
@@ -1,9 +1,189 @@
 #include "MockWebServer.h"
+#include "RequestLimiter.h"
+#include "StaticAssetCache.h"
 #include <algorithm>
 #include <sstream>
 #include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
-MockWebServer::MockWebServer(uint16_t port) : port_(port) {
+const size_t MockWebServer::kMaxRequestHeaders;
+const uint16_t MockWebServer::kNoRoute;
+const size_t MockWebServer::kLatencyBuckets;
+
+bool MockWebServer::Slice::equals(const char* text) const {
+    return std::strlen(text) == length && std::memcmp(data, text, length) == 0;
+}
+
+bool MockWebServer::Slice::equalsIgnoreCase(const char* text) const {
+    for (size_t i = 0; i < length; ++i) {
+        if (text[i] == '\0' || std::tolower(static_cast<unsigned char>(data[i])) !=
+                                    std::tolower(static_cast<unsigned char>(text[i]))) {
+            return false;
+        }
+    }
+    return text[length] == '\0';
+}
+
+MockWebServer::RequestView::RequestView(const HttpRequest& source)
+    : method(source.method), target(source.url), path(source.path), body(source.body),
+      clientIP(source.clientIP), clientPort(source.clientPort), source_(&source) {
+    const size_t queryPos = source.url.find('?');
+    if (queryPos != std::string::npos) {
+        query = Slice(source.url.data() + queryPos + 1, source.url.size() - queryPos - 1);
+    }
+    for (const auto& header : source.headers) {
+        if (headerCount == kMaxRequestHeaders) {
+            break;
+        }
+        headers[headerCount].name = Slice(header.first);
+        headers[headerCount].value = Slice(header.second);
+        ++headerCount;
+    }
+}
+
+MockWebServer::Slice MockWebServer::RequestView::header(const char* name) const {
+    for (size_t i = 0; i < headerCount; ++i) {
+        if (headers[i].name.equalsIgnoreCase(name)) {
+            return headers[i].value;
+        }
+    }
+    return Slice();
+}
+
+bool MockWebServer::RequestView::hasHeader(const char* name) const {
+    for (size_t i = 0; i < headerCount; ++i) {
+        if (headers[i].name.equalsIgnoreCase(name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MockWebServer::Slice MockWebServer::RequestView::queryParam(const char* name) const {
+    if (source_) {
+        // simulateGet() and friends fill queryParams without keeping the raw query.
+        auto it = source_->queryParams.find(name);
+        return it != source_->queryParams.end() ? Slice(it->second) : Slice();
+    }
+
+    // Last occurrence wins, as in parseQueryParams().
+    Slice found;
+    const size_t nameLength = std::strlen(name);
+    const char* pair = query.data;
+    const char* end = query.data + query.length;
+    while (pair < end) {
+        const char* next = static_cast<const char*>(std::memchr(pair, '&', static_cast<size_t>(end - pair)));
+        if (!next) {
+            next = end;
+        }
+        const char* eq = static_cast<const char*>(std::memchr(pair, '=', static_cast<size_t>(next - pair)));
+        if (eq && static_cast<size_t>(eq - pair) == nameLength && std::memcmp(pair, name, nameLength) == 0) {
+            found = Slice(eq + 1, static_cast<size_t>(next - eq - 1));
+        }
+        pair = next + 1;
+    }
+    return found;
+}
+
+MockWebServer::Slice MockWebServer::RequestView::pathParam(const char* name) const {
+    for (size_t i = 0; i < paramCount_ && i < paramNames_->size(); ++i) {
+        if ((*paramNames_)[i] == name) {
+            return Slice(path.data + params_[i].offset, params_[i].length);
+        }
+    }
+    return Slice();
+}
+
+long long MockWebServer::RequestView::pathParamInt(const char* name, long long fallback) const {
+    const Slice value = pathParam(name);
+    char digits[24];
+    if (value.empty() || value.length >= sizeof(digits)) {
+        return fallback;
+    }
+    std::memcpy(digits, value.data, value.length);
+    digits[value.length] = '\0';
+    return std::strtoll(digits, nullptr, 10);
+}
+
+std::string MockWebServer::RequestView::attribute(const std::string& name) const {
+    if (!attributes_) {
+        return std::string();
+    }
+    auto it = attributes_->find(name);
+    return it != attributes_->end() ? it->second : std::string();
+}
+
+const MockWebServer::HttpRequest& MockWebServer::RequestView::request() const {
+    if (source_ && paramCount_ == 0) {
+        return *source_;
+    }
+
+    if (!isMaterialized_) {
+        if (source_) {
+            materialized_ = *source_;
+        } else {
+            materialized_.method = method.str();
+            materialized_.url = target.str();
+            materialized_.path = path.str();
+            materialized_.queryParams = parseQueryParams(query.str());
+            for (size_t i = 0; i < headerCount; ++i) {
+                materialized_.headers[headers[i].name.str()] = headers[i].value.str();
+            }
+            materialized_.body = body.str();
+            materialized_.clientIP = clientIP.str();
+            materialized_.clientPort = clientPort;
+        }
+        addPathParams(materialized_);
+        isMaterialized_ = true;
+    }
+    return materialized_;
+}
+
+void MockWebServer::RequestView::clear() {
+    method = target = path = query = body = clientIP = Slice();
+    headerCount = 0;
+    clientPort = 0;
+    source_ = nullptr;
+    paramNames_ = nullptr;
+    paramCount_ = 0;
+    attributes_ = nullptr;
+    holdsSlot_ = false;
+    if (isMaterialized_) {
+        materialized_ = HttpRequest();
+        isMaterialized_ = false;
+    }
+}
+
+void MockWebServer::RequestView::bindRoute(const HttpRouter::Match& match, const std::vector<std::string>& names) {
+    paramNames_ = &names;
+    paramCount_ = match.paramCount;
+    for (size_t i = 0; i < paramCount_; ++i) {
+        params_[i] = match.params[i];
+    }
+    if (isMaterialized_) {
+        addPathParams(materialized_); // Materialized early, e.g. for middleware
+    }
+}
+
+void MockWebServer::RequestView::addPathParams(HttpRequest& request) const {
+    for (size_t i = 0; i < paramCount_ && i < paramNames_->size(); ++i) {
+        request.pathParams[(*paramNames_)[i]] = std::string(path.data + params_[i].offset, params_[i].length);
+    }
+}
+
+std::string MockWebServer::HttpRequest::getPathParam(const std::string& name) const {
+    auto it = pathParams.find(name);
+    return it != pathParams.end() ? it->second : std::string();
+}
+
+long long MockWebServer::HttpRequest::getPathParamInt(const std::string& name, long long fallback) const {
+    auto it = pathParams.find(name);
+    return it != pathParams.end() ? std::strtoll(it->second.c_str(), nullptr, 10) : fallback;
+}
+
+MockWebServer::MockWebServer(uint16_t port) : port_(port), history_(MOCK_WEB_SERVER_HISTORY_SIZE) {
     state_ = ServerState::STOPPED;
 }
 
@@ -32,28 +212,53 @@ void MockWebServer::end() {
     }
 }
 
-void MockWebServer::on(const std::string& method, const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
+bool MockWebServer::on(const std::string& method, const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
     Route route;
     route.method = method;
     route.path = path;
     route.handler = handler;
+    return addRoute(route);
+}
+
+bool MockWebServer::onView(const std::string& method, const std::string& path, std::function<HttpResponse(const RequestView&)> handler) {
+    Route route;
+    route.method = method;
+    route.path = path;
+    route.viewHandler = handler;
+    return addRoute(route);
+}
+
+bool MockWebServer::addRoute(Route& route) {
+    if (routes_.size() >= kNoRoute) {
+        return false;
+    }
+    if (!router_.add(route.method, route.path, static_cast<int>(routes_.size()), &route.paramNames)) {
+        return false;
+    }
     routes_.push_back(route);
+    Route& added = routes_.back();
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        if (stageApplies(stages_[i], added, routes_.size() - 1)) {
+            added.chain.push_back(i);
+        }
+    }
+    return true;
 }
 
-void MockWebServer::onGet(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
-    on("GET", path, handler);
+bool MockWebServer::onGet(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
+    return on("GET", path, handler);
 }
 
-void MockWebServer::onPost(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
-    on("POST", path, handler);
+bool MockWebServer::onPost(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
+    return on("POST", path, handler);
 }
 
-void MockWebServer::onPut(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
-    on("PUT", path, handler);
+bool MockWebServer::onPut(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
+    return on("PUT", path, handler);
 }
 
-void MockWebServer::onDelete(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
-    on("DELETE", path, handler);
+bool MockWebServer::onDelete(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler) {
+    return on("DELETE", path, handler);
 }
 
 void MockWebServer::serveStatic(const std::string& urlPath, const std::string& filePath) {
@@ -61,47 +266,226 @@ void MockWebServer::serveStatic(const std::string& urlPath, const std::string& f
 }
 
 MockWebServer::HttpResponse MockWebServer::simulateRequest(const HttpRequest& request) {
+    RequestView view(request);
+    HttpResponse response = handle(view);
+    drainStream(response);
+    if (view.holdsSlot()) {
+        releaseSlots(1);
+    }
+    return response;
+}
+
+void MockWebServer::releaseSlots(size_t count) {
+    if (!limiter_) {
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        limiter_->release();
+    }
+}
+
+MockWebServer::HttpResponse MockWebServer::handle(RequestView& request) {
     if (state_ != ServerState::RUNNING) {
         return createErrorResponse(503, "Service Unavailable");
     }
     
-    recordRequest(request);
-    
-    // Apply middleware
-    if (!applyMiddleware(request)) {
-        return createErrorResponse(403, "Forbidden");
+    const auto started = std::chrono::steady_clock::now();
+    uint16_t routeId = kNoRoute;
+    HttpResponse response = dispatch(request, routeId);
+    const HttpRouter::MethodId method = HttpRouter::methodId(request.method.data, request.method.length);
+    const size_t requestBytes = request.body.length;
+    if (response.stream) {
+        // The view may be gone by the time the body ends, so keep only what the record needs.
+        response.streamDone = [this, routeId, method, requestBytes, started](uint64_t bodyBytes, int statusCode) {
+            recordRequest(routeId, method, requestBytes, statusCode, bodyBytes, started);
+        };
+        return response;
     }
-    
+    recordRequest(routeId, method, requestBytes, response.statusCode, response.body.size(), started);
+    return response;
+}
+
+MockWebServer::HttpResponse MockWebServer::dispatch(RequestView& request, uint16_t& routeId) {
     // CORS headers
     if (corsEnabled_) {
         // Add CORS headers would be done here
     }
     
     // Find matching route
-    Route* route = findRoute(request.method, request.path);
+    HttpRouter::Match match;
+    Route* route = findRoute(request.method, request.path, match);
     if (!route) {
+        HttpResponse response;
+        if (assets_ && assets_->serve(request, response)) {
+            return response;
+        }
+        
         // Check for static files
-        auto staticIt = staticRoutes_.find(request.path);
+        auto staticIt = staticRoutes_.empty() ? staticRoutes_.end() : staticRoutes_.find(request.path.str());
         if (staticIt != staticRoutes_.end()) {
-            HttpResponse response;
             response.statusCode = 200;
             response.statusMessage = "OK";
             response.body = "Static file content for: " + staticIt->second;
             return response;
         }
         
+        if (match.pathMatched) {
+            HttpResponse response = createErrorResponse(405, "Method Not Allowed");
+            response.headers["Allow"] = match.allow;
+            return response;
+        }
+        
         return createErrorResponse(404, "Not Found");
     }
     
     // Execute route handler
+    routeId = static_cast<uint16_t>(match.route);
+    request.bindRoute(match, route->paramNames);
+    if (limiter_) {
+        const RequestLimiter::Decision decision = limiter_->acquire(request.clientIP);
+        if (decision != RequestLimiter::Decision::ADMIT) {
+            HttpResponse response;
+            limiter_->reject(decision, request.clientIP, response);
+            return response;
+        }
+        request.holdsSlot_ = true;
+    }
+    HttpResponse response;
+    if (route->chain.empty()) {
+        response = route->cacheVersion ? serveCached(*route, request) : invokeRoute(*route, request);
+    } else {
+        MiddlewareContext context(request);
+        request.attributes_ = &context.attributes;
+        if (runChain(*route, context, response)) {
+            response = route->cacheVersion ? serveCached(*route, request) : invokeRoute(*route, request);
+        }
+        request.attributes_ = nullptr;
+        for (const auto& header : context.responseHeaders) {
+            response.headers.insert(header);
+        }
+    }
+    return response;
+}
+
+MockWebServer::HttpResponse MockWebServer::invokeRoute(Route& route, const RequestView& request) {
     try {
-        HttpResponse response = route->handler(request);
+        if (route.viewHandler) {
+            return route.viewHandler(request);
+        }
+        HttpResponse response = route.handler(request.request());
         return response;
     } catch (const std::exception& e) {
         return createErrorResponse(500, std::string("Internal Server Error: ") + e.what());
     }
 }
 
+MockWebServer::HttpResponse MockWebServer::serveCached(Route& route, const RequestView& request) {
+    // Read before rendering: a change made while the handler runs invalidates the entry.
+    const uint64_t version = route.cacheVersion();
+    if (version != route.cachedVersion) {
+        route.cache.clear();
+        route.cachedVersion = version;
+    }
+
+    buildCacheKey(request, cacheKey_);
+    CachedResponse* oldest = nullptr;
+    for (auto& entry : route.cache) {
+        if (entry.key == cacheKey_) {
+            entry.lastUsed = ++cacheClock_;
+            ++route.stats.cacheHits;
+            return entry.response;
+        }
+        if (!oldest || entry.lastUsed < oldest->lastUsed) {
+            oldest = &entry;
+        }
+    }
+
+    ++route.stats.cacheMisses;
+    HttpResponse response = invokeRoute(route, request);
+    if (response.statusCode != 200 || response.stream) {
+        return response;
+    }
+    if (route.cache.size() < route.cacheCapacity) {
+        route.cache.push_back(CachedResponse());
+        oldest = &route.cache.back();
+    }
+    oldest->key = cacheKey_;
+    oldest->response = response;
+    oldest->lastUsed = ++cacheClock_;
+    return response;
+}
+
+void MockWebServer::buildCacheKey(const RequestView& request, std::string& key) {
+    key.assign(request.path.data, request.path.length);
+    if (request.source_) {
+        // Simulated requests carry parsed parameters rather than the raw query.
+        char separator = '?';
+        for (const auto& param : request.source_->queryParams) {
+            key += separator;
+            key += param.first;
+            key += '=';
+            key += param.second;
+            separator = '&';
+        }
+    } else if (!request.query.empty()) {
+        key += '?';
+        key.append(request.query.data, request.query.length);
+    }
+}
+
+bool MockWebServer::cacheRoute(const std::string& path, VersionSource version, size_t maxEntries) {
+    for (auto& route : routes_) {
+        if (route.method == "GET" && route.path == path) {
+            route.cacheVersion = version;
+            route.cacheCapacity = std::max<size_t>(maxEntries, 1);
+            route.cache.clear();
+            route.cache.reserve(route.cacheCapacity);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t MockWebServer::RouteStats::latencyPercentileMicros(double fraction) const {
+    if (requests == 0) {
+        return 0;
+    }
+    const double target = fraction * static_cast<double>(requests);
+    uint64_t seen = 0;
+    for (size_t i = 0; i + 1 < kLatencyBuckets; ++i) {
+        seen += latencyBuckets[i];
+        if (static_cast<double>(seen) >= target) {
+            return uint64_t(1) << i;
+        }
+    }
+    return (maxNanos + 999) / 1000;
+}
+
+std::vector<MockWebServer::RouteStats> MockWebServer::getAllRouteStats() const {
+    std::vector<RouteStats> stats;
+    stats.reserve(routes_.size());
+    for (const auto& route : routes_) {
+        stats.push_back(route.stats);
+    }
+    return stats;
+}
+
+std::string MockWebServer::getRouteName(uint16_t routeId) const {
+    if (routeId >= routes_.size()) {
+        return std::string();
+    }
+    return routes_[routeId].method + " " + routes_[routeId].path;
+}
+
+MockWebServer::RouteStats MockWebServer::getRouteStats(const std::string& method, const std::string& path) const {
+    for (const auto& route : routes_) {
+        if (route.method == method && route.path == path) {
+            return route.stats;
+        }
+    }
+    return RouteStats();
+}
+
 MockWebServer::HttpResponse MockWebServer::simulateGet(const std::string& path) {
     HttpRequest request;
     request.method = "GET";
@@ -191,6 +575,38 @@ MockWebServer::HttpResponse MockWebServer::createTextResponse(const std::string&
     return response;
 }
 
+MockWebServer::HttpResponse MockWebServer::createStreamResponse(BodyGenerator generator,
+                                                               const std::string& contentType, int statusCode) {
+    HttpResponse response;
+    response.statusCode = statusCode;
+    response.statusMessage = (statusCode == 200) ? "OK" : "Error";
+    response.stream = generator;
+    response.headers["Content-Type"] = contentType;
+    return response;
+}
+
+void MockWebServer::drainStream(HttpResponse& response, size_t chunkBytes) {
+    if (!response.stream) {
+        return;
+    }
+    BodyGenerator generator;
+    generator.swap(response.stream);
+    StreamDone done;
+    done.swap(response.streamDone);
+    try {
+        while (generator(response.body, chunkBytes)) {
+        }
+    } catch (const std::exception& e) {
+        // Like a throwing handler; a partial body is kept as it would have reached a client.
+        if (response.body.empty()) {
+            response = createErrorResponse(500, std::string("Internal Server Error: ") + e.what());
+        }
+    }
+    if (done) {
+        done(response.body.size(), response.statusCode);
+    }
+}
+
 MockWebServer::HttpResponse MockWebServer::createErrorResponse(int statusCode, const std::string& message) {
     HttpResponse response;
     response.statusCode = statusCode;
@@ -200,8 +616,51 @@ MockWebServer::HttpResponse MockWebServer::createErrorResponse(int statusCode, c
     return response;
 }
 
+void MockWebServer::use(const std::string& name, Stage stage, const std::string& pathPrefix) {
+    StageEntry entry;
+    entry.stage = stage;
+    entry.pathPrefix = pathPrefix;
+    entry.stats.name = name;
+    stages_.push_back(entry);
+    for (size_t i = 0; i < routes_.size(); ++i) {
+        if (stageApplies(stages_.back(), routes_[i], i)) {
+            routes_[i].chain.push_back(stages_.size() - 1);
+        }
+    }
+}
+
+bool MockWebServer::useOnRoute(const std::string& method, const std::string& path, const std::string& name, Stage stage) {
+    for (size_t i = 0; i < routes_.size(); ++i) {
+        if (routes_[i].method == method && routes_[i].path == path) {
+            StageEntry entry;
+            entry.stage = stage;
+            entry.route = static_cast<int>(i);
+            entry.stats.name = name;
+            stages_.push_back(entry);
+            routes_[i].chain.push_back(stages_.size() - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<MockWebServer::StageStats> MockWebServer::getMiddlewareStats() const {
+    std::vector<StageStats> stats;
+    stats.reserve(stages_.size());
+    for (const auto& entry : stages_) {
+        stats.push_back(entry.stats);
+    }
+    return stats;
+}
+
 void MockWebServer::addMiddleware(Middleware middleware) {
-    middlewares_.push_back(middleware);
+    use("middleware", [middleware](MiddlewareContext& context, HttpResponse& response) {
+        if (middleware(context.request.request())) {
+            return true;
+        }
+        response = createErrorResponse(403, "Forbidden");
+        return false;
+    });
 }
 
 void MockWebServer::enableCORS(const std::string& allowedOrigin) {
@@ -215,13 +674,11 @@ void MockWebServer::setCORSHeaders(std::map<std::string, std::string> headers) {
     corsHeaders_ = headers;
 }
 
-MockWebServer::Route* MockWebServer::findRoute(const std::string& method, const std::string& path) {
-    for (auto& route : routes_) {
-        if (route.method == method && route.path == path) {
-            return &route;
-        }
+MockWebServer::Route* MockWebServer::findRoute(const Slice& method, const Slice& path, HttpRouter::Match& match) {
+    if (!router_.find(method.data, method.length, path.data, path.length, match)) {
+        return nullptr;
     }
-    return nullptr;
+    return &routes_[static_cast<size_t>(match.route)];
 }
 
 std::string MockWebServer::extractPath(const std::string& url) {
@@ -254,23 +711,96 @@ std::map<std::string, std::string> MockWebServer::parseQueryParams(const std::st
     return params;
 }
 
-bool MockWebServer::applyMiddleware(const HttpRequest& request) {
-    for (auto& middleware : middlewares_) {
-        if (!middleware(request)) {
+bool MockWebServer::stageApplies(const StageEntry& entry, const Route& route, size_t routeIndex) const {
+    if (entry.route >= 0) {
+        return static_cast<size_t>(entry.route) == routeIndex;
+    }
+    // Whole segments only: "/api" covers "/api" and "/api/x" but not "/apidocs".
+    const std::string& prefix = entry.pathPrefix;
+    if (route.path.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    return route.path.size() == prefix.size() || prefix.empty() || prefix.back() == '/' ||
+           route.path[prefix.size()] == '/';
+}
+
+bool MockWebServer::runChain(const Route& route, MiddlewareContext& context, HttpResponse& response) {
+    for (size_t index : route.chain) {
+        StageEntry& entry = stages_[index];
+        const auto started = std::chrono::steady_clock::now();
+        bool proceed;
+        try {
+            proceed = entry.stage(context, response);
+        } catch (const std::exception& e) {
+            response = createErrorResponse(500, std::string("Internal Server Error: ") + e.what());
+            proceed = false;
+        }
+        const uint64_t elapsed = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count());
+        StageStats& stats = entry.stats;
+        ++stats.calls;
+        stats.totalNanos += elapsed;
+        stats.maxNanos = std::max(stats.maxNanos, elapsed);
+        if (!proceed) {
+            ++stats.stopped;
             return false;
         }
     }
     return true;
 }
 
-void MockWebServer::recordRequest(const HttpRequest& request) {
+void MockWebServer::setRequestHistoryLimit(size_t limit) {
+    history_.assign(limit, RequestSummary());
+    historyNext_ = 0;
+    historyCount_ = 0;
+}
+
+std::vector<MockWebServer::RequestSummary> MockWebServer::getRequestHistory() const {
+    std::vector<RequestSummary> history;
+    history.reserve(historyCount_);
+    const size_t first = (historyNext_ + history_.size() - historyCount_) % std::max<size_t>(history_.size(), 1);
+    for (size_t i = 0; i < historyCount_; ++i) {
+        history.push_back(history_[(first + i) % history_.size()]);
+    }
+    return history;
+}
+
+void MockWebServer::recordRequest(uint16_t routeId, HttpRouter::MethodId method, size_t requestBytes,
+                                  int statusCode, uint64_t responseBytes,
+                                  std::chrono::steady_clock::time_point started) {
     requestCount_++;
-    requestHistory_.push_back(request);
-    
-    // Keep history limited for testing
-    if (requestHistory_.size() > 100) {
-        requestHistory_.erase(requestHistory_.begin());
+    const uint64_t elapsed = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count());
+    const uint64_t micros = elapsed / 1000;
+
+    RouteStats& stats = routeId != kNoRoute ? routes_[routeId].stats : unroutedStats_;
+    ++stats.requests;
+    stats.totalNanos += elapsed;
+    stats.maxNanos = std::max(stats.maxNanos, elapsed);
+    stats.responseBytes += responseBytes;
+    if (statusCode >= 100 && statusCode < 600) {
+        ++stats.statusClasses[statusCode / 100 - 1];
+    }
+    size_t bucket = 0;
+    while (bucket + 1 < kLatencyBuckets && micros >= (uint64_t(1) << bucket)) {
+        ++bucket;
+    }
+    ++stats.latencyBuckets[bucket];
+
+    if (history_.empty()) {
+        return;
     }
+    RequestSummary& summary = history_[historyNext_];
+    summary.timestampMs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(started.time_since_epoch()).count());
+    summary.latencyMicros = static_cast<uint32_t>(std::min<uint64_t>(micros, UINT32_MAX));
+    summary.requestBytes = static_cast<uint32_t>(std::min<size_t>(requestBytes, UINT32_MAX));
+    summary.responseBytes = static_cast<uint32_t>(std::min<uint64_t>(responseBytes, UINT32_MAX));
+    summary.routeId = routeId;
+    summary.status = static_cast<uint16_t>(statusCode);
+    summary.method = method;
+    historyNext_ = (historyNext_ + 1) % history_.size();
+    historyCount_ = std::min(historyCount_ + 1, history_.size());
 }
 
 void MockWebServer::updateState(ServerState newState) {
@@ -8,8 +8,29 @@
 #include <memory>
 #include <chrono>
 
+#include "HttpRouter.h"
+
+class RequestLimiter;
+class StaticAssetCache;
+
+#ifndef MOCK_WEB_SERVER_MAX_HEADERS
+#define MOCK_WEB_SERVER_MAX_HEADERS 32
+#endif
+
+#ifndef MOCK_WEB_SERVER_HISTORY_SIZE
+#define MOCK_WEB_SERVER_HISTORY_SIZE 100
+#endif
+
 class MockWebServer {
 public:
+    static const size_t kMaxRequestHeaders = MOCK_WEB_SERVER_MAX_HEADERS;
+    static const uint16_t kNoRoute = 0xFFFF;
+    // Latency histogram bucket i counts requests under 2^i microseconds; the last bucket
+    // takes everything slower.
+    static const size_t kLatencyBuckets = 20;
+
+    // Owning form of a request. Requests parsed from a socket start as a RequestView and
+    // are only copied into this form when something asks for it (RequestView::request()).
     struct HttpRequest {
         std::string method;
         std::string url;
@@ -19,21 +40,170 @@ public:
         std::string body;
         std::string clientIP;
         uint16_t clientPort;
+        std::map<std::string, std::string> pathParams; // Filled from "{name}" route segments
+
+        std::string getPathParam(const std::string& name) const;
+        // Value of an {name:int} / {name:uint} segment, or fallback if absent.
+        long long getPathParamInt(const std::string& name, long long fallback = 0) const;
+    };
+
+    // Unowned bytes, usually in a connection's receive buffer (a C++11 string_view).
+    struct Slice {
+        const char* data = nullptr;
+        size_t length = 0;
+
+        Slice() = default;
+        Slice(const char* bytes, size_t size) : data(bytes), length(size) {}
+        Slice(const std::string& text) : data(text.data()), length(text.size()) {}
+
+        bool empty() const { return length == 0; }
+        std::string str() const { return std::string(data, length); }
+        bool equals(const char* text) const;
+        bool equalsIgnoreCase(const char* text) const;
+    };
+
+    struct HeaderField {
+        Slice name;
+        Slice value;
+    };
+
+    // A parsed request that refers to the bytes it was parsed from: no maps, no copies.
+    // Routes registered with onView() read it directly; request() materializes the
+    // HttpRequest compatibility form on first use (for on()/onGet() handlers, middleware
+    // and the request history) and caches it. Only valid while the source bytes are.
+    class RequestView {
+    public:
+        Slice method;
+        Slice target; // Path plus "?query"
+        Slice path;
+        Slice query;  // After "?", undecoded
+        Slice body;
+        HeaderField headers[kMaxRequestHeaders];
+        size_t headerCount = 0;
+        Slice clientIP;
+        uint16_t clientPort = 0;
+
+        RequestView() = default;
+        // Views an existing request (simulateRequest()); request() then returns it as-is.
+        explicit RequestView(const HttpRequest& source);
+
+        RequestView(const RequestView&) = delete;
+        RequestView& operator=(const RequestView&) = delete;
+
+        // First header with this name (case-insensitive), or an empty slice.
+        Slice header(const char* name) const;
+        bool hasHeader(const char* name) const;
+        // Raw value of the first "name=value" query pair, or an empty slice.
+        Slice queryParam(const char* name) const;
+        // Segment captured by a "{name}" route parameter, or an empty slice.
+        Slice pathParam(const char* name) const;
+        long long pathParamInt(const char* name, long long fallback = 0) const;
+        // Value a middleware stage stored in MiddlewareContext::attributes, or "".
+        std::string attribute(const std::string& name) const;
+
+        const HttpRequest& request() const;
+
+        // True once handle() admitted this request through a RequestLimiter; the slot is
+        // held until the transport calls MockWebServer::releaseSlots().
+        bool holdsSlot() const { return holdsSlot_; }
+
+        void clear();
+
+    private:
+        friend class MockWebServer;
+
+        const HttpRequest* source_ = nullptr;
+        const std::vector<std::string>* paramNames_ = nullptr;
+        HttpRouter::Param params_[HttpRouter::kMaxParams];
+        size_t paramCount_ = 0;
+        const std::map<std::string, std::string>* attributes_ = nullptr; // While a chain runs
+        bool holdsSlot_ = false;
+
+        mutable HttpRequest materialized_;
+        mutable bool isMaterialized_ = false;
+
+        void bindRoute(const HttpRouter::Match& match, const std::vector<std::string>& names);
+        void addPathParams(HttpRequest& request) const;
     };
 
+    // Produces a streamed body piecewise: append roughly maxBytes to `chunk` and return true
+    // while more follows, false after the last piece. Called only as fast as the client
+    // reads, so the whole document never has to exist at once.
+    using BodyGenerator = std::function<bool(std::string& chunk, size_t maxBytes)>;
+    // Told once that a streamed body has ended (finished, failed or abandoned), with the body
+    // bytes produced and the status the client got.
+    using StreamDone = std::function<void(uint64_t bodyBytes, int statusCode)>;
+
     struct HttpResponse {
         int statusCode = 200;
         std::string statusMessage = "OK";
         std::map<std::string, std::string> headers;
         std::string body;
+        BodyGenerator stream; // When set, replaces `body` (sent with chunked transfer encoding)
+        StreamDone streamDone; // Set by handle() alongside `stream`; whoever ends the stream calls it
         bool keepAlive = true;
     };
 
+    // Per-route counters and histograms: fixed size however many requests are served.
+    // Latency is the whole of handle(), including routing, admission and middleware; for a
+    // streamed body it runs until the stream ends.
+    struct RouteStats {
+        uint64_t requests = 0;
+        uint64_t cacheHits = 0;
+        uint64_t cacheMisses = 0; // Only cached routes (cacheRoute()) count hits and misses
+        uint64_t totalNanos = 0;
+        uint64_t maxNanos = 0;
+        uint64_t responseBytes = 0;       // Bodies
+        uint32_t statusClasses[5] = {};   // 1xx .. 5xx
+        uint32_t latencyBuckets[kLatencyBuckets] = {};
+
+        // Upper bound of the histogram bucket that reaches `fraction` (e.g. 0.99) of the
+        // requests, in microseconds; maxNanos decides the open-ended last bucket.
+        uint64_t latencyPercentileMicros(double fraction) const;
+
+        double hitRate() const {
+            const uint64_t lookups = cacheHits + cacheMisses;
+            return lookups ? static_cast<double>(cacheHits) / static_cast<double>(lookups) : 0.0;
+        }
+        double averageNanos() const {
+            return requests ? static_cast<double>(totalNanos) / static_cast<double>(requests) : 0.0;
+        }
+    };
+
+    // One handled request, as kept by the history ring.
+    struct RequestSummary {
+        uint64_t timestampMs = 0;    // Steady clock, when handling started
+        uint32_t latencyMicros = 0;
+        uint32_t requestBytes = 0;   // Body
+        uint32_t responseBytes = 0;  // Body
+        uint16_t routeId = kNoRoute; // Matched route (getRouteName()), or kNoRoute
+        uint16_t status = 0;
+        HttpRouter::MethodId method = HttpRouter::METHOD_OTHER;
+    };
+
+    // Returns a counter that the data behind a response bumps on every change.
+    using VersionSource = std::function<uint64_t()>;
+
+    struct CachedResponse {
+        std::string key; // Path plus "?query"
+        HttpResponse response;
+        uint64_t lastUsed = 0;
+    };
+
     struct Route {
         std::string method;
         std::string path;
         std::function<HttpResponse(const HttpRequest&)> handler;
+        std::function<HttpResponse(const RequestView&)> viewHandler; // Set instead of handler by onView()
         std::string description;
+        std::vector<std::string> paramNames;
+        std::vector<size_t> chain; // Indexes into stages_, in run order
+
+        VersionSource cacheVersion; // Set by cacheRoute()
+        size_t cacheCapacity = 0;
+        uint64_t cachedVersion = 0; // Version the entries in `cache` were rendered at
+        std::vector<CachedResponse> cache;
+        RouteStats stats;
     };
 
     enum class ServerState {
@@ -53,18 +223,52 @@ public:
     bool isRunning() const { return state_ == ServerState::RUNNING; }
     ServerState getState() const { return state_; }
     
-    // Route management
-    void on(const std::string& method, const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
-    void onGet(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
-    void onPost(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
-    void onPut(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
-    void onDelete(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
+    // Route management. Paths may contain typed parameters, e.g. "/api/sensors/{index:uint}"
+    // (see HttpRouter). Returns false for malformed patterns and duplicate method/path pairs.
+    bool on(const std::string& method, const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
+    bool onGet(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
+    bool onPost(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
+    bool onPut(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
+    bool onDelete(const std::string& path, std::function<HttpResponse(const HttpRequest&)> handler);
+    // Handler that reads the request in place (see RequestView); it never forces the
+    // HttpRequest copy to be built.
+    bool onView(const std::string& method, const std::string& path, std::function<HttpResponse(const RequestView&)> handler);
+    size_t getRouteCount() const { return routes_.size(); }
+
+    // Answer repeated requests to the GET route registered at `path` from a copy of its
+    // last 200 response for the same path and query, until `version` returns a new value.
+    // The handler must depend only on the path, the query and state covered by `version`;
+    // for several sources, return the sum of their counters. Up to maxEntries distinct
+    // path/query keys are kept, least recently used replaced first. Returns false if no
+    // such route exists.
+    bool cacheRoute(const std::string& path, VersionSource version, size_t maxEntries = 4);
+    // Counters for the route registered as method + path pattern (zero if unknown).
+    RouteStats getRouteStats(const std::string& method, const std::string& path) const;
+    // Counters for every route, indexed by route id.
+    std::vector<RouteStats> getAllRouteStats() const;
+    // Counters for requests no route matched (404, 405, static assets).
+    RouteStats getUnroutedStats() const { return unroutedStats_; }
+    // "GET /api/status" for a route id, or "" for kNoRoute.
+    std::string getRouteName(uint16_t routeId) const;
     
     // Static file serving
     void serveStatic(const std::string& urlPath, const std::string& filePath);
+    // Answer GET/HEAD for paths no route matched from `assets` (not owned; nullptr detaches).
+    void serveAssets(StaticAssetCache* assets) { assets_ = assets; }
+
+    // Admit requests that matched a route through `limiter` (not owned; nullptr detaches)
+    // before their middleware runs; refusals are answered with 429. An admitted request
+    // holds a slot until its response has been delivered: transports call releaseSlots()
+    // then (simulateRequest() does so before returning).
+    void limitRequests(RequestLimiter* limiter) { limiter_ = limiter; }
+    void releaseSlots(size_t count = 1);
     
     // Request simulation for testing
     HttpResponse simulateRequest(const HttpRequest& request);
+    // Dispatch a request parsed in place, e.g. by HttpRequestParser. The view is annotated
+    // with the matched route's parameters. A streamed response is counted in the route stats
+    // and history only once its streamDone hook runs.
+    HttpResponse handle(RequestView& request);
     HttpResponse simulateGet(const std::string& path);
     HttpResponse simulatePost(const std::string& path, const std::string& body = "");
     HttpResponse simulatePut(const std::string& path, const std::string& body = "");
@@ -78,14 +282,61 @@ public:
     uint16_t getPort() const { return port_; }
     std::string getURL() const { return "http://localhost:" + std::to_string(port_); }
     uint32_t getRequestCount() const { return requestCount_; }
-    std::vector<HttpRequest> getRequestHistory() const { return requestHistory_; }
+    // The most recent requests, oldest first: a fixed ring of compact summaries
+    // (MOCK_WEB_SERVER_HISTORY_SIZE by default). Aggregates live in the route stats.
+    std::vector<RequestSummary> getRequestHistory() const;
+    // Resize (and clear) the ring; 0 disables it.
+    void setRequestHistoryLimit(size_t limit);
     
     // Response simulation helpers
     static HttpResponse createJsonResponse(const std::string& json, int statusCode = 200);
     static HttpResponse createTextResponse(const std::string& text, const std::string& contentType = "text/plain", int statusCode = 200);
     static HttpResponse createErrorResponse(int statusCode, const std::string& message = "");
+    static HttpResponse createStreamResponse(BodyGenerator generator,
+                                             const std::string& contentType = "application/json",
+                                             int statusCode = 200);
+    // Run a response's generator to the end, moving the result into `body`, then call its
+    // streamDone hook. Simulated requests do this so callers always see a complete body. A
+    // generator that throws ends the body there; if it had produced nothing the response
+    // becomes a 500.
+    static void drainStream(HttpResponse& response, size_t chunkBytes = 4096);
+    static std::map<std::string, std::string> parseQueryParams(const std::string& query);
     
-    // Middleware simulation
+    // Middleware. A stage sees the matched request and may add response headers or
+    // attributes for later stages and the handler (RequestView::attribute()). Returning
+    // false stops the chain; `response` is then sent instead of calling the handler.
+    // Headers in the context are added to whichever response is sent, without replacing
+    // ones the handler set.
+    struct MiddlewareContext {
+        explicit MiddlewareContext(const RequestView& view) : request(view) {}
+
+        const RequestView& request;
+        std::map<std::string, std::string> responseHeaders;
+        std::map<std::string, std::string> attributes;
+    };
+    using Stage = std::function<bool(MiddlewareContext& context, HttpResponse& response)>;
+
+    struct StageStats {
+        std::string name;
+        uint64_t calls = 0;
+        uint64_t stopped = 0; // Calls that answered the request themselves
+        uint64_t totalNanos = 0;
+        uint64_t maxNanos = 0;
+    };
+
+    // Run `stage` for every route whose pattern lies under pathPrefix, matched by whole
+    // segments ("/api" covers "/api" and "/api/x", not "/apidocs"), whether registered
+    // before or after this call. Each route's chain is resolved here, once, into a flat
+    // list, so requests that match no route (404, 405, static assets) run no middleware.
+    // Stages run in the order they were added.
+    void use(const std::string& name, Stage stage, const std::string& pathPrefix = "/");
+    // Run `stage` for one route only. Returns false if it is not registered.
+    bool useOnRoute(const std::string& method, const std::string& path, const std::string& name, Stage stage);
+    // Counters per stage, in the order added.
+    std::vector<StageStats> getMiddlewareStats() const;
+
+    // Compatibility form: a predicate on the materialized request, answered with 403 when
+    // false. Equivalent to use() with prefix "/".
     using Middleware = std::function<bool(const HttpRequest&)>;
     void addMiddleware(Middleware middleware);
     
@@ -97,22 +348,42 @@ private:
     uint16_t port_;
     ServerState state_ = ServerState::STOPPED;
     std::vector<Route> routes_;
+    HttpRouter router_;
     std::map<std::string, std::string> staticRoutes_;
-    std::vector<Middleware> middlewares_;
+    StaticAssetCache* assets_ = nullptr;
+    RequestLimiter* limiter_ = nullptr;
+    struct StageEntry {
+        Stage stage;
+        std::string pathPrefix; // Used when route < 0
+        int route = -1;         // Index into routes_ for useOnRoute()
+        StageStats stats;
+    };
+    std::vector<StageEntry> stages_;
     std::map<std::string, std::string> corsHeaders_;
     bool corsEnabled_ = false;
     
     // Statistics
     uint32_t requestCount_ = 0;
-    std::vector<HttpRequest> requestHistory_;
+    std::vector<RequestSummary> history_; // Ring; size() is the capacity
+    size_t historyNext_ = 0;
+    size_t historyCount_ = 0;
+    RouteStats unroutedStats_;
+    uint64_t cacheClock_ = 0;
+    std::string cacheKey_; // Reused lookup key
     std::vector<std::string> connectedClients_;
     
     // Helper methods
-    Route* findRoute(const std::string& method, const std::string& path);
+    Route* findRoute(const Slice& method, const Slice& path, HttpRouter::Match& match);
     std::string extractPath(const std::string& url);
-    std::map<std::string, std::string> parseQueryParams(const std::string& query);
-    bool applyMiddleware(const HttpRequest& request);
-    void recordRequest(const HttpRequest& request);
+    bool addRoute(Route& route);
+    HttpResponse invokeRoute(Route& route, const RequestView& request);
+    HttpResponse serveCached(Route& route, const RequestView& request);
+    static void buildCacheKey(const RequestView& request, std::string& key);
+    bool stageApplies(const StageEntry& entry, const Route& route, size_t routeIndex) const;
+    bool runChain(const Route& route, MiddlewareContext& context, HttpResponse& response);
+    HttpResponse dispatch(RequestView& request, uint16_t& routeId);
+    void recordRequest(uint16_t routeId, HttpRouter::MethodId method, size_t requestBytes, int statusCode,
+                       uint64_t responseBytes, std::chrono::steady_clock::time_point started);
     void updateState(ServerState newState);
 };
 
@@ -0,0 +1,92 @@
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded multi-producer / single-consumer ring with per-slot sequence numbers.
+// Producers claim a slot with a CAS on the enqueue position and publish it by
+// bumping the slot sequence; they never wait on each other or on the consumer.
+// A full ring makes tryPush() fail instead of blocking.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t minCapacity) {
+        capacity_ = 2;
+        while (capacity_ < minCapacity) {
+            capacity_ <<= 1;
+        }
+        mask_ = capacity_ - 1;
+
+        slots_.reset(new Slot[capacity_]);
+        for (size_t i = 0; i < capacity_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // Producer side: claim a slot, let fill() write the payload in place, then publish.
+    template <typename Fill>
+    bool tryPush(Fill fill) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            const size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        fill(slot->value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: hand the oldest published payload to consume() and release its slot.
+    // Must only be called from one thread at a time.
+    template <typename Consume>
+    bool tryPop(Consume consume) {
+        Slot& slot = slots_[dequeuePos_ & mask_];
+        const size_t seq = slot.sequence.load(std::memory_order_acquire);
+
+        if (seq != dequeuePos_ + 1) {
+            return false; // Empty, or the next producer has not published yet
+        }
+
+        consume(slot.value);
+        slot.sequence.store(dequeuePos_ + capacity_, std::memory_order_release);
+        ++dequeuePos_;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+
+    std::atomic<size_t> enqueuePos_{0};
+    size_t dequeuePos_ = 0;
+};
+
+#endif // MPSC_RING_H
@@ -0,0 +1,265 @@
+#include "PushHub.h"
+
+#include <algorithm>
+#include <cstdio>
+
+const PushHub::SubscriberId PushHub::kInvalidSubscriber;
+
+namespace {
+const char* boolText(bool value) {
+    return value ? "true" : "false";
+}
+} // namespace
+
+PushHub::PushHub() : PushHub(Config()) {
+}
+
+PushHub::PushHub(const Config& config) : config_(config) {
+}
+
+PushHub::SubscriberId PushHub::subscribe(Format format, uint32_t intervalMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscribers_.size() >= config_.maxSubscribers) {
+        return kInvalidSubscriber;
+    }
+
+    Subscriber subscriber;
+    subscriber.id = nextId_++;
+    if (nextId_ == kInvalidSubscriber) {
+        nextId_ = 1;
+    }
+    subscriber.format = format;
+    subscriber.intervalMs = std::max(intervalMs, config_.minIntervalMs);
+    subscriber.sentVersions.assign(topics_.size(), 0);
+    subscriber.subscribedAtChange = changeCounter_;
+    subscribers_.push_back(subscriber);
+    stats_.subscribers = subscribers_.size();
+    return subscriber.id;
+}
+
+void PushHub::unsubscribe(SubscriberId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < subscribers_.size(); ++i) {
+        if (subscribers_[i].id == id) {
+            subscribers_[i] = std::move(subscribers_.back());
+            subscribers_.pop_back();
+            break;
+        }
+    }
+    stats_.subscribers = subscribers_.size();
+}
+
+void PushHub::publish(const std::string& topic, const std::string& json) {
+    std::function<void()> notify;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = topicIndex_.find(topic);
+        size_t index;
+        if (it == topicIndex_.end()) {
+            index = topics_.size();
+            topics_.push_back(Topic());
+            topics_.back().name = topic;
+            topics_.back().createdAtChange = changeCounter_ + 1;
+            topicIndex_[topic] = index;
+            stats_.topics = topics_.size();
+        } else {
+            index = it->second;
+            if (topics_[index].json == json) {
+                return; // Controllers re-report unchanged state; nothing new to send
+            }
+        }
+
+        Topic& entry = topics_[index];
+        entry.json = json;
+        ++entry.version;
+        ++changeCounter_;
+        ++stats_.published;
+        notify = notify_;
+    }
+    if (notify) {
+        notify();
+    }
+}
+
+PushHub::Subscriber* PushHub::findLocked(SubscriberId id) {
+    for (auto& subscriber : subscribers_) {
+        if (subscriber.id == id) {
+            return &subscriber;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t PushHub::dueMsLocked(const Subscriber& subscriber) const {
+    if (!subscriber.flushed) {
+        return 0;
+    }
+    if (subscriber.seenChange != changeCounter_) {
+        return subscriber.lastFlushMs + subscriber.intervalMs;
+    }
+    return subscriber.lastWriteMs + config_.keepAliveMs;
+}
+
+bool PushHub::collect(SubscriberId id, uint64_t nowMs, std::string& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Subscriber* subscriber = findLocked(id);
+    if (!subscriber || nowMs < dueMsLocked(*subscriber)) {
+        return false;
+    }
+
+    if (subscriber->flushed && subscriber->seenChange == changeCounter_) {
+        // Nothing changed for keepAliveMs: a heartbeat lets both ends notice dead peers.
+        if (subscriber->format == Format::SSE) {
+            out += ":\n\n";
+        } else {
+            appendWebSocketFrame(0x9, nullptr, 0, out);
+        }
+        subscriber->lastWriteMs = nowMs;
+        ++stats_.keepAlives;
+        return true;
+    }
+
+    subscriber->sentVersions.resize(topics_.size(), 0);
+    size_t events = 0;
+    for (size_t i = 0; i < topics_.size(); ++i) {
+        const uint64_t sent = subscriber->sentVersions[i];
+        if (topics_[i].version == sent) {
+            continue;
+        }
+        // Versions older than the subscription were never due to this subscriber.
+        if (sent > 0 || topics_[i].createdAtChange > subscriber->subscribedAtChange) {
+            stats_.coalesced += topics_[i].version - sent - 1;
+        }
+        appendEvent(subscriber->format, topics_[i], out);
+        subscriber->sentVersions[i] = topics_[i].version;
+        ++events;
+    }
+
+    subscriber->flushed = true;
+    subscriber->lastFlushMs = nowMs;
+    subscriber->lastWriteMs = nowMs;
+    subscriber->seenChange = changeCounter_;
+    stats_.delivered += events;
+    ++stats_.flushes;
+    return events > 0;
+}
+
+uint64_t PushHub::nextDueMs(uint64_t nowMs) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t due = UINT64_MAX;
+    for (const auto& subscriber : subscribers_) {
+        due = std::min(due, dueMsLocked(subscriber));
+    }
+    return due < nowMs ? nowMs : due;
+}
+
+void PushHub::setNotify(std::function<void()> notify) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notify_ = notify;
+}
+
+PushHub::Stats PushHub::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PushHub::appendEvent(Format format, const Topic& topic, std::string& out) {
+    if (format == Format::SSE) {
+        out += "event: ";
+        out += topic.name;
+        // A newline inside the value would end the field; continue it on another data line.
+        size_t start = 0;
+        for (;;) {
+            const size_t newline = topic.json.find('\n', start);
+            out += "\ndata: ";
+            out.append(topic.json, start, newline == std::string::npos ? std::string::npos : newline - start);
+            if (newline == std::string::npos) {
+                break;
+            }
+            start = newline + 1;
+        }
+        out += "\n\n";
+        return;
+    }
+
+    std::string payload;
+    payload.reserve(topic.name.size() + topic.json.size() + 20);
+    payload += "{\"topic\":\"";
+    payload += topic.name;
+    payload += "\",\"data\":";
+    payload += topic.json;
+    payload += '}';
+    appendWebSocketFrame(0x1, payload.data(), payload.size(), out);
+}
+
+void PushHub::appendWebSocketFrame(uint8_t opcode, const char* payload, size_t length, std::string& out) {
+    out += static_cast<char>(0x80 | opcode); // FIN; server frames are never masked
+    if (length < 126) {
+        out += static_cast<char>(length);
+    } else if (length <= 0xFFFF) {
+        out += static_cast<char>(126);
+        out += static_cast<char>(length >> 8);
+        out += static_cast<char>(length & 0xFF);
+    } else {
+        out += static_cast<char>(127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out += static_cast<char>((static_cast<uint64_t>(length) >> shift) & 0xFF);
+        }
+    }
+    if (length > 0) {
+        out.append(payload, length);
+    }
+}
+
+void PushHub::bindSensors(MockSensorManager& sensors) {
+    sensors.setDataCallback([this](const MockSensorManager::SensorData& data, int index) {
+        publish("sensor/" + std::to_string(index), toJson(data, index));
+    });
+}
+
+void PushHub::bindPump(MockPumpController& pump) {
+    pump.setStateChangeCallback([this](const MockPumpController::PumpState& state, bool) {
+        publish("pump", toJson(state));
+    });
+}
+
+void PushHub::bindLight(MockLightController& light) {
+    light.setStateChangeCallback([this](const MockLightController::LightState& state) {
+        publish("light", toJson(state));
+    });
+    // Fades report brightness only; the state is already updated when this fires.
+    light.setBrightnessChangeCallback([this, &light](uint8_t) { publish("light", toJson(light.getState())); });
+}
+
+std::string PushHub::toJson(const MockSensorManager::SensorData& data, int index) {
+    char buffer[192];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"index\":%d,\"temperature\":%.2f,\"valid\":%s,\"waterMeter\":%s,\"pulses\":%u,"
+                  "\"flowGpm\":%.2f,\"totalGallons\":%.2f}",
+                  index, static_cast<double>(data.temperature), boolText(data.isValid), boolText(data.isWaterMeter),
+                  static_cast<unsigned>(data.pulseCount), static_cast<double>(data.flowRateGPM),
+                  static_cast<double>(data.totalGallons));
+    return buffer;
+}
+
+std::string PushHub::toJson(const MockPumpController::PumpState& state) {
+    char buffer[192];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"active\":%s,\"enabled\":%s,\"fault\":%s,\"cycles\":%u,\"onTime\":%u,\"offTime\":%u,"
+                  "\"flowGpm\":%.2f,\"temperature\":%.2f}",
+                  boolText(state.isActive), boolText(state.isEnabled), boolText(state.faultDetected),
+                  static_cast<unsigned>(state.cycleCount), static_cast<unsigned>(state.onTime),
+                  static_cast<unsigned>(state.offTime), static_cast<double>(state.flowRate),
+                  static_cast<double>(state.currentTemperature));
+    return buffer;
+}
+
+std::string PushHub::toJson(const MockLightController::LightState& state) {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"on\":%s,\"brightness\":%u,\"auto\":%s,\"day\":%s,\"transition\":%s,\"progress\":%.2f}",
+                  boolText(state.isOn), static_cast<unsigned>(state.brightness), boolText(state.isAutoMode),
+                  boolText(state.isDayTime), boolText(state.transitionActive),
+                  static_cast<double>(state.transitionProgress));
+    return buffer;
+}
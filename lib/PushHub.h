@@ -0,0 +1,129 @@
+#ifndef PUSH_HUB_H
+#define PUSH_HUB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "MockLightController.h"
+#include "MockPumpController.h"
+#include "MockSensorManager.h"
+
+#ifndef PUSH_HUB_MIN_INTERVAL_MS
+#define PUSH_HUB_MIN_INTERVAL_MS 250
+#endif
+
+// Live telemetry fan-out for the web UI, replacing REST polling. Producers publish the
+// latest JSON state of a topic ("pump", "light", "sensor/0"); the hub keeps one copy per
+// topic plus a version number, so publish() is O(1) however many clients are connected.
+// Each subscriber remembers the versions it has sent and is flushed at most once per
+// interval: everything that changed since its last flush goes out together, and
+// intermediate values of a topic are coalesced into the newest. A slow client therefore
+// just sees fewer, fresher updates instead of growing a queue.
+//
+// publish() may be called from any thread. The transport (EpollHttpServer) calls collect()
+// for each subscriber when it is due; setNotify() tells it when a publish needs attention.
+class PushHub {
+public:
+    enum class Format {
+        SSE,       // "event: <topic>\ndata: <json>\n\n"
+        WEBSOCKET  // One text frame per event: {"topic":"<topic>","data":<json>}
+    };
+
+    struct Config {
+        uint32_t minIntervalMs = PUSH_HUB_MIN_INTERVAL_MS; // Floor for every subscriber's interval
+        uint32_t keepAliveMs = 15000;                     // Idle subscribers get a heartbeat
+        size_t maxSubscribers = 32;
+    };
+
+    struct Stats {
+        uint64_t published = 0;
+        uint64_t delivered = 0; // Events written to subscribers
+        uint64_t coalesced = 0; // Versions a subscriber skipped because a newer one replaced them
+        uint64_t flushes = 0;
+        uint64_t keepAlives = 0;
+        size_t subscribers = 0;
+        size_t topics = 0;
+    };
+
+    using SubscriberId = uint32_t;
+    static const SubscriberId kInvalidSubscriber = 0;
+
+    PushHub();
+    explicit PushHub(const Config& config);
+
+    PushHub(const PushHub&) = delete;
+    PushHub& operator=(const PushHub&) = delete;
+
+    // Returns kInvalidSubscriber when full. intervalMs is raised to the configured minimum.
+    // A new subscriber first receives the current state of every topic.
+    SubscriberId subscribe(Format format, uint32_t intervalMs = 0);
+    void unsubscribe(SubscriberId id);
+
+    // `json` must be a complete JSON value.
+    void publish(const std::string& topic, const std::string& json);
+
+    // Append the subscriber's due events (or a heartbeat) to `out`. Returns false if nothing
+    // was due. Call again at nextDueMs().
+    bool collect(SubscriberId id, uint64_t nowMs, std::string& out);
+    // Earliest time any subscriber has something to flush, or UINT64_MAX.
+    uint64_t nextDueMs(uint64_t nowMs) const;
+
+    // Called after a publish, outside the hub's lock. Must not call back into the hub.
+    void setNotify(std::function<void()> notify);
+
+    // Publish controller state changes through their existing callbacks. Each replaces any
+    // callback already registered on that controller.
+    void bindSensors(MockSensorManager& sensors);
+    void bindPump(MockPumpController& pump);
+    void bindLight(MockLightController& light);
+
+    static std::string toJson(const MockSensorManager::SensorData& data, int index);
+    static std::string toJson(const MockPumpController::PumpState& state);
+    static std::string toJson(const MockLightController::LightState& state);
+
+    static void appendWebSocketFrame(uint8_t opcode, const char* payload, size_t length, std::string& out);
+
+    Config getConfig() const { return config_; }
+    Stats getStats() const;
+
+private:
+    struct Topic {
+        std::string name;
+        std::string json;
+        uint64_t version = 0;
+        uint64_t createdAtChange = 0; // changeCounter_ when first published
+    };
+
+    struct Subscriber {
+        SubscriberId id = kInvalidSubscriber;
+        Format format = Format::SSE;
+        uint32_t intervalMs = 0;
+        uint64_t lastFlushMs = 0;
+        uint64_t lastWriteMs = 0;
+        uint64_t seenChange = 0;            // changeCounter_ at the last flush
+        uint64_t subscribedAtChange = 0;
+        std::vector<uint64_t> sentVersions; // Per topic index
+        bool flushed = false;               // Has had a first flush
+    };
+
+    Config config_;
+    mutable std::mutex mutex_;
+    std::vector<Topic> topics_;
+    std::map<std::string, size_t> topicIndex_;
+    std::vector<Subscriber> subscribers_;
+    SubscriberId nextId_ = 1;
+    uint64_t changeCounter_ = 0; // Bumped by every publish
+    std::function<void()> notify_;
+    Stats stats_;
+
+    Subscriber* findLocked(SubscriberId id);
+    uint64_t dueMsLocked(const Subscriber& subscriber) const;
+    void appendEvent(Format format, const Topic& topic, std::string& out);
+};
+
+#endif // PUSH_HUB_H
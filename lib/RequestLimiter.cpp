@@ -0,0 +1,128 @@
+#include "RequestLimiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+const size_t RequestLimiter::kMaxClients;
+const size_t RequestLimiter::kMaxAddressLength;
+
+RequestLimiter::RequestLimiter() : RequestLimiter(Config()) {
+}
+
+RequestLimiter::RequestLimiter(const Config& config) : config_(config) {
+}
+
+uint64_t RequestLimiter::nowMs() const {
+    if (timeProvider_) {
+        return timeProvider_();
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+const RequestLimiter::Client* RequestLimiter::find(const MockWebServer::Slice& clientIP) const {
+    const size_t length = std::min(clientIP.length, kMaxAddressLength);
+    for (size_t i = 0; i < clientCount_; ++i) {
+        if (clients_[i].length == length && std::memcmp(clients_[i].address, clientIP.data, length) == 0) {
+            return &clients_[i];
+        }
+    }
+    return nullptr;
+}
+
+RequestLimiter::Client& RequestLimiter::findOrAdd(const MockWebServer::Slice& clientIP, uint64_t now) {
+    const Client* existing = find(clientIP);
+    if (existing) {
+        return const_cast<Client&>(*existing);
+    }
+
+    Client* client;
+    if (clientCount_ < kMaxClients) {
+        client = &clients_[clientCount_++];
+    } else {
+        client = &clients_[0];
+        for (size_t i = 1; i < kMaxClients; ++i) {
+            if (clients_[i].lastSeenMs < client->lastSeenMs) {
+                client = &clients_[i];
+            }
+        }
+        ++stats_.clientsEvicted;
+    }
+
+    const size_t length = std::min(clientIP.length, kMaxAddressLength);
+    if (length > 0) {
+        std::memcpy(client->address, clientIP.data, length);
+    }
+    client->length = static_cast<uint8_t>(length);
+    client->tokens = static_cast<uint32_t>(config_.burst) * 1000;
+    client->lastRefillMs = now;
+    client->lastSeenMs = now;
+    return *client;
+}
+
+RequestLimiter::Decision RequestLimiter::acquire(const MockWebServer::Slice& clientIP) {
+    // The budget is checked first: a refusal for load should not also cost the client a token.
+    if (config_.maxInFlight > 0 && inFlight_ >= config_.maxInFlight) {
+        ++stats_.overBudget;
+        return Decision::OVER_BUDGET;
+    }
+
+    if (config_.requestsPerSecond > 0) {
+        const uint64_t now = nowMs();
+        Client& client = findOrAdd(clientIP, now);
+        const uint64_t capacity = static_cast<uint64_t>(config_.burst) * 1000;
+        if (now > client.lastRefillMs) {
+            const uint64_t refill = (now - client.lastRefillMs) * config_.requestsPerSecond;
+            client.tokens = static_cast<uint32_t>(std::min<uint64_t>(capacity, client.tokens + refill));
+            client.lastRefillMs = now;
+        }
+        client.lastSeenMs = now;
+        if (client.tokens < 1000) {
+            ++stats_.rateLimited;
+            return Decision::RATE_LIMITED;
+        }
+        client.tokens -= 1000;
+    }
+
+    stats_.depthSum += inFlight_;
+    ++inFlight_;
+    ++stats_.admitted;
+    stats_.peakInFlight = std::max(stats_.peakInFlight, inFlight_);
+    return Decision::ADMIT;
+}
+
+void RequestLimiter::release() {
+    if (inFlight_ > 0) {
+        --inFlight_;
+    }
+}
+
+void RequestLimiter::reject(Decision decision, const MockWebServer::Slice& clientIP,
+                            MockWebServer::HttpResponse& response) const {
+    uint32_t retryAfter = 1;
+    if (decision == Decision::RATE_LIMITED && config_.requestsPerSecond > 0) {
+        const Client* client = find(clientIP);
+        const uint32_t missing = client && client->tokens < 1000 ? 1000 - client->tokens : 0;
+        // Milliseconds until one token has refilled, rounded up to whole seconds.
+        const uint64_t waitMs = (missing + config_.requestsPerSecond - 1) / config_.requestsPerSecond;
+        retryAfter = static_cast<uint32_t>(std::max<uint64_t>(1, (waitMs + 999) / 1000));
+    }
+
+    response = MockWebServer::createErrorResponse(
+        429, decision == Decision::OVER_BUDGET ? "Too Many Requests: server busy" : "Too Many Requests");
+    response.statusMessage = "Too Many Requests";
+    response.headers["Retry-After"] = std::to_string(retryAfter);
+}
+
+RequestLimiter::Stats RequestLimiter::getStats() const {
+    Stats stats = stats_;
+    stats.inFlight = inFlight_;
+    stats.clients = clientCount_;
+    return stats;
+}
+
+void RequestLimiter::resetStats() {
+    stats_ = Stats();
+}
@@ -0,0 +1,102 @@
+#ifndef REQUEST_LIMITER_H
+#define REQUEST_LIMITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "MockWebServer.h"
+
+#ifndef REQUEST_LIMITER_MAX_CLIENTS
+#define REQUEST_LIMITER_MAX_CLIENTS 16
+#endif
+
+// Admission control for routed requests, so one client polling hard cannot starve the
+// control loop. Each client IP gets a token bucket (requestsPerSecond, up to burst saved
+// up); on top of that only maxInFlight admitted requests may be outstanding at once across
+// all clients. A request holds its slot from admission until the transport reports its
+// response delivered (MockWebServer::releaseSlots()), so slow readers and deep pipelines
+// count against the budget. Refused requests get a 429 with Retry-After.
+//
+// Buckets live in a fixed table of REQUEST_LIMITER_MAX_CLIENTS entries; when it is full the
+// least recently seen client is forgotten (and starts again with a full bucket). Used from
+// one thread (the web server's); attach with MockWebServer::limitRequests().
+class RequestLimiter {
+public:
+    struct Config {
+        uint32_t requestsPerSecond = 5; // Per client; 0 = unlimited
+        uint32_t burst = 20;
+        size_t maxInFlight = 8;         // Across all clients; 0 = unlimited
+    };
+
+    enum class Decision : uint8_t {
+        ADMIT,
+        RATE_LIMITED, // The client's bucket is empty
+        OVER_BUDGET   // Too many requests in flight
+    };
+
+    struct Stats {
+        uint64_t admitted = 0;
+        uint64_t rateLimited = 0;
+        uint64_t overBudget = 0;
+        size_t inFlight = 0;       // Current queue depth
+        size_t peakInFlight = 0;
+        uint64_t depthSum = 0;     // Requests already in flight when each was admitted
+        size_t clients = 0;
+        uint64_t clientsEvicted = 0;
+
+        double averageDepth() const {
+            return admitted ? static_cast<double>(depthSum) / static_cast<double>(admitted) : 0.0;
+        }
+    };
+
+    using TimeProvider = std::function<uint64_t()>;
+
+    RequestLimiter();
+    explicit RequestLimiter(const Config& config);
+
+    RequestLimiter(const RequestLimiter&) = delete;
+    RequestLimiter& operator=(const RequestLimiter&) = delete;
+
+    void setConfig(const Config& config) { config_ = config; }
+    Config getConfig() const { return config_; }
+    // Milliseconds since an arbitrary epoch; defaults to the steady clock.
+    void setTimeProvider(TimeProvider provider) { timeProvider_ = provider; }
+
+    // Take a token from the client's bucket and a slot from the budget. Only ADMIT takes
+    // anything; each admission must be matched by one release().
+    Decision acquire(const MockWebServer::Slice& clientIP);
+    void release();
+
+    // Fill `response` with the 429 for a refusal.
+    void reject(Decision decision, const MockWebServer::Slice& clientIP, MockWebServer::HttpResponse& response) const;
+
+    size_t getInFlight() const { return inFlight_; }
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    static const size_t kMaxClients = REQUEST_LIMITER_MAX_CLIENTS;
+    static const size_t kMaxAddressLength = 46; // INET6_ADDRSTRLEN
+
+    struct Client {
+        char address[kMaxAddressLength];
+        uint8_t length = 0;
+        uint32_t tokens = 0; // 1/1000 units, as in Logger's tag buckets
+        uint64_t lastRefillMs = 0;
+        uint64_t lastSeenMs = 0;
+    };
+
+    Config config_;
+    TimeProvider timeProvider_;
+    Client clients_[kMaxClients];
+    size_t clientCount_ = 0;
+    size_t inFlight_ = 0;
+    Stats stats_;
+
+    uint64_t nowMs() const;
+    Client& findOrAdd(const MockWebServer::Slice& clientIP, uint64_t now);
+    const Client* find(const MockWebServer::Slice& clientIP) const;
+};
+
+#endif // REQUEST_LIMITER_H
@@ -0,0 +1,295 @@
+#include "SettingsStore.h"
+
+#include "Crc32.h"
+
+namespace {
+const char kSnapshotMagic[4] = {'C', 'S', 'S', '1'};
+
+// Record framing: u32 payload length, u32 CRC of the payload, payload.
+const size_t kRecordHeaderBytes = 8;
+
+// Entry: u8 op, u16 key length, key, u32 value length, value.
+enum : uint8_t { kOpSet = 0, kOpErase = 1 };
+
+void putU16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>((v >> 8) & 0xFF));
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+}
+
+void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64_t getLE(const std::string& data, size_t offset, size_t bytes) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        v |= static_cast<uint64_t>(static_cast<uint8_t>(data[offset + i])) << (8 * i);
+    }
+    return v;
+}
+
+void putEntry(std::string& out, uint8_t op, const std::string& key, const std::string& value) {
+    out.push_back(static_cast<char>(op));
+    putU16(out, static_cast<uint16_t>(key.size()));
+    out += key;
+    putU32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+// Applies `count` entries starting at `p` to `values`; false if the payload does not hold
+// exactly that many well-formed entries.
+bool applyEntries(const std::string& payload, size_t p, uint32_t count, SettingsStore::Values& values) {
+    for (uint32_t i = 0; i < count; ++i) {
+        if (p + 3 > payload.size()) {
+            return false;
+        }
+        const uint8_t op = static_cast<uint8_t>(payload[p]);
+        const size_t keyLength = static_cast<size_t>(getLE(payload, p + 1, 2));
+        p += 3;
+        if (op > kOpErase || p + keyLength + 4 > payload.size()) {
+            return false;
+        }
+        std::string key = payload.substr(p, keyLength);
+        p += keyLength;
+        const size_t valueLength = static_cast<size_t>(getLE(payload, p, 4));
+        p += 4;
+        if (valueLength > payload.size() - p) {
+            return false;
+        }
+        if (op == kOpSet) {
+            values[key].assign(payload, p, valueLength);
+        } else {
+            values.erase(key);
+        }
+        p += valueLength;
+    }
+    return p == payload.size();
+}
+} // namespace
+
+SettingsStore::SettingsStore(StorageBackend& storage) : storage_(storage) {
+}
+
+void SettingsStore::setConfig(const Config& config) {
+    config_ = config;
+}
+
+std::string SettingsStore::slotName(int slot) const {
+    return config_.filePrefix + (slot == 0 ? ".a" : ".b");
+}
+
+std::string SettingsStore::logName() const {
+    return config_.filePrefix + ".log";
+}
+
+bool SettingsStore::begin() {
+    values_.clear();
+    sequence_ = 0;
+    generation_ = 0;
+    activeSlot_ = -1;
+    logBytes_ = 0;
+    logDamaged_ = false;
+
+    for (int slot = 0; slot < 2; ++slot) {
+        Values values;
+        uint64_t generation = 0;
+        uint64_t sequence = 0;
+        if (readSnapshot(slot, values, generation, sequence) && (activeSlot_ < 0 || generation > generation_)) {
+            values_.swap(values);
+            generation_ = generation;
+            sequence_ = sequence;
+            activeSlot_ = slot;
+        }
+    }
+
+    size_t replayed = 0;
+    std::string log;
+    if (storage_.readFile(logName(), log)) {
+        const uint64_t before = stats_.recordsReplayed;
+        const size_t valid = replayLog(log);
+        replayed = static_cast<size_t>(stats_.recordsReplayed - before);
+        logBytes_ = log.size();
+        if (valid < log.size()) {
+            // Power was lost mid-append. Nothing may be appended after the torn record, so
+            // fold the good part into a snapshot now; until that succeeds every save does.
+            logDamaged_ = true;
+            ++stats_.tornTails;
+            compact();
+        }
+    }
+
+    hasData_ = activeSlot_ >= 0 || replayed > 0;
+    return true;
+}
+
+size_t SettingsStore::replayLog(const std::string& data) {
+    size_t offset = 0;
+    std::string payload;
+    for (;;) {
+        size_t next = offset;
+        if (!decodeRecord(data, next, payload) || payload.size() < 12) {
+            return offset;
+        }
+        const uint64_t sequence = getLE(payload, 0, 8);
+        const uint32_t count = static_cast<uint32_t>(getLE(payload, 8, 4));
+        Values staged = values_;
+        if (!applyEntries(payload, 12, count, staged)) {
+            return offset;
+        }
+        // Records at or before the snapshot's sequence are already part of it (a compaction
+        // that died before removing the log).
+        if (sequence > sequence_) {
+            values_.swap(staged);
+            sequence_ = sequence;
+            ++stats_.recordsReplayed;
+        }
+        offset = next;
+    }
+}
+
+bool SettingsStore::save(const Values& state) {
+    std::string payload;
+    putU64(payload, sequence_ + 1);
+    putU32(payload, 0);
+
+    uint32_t count = 0;
+    for (const auto& entry : state) {
+        if (entry.first.size() > 0xFFFF) {
+            return false;
+        }
+        auto it = values_.find(entry.first);
+        if (it == values_.end() || it->second != entry.second) {
+            putEntry(payload, kOpSet, entry.first, entry.second);
+            ++count;
+        }
+    }
+    for (const auto& entry : values_) {
+        if (state.find(entry.first) == state.end()) {
+            putEntry(payload, kOpErase, entry.first, std::string());
+            ++count;
+        }
+    }
+    if (count == 0) {
+        return true;
+    }
+    for (int i = 0; i < 4; ++i) {
+        payload[8 + i] = static_cast<char>((count >> (8 * i)) & 0xFF);
+    }
+
+    std::string record;
+    encodeRecord(payload, record);
+
+    if (logDamaged_ || logBytes_ + record.size() > config_.maxLogBytes) {
+        if (!writeSnapshot(state, sequence_ + 1)) {
+            return false;
+        }
+    } else {
+        if (!storage_.appendFile(logName(), record.data(), record.size())) {
+            // Part of the record may have reached the medium; the next save compacts.
+            ++stats_.writeErrors;
+            logBytes_ = storage_.fileSize(logName());
+            logDamaged_ = true;
+            return false;
+        }
+        logBytes_ += record.size();
+        stats_.bytesWritten += record.size();
+        ++stats_.recordsAppended;
+    }
+
+    values_ = state;
+    ++sequence_;
+    hasData_ = true;
+    ++stats_.saves;
+    return true;
+}
+
+bool SettingsStore::compact() {
+    return writeSnapshot(values_, sequence_);
+}
+
+bool SettingsStore::writeSnapshot(const Values& state, uint64_t sequence) {
+    std::string payload;
+    putU64(payload, generation_ + 1);
+    putU64(payload, sequence);
+    putU32(payload, static_cast<uint32_t>(state.size()));
+    for (const auto& entry : state) {
+        putEntry(payload, kOpSet, entry.first, entry.second);
+    }
+
+    std::string file(kSnapshotMagic, sizeof(kSnapshotMagic));
+    encodeRecord(payload, file);
+
+    // Always overwrite the older slot: if this write tears, the newer one is still whole.
+    const int slot = activeSlot_ == 0 ? 1 : 0;
+    if (!storage_.writeFile(slotName(slot), file)) {
+        ++stats_.writeErrors;
+        return false;
+    }
+    activeSlot_ = slot;
+    ++generation_;
+    stats_.bytesWritten += file.size();
+    ++stats_.compactions;
+
+    // The snapshot now covers every log record; if removing the log fails, replay skips
+    // them by sequence number.
+    storage_.removeFile(logName());
+    if (storage_.exists(logName())) {
+        logBytes_ = storage_.fileSize(logName());
+    } else {
+        logBytes_ = 0;
+        logDamaged_ = false;
+    }
+    return true;
+}
+
+bool SettingsStore::readSnapshot(int slot, Values& out, uint64_t& generation, uint64_t& sequence) const {
+    std::string data;
+    if (!storage_.readFile(slotName(slot), data) || data.size() < sizeof(kSnapshotMagic) ||
+        data.compare(0, sizeof(kSnapshotMagic), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        return false;
+    }
+
+    size_t offset = sizeof(kSnapshotMagic);
+    std::string payload;
+    if (!decodeRecord(data, offset, payload) || offset != data.size() || payload.size() < 20) {
+        return false;
+    }
+    generation = getLE(payload, 0, 8);
+    sequence = getLE(payload, 8, 8);
+    out.clear();
+    return applyEntries(payload, 20, static_cast<uint32_t>(getLE(payload, 16, 4)), out);
+}
+
+void SettingsStore::encodeRecord(const std::string& payload, std::string& out) {
+    putU32(out, static_cast<uint32_t>(payload.size()));
+    putU32(out, Crc32::compute(payload.data(), payload.size()));
+    out += payload;
+}
+
+bool SettingsStore::decodeRecord(const std::string& data, size_t& offset, std::string& payload) {
+    if (offset + kRecordHeaderBytes > data.size()) {
+        return false;
+    }
+
+    const size_t payloadLength = static_cast<size_t>(getLE(data, offset, 4));
+    const uint32_t crc = static_cast<uint32_t>(getLE(data, offset + 4, 4));
+    const size_t start = offset + kRecordHeaderBytes;
+    if (payloadLength > data.size() - start) {
+        return false;
+    }
+    if (Crc32::compute(data.data() + start, payloadLength) != crc) {
+        return false;
+    }
+
+    payload.assign(data, start, payloadLength);
+    offset = start + payloadLength;
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "StorageBackend.h"
+
+// Crash-safe key/value persistence for settings. A save appends only the keys that changed,
+// as one CRC-checked record with a sequence number, to a log file; once the log outgrows
+// its budget the whole state is compacted into a snapshot. Snapshots alternate between two
+// slots (A/B) and carry a generation, so the previous one stays intact until the new one
+// is fully written. Boot takes the newest valid snapshot and replays the log records after
+// it, stopping at the first torn or corrupt record. A save is therefore all-or-nothing
+// across power loss, and flash sees small appends plus writes spread over two files
+// instead of a full rewrite per change.
+class SettingsStore {
+public:
+    using Values = std::map<std::string, std::string>;
+
+    struct Config {
+        std::string filePrefix = "settings";
+        size_t maxLogBytes = 4096; // Compact once an append would grow the log beyond this
+    };
+
+    struct Stats {
+        uint64_t saves = 0;           // Saves that wrote something
+        uint64_t recordsAppended = 0;
+        uint64_t compactions = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t recordsReplayed = 0; // Log records applied by begin()
+        uint64_t tornTails = 0;       // Boots that found a damaged log tail
+        uint64_t writeErrors = 0;
+    };
+
+    explicit SettingsStore(StorageBackend& storage);
+
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    // Call before begin().
+    void setConfig(const Config& config);
+    const Config& getConfig() const { return config_; }
+
+    // Recover the last saved state. A damaged log tail is compacted away so later appends
+    // never land behind it.
+    bool begin();
+    // True if begin() found a snapshot or log record.
+    bool hasData() const { return hasData_; }
+
+    const Values& values() const { return values_; }
+
+    // Make the stored state equal `state`: changed and new keys are written, missing keys
+    // erased. Nothing is written if nothing changed. On failure the stored state is the
+    // previous one (or, if the failed write reached the medium in full, the new one).
+    bool save(const Values& state);
+    // Write the current state as a snapshot and start an empty log.
+    bool compact();
+
+    uint64_t getSequence() const { return sequence_; }
+    size_t getLogBytes() const { return logBytes_; }
+    Stats getStats() const { return stats_; }
+
+private:
+    StorageBackend& storage_;
+    Config config_;
+
+    Values values_;
+    uint64_t sequence_ = 0;   // Last sequence number written or replayed
+    uint64_t generation_ = 0; // Of the newest valid snapshot
+    int activeSlot_ = -1;     // Slot holding that snapshot, or -1
+    size_t logBytes_ = 0;
+    bool logDamaged_ = false; // The log may end in a partial record
+    bool hasData_ = false;
+    Stats stats_;
+
+    std::string slotName(int slot) const;
+    std::string logName() const;
+    bool writeSnapshot(const Values& state, uint64_t sequence);
+    bool readSnapshot(int slot, Values& out, uint64_t& generation, uint64_t& sequence) const;
+    size_t replayLog(const std::string& data); // Returns the length of the valid prefix
+
+    static void encodeRecord(const std::string& payload, std::string& out);
+    static bool decodeRecord(const std::string& data, size_t& offset, std::string& payload);
+};
+
+#endif // SETTINGS_STORE_H
@@ -0,0 +1,100 @@
+#include "SettingsWriteBack.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+SettingsWriteBack::SettingsWriteBack(MockSettingsManager& settings)
+    : settings_(settings), seenVersion_(settings.getVersion()) {
+}
+
+uint64_t SettingsWriteBack::nowMs() const {
+    if (timeProvider_) {
+        return timeProvider_();
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+void SettingsWriteBack::observe(uint64_t now) {
+    const uint64_t version = settings_.getVersion();
+    const uint64_t steps = version - seenVersion_;
+    seenVersion_ = version;
+
+    if (!settings_.hasUnsavedChanges()) {
+        pending_ = false; // Saved or reloaded elsewhere
+        return;
+    }
+    if (!pending_) {
+        pending_ = true;
+        firstChangeMs_ = now;
+        windowStartMs_ = now;
+        lastChangeMs_ = now;
+        batchChanges_ = 0;
+    }
+    if (steps > 0) {
+        lastChangeMs_ = now;
+        batchChanges_ += steps;
+        stats_.changes += steps;
+    }
+}
+
+bool SettingsWriteBack::poll() {
+    const uint64_t now = nowMs();
+    observe(now);
+    if (!pending_) {
+        return false;
+    }
+    if (now - lastChangeMs_ >= config_.quietMs) {
+        return flush(now, Reason::QUIET);
+    }
+    if (now - windowStartMs_ >= config_.maxLatencyMs) {
+        return flush(now, Reason::LATENCY);
+    }
+    return false;
+}
+
+bool SettingsWriteBack::flushBeforeReboot() {
+    const uint64_t now = nowMs();
+    observe(now);
+    return !pending_ || flush(now, Reason::REBOOT);
+}
+
+uint64_t SettingsWriteBack::msUntilDue() {
+    const uint64_t now = nowMs();
+    observe(now);
+    if (!pending_) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    const uint64_t due = std::min(lastChangeMs_ + config_.quietMs, windowStartMs_ + config_.maxLatencyMs);
+    return due > now ? due - now : 0;
+}
+
+bool SettingsWriteBack::flush(uint64_t now, Reason reason) {
+    if (!settings_.saveSettings()) {
+        ++stats_.flushErrors;
+        // Retry after another quiet period rather than on every poll.
+        windowStartMs_ = now;
+        lastChangeMs_ = now;
+        return false;
+    }
+
+    seenVersion_ = settings_.getVersion();
+    pending_ = false;
+
+    ++stats_.flushes;
+    if (batchChanges_ > 1) {
+        stats_.writesAvoided += batchChanges_ - 1;
+    }
+    switch (reason) {
+        case Reason::QUIET: ++stats_.quietFlushes; break;
+        case Reason::LATENCY: ++stats_.latencyFlushes; break;
+        case Reason::REBOOT: ++stats_.rebootFlushes; break;
+    }
+    const uint64_t latency = now - firstChangeMs_;
+    stats_.lastLatencyMs = latency;
+    stats_.maxLatencyMs = std::max(stats_.maxLatencyMs, latency);
+    stats_.totalLatencyMs += latency;
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef SETTINGS_WRITE_BACK_H
+#define SETTINGS_WRITE_BACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "MockSettingsManager.h"
+
+// Debounced write-back for MockSettingsManager. The UI posts a form one field at a time, so
+// saving on every change would write flash once per field; instead changes are left to
+// pile up and saved together once none has arrived for quietMs, or maxLatencyMs after the
+// first one at the latest so a steady trickle cannot hold a save off forever. The save
+// itself writes only the keys that differ from what is stored (SettingsStore), so a field
+// edited five times in a batch costs one entry.
+//
+// Changes are noticed through the settings version, which every mutation bumps, so nothing
+// has to be hooked into the setters; a save made elsewhere (hasUnsavedChanges() false)
+// cancels the pending batch. Call poll() from the main loop and flushBeforeReboot() before
+// restarting or starting an OTA update. Not thread-safe: use from the settings' thread.
+class SettingsWriteBack {
+public:
+    struct Config {
+        uint32_t quietMs = 2000;       // Save once no change has been seen for this long...
+        uint32_t maxLatencyMs = 10000; // ...or this long after the first unsaved change
+    };
+
+    struct Stats {
+        uint64_t changes = 0;        // Mutations seen (settings version steps)
+        uint64_t flushes = 0;        // Successful saves
+        uint64_t writesAvoided = 0;  // Changes that rode along in another change's save
+        uint64_t quietFlushes = 0;
+        uint64_t latencyFlushes = 0; // Forced by maxLatencyMs
+        uint64_t rebootFlushes = 0;
+        uint64_t flushErrors = 0;
+        uint64_t lastLatencyMs = 0;  // First unsaved change to the save that stored it
+        uint64_t maxLatencyMs = 0;
+        uint64_t totalLatencyMs = 0;
+
+        double averageLatencyMs() const {
+            return flushes ? static_cast<double>(totalLatencyMs) / static_cast<double>(flushes) : 0.0;
+        }
+    };
+
+    using TimeProvider = std::function<uint64_t()>;
+
+    explicit SettingsWriteBack(MockSettingsManager& settings);
+
+    SettingsWriteBack(const SettingsWriteBack&) = delete;
+    SettingsWriteBack& operator=(const SettingsWriteBack&) = delete;
+
+    void setConfig(const Config& config) { config_ = config; }
+    Config getConfig() const { return config_; }
+    // Milliseconds since an arbitrary epoch; defaults to the steady clock.
+    void setTimeProvider(TimeProvider provider) { timeProvider_ = provider; }
+
+    // Pick up new changes and save if a deadline has passed. Returns true if it saved.
+    bool poll();
+    // Save anything pending now. True if nothing was pending or the save worked.
+    bool flushBeforeReboot();
+
+    bool isPending() const { return pending_; }
+    // Until poll() would save: 0 when due, UINT64_MAX when nothing is pending.
+    uint64_t msUntilDue();
+
+    Stats getStats() const { return stats_; }
+    void resetStats() { stats_ = Stats(); }
+
+private:
+    enum class Reason : uint8_t { QUIET, LATENCY, REBOOT };
+
+    MockSettingsManager& settings_;
+    Config config_;
+    TimeProvider timeProvider_;
+    uint64_t seenVersion_;
+    bool pending_ = false;
+    uint64_t firstChangeMs_ = 0; // Latency is measured from here
+    uint64_t windowStartMs_ = 0; // maxLatencyMs runs from here (restarted after a failed save)
+    uint64_t lastChangeMs_ = 0;
+    uint64_t batchChanges_ = 0;
+    Stats stats_;
+
+    uint64_t nowMs() const;
+    void observe(uint64_t now);
+    bool flush(uint64_t now, Reason reason);
+};
+
+#endif // SETTINGS_WRITE_BACK_H
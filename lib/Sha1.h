@@ -0,0 +1,16 @@
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <cstddef>
+#include <cstdint>
+
+// SHA-1 (FIPS 180-4). Only for protocol handshakes such as Sec-WebSocket-Accept; not for
+// anything security-sensitive.
+class Sha1 {
+public:
+    static const size_t kDigestBytes = 20;
+
+    static void compute(const void* data, size_t length, uint8_t digest[kDigestBytes]);
+};
+
+#endif // SHA1_H
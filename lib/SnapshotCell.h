@@ -0,0 +1,106 @@
+#ifndef SNAPSHOT_CELL_H
+#define SNAPSHOT_CELL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// One writer publishes immutable values, any number of reader threads take references to
+// the latest one; neither side takes a lock. Values live in nodes that are recycled, never
+// freed, while the cell exists, so a reader may touch the reader count of a node that is
+// being retired: it pins the node by bumping that count, then checks that the node is still
+// the published one and backs off if not. The writer refills only nodes that are neither
+// published nor pinned, reusing their storage (string capacity included), and allocates a
+// new node only while every spare one is still held. All Refs must be gone before the cell.
+template <typename T>
+class SnapshotCell {
+    struct Node {
+        T value;
+        std::atomic<size_t> readers{0};
+    };
+
+public:
+    // A pinned value. Holding one keeps it unchanged; copies pin it again.
+    class Ref {
+    public:
+        Ref() = default;
+        Ref(const Ref& other) : node_(other.node_) {
+            if (node_) {
+                node_->readers.fetch_add(1);
+            }
+        }
+        Ref(Ref&& other) : node_(other.node_) { other.node_ = nullptr; }
+        Ref& operator=(Ref other) {
+            std::swap(node_, other.node_);
+            return *this;
+        }
+        ~Ref() {
+            if (node_) {
+                node_->readers.fetch_sub(1);
+            }
+        }
+
+        const T& operator*() const { return node_->value; }
+        const T* operator->() const { return &node_->value; }
+        const T* get() const { return node_ ? &node_->value : nullptr; }
+        explicit operator bool() const { return node_ != nullptr; }
+
+    private:
+        friend class SnapshotCell;
+        explicit Ref(Node* node) : node_(node) {}
+
+        Node* node_ = nullptr;
+    };
+
+    SnapshotCell() {
+        nodes_.push_back(std::unique_ptr<Node>(new Node()));
+        current_.store(nodes_.back().get());
+    }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    // Reader side, any thread. Retries only when a publish lands between the two loads.
+    Ref load() const {
+        for (;;) {
+            Node* node = current_.load();
+            node->readers.fetch_add(1);
+            if (current_.load() == node) {
+                return Ref(node);
+            }
+            node->readers.fetch_sub(1);
+        }
+    }
+
+    // Writer side, one thread: let fill() overwrite a spare value in place, then publish it.
+    // The spare holds whatever an older publish left there.
+    template <typename Fill>
+    void publish(Fill fill) {
+        Node* published = current_.load(std::memory_order_relaxed);
+        Node* spare = nullptr;
+        for (const std::unique_ptr<Node>& node : nodes_) {
+            // Seen unpinned while unpublished: a reader that pins it later fails its recheck.
+            if (node.get() != published && node->readers.load() == 0) {
+                spare = node.get();
+                break;
+            }
+        }
+        if (!spare) {
+            nodes_.push_back(std::unique_ptr<Node>(new Node()));
+            spare = nodes_.back().get();
+        }
+        fill(spare->value);
+        current_.store(spare);
+    }
+
+    // Nodes allocated so far: one published plus one per value still pinned, at peak.
+    size_t nodeCount() const { return nodes_.size(); }
+
+private:
+    std::atomic<Node*> current_{nullptr};
+    std::vector<std::unique_ptr<Node>> nodes_; // Writer only
+};
+
+#endif // SNAPSHOT_CELL_H
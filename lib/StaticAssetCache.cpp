@@ -0,0 +1,446 @@
+#include "StaticAssetCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "Crc32.h"
+
+namespace {
+typedef MockWebServer::Slice Slice;
+
+const char* const kSuffixes[StaticAssetCache::ENCODING_COUNT] = {"", ".gz", ".br"};
+const char* const kContentEncodings[StaticAssetCache::ENCODING_COUNT] = {"", "gzip", "br"};
+
+bool endsWith(const std::string& text, const char* suffix) {
+    const size_t n = std::strlen(suffix);
+    return text.size() >= n && text.compare(text.size() - n, n, suffix) == 0;
+}
+
+Slice trimmed(const char* begin, const char* end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) {
+        --end;
+    }
+    return Slice(begin, static_cast<size_t>(end - begin));
+}
+
+// Calls fn(item) for each comma-separated, trimmed, non-empty item.
+template <typename Fn>
+void forEachListItem(const Slice& list, Fn fn) {
+    const char* item = list.data;
+    const char* end = list.data + list.length;
+    while (item < end) {
+        const char* comma = static_cast<const char*>(std::memchr(item, ',', static_cast<size_t>(end - item)));
+        const char* itemEnd = comma ? comma : end;
+        const Slice value = trimmed(item, itemEnd);
+        if (!value.empty()) {
+            fn(value);
+        }
+        item = itemEnd + 1;
+    }
+}
+
+// "0", "0.5", "1.000" -> 0..1000; malformed values count as 1 (RFC 9110 default).
+int parseQValue(const Slice& text) {
+    if (text.empty() || (text.data[0] != '0' && text.data[0] != '1')) {
+        return 1000;
+    }
+    int value = (text.data[0] - '0') * 1000;
+    int scale = 100;
+    for (size_t i = 2; i < text.length && i < 5 && text.data[1] == '.'; ++i) {
+        if (text.data[i] < '0' || text.data[i] > '9') {
+            break;
+        }
+        value += (text.data[i] - '0') * scale;
+        scale /= 10;
+    }
+    return value > 1000 ? 1000 : value;
+}
+
+bool parseUnsigned(const char* begin, const char* end, uint64_t& out) {
+    if (begin == end || end - begin > 18) {
+        return false;
+    }
+    out = 0;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        out = out * 10 + static_cast<uint64_t>(*p - '0');
+    }
+    return true;
+}
+
+enum class RangeResult {
+    NONE,          // No usable Range header: send the whole body
+    SATISFIABLE,
+    UNSATISFIABLE
+};
+
+// Single "bytes=first-last", "bytes=first-" or "bytes=-suffix". Multiple ranges and
+// malformed headers are ignored, which RFC 9110 allows.
+RangeResult parseRange(const Slice& header, size_t size, size_t& first, size_t& last) {
+    if (header.length < 7 || std::memcmp(header.data, "bytes=", 6) != 0 ||
+        std::memchr(header.data, ',', header.length) != nullptr) {
+        return RangeResult::NONE;
+    }
+    const char* spec = header.data + 6;
+    const char* end = header.data + header.length;
+    const char* dash = static_cast<const char*>(std::memchr(spec, '-', static_cast<size_t>(end - spec)));
+    if (!dash) {
+        return RangeResult::NONE;
+    }
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (dash == spec) {
+        if (!parseUnsigned(dash + 1, end, b)) {
+            return RangeResult::NONE;
+        }
+        if (b == 0 || size == 0) {
+            return RangeResult::UNSATISFIABLE;
+        }
+        first = b >= size ? 0 : size - static_cast<size_t>(b);
+        last = size - 1;
+        return RangeResult::SATISFIABLE;
+    }
+
+    if (!parseUnsigned(spec, dash, a)) {
+        return RangeResult::NONE;
+    }
+    if (dash + 1 == end) {
+        b = size == 0 ? 0 : size - 1;
+    } else if (!parseUnsigned(dash + 1, end, b) || b < a) {
+        return RangeResult::NONE;
+    }
+    if (a >= size) {
+        return RangeResult::UNSATISFIABLE;
+    }
+    first = static_cast<size_t>(a);
+    last = b >= size ? size - 1 : static_cast<size_t>(b);
+    return RangeResult::SATISFIABLE;
+}
+
+bool etagListMatches(const Slice& list, const std::string& etag) {
+    bool matched = false;
+    forEachListItem(list, [&](Slice item) {
+        if (item.length >= 2 && item.data[0] == 'W' && item.data[1] == '/') {
+            item = Slice(item.data + 2, item.length - 2); // If-None-Match uses weak comparison
+        }
+        if (item.equals("*") || (item.length == etag.size() && std::memcmp(item.data, etag.data(), item.length) == 0)) {
+            matched = true;
+        }
+    });
+    return matched;
+}
+} // namespace
+
+StaticAssetCache::StaticAssetCache(StorageBackend& storage, size_t cacheBytes)
+    : storage_(storage), cacheBytes_(cacheBytes) {
+}
+
+const char* StaticAssetCache::contentTypeFor(const std::string& fileName) {
+    struct Type {
+        const char* extension;
+        const char* contentType;
+    };
+    static const Type kTypes[] = {
+        {".html", "text/html; charset=utf-8"},
+        {".htm", "text/html; charset=utf-8"},
+        {".js", "application/javascript"},
+        {".mjs", "application/javascript"},
+        {".css", "text/css"},
+        {".json", "application/json"},
+        {".map", "application/json"},
+        {".webmanifest", "application/manifest+json"},
+        {".svg", "image/svg+xml"},
+        {".png", "image/png"},
+        {".jpg", "image/jpeg"},
+        {".jpeg", "image/jpeg"},
+        {".gif", "image/gif"},
+        {".webp", "image/webp"},
+        {".ico", "image/x-icon"},
+        {".woff2", "font/woff2"},
+        {".woff", "font/woff"},
+        {".txt", "text/plain; charset=utf-8"},
+    };
+    for (const auto& type : kTypes) {
+        if (endsWith(fileName, type.extension)) {
+            return type.contentType;
+        }
+    }
+    return "application/octet-stream";
+}
+
+StaticAssetCache::Encoding StaticAssetCache::negotiate(const MockWebServer::Slice& acceptEncoding, unsigned available) {
+    // q-values in thousandths; -1 means "not mentioned".
+    int q[ENCODING_COUNT] = {-1, -1, -1};
+    int wildcard = -1;
+
+    forEachListItem(acceptEncoding, [&](const Slice& item) {
+        const char* semicolon = static_cast<const char*>(std::memchr(item.data, ';', item.length));
+        const Slice coding = trimmed(item.data, semicolon ? semicolon : item.data + item.length);
+        int value = 1000;
+        if (semicolon) {
+            const Slice params = trimmed(semicolon + 1, item.data + item.length);
+            if (params.length >= 2 && (params.data[0] == 'q' || params.data[0] == 'Q') && params.data[1] == '=') {
+                value = parseQValue(Slice(params.data + 2, params.length - 2));
+            }
+        }
+
+        if (coding.equalsIgnoreCase("br")) {
+            q[ENCODING_BROTLI] = value;
+        } else if (coding.equalsIgnoreCase("gzip") || coding.equalsIgnoreCase("x-gzip")) {
+            q[ENCODING_GZIP] = value;
+        } else if (coding.equalsIgnoreCase("identity")) {
+            q[ENCODING_IDENTITY] = value;
+        } else if (coding.equals("*")) {
+            wildcard = value;
+        }
+    });
+
+    for (size_t i = 0; i < ENCODING_COUNT; ++i) {
+        if (q[i] < 0) {
+            // Unlisted codings get the wildcard's q; identity stays acceptable unless excluded.
+            q[i] = wildcard >= 0 ? wildcard : (i == ENCODING_IDENTITY ? 1 : 0);
+        }
+    }
+
+    // Highest q wins; on a tie prefer the smaller body.
+    static const Encoding kPreference[] = {ENCODING_BROTLI, ENCODING_GZIP, ENCODING_IDENTITY};
+    Encoding best = ENCODING_COUNT;
+    int bestQ = 0;
+    for (Encoding encoding : kPreference) {
+        if ((available & (1u << encoding)) && q[encoding] > bestQ) {
+            best = encoding;
+            bestQ = q[encoding];
+        }
+    }
+    return best;
+}
+
+bool StaticAssetCache::add(const std::string& urlPath, const std::string& fileName, const std::string& contentType,
+                           const std::string& cacheControl) {
+    if (urlPath.empty() || urlPath[0] != '/') {
+        return false;
+    }
+
+    Asset asset;
+    asset.urlPath = urlPath;
+    asset.contentType = contentType.empty() ? contentTypeFor(fileName) : contentType;
+    asset.cacheControl = cacheControl;
+
+    bool any = false;
+    for (size_t i = 0; i < ENCODING_COUNT; ++i) {
+        Variant& variant = asset.variants[i];
+        variant.fileName = fileName + kSuffixes[i];
+        if (!storage_.exists(variant.fileName) || !storage_.readFile(variant.fileName, variant.body)) {
+            variant.body.clear();
+            continue;
+        }
+        char etag[16];
+        std::snprintf(etag, sizeof(etag), "\"%08x\"",
+                      static_cast<unsigned>(Crc32::compute(variant.body.data(), variant.body.size())));
+        variant.etag = etag;
+        variant.size = variant.body.size();
+        variant.present = true;
+        std::string().swap(variant.body); // Loaded into the cache on first request
+        any = true;
+    }
+    if (!any) {
+        return false;
+    }
+
+    auto it = std::lower_bound(assets_.begin(), assets_.end(), urlPath,
+                               [](const Asset& a, const std::string& path) { return a.urlPath < path; });
+    if (it != assets_.end() && it->urlPath == urlPath) {
+        for (const Variant& old : it->variants) {
+            stats_.cachedBytes -= old.resident ? old.size : 0;
+        }
+        *it = std::move(asset);
+    } else {
+        assets_.insert(it, std::move(asset));
+    }
+    return true;
+}
+
+size_t StaticAssetCache::addAll(const std::string& urlPrefix) {
+    std::string prefix = urlPrefix;
+    if (prefix.empty() || prefix[prefix.size() - 1] != '/') {
+        prefix += '/';
+    }
+
+    size_t added = 0;
+    for (const std::string& name : storage_.listFiles("")) {
+        if (endsWith(name, ".gz") || endsWith(name, ".br")) {
+            continue;
+        }
+        if (add(prefix + name, name)) {
+            ++added;
+            if (name == "index.html") {
+                add(prefix, name);
+            }
+        }
+    }
+    return added;
+}
+
+void StaticAssetCache::clear() {
+    assets_.clear();
+    stats_.cachedBytes = 0;
+}
+
+std::string StaticAssetCache::getETag(const std::string& urlPath, Encoding encoding) const {
+    const Asset* asset = find(Slice(urlPath));
+    if (!asset || encoding >= ENCODING_COUNT) {
+        return std::string();
+    }
+    return asset->variants[encoding].etag;
+}
+
+StaticAssetCache::Stats StaticAssetCache::getStats() const {
+    return stats_;
+}
+
+const StaticAssetCache::Asset* StaticAssetCache::find(const MockWebServer::Slice& urlPath) const {
+    auto it = std::lower_bound(assets_.begin(), assets_.end(), urlPath, [](const Asset& a, const Slice& path) {
+        return a.urlPath.compare(0, std::string::npos, path.data, path.length) < 0;
+    });
+    if (it == assets_.end() || it->urlPath.compare(0, std::string::npos, urlPath.data, urlPath.length) != 0) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+void StaticAssetCache::makeRoom(size_t bytes) {
+    while (stats_.cachedBytes + bytes > cacheBytes_) {
+        Variant* oldest = nullptr;
+        for (Asset& asset : assets_) {
+            for (Variant& variant : asset.variants) {
+                if (variant.resident && (!oldest || variant.lastUsed < oldest->lastUsed)) {
+                    oldest = &variant;
+                }
+            }
+        }
+        if (!oldest) {
+            return;
+        }
+        std::string().swap(oldest->body);
+        oldest->resident = false;
+        stats_.cachedBytes -= oldest->size;
+    }
+}
+
+bool StaticAssetCache::load(Variant& variant) {
+    variant.lastUsed = ++useClock_;
+    if (variant.resident) {
+        ++stats_.memoryHits;
+        return true;
+    }
+
+    ++stats_.flashReads;
+    if (!storage_.readFile(variant.fileName, variant.body)) {
+        return false;
+    }
+    variant.size = variant.body.size();
+    if (variant.size <= cacheBytes_) {
+        makeRoom(variant.size);
+        variant.resident = true;
+        stats_.cachedBytes += variant.size;
+    }
+    return true;
+}
+
+bool StaticAssetCache::serve(const MockWebServer::RequestView& request, MockWebServer::HttpResponse& response) {
+    Asset* asset = const_cast<Asset*>(find(request.path));
+    if (!asset) {
+        return false;
+    }
+
+    response = MockWebServer::HttpResponse();
+    if (!request.method.equals("GET") && !request.method.equals("HEAD")) {
+        response = MockWebServer::createErrorResponse(405, "Method Not Allowed");
+        response.headers["Allow"] = "GET, HEAD";
+        return true;
+    }
+    ++stats_.requests;
+
+    unsigned available = 0;
+    for (size_t i = 0; i < ENCODING_COUNT; ++i) {
+        available |= asset->variants[i].present ? (1u << i) : 0u;
+    }
+    const Encoding encoding = negotiate(request.header("Accept-Encoding"), available);
+    if (encoding == ENCODING_COUNT) {
+        response = MockWebServer::createErrorResponse(406, "Not Acceptable");
+        return true;
+    }
+    Variant& variant = asset->variants[encoding];
+    const Variant& identity = asset->variants[ENCODING_IDENTITY];
+    stats_.identityBytes += identity.present ? identity.size : variant.size;
+
+    response.headers["Content-Type"] = asset->contentType;
+    response.headers["ETag"] = variant.etag;
+    response.headers["Accept-Ranges"] = "bytes";
+    if (!asset->cacheControl.empty()) {
+        response.headers["Cache-Control"] = asset->cacheControl;
+    }
+    if (available != (1u << ENCODING_IDENTITY)) {
+        response.headers["Vary"] = "Accept-Encoding";
+    }
+    if (encoding != ENCODING_IDENTITY) {
+        response.headers["Content-Encoding"] = kContentEncodings[encoding];
+    }
+
+    const Slice ifNoneMatch = request.header("If-None-Match");
+    if (!ifNoneMatch.empty() && etagListMatches(ifNoneMatch, variant.etag)) {
+        response.statusCode = 304;
+        response.statusMessage = "Not Modified";
+        ++stats_.notModified;
+        return true;
+    }
+
+    // If-Range only applies the range when the client's copy is still current (strong match).
+    size_t first = 0;
+    size_t last = 0;
+    RangeResult range = RangeResult::NONE;
+    const Slice rangeHeader = request.header("Range");
+    const Slice ifRange = request.header("If-Range");
+    if (!rangeHeader.empty() && (ifRange.empty() || ifRange.equals(variant.etag.c_str()))) {
+        range = parseRange(rangeHeader, variant.size, first, last);
+    }
+    if (range == RangeResult::UNSATISFIABLE) {
+        response.statusCode = 416;
+        response.statusMessage = "Range Not Satisfiable";
+        response.headers["Content-Range"] = "bytes */" + std::to_string(variant.size);
+        return true;
+    }
+
+    if (!load(variant)) {
+        response = MockWebServer::createErrorResponse(500, "Asset unreadable");
+        return true;
+    }
+    ++stats_.servedByEncoding[encoding];
+    if (range == RangeResult::SATISFIABLE && last >= variant.body.size()) {
+        range = RangeResult::NONE; // File changed size since add(); send it whole
+    }
+
+    if (range == RangeResult::SATISFIABLE) {
+        response.statusCode = 206;
+        response.statusMessage = "Partial Content";
+        response.headers["Content-Range"] = "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" +
+                                            std::to_string(variant.body.size());
+        response.body.assign(variant.body, first, last - first + 1);
+        ++stats_.partial;
+    } else {
+        response.body = variant.body;
+    }
+    stats_.bytesServed += response.body.size();
+
+    if (!variant.resident) {
+        std::string().swap(variant.body); // Larger than the whole cache: read per request
+    }
+    return true;
+}
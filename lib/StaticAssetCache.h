@@ -0,0 +1,103 @@
+#ifndef STATIC_ASSET_CACHE_H
+#define STATIC_ASSET_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MockWebServer.h"
+#include "StorageBackend.h"
+
+#ifndef STATIC_ASSET_CACHE_BYTES
+#define STATIC_ASSET_CACHE_BYTES (64 * 1024)
+#endif
+
+// Serves the web UI bundle from storage. The UI build writes each file next to its
+// precompressed variants ("app.js", "app.js.br", "app.js.gz"); add() records which exist and
+// gives each a strong ETag (CRC-32 of its bytes), so the variant is chosen per request from
+// Accept-Encoding and a revalidation with a matching If-None-Match costs no flash read.
+// Single "bytes=" ranges are honoured on the selected variant. Recently served variants are
+// kept in RAM up to the byte budget, least recently used evicted first.
+//
+// Used from one thread (the web server's); attach with MockWebServer::serveAssets().
+class StaticAssetCache {
+public:
+    enum Encoding : uint8_t {
+        ENCODING_IDENTITY,
+        ENCODING_GZIP,
+        ENCODING_BROTLI,
+        ENCODING_COUNT
+    };
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t notModified = 0;    // 304s
+        uint64_t partial = 0;        // 206s
+        uint64_t memoryHits = 0;     // Bodies served from the RAM cache
+        uint64_t flashReads = 0;     // Bodies read from storage
+        uint64_t bytesServed = 0;    // Body bytes in responses
+        uint64_t identityBytes = 0;  // What those bodies would have cost uncompressed and whole
+        uint64_t servedByEncoding[ENCODING_COUNT] = {0, 0, 0};
+        size_t cachedBytes = 0;
+    };
+
+    explicit StaticAssetCache(StorageBackend& storage, size_t cacheBytes = STATIC_ASSET_CACHE_BYTES);
+
+    StaticAssetCache(const StaticAssetCache&) = delete;
+    StaticAssetCache& operator=(const StaticAssetCache&) = delete;
+
+    // Serve storage file `fileName` (and whichever of fileName.br / fileName.gz exist) at
+    // urlPath. contentType defaults to one derived from the extension. cacheControl is sent
+    // on every response; the default makes browsers revalidate, which is a cheap 304 here.
+    bool add(const std::string& urlPath, const std::string& fileName, const std::string& contentType = "",
+             const std::string& cacheControl = "no-cache");
+    // add() every file in storage under urlPrefix ("/" + name); "index.html" is also served
+    // at urlPrefix itself. Returns the number of assets added.
+    size_t addAll(const std::string& urlPrefix = "/");
+    void clear();
+
+    bool contains(const MockWebServer::Slice& urlPath) const { return find(urlPath) != nullptr; }
+    size_t size() const { return assets_.size(); }
+    // ETag of a variant, or "" if the asset or variant is missing.
+    std::string getETag(const std::string& urlPath, Encoding encoding) const;
+    Stats getStats() const;
+
+    // Answer a GET or HEAD for a registered path; false if the path is not an asset.
+    bool serve(const MockWebServer::RequestView& request, MockWebServer::HttpResponse& response);
+
+    static const char* contentTypeFor(const std::string& fileName);
+    // Best encoding among `available` (bit per Encoding) that the Accept-Encoding value
+    // allows, honouring q-values; ENCODING_COUNT if none is acceptable.
+    static Encoding negotiate(const MockWebServer::Slice& acceptEncoding, unsigned available);
+
+private:
+    struct Variant {
+        bool present = false;
+        std::string fileName;
+        size_t size = 0;
+        std::string etag;
+        std::string body;      // Cached bytes; empty when not resident
+        bool resident = false;
+        uint64_t lastUsed = 0;
+    };
+
+    struct Asset {
+        std::string urlPath;
+        std::string contentType;
+        std::string cacheControl;
+        Variant variants[ENCODING_COUNT];
+    };
+
+    StorageBackend& storage_;
+    size_t cacheBytes_;
+    std::vector<Asset> assets_; // Sorted by urlPath
+    uint64_t useClock_ = 0;
+    Stats stats_;
+
+    const Asset* find(const MockWebServer::Slice& urlPath) const;
+    bool load(Variant& variant);
+    void makeRoom(size_t bytes);
+};
+
+#endif // STATIC_ASSET_CACHE_H
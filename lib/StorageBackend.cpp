@@ -0,0 +1,108 @@
+#include "StorageBackend.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+bool writeAll(FILE* file, const char* data, size_t length) {
+    if (length > 0 && std::fwrite(data, 1, length, file) != length) {
+        return false;
+    }
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+    return fsync(fileno(file)) == 0;
+}
+} // namespace
+
+FileStorageBackend::FileStorageBackend(const std::string& rootDir) : rootDir_(rootDir) {
+    while (rootDir_.size() > 1 && rootDir_[rootDir_.size() - 1] == '/') {
+        rootDir_.erase(rootDir_.size() - 1);
+    }
+}
+
+std::string FileStorageBackend::pathFor(const std::string& name) const {
+    return rootDir_ + "/" + name;
+}
+
+bool FileStorageBackend::readFile(const std::string& name, std::string& out) {
+    FILE* file = std::fopen(pathFor(name).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    out.clear();
+    char buffer[512];
+    size_t n = 0;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        out.append(buffer, n);
+    }
+
+    const bool ok = !std::ferror(file);
+    std::fclose(file);
+    return ok;
+}
+
+bool FileStorageBackend::writeFile(const std::string& name, const std::string& data) {
+    FILE* file = std::fopen(pathFor(name).c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+
+    const bool ok = writeAll(file, data.data(), data.size());
+    return (std::fclose(file) == 0) && ok;
+}
+
+bool FileStorageBackend::appendFile(const std::string& name, const char* data, size_t length) {
+    FILE* file = std::fopen(pathFor(name).c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+
+    const bool ok = writeAll(file, data, length);
+    return (std::fclose(file) == 0) && ok;
+}
+
+bool FileStorageBackend::removeFile(const std::string& name) {
+    return std::remove(pathFor(name).c_str()) == 0;
+}
+
+bool FileStorageBackend::renameFile(const std::string& from, const std::string& to) {
+    return std::rename(pathFor(from).c_str(), pathFor(to).c_str()) == 0;
+}
+
+bool FileStorageBackend::exists(const std::string& name) {
+    struct stat st;
+    return stat(pathFor(name).c_str(), &st) == 0;
+}
+
+size_t FileStorageBackend::fileSize(const std::string& name) {
+    struct stat st;
+    if (stat(pathFor(name).c_str(), &st) != 0) {
+        return 0;
+    }
+    return static_cast<size_t>(st.st_size);
+}
+
+std::vector<std::string> FileStorageBackend::listFiles(const std::string& prefix) {
+    std::vector<std::string> names;
+
+    DIR* dir = opendir(rootDir_.c_str());
+    if (!dir) {
+        return names;
+    }
+
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0 && name != "." && name != "..") {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
@@ -0,0 +1,50 @@
+#ifndef STORAGE_BACKEND_H
+#define STORAGE_BACKEND_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Minimal flat-directory file API used by the persistence tiers. File names are relative
+// to the backend root and contain no directories.
+class StorageBackend {
+public:
+    virtual ~StorageBackend() = default;
+
+    virtual bool readFile(const std::string& name, std::string& out) = 0;
+    // Create or replace `name` with `data`, flushed to the medium before returning.
+    virtual bool writeFile(const std::string& name, const std::string& data) = 0;
+    virtual bool appendFile(const std::string& name, const char* data, size_t length) = 0;
+    virtual bool removeFile(const std::string& name) = 0;
+    // Atomically replace `to` with `from`.
+    virtual bool renameFile(const std::string& from, const std::string& to) = 0;
+    virtual bool exists(const std::string& name) = 0;
+    virtual size_t fileSize(const std::string& name) = 0;
+    // Names starting with `prefix`, sorted ascending.
+    virtual std::vector<std::string> listFiles(const std::string& prefix) = 0;
+};
+
+// stdio/POSIX implementation rooted at a directory. On the ESP32 point it at the LittleFS
+// VFS mount (e.g. "/littlefs"); on desktop at a temp directory.
+class FileStorageBackend : public StorageBackend {
+public:
+    explicit FileStorageBackend(const std::string& rootDir);
+
+    const std::string& getRootDir() const { return rootDir_; }
+
+    bool readFile(const std::string& name, std::string& out) override;
+    bool writeFile(const std::string& name, const std::string& data) override;
+    bool appendFile(const std::string& name, const char* data, size_t length) override;
+    bool removeFile(const std::string& name) override;
+    bool renameFile(const std::string& from, const std::string& to) override;
+    bool exists(const std::string& name) override;
+    size_t fileSize(const std::string& name) override;
+    std::vector<std::string> listFiles(const std::string& prefix) override;
+
+private:
+    std::string rootDir_;
+
+    std::string pathFor(const std::string& name) const;
+};
+
+#endif // STORAGE_BACKEND_H
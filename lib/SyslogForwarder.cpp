@@ -0,0 +1,345 @@
+#include "SyslogForwarder.h"
+
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+uint64_t defaultNowMs() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+// RFC 5424 header fields are printable US-ASCII without spaces; NILVALUE when empty.
+std::string headerField(const std::string& value, size_t maxLength) {
+    if (value.empty()) {
+        return "-";
+    }
+
+    std::string out;
+    for (size_t i = 0; i < value.size() && out.size() < maxLength; ++i) {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        out.push_back((c > 32 && c < 127) ? static_cast<char>(c) : '_');
+    }
+    return out;
+}
+} // namespace
+
+UdpSyslogTransport::~UdpSyslogTransport() {
+    close();
+}
+
+bool UdpSyslogTransport::open(const std::string& host, uint16_t port) {
+    close();
+
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    struct addrinfo* result = nullptr;
+    const std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &result) != 0 || !result) {
+        return false;
+    }
+
+    for (struct addrinfo* ai = result; ai; ai = ai->ai_next) {
+        int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            socket_ = fd;
+            break;
+        }
+        ::close(fd);
+    }
+
+    freeaddrinfo(result);
+    return socket_ >= 0;
+}
+
+void UdpSyslogTransport::close() {
+    if (socket_ >= 0) {
+        ::close(socket_);
+        socket_ = -1;
+    }
+}
+
+bool UdpSyslogTransport::send(const char* data, size_t length) {
+    if (socket_ < 0) {
+        return false;
+    }
+    return ::send(socket_, data, length, 0) == static_cast<ssize_t>(length);
+}
+
+SyslogForwarder::SyslogForwarder(Logger& logger) : logger_(logger), timeProvider_(defaultNowMs) {
+}
+
+SyslogForwarder::~SyslogForwarder() {
+    stop();
+}
+
+void SyslogForwarder::setConfig(const Config& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    if (config_.maxBatchEntries == 0) {
+        config_.maxBatchEntries = 1;
+    }
+}
+
+SyslogForwarder::Config SyslogForwarder::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_;
+}
+
+void SyslogForwarder::setTransport(Transport transport) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    udp_.reset();
+    transport_ = transport;
+    enabled_ = static_cast<bool>(transport_);
+}
+
+void SyslogForwarder::setTimeProvider(TimeProvider provider) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeProvider_ = provider ? provider : defaultNowMs;
+}
+
+bool SyslogForwarder::configure(const MockSettingsManager::Settings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    udp_.reset();
+    transport_ = nullptr;
+    enabled_ = false;
+
+    if (!settings.syslogEnabled || settings.syslogServer.empty()) {
+        return true;
+    }
+
+    std::unique_ptr<UdpSyslogTransport> udp(new UdpSyslogTransport());
+    if (!udp->open(settings.syslogServer, settings.syslogPort)) {
+        return false;
+    }
+
+    UdpSyslogTransport* raw = udp.get();
+    udp_ = std::move(udp);
+    transport_ = [raw](const char* data, size_t length) {
+        return raw->send(data, length);
+    };
+    enabled_ = true;
+    return true;
+}
+
+bool SyslogForwarder::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_ && static_cast<bool>(transport_);
+}
+
+uint8_t SyslogForwarder::severityFor(Logger::Level level) {
+    switch (level) {
+        case Logger::Level::DEBUG: return 7;
+        case Logger::Level::INFO: return 6;
+        case Logger::Level::WARN: return 4;
+        case Logger::Level::ERROR: return 3;
+    }
+    return 6;
+}
+
+std::string SyslogForwarder::formatMessage(const Logger::Entry& entry, const Config& config) {
+    const unsigned pri = static_cast<unsigned>(config.facility) * 8u + severityFor(entry.level);
+
+    // No wall clock on the device, so TIMESTAMP is NILVALUE and uptime/sequence go into
+    // the registered "meta" SD-ID (sysUpTime is in hundredths of a second).
+    std::string out;
+    out.reserve(64 + entry.message.size());
+    out += '<';
+    out += std::to_string(pri);
+    out += ">1 - ";
+    out += headerField(config.hostname, 255);
+    out += ' ';
+    out += headerField(config.appName, 48);
+    out += " - ";
+    out += headerField(entry.tag, 32);
+    out += " [meta sequenceId=\"";
+    out += std::to_string(entry.sequence % 2147483647ull + 1);
+    out += "\" sysUpTime=\"";
+    out += std::to_string(entry.timestampMs / 10);
+    out += "\"] ";
+    out += entry.message;
+    return out;
+}
+
+void SyslogForwarder::refillTokens(uint64_t nowMs) {
+    if (!refillStarted_) {
+        refillStarted_ = true;
+        lastRefillMs_ = nowMs;
+        tokens_ = config_.burstMessages;
+        return;
+    }
+
+    if (nowMs > lastRefillMs_) {
+        tokens_ += static_cast<double>(nowMs - lastRefillMs_) * config_.messagesPerSecond / 1000.0;
+        if (tokens_ > config_.burstMessages) {
+            tokens_ = config_.burstMessages;
+        }
+        lastRefillMs_ = nowMs;
+    }
+}
+
+bool SyslogForwarder::sendDatagram(const std::string& datagram) {
+    if (!transport_(datagram.data(), datagram.size())) {
+        ++stats_.sendFailures;
+        return false;
+    }
+    ++stats_.datagramsSent;
+    return true;
+}
+
+size_t SyslogForwarder::pump() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_ || !transport_) {
+        return 0;
+    }
+
+    refillTokens(timeProvider_());
+
+    Logger::TailResult tail = logger_.getEntriesSince(cursor_, config_.maxBatchEntries);
+    stats_.entriesMissed += tail.missed;
+    if (tail.entries.empty()) {
+        cursor_ = tail.nextSequence;
+        return 0;
+    }
+
+    const uint64_t newest = logger_.nextSequence();
+    size_t sent = 0;
+
+    std::string datagram;
+    datagram.reserve(config_.maxDatagramBytes);
+    size_t inDatagram = 0;
+    uint64_t datagramFirst = 0;
+    uint64_t shedDebug = 0;
+    uint64_t shedInfo = 0;
+
+    // Commit the datagram (and the drops decided while building it), or rewind the cursor
+    // so its entries are retried on the next pump.
+    auto flushDatagram = [&]() -> bool {
+        if (inDatagram == 0) {
+            return true;
+        }
+        if (!sendDatagram(datagram)) {
+            tokens_ += static_cast<double>(inDatagram);
+            cursor_ = datagramFirst;
+            return false;
+        }
+        sent += inDatagram;
+        stats_.messagesSent += inDatagram;
+        stats_.droppedDebug += shedDebug;
+        stats_.droppedInfo += shedInfo;
+        shedDebug = 0;
+        shedInfo = 0;
+        datagram.clear();
+        inDatagram = 0;
+        return true;
+    };
+
+    for (const Logger::Entry& entry : tail.entries) {
+        const uint64_t backlog = newest - entry.sequence;
+        const bool shed = (entry.level == Logger::Level::DEBUG && backlog > config_.dropDebugBacklog) ||
+                          (entry.level == Logger::Level::INFO && backlog > config_.dropInfoBacklog);
+        if (shed) {
+            uint64_t& counter = (entry.level == Logger::Level::DEBUG) ? shedDebug : shedInfo;
+            ++counter;
+            if (inDatagram == 0) {
+                stats_.droppedDebug += shedDebug;
+                stats_.droppedInfo += shedInfo;
+                shedDebug = 0;
+                shedInfo = 0;
+            }
+            cursor_ = entry.sequence + 1;
+            continue;
+        }
+
+        if (tokens_ < 1.0) {
+            ++stats_.rateLimitedPumps;
+            break;
+        }
+
+        const std::string message = formatMessage(entry, config_);
+        std::string framed = std::to_string(message.size());
+        framed += ' ';
+        framed += message;
+
+        if (inDatagram > 0 && datagram.size() + framed.size() > config_.maxDatagramBytes) {
+            if (!flushDatagram()) {
+                return sent;
+            }
+        }
+
+        if (inDatagram == 0) {
+            datagramFirst = entry.sequence;
+        }
+        datagram += framed;
+        ++inDatagram;
+        tokens_ -= 1.0;
+        cursor_ = entry.sequence + 1;
+    }
+
+    flushDatagram();
+    return sent;
+}
+
+bool SyslogForwarder::start() {
+    if (logger_.mode() != Logger::Mode::CONCURRENT || isRunning()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workerMutex_);
+        stopRequested_ = false;
+    }
+    worker_ = std::thread(&SyslogForwarder::workerLoop, this);
+    return true;
+}
+
+void SyslogForwarder::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workerMutex_);
+        stopRequested_ = true;
+    }
+    workerWake_.notify_all();
+    worker_.join();
+}
+
+void SyslogForwarder::workerLoop() {
+    std::unique_lock<std::mutex> lock(workerMutex_);
+    while (!stopRequested_) {
+        workerWake_.wait_for(lock, std::chrono::milliseconds(getConfig().pollIntervalMs));
+        if (stopRequested_) {
+            break;
+        }
+
+        lock.unlock();
+        pump();
+        lock.lock();
+    }
+}
+
+SyslogForwarder::Stats SyslogForwarder::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+size_t SyslogForwarder::getBacklog() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t newest = logger_.nextSequence();
+    return newest > cursor_ ? static_cast<size_t>(newest - cursor_) : 0;
+}
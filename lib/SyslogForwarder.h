@@ -0,0 +1,124 @@
+#ifndef SYSLOG_FORWARDER_H
+#define SYSLOG_FORWARDER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Logger.h"
+#include "MockSettingsManager.h"
+
+// UDP datagram socket for the syslog forwarder. Non-blocking: send() returns false instead
+// of waiting when the socket buffer is full.
+class UdpSyslogTransport {
+public:
+    UdpSyslogTransport() = default;
+    ~UdpSyslogTransport();
+
+    UdpSyslogTransport(const UdpSyslogTransport&) = delete;
+    UdpSyslogTransport& operator=(const UdpSyslogTransport&) = delete;
+
+    bool open(const std::string& host, uint16_t port);
+    void close();
+    bool isOpen() const { return socket_ >= 0; }
+
+    bool send(const char* data, size_t length);
+
+private:
+    int socket_ = -1;
+};
+
+// Drains a Logger asynchronously (through its sequence cursor) and forwards entries as
+// RFC 5424 messages. Several messages are packed into one datagram using octet-counting
+// framing ("<len> <msg>", RFC 6587). A token bucket limits messages per second; when the
+// unsent backlog grows, DEBUG entries are dropped first, then INFO.
+class SyslogForwarder {
+public:
+    // Sends one datagram; returns false if it could not be sent right now.
+    using Transport = std::function<bool(const char* data, size_t length)>;
+    using TimeProvider = std::function<uint64_t()>;
+
+    struct Config {
+        std::string hostname = "coop-controller";
+        std::string appName = "coop";
+        uint8_t facility = 16;               // local0
+        size_t maxDatagramBytes = 1200;      // Stay below a typical MTU
+        size_t maxBatchEntries = 64;         // Entries examined per pump()
+        uint32_t messagesPerSecond = 20;     // Token bucket refill rate
+        uint32_t burstMessages = 60;         // Token bucket size
+        size_t dropDebugBacklog = 64;        // Backlog above which DEBUG is dropped
+        size_t dropInfoBacklog = 192;        // Backlog above which INFO is dropped too
+        uint32_t pollIntervalMs = 200;       // Background thread cadence
+    };
+
+    struct Stats {
+        uint64_t messagesSent = 0;
+        uint64_t datagramsSent = 0;
+        uint64_t sendFailures = 0;
+        uint64_t droppedDebug = 0;  // Shed under backpressure
+        uint64_t droppedInfo = 0;
+        uint64_t rateLimitedPumps = 0; // pump() calls that stopped on an empty bucket
+        uint64_t entriesMissed = 0;    // Overwritten in the ring before forwarding
+    };
+
+    explicit SyslogForwarder(Logger& logger);
+    ~SyslogForwarder();
+
+    SyslogForwarder(const SyslogForwarder&) = delete;
+    SyslogForwarder& operator=(const SyslogForwarder&) = delete;
+
+    void setConfig(const Config& config);
+    Config getConfig() const;
+
+    void setTransport(Transport transport);
+    void setTimeProvider(TimeProvider provider);
+
+    // Apply syslogEnabled/syslogServer/syslogPort: opens (or closes) a UDP transport.
+    bool configure(const MockSettingsManager::Settings& settings);
+    bool isEnabled() const;
+
+    // Forward what is pending, within the rate limit. Returns messages sent.
+    size_t pump();
+
+    // Background pump thread. Requires Logger::Mode::CONCURRENT.
+    bool start();
+    void stop();
+    bool isRunning() const { return worker_.joinable(); }
+
+    Stats getStats() const;
+    size_t getBacklog() const;
+
+    static std::string formatMessage(const Logger::Entry& entry, const Config& config);
+    static uint8_t severityFor(Logger::Level level);
+
+private:
+    Logger& logger_;
+    Config config_;
+    Transport transport_;
+    TimeProvider timeProvider_;
+    std::unique_ptr<UdpSyslogTransport> udp_;
+    bool enabled_ = true;
+
+    mutable std::mutex mutex_;
+    uint64_t cursor_ = 0;
+    double tokens_ = 0.0;
+    uint64_t lastRefillMs_ = 0;
+    bool refillStarted_ = false;
+    Stats stats_;
+
+    std::thread worker_;
+    std::mutex workerMutex_;
+    std::condition_variable workerWake_;
+    bool stopRequested_ = false;
+
+    void refillTokens(uint64_t nowMs);
+    bool sendDatagram(const std::string& datagram);
+    void workerLoop();
+};
+
+#endif // SYSLOG_FORWARDER_H
@@ -0,0 +1,66 @@
+// Fuzz target for settings import: JsonReader plus MockSettingsManager::deserializeFromJson.
+//
+// With clang and -DCOOP_BUILD_FUZZERS=ON this links against libFuzzer:
+//   ./settings_json_fuzzer corpus/
+// With other compilers it builds a replay driver that runs each file given on the command
+// line through the same checks, for reproducing crashes found elsewhere.
+//
+// Beyond "does not crash", a document that imports must export to JSON that imports again
+// to the same settings.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "JsonReader.h"
+#include "MockSettingsManager.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const std::string input(reinterpret_cast<const char*>(data), size);
+
+    JsonReader reader;
+    const bool parsed = reader.parse(input, [&](const JsonReader::Token& token) -> const char* {
+        if (token.offset >= size || token.depth > JsonReader::kMaxDepth) {
+            std::abort();
+        }
+        return nullptr;
+    });
+    if (!parsed && (reader.error().offset > size || !reader.error().message)) {
+        std::abort();
+    }
+
+    MockSettingsManager settings;
+    settings.setTestMode(true);
+    JsonReader::Error error;
+    if (!settings.deserializeFromJson(input, error)) {
+        return 0;
+    }
+    if (!parsed) {
+        std::abort(); // The settings import accepted malformed JSON
+    }
+
+    const std::string exported = settings.serializeToJson();
+    MockSettingsManager reimported;
+    if (!reimported.deserializeFromJson(exported, error) || reimported.serializeToJson() != exported) {
+        std::abort();
+    }
+    return 0;
+}
+
+#ifndef COOP_LIBFUZZER
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        const std::string data = contents.str();
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+        std::printf("%s: ok\n", argv[i]);
+    }
+    return 0;
+}
+#endif
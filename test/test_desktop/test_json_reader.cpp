@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CommonTestFixture.h"
+#include "JsonReader.h"
+#include "JsonWriter.h"
+#include "MockSettingsManager.h"
+
+namespace {
+// One line per token: "<depth> <event> <text>@<offset>".
+std::string trace(const std::string& json, bool* ok = nullptr, JsonReader* readerOut = nullptr) {
+    static const char* kNames[] = {"{", "}", "[", "]", "key", "str", "num", "bool", "null"};
+    JsonReader local;
+    JsonReader& reader = readerOut ? *readerOut : local;
+    std::string out;
+    const bool parsed = reader.parse(json, [&](const JsonReader::Token& token) -> const char* {
+        out += std::to_string(token.depth) + " " + kNames[static_cast<int>(token.event)];
+        if (token.text) {
+            out += " " + std::string(token.text, token.length);
+        }
+        out += "@" + std::to_string(token.offset) + "\n";
+        return nullptr;
+    });
+    if (ok) {
+        *ok = parsed;
+    }
+    return out;
+}
+} // namespace
+
+class JsonReaderTest : public CommonTestFixture {};
+
+TEST_F(JsonReaderTest, ReportsTokensWithDepthAndOffset) {
+    bool ok = false;
+    const std::string tokens = trace("{\"a\": [1, -2.5e3, true], \"b\": {\"c\": null}, \"d\": \"x\"}", &ok);
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(tokens,
+              "0 {@0\n"
+              "1 key a@1\n"
+              "1 [@6\n"
+              "2 num 1@7\n"
+              "2 num -2.5e3@10\n"
+              "2 bool true@18\n"
+              "1 ]@22\n"
+              "1 key b@25\n"
+              "1 {@30\n"
+              "2 key c@31\n"
+              "2 null null@36\n"
+              "1 }@40\n"
+              "1 key d@43\n"
+              "1 str x@48\n"
+              "0 }@51\n");
+
+    EXPECT_EQ(trace(" 42 ", &ok), "0 num 42@1\n");
+    EXPECT_TRUE(ok);
+}
+
+TEST_F(JsonReaderTest, UnescapesStrings) {
+    bool ok = false;
+    EXPECT_EQ(trace("\"tab\\tquote\\\" slash\\/ \\u00e9 \\ud83d\\ude00\"", &ok),
+              "0 str tab\tquote\" slash/ \xC3\xA9 \xF0\x9F\x98\x80@0\n");
+    EXPECT_TRUE(ok);
+}
+
+TEST_F(JsonReaderTest, ErrorsCarryByteOffsets) {
+    struct Case {
+        const char* json;
+        size_t offset;
+        const char* message;
+    };
+    const Case cases[] = {
+        {"", 0, "unexpected end of input"},
+        {"{\"a\" 1}", 5, "expected ':'"},
+        {"{\"a\": 1,}", 8, "expected a key"},
+        {"[1 2]", 3, "expected ',' or ']'"},
+        {"[01]", 1, "leading zero in number"},
+        {"[1.]", 1, "invalid number"},
+        {"\"abc", 0, "unterminated string"},
+        {"\"a\\qb\"", 2, "invalid escape"},
+        {"\"\\ud83d\"", 1, "unpaired surrogate"},
+        {"\"a\nb\"", 2, "control character in string"},
+        {"[tru]", 1, "expected a value"},
+        {"{} {}", 3, "unexpected data after the document"},
+    };
+    for (const Case& c : cases) {
+        JsonReader reader;
+        bool ok = true;
+        trace(c.json, &ok, &reader);
+        EXPECT_FALSE(ok) << c.json;
+        EXPECT_EQ(reader.error().offset, c.offset) << c.json;
+        EXPECT_STREQ(reader.error().message, c.message) << c.json;
+    }
+
+    JsonReader reader;
+    reader.parse("[1, 2]", [](const JsonReader::Token& token) -> const char* {
+        return token.event == JsonReader::Event::NUMBER && token.is("2") ? "no twos" : nullptr;
+    });
+    EXPECT_EQ(reader.errorString(), "offset 4: no twos");
+}
+
+TEST_F(JsonReaderTest, BoundsNesting) {
+    bool ok = true;
+    JsonReader reader;
+    trace(std::string(JsonReader::kMaxDepth, '[') + std::string(JsonReader::kMaxDepth, ']'), &ok);
+    EXPECT_TRUE(ok);
+    trace(std::string(100000, '['), &ok, &reader);
+    EXPECT_FALSE(ok);
+    EXPECT_STREQ(reader.error().message, "nesting too deep");
+    EXPECT_EQ(reader.error().offset, JsonReader::kMaxDepth);
+}
+
+TEST_F(JsonReaderTest, WriterOutputReadsBack) {
+    std::string json;
+    JsonWriter writer(json);
+    writer.beginObject();
+    writer.key("f");
+    writer.value(1.1f);
+    writer.key("n");
+    writer.value(-7);
+    writer.key("s");
+    writer.value("a\"b\\c\x01");
+    writer.key("list");
+    writer.beginArray();
+    writer.value(true);
+    writer.null();
+    writer.beginObject();
+    writer.endObject();
+    writer.endArray();
+    writer.endObject();
+    EXPECT_EQ(json, "{\"f\":1.1,\"n\":-7,\"s\":\"a\\\"b\\\\c\\u0001\",\"list\":[true,null,{}]}");
+
+    bool ok = false;
+    EXPECT_NE(trace(json, &ok).find("1 str a\"b\\c\x01@20\n"), std::string::npos);
+    EXPECT_TRUE(ok);
+
+    std::string pretty;
+    JsonWriter indented(pretty, true);
+    indented.beginObject();
+    indented.key("a");
+    indented.beginArray();
+    indented.value(1u);
+    indented.endArray();
+    indented.endObject();
+    EXPECT_EQ(pretty, "{\n  \"a\": [\n    1\n  ]\n}");
+}
+
+TEST_F(JsonReaderTest, MutatedSettingsDocumentsNeverCorruptSettings) {
+    // A desktop stand-in for the fuzz target in test/fuzz: random damage to a full export.
+    MockSettingsManager source;
+    MockSettingsManager::Settings s = source.getSettings();
+    s.wifiSSID = "Coop \"net\"";
+    s.emailRecipients = {"a@example.com", "b@example.com"};
+    source.setSettings(s);
+    const std::string document = source.serializeToJson();
+
+    std::mt19937 random(1234);
+    size_t accepted = 0;
+    for (int i = 0; i < 2000; ++i) {
+        std::string input = document;
+        const int edits = 1 + static_cast<int>(random() % 4);
+        for (int e = 0; e < edits; ++e) {
+            const size_t at = random() % input.size();
+            switch (random() % 3) {
+                case 0: input[at] = static_cast<char>(random() % 256); break;
+                case 1: input.erase(at, 1 + random() % 8); break;
+                default: input.insert(at, 1, "{}[]\",:\\0e-"[random() % 11]); break;
+            }
+            if (input.empty()) {
+                input = "{";
+            }
+        }
+
+        MockSettingsManager target;
+        const std::string before = target.serializeToJson();
+        JsonReader::Error error;
+        if (!target.deserializeFromJson(input, error)) {
+            ASSERT_NE(error.message, nullptr);
+            ASSERT_LE(error.offset, input.size());
+            ASSERT_EQ(target.serializeToJson(), before); // All or nothing
+            continue;
+        }
+        ++accepted;
+        MockSettingsManager reimported;
+        ASSERT_TRUE(reimported.deserializeFromJson(target.serializeToJson()));
+        ASSERT_EQ(reimported.serializeToJson(), target.serializeToJson());
+    }
+    EXPECT_GT(accepted, 0u);
+}
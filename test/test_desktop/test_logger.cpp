@@ -1,11 +1,67 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <new>
+#include <thread>
+#include <vector>
 
 #include "CommonTestFixture.h"
 #include "Logger.h"
 #include "TestUtils.h"
 
+// Global allocation counters for this test binary; TestMemoryUtils only tracks explicit
+// allocations, so heap churn inside Logger is measured by replacing operator new. Each block
+// carries a header with its size so live and peak bytes can be tracked.
+namespace {
+const size_t kAllocHeader = 16;
+std::atomic<size_t> g_heapAllocations{0};
+std::atomic<size_t> g_heapLiveBytes{0};
+std::atomic<size_t> g_heapPeakBytes{0};
+
+void resetHeapPeak() {
+    g_heapPeakBytes.store(g_heapLiveBytes.load());
+}
+
+size_t heapPeakAboveLive(size_t baseline) {
+    size_t peak = g_heapPeakBytes.load();
+    return peak > baseline ? peak - baseline : 0;
+}
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    char* raw = static_cast<char*>(std::malloc(size + kAllocHeader));
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(raw) = size;
+
+    size_t live = g_heapLiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = g_heapPeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_heapPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return raw + kAllocHeader;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) {
+        return;
+    }
+    char* raw = static_cast<char*>(p) - kAllocHeader;
+    g_heapLiveBytes.fetch_sub(*reinterpret_cast<size_t*>(raw), std::memory_order_relaxed);
+    std::free(raw);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
 class LoggerTest : public CommonTestFixture {};
 
 TEST_F(LoggerTest, StartsEmptyWithCapacity) {
@@ -163,3 +219,875 @@ TEST_F(LoggerTest, PerformanceLoggingTenThousandEntriesFast) {
 
     EXPECT_LT(elapsed.count(), 2000);
 }
+
+TEST_F(LoggerTest, DefaultModeIsSingleThreaded) {
+    Logger logger(10);
+    EXPECT_EQ(logger.mode(), Logger::Mode::SINGLE_THREADED);
+}
+
+TEST_F(LoggerTest, ConcurrentModeEntriesVisibleToReaders) {
+    Logger logger(10, Logger::Mode::CONCURRENT);
+    logger.info("hello", "test");
+
+    EXPECT_EQ(logger.size(), 1u);
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, "hello");
+    EXPECT_EQ(entries[0].tag, "test");
+}
+
+TEST_F(LoggerTest, ConcurrentModeKeepsCircularSemantics) {
+    Logger logger(3, Logger::Mode::CONCURRENT);
+
+    for (int i = 1; i <= 5; ++i) {
+        logger.info(std::to_string(i));
+        logger.drain();
+    }
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].message, "3");
+    EXPECT_EQ(entries[2].message, "5");
+}
+
+TEST_F(LoggerTest, ConcurrentModeDropsWhenRingFullWithoutBlocking) {
+    Logger logger(4, Logger::Mode::CONCURRENT);
+
+    // Edge: nobody drains, so the pending ring (4 slots) fills up.
+    for (int i = 0; i < 10; ++i) {
+        logger.info(std::to_string(i));
+    }
+
+    EXPECT_EQ(logger.droppedCount(), 6u);
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[0].message, "0");
+}
+
+TEST_F(LoggerTest, ConcurrentModeManyProducersLoseNothingWhileDrained) {
+    const int kThreads = 4;
+    const int kPerThread = 2000;
+    Logger logger(kThreads * kPerThread, Logger::Mode::CONCURRENT);
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&logger, t]() {
+            const std::string tag = "T" + std::to_string(t);
+            for (int i = 0; i < kPerThread; ++i) {
+                logger.info("m", tag);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    EXPECT_EQ(logger.droppedCount(), 0u);
+    EXPECT_EQ(logger.size(), static_cast<size_t>(kThreads * kPerThread));
+    for (int t = 0; t < kThreads; ++t) {
+        EXPECT_EQ(logger.getEntries(Logger::Level::DEBUG, "T" + std::to_string(t)).size(),
+                  static_cast<size_t>(kPerThread));
+    }
+}
+
+TEST_F(LoggerTest, ConcurrentModeClearDiscardsPendingEntries) {
+    Logger logger(10, Logger::Mode::CONCURRENT);
+    logger.info("a");
+    logger.clear();
+    EXPECT_TRUE(logger.empty());
+}
+
+TEST_F(LoggerTest, LongMessagesAreTruncatedToSlab) {
+    Logger logger(4);
+    std::string longMessage(Logger::kMaxMessageLength + 50, 'x');
+    logger.info(longMessage);
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, std::string(Logger::kMaxMessageLength, 'x'));
+}
+
+TEST_F(LoggerTest, TagsAreInternedOnce) {
+    Logger logger(10);
+    logger.info("a", "sensor");
+    logger.info("b", "sensor");
+    logger.info("c", "pump");
+
+    // Empty tag + two distinct tags
+    EXPECT_EQ(logger.tagCount(), 3u);
+    EXPECT_EQ(logger.getEntries(Logger::Level::DEBUG, "sensor").size(), 2u);
+}
+
+TEST_F(LoggerTest, UnknownTagFilterReturnsNothing) {
+    Logger logger(10);
+    logger.info("a", "sensor");
+    EXPECT_TRUE(logger.getEntries(Logger::Level::DEBUG, "never-logged").empty());
+}
+
+TEST_F(LoggerTest, TagTableOverflowCollapsesToOverflowTag) {
+    Logger logger(LogTagTable::kMaxTags + 8);
+    for (size_t i = 0; i < LogTagTable::kMaxTags + 4; ++i) {
+        logger.info("m", ("tag" + std::to_string(i)).c_str());
+    }
+
+    EXPECT_EQ(logger.tagCount(), LogTagTable::kMaxTags);
+    auto entries = logger.getEntries();
+    EXPECT_EQ(entries.back().tag, "~");
+}
+
+// Stands in for a producer preempted between claiming a tag slot and publishing it.
+struct LogTagTableProbe {
+    static void park(LogTagTable& table, size_t slot) {
+        table.slots_[slot].state.store(LogTagTable::SLOT_WRITING);
+    }
+    static void publish(LogTagTable& table, size_t slot, const char* name) {
+        std::strcpy(table.slots_[slot].name, name);
+        table.slots_[slot].length = static_cast<uint8_t>(std::strlen(name));
+        table.slots_[slot].state.store(LogTagTable::SLOT_READY);
+    }
+};
+
+TEST_F(LoggerTest, TagInternNeverWaitsForAParkedProducer) {
+    LogTagTable table;
+    const uint8_t sensor = table.intern("sensor", 6);
+    LogTagTableProbe::park(table, 2);
+
+    // Run on another thread so a regression fails the test instead of hanging it.
+    std::future<std::vector<uint8_t>> other = std::async(std::launch::async, [&table]() {
+        return std::vector<uint8_t>{table.intern("sensor", 6), table.intern("pump", 4)};
+    });
+    const bool returned = other.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+    LogTagTableProbe::publish(table, 2, "wifi");
+    ASSERT_TRUE(returned);
+
+    const std::vector<uint8_t> ids = other.get();
+    EXPECT_EQ(ids[0], sensor);                      // Known tags before the parked slot still resolve
+    EXPECT_EQ(ids[1], LogTagTable::kOverflowTagId); // A new one is not placed behind it
+    EXPECT_EQ(table.intern("pump", 4), 3u);         // Once published, interning resumes
+    EXPECT_EQ(table.size(), 4u);
+}
+
+TEST_F(LoggerTest, SteadyStateLoggingDoesNotAllocate) {
+    Logger logger(256);
+    const std::string tag = "sensor";
+    const std::string message = "temp=21.5";
+
+    // Warm up so the tags are interned.
+    logger.info("warmup", "pump");
+    logger.warn(message, tag);
+
+    const size_t before = g_heapAllocations.load();
+    for (int i = 0; i < 1000000; ++i) {
+        logger.info("pump cycle complete", "pump");
+        logger.warn(message, tag);
+    }
+    const size_t after = g_heapAllocations.load();
+
+    EXPECT_EQ(after, before);
+    EXPECT_EQ(logger.size(), 256u);
+}
+
+TEST_F(LoggerTest, ConcurrentSteadyStateLoggingDoesNotAllocate) {
+    Logger logger(256, Logger::Mode::CONCURRENT);
+    logger.info("warmup", "wifi");
+    logger.drain();
+
+    const size_t before = g_heapAllocations.load();
+    for (int i = 0; i < 1000000; ++i) {
+        logger.info("reconnect attempt", "wifi");
+        if ((i & 0x7F) == 0) {
+            logger.drain();
+        }
+    }
+    const size_t after = g_heapAllocations.load();
+
+    EXPECT_EQ(after, before);
+}
+
+TEST_F(LoggerTest, LogfRendersOnRead) {
+    Logger logger(10);
+    logger.logf(Logger::Level::INFO, "sensor", "temp=%.1f idx=%d name=%s", 21.54, 2, "coop");
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].tag, "sensor");
+    EXPECT_EQ(entries[0].message, "temp=21.5 idx=2 name=coop");
+}
+
+TEST_F(LoggerTest, LogfHandlesWidthsModifiersAndPercent) {
+    Logger logger(10);
+    std::string owned = "pump";
+    logger.infof("", "%5lu|%-4s|%*d|%%|%llx|%c", 42ul, owned, 3, 7, 255ull, 'z');
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, "   42|pump|  7|%|ff|z");
+}
+
+TEST_F(LoggerTest, LogfMissingArgumentsAreLeftVerbatim) {
+    Logger logger(10);
+    // Edge: more conversions than arguments.
+    logger.warnf("", "a=%d b=%s", 1);
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, "a=1 b=%s");
+}
+
+TEST_F(LoggerTest, LogfOversizedSpecIsLeftVerbatim) {
+    Logger logger(10);
+    // Edge: the star width no longer fits the spec buffer (this used to overrun it).
+    logger.infof("", "%0000000000000000000000000*d|%d", std::numeric_limits<int64_t>::min(), 5);
+    logger.infof("", "%000000000000000000000000000000000000000d|%d", 1, 2);
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].message, "%0000000000000000000000000*d|5");
+    EXPECT_EQ(entries[1].message, "%000000000000000000000000000000000000000d|1");
+}
+
+TEST_F(LoggerTest, LogfPassesOnlyFlagsWidthAndPrecisionToPrintf) {
+    Logger logger(10);
+    // Edge: %n, positional arguments and grouping never reach snprintf.
+    logger.infof("", "%nd|%'d|%1$d|%d", 7);
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, "%nd|%'d|%1$d|7");
+}
+
+TEST_F(LoggerTest, LogfMessagesAreBoundedTheSameOnEveryReadPath) {
+    Logger logger(10);
+    // Three 120-character fields render to 360 characters; every path keeps the first 256.
+    logger.infof("", "%120d%120d%120d", 1, 2, 3);
+    const std::string full = std::string(119, ' ') + "1" + std::string(119, ' ') + "2" + std::string(119, ' ') + "3";
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, full.substr(0, 256));
+    EXPECT_NE(logger.exportToJson().find("\"" + entries[0].message + "\""), std::string::npos);
+}
+
+TEST_F(LoggerTest, LogfBelowMinLevelIsDiscardedWithoutAllocating) {
+    Logger logger(10);
+    logger.setMinLevel(Logger::Level::WARN);
+    const std::string big(200, 'x');
+
+    const size_t before = g_heapAllocations.load();
+    for (int i = 0; i < 1000; ++i) {
+        logger.debugf("pump", "flow=%f pulses=%u %s", 1.5, 10u, big);
+    }
+    EXPECT_EQ(g_heapAllocations.load(), before);
+    EXPECT_TRUE(logger.empty());
+}
+
+TEST_F(LoggerTest, MinLevelFiltersPlainLogCalls) {
+    Logger logger(10);
+    logger.setMinLevel(Logger::Level::INFO);
+    logger.debug("d");
+    logger.info("i");
+
+    EXPECT_EQ(logger.getMinLevel(), Logger::Level::INFO);
+    ASSERT_EQ(logger.size(), 1u);
+    EXPECT_EQ(logger.getEntries()[0].message, "i");
+}
+
+TEST_F(LoggerTest, LogfWorksInConcurrentModeAndJsonExport) {
+    Logger logger(10, Logger::Mode::CONCURRENT);
+    logger.errorf("pump", "fault after %u s", 60u);
+
+    std::string json = logger.exportToJson();
+    EXPECT_NE(json.find("\"msg\":\"fault after 60 s\""), std::string::npos);
+}
+
+TEST_F(LoggerTest, StreamingExportMatchesStringExport) {
+    Logger logger(16);
+    logger.info("plain \"quoted\"", "web");
+    logger.warnf("pump", "flow=%.2f", 1.25);
+    logger.error("ctrl\x01" "char");
+
+    std::string streamed;
+    size_t chunks = 0;
+    bool complete = logger.exportToJson([&](const char* data, size_t length) {
+        EXPECT_LE(length, Logger::kJsonChunkSize);
+        streamed.append(data, length);
+        ++chunks;
+        return true;
+    });
+
+    EXPECT_TRUE(complete);
+    EXPECT_GE(chunks, 1u);
+    EXPECT_EQ(streamed, logger.exportToJson());
+    EXPECT_NE(streamed.find("\"msg\":\"flow=1.25\""), std::string::npos);
+    EXPECT_NE(streamed.find("ctrl\\u0001char"), std::string::npos);
+}
+
+TEST_F(LoggerTest, StreamingExportSplitsIntoFixedChunks) {
+    Logger logger(256);
+    for (int i = 0; i < 256; ++i) {
+        logger.info("sensor reading within expected range", "sensor");
+    }
+
+    std::vector<size_t> sizes;
+    logger.exportToJson([&](const char*, size_t length) {
+        sizes.push_back(length);
+        return true;
+    });
+
+    ASSERT_GT(sizes.size(), 2u);
+    for (size_t i = 0; i + 1 < sizes.size(); ++i) {
+        EXPECT_EQ(sizes[i], Logger::kJsonChunkSize);
+    }
+}
+
+TEST_F(LoggerTest, StreamingExportStopsWhenSinkFails) {
+    Logger logger(256);
+    for (int i = 0; i < 256; ++i) {
+        logger.info("message", "tag");
+    }
+
+    size_t calls = 0;
+    bool complete = logger.exportToJson([&](const char*, size_t) {
+        ++calls;
+        return false;
+    });
+
+    EXPECT_FALSE(complete);
+    EXPECT_EQ(calls, 1u);
+}
+
+TEST_F(LoggerTest, StreamingExportPeakMemoryFarBelowStringExport) {
+    Logger logger(256);
+    for (int i = 0; i < 256; ++i) {
+        logger.info("pump cycle complete, flow within expected range", "pump");
+        logger.infof("sensor", "temp=%.2f", 20.0 + i * 0.01);
+    }
+
+    size_t baseline = g_heapLiveBytes.load();
+    resetHeapPeak();
+    std::string document = logger.exportToJson();
+    const size_t stringPeak = heapPeakAboveLive(baseline);
+    ASSERT_GT(document.size(), 0u);
+
+    size_t streamedBytes = 0;
+    baseline = g_heapLiveBytes.load();
+    resetHeapPeak();
+    logger.exportToJson([&](const char*, size_t length) {
+        streamedBytes += length;
+        return true;
+    });
+    const size_t streamPeak = heapPeakAboveLive(baseline);
+
+    EXPECT_EQ(streamedBytes, document.size());
+    EXPECT_GE(stringPeak, document.size());
+    EXPECT_LT(streamPeak, Logger::kJsonChunkSize);
+}
+
+TEST_F(LoggerTest, EntriesCarryMonotonicSequenceNumbers) {
+    Logger logger(3);
+    for (int i = 0; i < 5; ++i) {
+        logger.info(std::to_string(i));
+    }
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].sequence, 2u);
+    EXPECT_EQ(entries[2].sequence, 4u);
+    EXPECT_EQ(logger.nextSequence(), 5u);
+}
+
+TEST_F(LoggerTest, GetEntriesSinceReturnsOnlyNewEntries) {
+    Logger logger(10);
+    logger.info("a");
+    logger.info("b");
+
+    Logger::TailResult first = logger.getEntriesSince(0);
+    ASSERT_EQ(first.entries.size(), 2u);
+    EXPECT_EQ(first.nextSequence, 2u);
+    EXPECT_EQ(first.missed, 0u);
+
+    logger.info("c");
+    Logger::TailResult second = logger.getEntriesSince(first.nextSequence);
+    ASSERT_EQ(second.entries.size(), 1u);
+    EXPECT_EQ(second.entries[0].message, "c");
+
+    Logger::TailResult idle = logger.getEntriesSince(second.nextSequence);
+    EXPECT_TRUE(idle.entries.empty());
+    EXPECT_EQ(idle.nextSequence, second.nextSequence);
+}
+
+TEST_F(LoggerTest, GetEntriesSinceRespectsMaxCount) {
+    Logger logger(10);
+    for (int i = 0; i < 6; ++i) {
+        logger.info(std::to_string(i));
+    }
+
+    Logger::TailResult page = logger.getEntriesSince(0, 4);
+    ASSERT_EQ(page.entries.size(), 4u);
+    EXPECT_EQ(page.nextSequence, 4u);
+
+    Logger::TailResult rest = logger.getEntriesSince(page.nextSequence, 4);
+    ASSERT_EQ(rest.entries.size(), 2u);
+    EXPECT_EQ(rest.entries[1].message, "5");
+}
+
+TEST_F(LoggerTest, GetEntriesSinceReportsOverwriteGap) {
+    Logger logger(3);
+    for (int i = 0; i < 8; ++i) {
+        logger.info(std::to_string(i));
+    }
+
+    // Edge: cursor 1 is long gone; entries 1..4 were overwritten.
+    Logger::TailResult tail = logger.getEntriesSince(1);
+    EXPECT_EQ(tail.missed, 4u);
+    ASSERT_EQ(tail.entries.size(), 3u);
+    EXPECT_EQ(tail.entries[0].message, "5");
+    EXPECT_EQ(tail.nextSequence, 8u);
+}
+
+TEST_F(LoggerTest, GetEntriesSinceRestartsForCursorFromTheFuture) {
+    Logger logger(10);
+    logger.info("a");
+
+    Logger::TailResult tail = logger.getEntriesSince(1000);
+    ASSERT_EQ(tail.entries.size(), 1u);
+    EXPECT_EQ(tail.entries[0].message, "a");
+}
+
+TEST_F(LoggerTest, ClearKeepsSequenceMonotonic) {
+    Logger logger(10);
+    logger.info("a");
+    logger.info("b");
+    logger.clear();
+    logger.info("c");
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].sequence, 2u);
+
+    Logger::TailResult tail = logger.getEntriesSince(1);
+    EXPECT_EQ(tail.missed, 1u);
+    ASSERT_EQ(tail.entries.size(), 1u);
+}
+
+TEST_F(LoggerTest, ConcurrentModeAssignsSequenceOnDrain) {
+    Logger logger(10, Logger::Mode::CONCURRENT);
+    logger.info("a");
+    logger.info("b");
+
+    Logger::TailResult tail = logger.getEntriesSince(0);
+    ASSERT_EQ(tail.entries.size(), 2u);
+    EXPECT_EQ(tail.entries[0].sequence, 0u);
+    EXPECT_EQ(tail.entries[1].sequence, 1u);
+}
+
+TEST_F(LoggerTest, LevelCountsTrackInsertsAndEvictions) {
+    Logger logger(4);
+    logger.debug("d");
+    logger.info("i");
+    logger.warn("w");
+    logger.error("e");
+    EXPECT_EQ(logger.getLevelCount(Logger::Level::DEBUG), 1u);
+
+    // Evicts the DEBUG entry.
+    logger.error("e2");
+    EXPECT_EQ(logger.getLevelCount(Logger::Level::DEBUG), 0u);
+    EXPECT_EQ(logger.getLevelCount(Logger::Level::ERROR), 2u);
+
+    logger.clear();
+    EXPECT_EQ(logger.getLevelCount(Logger::Level::ERROR), 0u);
+}
+
+TEST_F(LoggerTest, IndexedQueriesMatchLinearScanAcrossWraparound) {
+    const size_t kCapacity = 97;
+    Logger logger(kCapacity);
+    const char* tags[] = {"sensor", "pump", "light", "wifi", ""};
+
+    struct Expected {
+        Logger::Level level;
+        std::string tag;
+        std::string message;
+    };
+    std::vector<Expected> all;
+
+    uint32_t rng = 12345;
+    for (int i = 0; i < 1000; ++i) {
+        rng = rng * 1103515245u + 12345u;
+        Logger::Level level = static_cast<Logger::Level>((rng >> 8) % 4);
+        const char* tag = tags[(rng >> 16) % 5];
+        std::string message = std::to_string(i);
+        logger.log(level, message, tag);
+        all.push_back({level, tag, message});
+    }
+
+    std::vector<Expected> live(all.end() - kCapacity, all.end());
+    for (int min = 0; min < 4; ++min) {
+        for (const char* tag : tags) {
+            std::vector<std::string> expected;
+            for (const Expected& e : live) {
+                if (static_cast<int>(e.level) >= min && (tag[0] == '\0' || e.tag == tag)) {
+                    expected.push_back(e.message);
+                }
+            }
+
+            auto entries = logger.getEntries(static_cast<Logger::Level>(min), tag);
+            std::vector<std::string> actual;
+            for (const auto& entry : entries) {
+                actual.push_back(entry.message);
+            }
+            EXPECT_EQ(actual, expected) << "min=" << min << " tag=" << tag;
+        }
+    }
+}
+
+TEST_F(LoggerTest, TagChainIgnoresEntriesFromBeforeClear) {
+    Logger logger(10);
+    logger.info("old", "pump");
+    logger.clear();
+    logger.info("new", "pump");
+
+    auto entries = logger.getEntries(Logger::Level::DEBUG, "pump");
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, "new");
+}
+
+TEST_F(LoggerTest, LevelChainIgnoresEntriesFromBeforeClear) {
+    Logger logger(10);
+    logger.error("old");
+    logger.clear();
+    logger.warn("new");
+
+    auto entries = logger.getEntries(Logger::Level::WARN);
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].message, "new");
+}
+
+TEST_F(LoggerTest, RepeatedMessagesAreCoalesced) {
+    Logger logger(16);
+    uint64_t now = 0;
+    logger.setTimeProvider([&now]() { return now; });
+    Logger::SuppressionConfig config;
+    config.coalesceRepeats = true;
+    logger.setSuppression(config);
+
+    for (int i = 0; i < 50; ++i) {
+        now += 10;
+        logger.error("DS18B20 read failed", "sensor");
+    }
+    logger.info("DS18B20 recovered", "sensor");
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].message, "DS18B20 read failed");
+    EXPECT_EQ(entries[1].message, "last message repeated 49 times");
+    EXPECT_EQ(entries[1].level, Logger::Level::ERROR);
+    EXPECT_EQ(entries[1].tag, "sensor");
+    EXPECT_EQ(entries[1].timestampMs, 500u);
+    EXPECT_EQ(entries[2].message, "DS18B20 recovered");
+
+    EXPECT_EQ(logger.getSuppressionStats().repeatsCoalesced, 49u);
+    EXPECT_EQ(logger.getSuppressionStats().summariesLogged, 1u);
+    EXPECT_EQ(logger.getSuppressedCount("sensor"), 49u);
+    EXPECT_EQ(logger.getSuppressedCount("wifi"), 0u);
+}
+
+TEST_F(LoggerTest, RepeatCoalescingIsPerTagAndLevel) {
+    Logger logger(16);
+    Logger::SuppressionConfig config;
+    config.coalesceRepeats = true;
+    logger.setSuppression(config);
+
+    logger.warn("link down", "wifi");
+    logger.warn("tick", "pump");
+    logger.warn("link down", "wifi"); // Still a repeat: other tags do not interrupt it
+    logger.error("link down", "wifi"); // Different level, so a new message
+    logger.flushSuppressed();
+
+    auto wifi = logger.getEntries(Logger::Level::DEBUG, "wifi");
+    ASSERT_EQ(wifi.size(), 3u);
+    EXPECT_EQ(wifi[0].message, "link down");
+    EXPECT_EQ(wifi[1].message, "last message repeated 1 times");
+    EXPECT_EQ(wifi[2].level, Logger::Level::ERROR);
+    EXPECT_EQ(logger.getEntries(Logger::Level::DEBUG, "pump").size(), 1u);
+}
+
+TEST_F(LoggerTest, LongRunningRepeatsAreSummarisedPeriodically) {
+    Logger logger(16);
+    uint64_t now = 0;
+    logger.setTimeProvider([&now]() { return now; });
+    Logger::SuppressionConfig config;
+    config.coalesceRepeats = true;
+    config.repeatFlushMs = 1000;
+    logger.setSuppression(config);
+
+    for (int i = 0; i < 35; ++i) {
+        logger.warn("reconnecting", "wifi");
+        now += 100;
+    }
+
+    // First entry, then one summary per second of repeats; the tail is still pending.
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[1].message, "last message repeated 11 times");
+    EXPECT_EQ(entries[2].message, "last message repeated 11 times");
+    EXPECT_EQ(entries[3].message, "last message repeated 11 times");
+
+    logger.flushSuppressed();
+    EXPECT_EQ(logger.getEntries().back().message, "last message repeated 1 times");
+}
+
+TEST_F(LoggerTest, PerTagRateLimitSuppressesBursts) {
+    Logger logger(64);
+    uint64_t now = 0;
+    logger.setTimeProvider([&now]() { return now; });
+    Logger::SuppressionConfig config;
+    config.tagMessagesPerSecond = 2;
+    config.tagBurst = 5;
+    logger.setSuppression(config);
+
+    for (int i = 0; i < 20; ++i) {
+        logger.info("flap " + std::to_string(i), "wifi");
+        logger.info("ok " + std::to_string(i), "pump");
+        if (i == 9) {
+            logger.info("pump keeps its own budget", "pump");
+        }
+    }
+
+    EXPECT_EQ(logger.getEntries(Logger::Level::DEBUG, "wifi").size(), 5u);
+    EXPECT_EQ(logger.getSuppressedCount("wifi"), 15u);
+    EXPECT_EQ(logger.getSuppressedCount("pump"), 16u);
+    EXPECT_EQ(logger.getSuppressionStats().rateLimited, 31u);
+
+    now += 1000; // Two tokens back
+    logger.warn("flap again", "wifi");
+
+    auto wifi = logger.getEntries(Logger::Level::DEBUG, "wifi");
+    ASSERT_EQ(wifi.size(), 7u);
+    EXPECT_EQ(wifi[5].message, "15 messages suppressed by rate limit");
+    EXPECT_EQ(wifi[5].level, Logger::Level::INFO);
+    EXPECT_EQ(wifi[6].message, "flap again");
+}
+
+TEST_F(LoggerTest, SuppressedFloodDoesNotEvictOtherHistory) {
+    Logger logger(8);
+    Logger::SuppressionConfig config;
+    config.coalesceRepeats = true;
+    logger.setSuppression(config);
+
+    logger.error("pump stalled", "pump");
+    for (int i = 0; i < 1000; ++i) {
+        logger.warn("sensor timeout", "sensor");
+    }
+
+    auto pump = logger.getEntries(Logger::Level::DEBUG, "pump");
+    ASSERT_EQ(pump.size(), 1u);
+    EXPECT_EQ(pump[0].message, "pump stalled");
+    EXPECT_EQ(logger.size(), 2u);
+}
+
+TEST_F(LoggerTest, CoalescedRepeatsDoNotAllocate) {
+    Logger logger(16);
+    Logger::SuppressionConfig config;
+    config.coalesceRepeats = true;
+    logger.setSuppression(config);
+    logger.warn("sensor timeout", "sensor");
+
+    const size_t before = g_heapAllocations.load();
+    for (int i = 0; i < 1000; ++i) {
+        logger.warn("sensor timeout", "sensor");
+    }
+    EXPECT_EQ(g_heapAllocations.load(), before);
+}
+
+TEST_F(LoggerTest, ConcurrentModeAppliesSuppressionOnDrain) {
+    Logger logger(16, Logger::Mode::CONCURRENT);
+    Logger::SuppressionConfig config;
+    config.coalesceRepeats = true;
+    logger.setSuppression(config);
+
+    for (int i = 0; i < 10; ++i) {
+        logger.info("same", "tag");
+    }
+    logger.info("different", "tag");
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[1].message, "last message repeated 9 times");
+    EXPECT_EQ(logger.getSuppressionStats().repeatsCoalesced, 9u);
+}
+
+namespace {
+// Mixed, realistic traffic: periodic sensor readings, pump cycles, occasional warnings.
+void logArchiveTraffic(Logger& logger, int count) {
+    for (int i = 0; i < count; ++i) {
+        switch (i % 5) {
+            case 0: logger.infof("sensor", "temp=%.1f humidity=%d%%", 18.0 + (i % 40) / 10.0, 40 + i % 13); break;
+            case 1: logger.debug("pump cycle complete", "pump"); break;
+            case 2: logger.info("light level " + std::to_string(100 + i % 17), "light"); break;
+            case 3: logger.warnf("wifi", "rssi %d dBm, retry %d", -60 - i % 9, i % 3); break;
+            default: logger.error("door sensor timeout after " + std::to_string(i % 7) + " tries", "door");
+        }
+    }
+}
+} // namespace
+
+TEST_F(LoggerTest, ArchiveMatchesLargeHotRing) {
+    uint64_t now = 1000;
+    auto clock = [&now]() { return now += 250; };
+
+    Logger reference(2000);
+    reference.setTimeProvider(clock);
+    logArchiveTraffic(reference, 1500);
+
+    now = 1000;
+    Logger archived(16, Logger::Mode::SINGLE_THREADED, 64 * 1024);
+    archived.setTimeProvider(clock);
+    logArchiveTraffic(archived, 1500);
+
+    EXPECT_EQ(archived.size(), 16u);
+    EXPECT_EQ(archived.archivedCount(), 1484u);
+
+    for (int min = 0; min < 4; ++min) {
+        const Logger::Level level = static_cast<Logger::Level>(min);
+        for (const char* tag : {"", "sensor", "pump", "wifi", "door"}) {
+            auto expected = reference.getEntries(level, tag);
+            auto actual = archived.getEntries(level, tag);
+            ASSERT_EQ(actual.size(), expected.size()) << "min=" << min << " tag=" << tag;
+            for (size_t i = 0; i < expected.size(); ++i) {
+                EXPECT_EQ(actual[i].sequence, expected[i].sequence);
+                EXPECT_EQ(actual[i].timestampMs, expected[i].timestampMs);
+                EXPECT_EQ(actual[i].level, expected[i].level);
+                EXPECT_EQ(actual[i].tag, expected[i].tag);
+                EXPECT_EQ(actual[i].message, expected[i].message);
+            }
+        }
+    }
+    EXPECT_EQ(archived.exportToJson(Logger::Level::INFO), reference.exportToJson(Logger::Level::INFO));
+}
+
+TEST_F(LoggerTest, CursorExportResumesAcrossTiersInBoundedPieces) {
+    Logger logger(4, Logger::Mode::SINGLE_THREADED, 8 * 1024);
+    for (int i = 0; i < 30; ++i) {
+        logger.infof("tail", "entry %d", i);
+    }
+    logger.debug("hidden", "tail");
+
+    Logger::JsonCursor cursor;
+    std::string document;
+    size_t pieces = 0;
+    bool more = true;
+    while (more) {
+        const size_t before = document.size();
+        more = logger.exportToJson(cursor, document, 64, Logger::Level::INFO);
+        // Whole entries only: a piece stops at the first entry boundary past the budget.
+        EXPECT_LT(document.size() - before, 64u + 64u);
+        ++pieces;
+        ASSERT_LT(pieces, 100u);
+    }
+
+    EXPECT_GT(pieces, 5u);
+    EXPECT_TRUE(cursor.finished);
+    EXPECT_EQ(document, logger.exportToJson(Logger::Level::INFO));
+    EXPECT_FALSE(logger.exportToJson(cursor, document, 64));
+
+    // An empty history still yields a valid document.
+    Logger empty(4);
+    Logger::JsonCursor emptyCursor;
+    std::string json;
+    EXPECT_FALSE(empty.exportToJson(emptyCursor, json, 64));
+    EXPECT_EQ(json, "[]");
+}
+
+TEST_F(LoggerTest, ArchiveQueriesStartAtTheRightBlockWithoutAllocating) {
+    Logger logger(16, Logger::Mode::SINGLE_THREADED, 32 * 1024);
+    logArchiveTraffic(logger, 2000);
+    ASSERT_GT(logger.getArchiveStats().blocks, 4u);
+
+    const std::vector<Logger::Entry> all = logger.getEntries();
+    const uint64_t from = all[all.size() / 2].sequence;
+    Logger::TailResult tail = logger.getEntriesSince(from, 5);
+    ASSERT_EQ(tail.entries.size(), 5u);
+    for (size_t i = 0; i < tail.entries.size(); ++i) {
+        EXPECT_EQ(tail.entries[i].sequence, from + i);
+        EXPECT_EQ(tail.entries[i].message, all[all.size() / 2 + i].message);
+    }
+
+    // Every streamed piece queries the archive again; none of them may allocate.
+    const std::string expected = logger.exportToJson();
+    Logger::JsonCursor cursor;
+    std::string document;
+    document.reserve(expected.size() + 1024);
+    const size_t before = g_heapAllocations.load();
+    while (logger.exportToJson(cursor, document, 512)) {
+    }
+    EXPECT_EQ(g_heapAllocations.load(), before);
+    EXPECT_EQ(document, expected);
+}
+
+TEST_F(LoggerTest, ArchiveCompressesRepetitiveHistory) {
+    Logger logger(16, Logger::Mode::SINGLE_THREADED, 32 * 1024);
+    logArchiveTraffic(logger, 2000);
+
+    LogArchive::Stats stats = logger.getArchiveStats();
+    ASSERT_GT(stats.entries, 0u);
+    const double bytesPerEntry = static_cast<double>(stats.usedBytes) / stats.entries;
+    EXPECT_LT(bytesPerEntry * 8, static_cast<double>(Logger::hotEntryBytes())) << bytesPerEntry;
+    EXPECT_LT(stats.usedBytes, stats.rawBytes);
+}
+
+TEST_F(LoggerTest, ArchiveTailCrossesTiers) {
+    Logger logger(4, Logger::Mode::SINGLE_THREADED, 8 * 1024);
+    for (int i = 0; i < 20; ++i) {
+        logger.info("entry " + std::to_string(i), "tail");
+    }
+
+    uint64_t cursor = 0;
+    std::vector<std::string> messages;
+    for (int polls = 0; polls < 10; ++polls) {
+        Logger::TailResult tail = logger.getEntriesSince(cursor, 3);
+        EXPECT_EQ(tail.missed, 0u);
+        for (const auto& entry : tail.entries) {
+            EXPECT_EQ(entry.sequence, messages.size());
+            messages.push_back(entry.message);
+        }
+        cursor = tail.nextSequence;
+    }
+
+    ASSERT_EQ(messages.size(), 20u);
+    EXPECT_EQ(messages[0], "entry 0");
+    EXPECT_EQ(messages[19], "entry 19");
+}
+
+TEST_F(LoggerTest, ArchiveDropsOldestBlocksWhenFull) {
+    Logger logger(4, Logger::Mode::SINGLE_THREADED, 2 * LogArchive::kBlockBytes);
+    for (int i = 0; i < 5000; ++i) {
+        logger.info("unique payload " + std::to_string(i * 7919), "fill");
+    }
+
+    LogArchive::Stats stats = logger.getArchiveStats();
+    EXPECT_EQ(stats.blocks, 2u);
+    EXPECT_GT(stats.entriesDropped, 0u);
+    EXPECT_EQ(stats.entries + stats.entriesDropped, 4996u);
+
+    Logger::TailResult tail = logger.getEntriesSince(0);
+    EXPECT_EQ(tail.missed, stats.entriesDropped);
+    EXPECT_EQ(tail.entries.size(), stats.entries + 4);
+    EXPECT_EQ(tail.entries.back().message, "unique payload " + std::to_string(4999 * 7919));
+}
+
+TEST_F(LoggerTest, ArchiveFollowsClearAndSequenceRebase) {
+    Logger logger(4, Logger::Mode::SINGLE_THREADED, 4096);
+    for (int i = 0; i < 10; ++i) {
+        logger.info("before " + std::to_string(i));
+    }
+    logger.advanceSequenceTo(100);
+
+    auto entries = logger.getEntries();
+    ASSERT_EQ(entries.size(), 10u);
+    EXPECT_EQ(entries[0].sequence, 100u);
+    EXPECT_EQ(entries[9].sequence, 109u);
+
+    logger.clear();
+    EXPECT_EQ(logger.archivedCount(), 0u);
+    EXPECT_TRUE(logger.getEntries().empty());
+}
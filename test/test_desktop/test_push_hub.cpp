@@ -0,0 +1,368 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CommonTestFixture.h"
+#include "EpollHttpServer.h"
+#include "MockLightController.h"
+#include "MockPumpController.h"
+#include "MockSensorManager.h"
+#include "MockWebServer.h"
+#include "PushHub.h"
+#include "Sha1.h"
+
+namespace {
+size_t countOccurrences(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+int connectLoopback(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    timeval timeout;
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+// Receive until `marker` has been seen or the timeout passes.
+bool readUntil(int fd, std::string& data, const std::string& marker, int timeoutMs = 2000) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    char buffer[4096];
+    while (data.find(marker) == std::string::npos) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        pollfd p = {fd, POLLIN, 0};
+        if (::poll(&p, 1, 50) <= 0) {
+            continue;
+        }
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return false;
+        }
+        data.append(buffer, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+std::string toHex(const uint8_t* data, size_t length) {
+    std::string hex;
+    char byte[3];
+    for (size_t i = 0; i < length; ++i) {
+        std::snprintf(byte, sizeof(byte), "%02x", data[i]);
+        hex += byte;
+    }
+    return hex;
+}
+} // namespace
+
+class PushHubTest : public CommonTestFixture {
+protected:
+    static PushHub::Config fastConfig() {
+        PushHub::Config config;
+        config.minIntervalMs = 100;
+        config.keepAliveMs = 1000;
+        return config;
+    }
+};
+
+TEST_F(PushHubTest, CoalescesUpdatesToNewestStatePerInterval) {
+    PushHub hub(fastConfig());
+    const PushHub::SubscriberId id = hub.subscribe(PushHub::Format::SSE, 100);
+    ASSERT_NE(id, PushHub::kInvalidSubscriber);
+
+    std::string out;
+    EXPECT_FALSE(hub.collect(id, 0, out)); // Nothing published yet
+
+    hub.publish("pump", "{\"active\":false}");
+    hub.publish("pump", "{\"active\":true}");
+    hub.publish("light", "{\"brightness\":10}");
+    hub.publish("light", "{\"brightness\":20}");
+    hub.publish("light", "{\"brightness\":30}");
+    hub.publish("light", "{\"brightness\":30}"); // Unchanged: ignored
+
+    EXPECT_FALSE(hub.collect(id, 50, out)); // Inside the interval
+    EXPECT_EQ(hub.nextDueMs(50), 100u);
+    ASSERT_TRUE(hub.collect(id, 100, out));
+    EXPECT_EQ(out, "event: pump\ndata: {\"active\":true}\n\n"
+                   "event: light\ndata: {\"brightness\":30}\n\n");
+
+    PushHub::Stats stats = hub.getStats();
+    EXPECT_EQ(stats.published, 5u);
+    EXPECT_EQ(stats.delivered, 2u);
+    EXPECT_EQ(stats.coalesced, 3u);
+    EXPECT_EQ(stats.topics, 2u);
+
+    // Only what changed since the last flush is sent next time.
+    out.clear();
+    hub.publish("light", "{\"brightness\":40}");
+    ASSERT_TRUE(hub.collect(id, 200, out));
+    EXPECT_EQ(out, "event: light\ndata: {\"brightness\":40}\n\n");
+}
+
+TEST_F(PushHubTest, SubscribersFlushAtTheirOwnRates) {
+    PushHub hub(fastConfig());
+    const PushHub::SubscriberId fast = hub.subscribe(PushHub::Format::SSE, 0); // Raised to 100
+    const PushHub::SubscriberId slow = hub.subscribe(PushHub::Format::SSE, 500);
+    std::string fastOut;
+    std::string slowOut;
+
+    for (uint64_t now = 0; now < 1000; now += 10) {
+        hub.publish("sensor/0", "{\"temperature\":" + std::to_string(now) + "}");
+        hub.collect(fast, now, fastOut);
+        hub.collect(slow, now, slowOut);
+    }
+
+    EXPECT_EQ(countOccurrences(fastOut, "event: sensor/0"), 10u);
+    EXPECT_EQ(countOccurrences(slowOut, "event: sensor/0"), 2u);
+    EXPECT_NE(slowOut.find("{\"temperature\":500}"), std::string::npos);
+
+    // A late subscriber starts from the current state.
+    const PushHub::SubscriberId late = hub.subscribe(PushHub::Format::SSE);
+    std::string lateOut;
+    ASSERT_TRUE(hub.collect(late, 1000, lateOut));
+    EXPECT_EQ(lateOut, "event: sensor/0\ndata: {\"temperature\":990}\n\n");
+
+    hub.unsubscribe(slow);
+    EXPECT_EQ(hub.getStats().subscribers, 2u);
+    EXPECT_FALSE(hub.collect(slow, 2000, slowOut));
+}
+
+TEST_F(PushHubTest, SendsHeartbeatsAndWebSocketFrames) {
+    PushHub hub(fastConfig());
+    const PushHub::SubscriberId sse = hub.subscribe(PushHub::Format::SSE);
+    const PushHub::SubscriberId ws = hub.subscribe(PushHub::Format::WEBSOCKET);
+    hub.publish("light", "{\"on\":true}");
+
+    std::string out;
+    ASSERT_TRUE(hub.collect(ws, 0, out));
+    const std::string payload = "{\"topic\":\"light\",\"data\":{\"on\":true}}";
+    ASSERT_EQ(out.size(), 2 + payload.size());
+    EXPECT_EQ(static_cast<uint8_t>(out[0]), 0x81);
+    EXPECT_EQ(static_cast<uint8_t>(out[1]), payload.size());
+    EXPECT_EQ(out.substr(2), payload);
+
+    out.clear();
+    ASSERT_TRUE(hub.collect(sse, 0, out));
+    out.clear();
+    EXPECT_FALSE(hub.collect(sse, 999, out));
+    ASSERT_TRUE(hub.collect(sse, 1000, out));
+    EXPECT_EQ(out, ":\n\n");
+
+    out.clear();
+    PushHub::appendWebSocketFrame(0x1, std::string(300, 'x').data(), 300, out);
+    EXPECT_EQ(static_cast<uint8_t>(out[1]), 126);
+    EXPECT_EQ((static_cast<uint8_t>(out[2]) << 8) | static_cast<uint8_t>(out[3]), 300);
+}
+
+TEST_F(PushHubTest, PublishesControllerStateChanges) {
+    PushHub hub(fastConfig());
+    MockSensorManager sensors;
+    sensors.setConfig(MockSensorManager::Config());
+    MockPumpController pump;
+    pump.setConfig(MockPumpController::Config());
+    MockLightController light;
+    light.setConfig(MockLightController::Config());
+    hub.bindSensors(sensors);
+    hub.bindPump(pump);
+    hub.bindLight(light);
+
+    const PushHub::SubscriberId id = hub.subscribe(PushHub::Format::SSE);
+    sensors.setTemperature(3.5f, 1);
+    pump.setMode(MockPumpController::PumpMode::MANUAL_ON);
+    pump.setManualState(true);
+    light.setMode(MockLightController::LightMode::MANUAL_ON);
+    light.setManualBrightness(200);
+
+    std::string out;
+    ASSERT_TRUE(hub.collect(id, 0, out));
+    EXPECT_NE(out.find("event: sensor/1\ndata: {\"index\":1,\"temperature\":3.50,"), std::string::npos);
+    EXPECT_NE(out.find("event: pump\ndata: {\"active\":true,"), std::string::npos);
+    EXPECT_NE(out.find("event: light\ndata: {\"on\":true,"), std::string::npos);
+}
+
+TEST_F(PushHubTest, Sha1MatchesKnownDigests) {
+    uint8_t digest[Sha1::kDigestBytes];
+    Sha1::compute("abc", 3, digest);
+    EXPECT_EQ(toHex(digest, sizeof(digest)), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    const std::string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    Sha1::compute(twoBlocks.data(), twoBlocks.size(), digest);
+    EXPECT_EQ(toHex(digest, sizeof(digest)), "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+}
+
+TEST_F(PushHubTest, EpollBackendUpgradesWebSocketClients) {
+    MockWebServer server;
+    PushHub hub(fastConfig());
+    EpollHttpServer backend(server);
+    backend.servePush("/api/live", &hub);
+    ASSERT_TRUE(backend.start(EpollHttpServer::Config()));
+    hub.publish("pump", "{\"active\":true}");
+
+    int fd = connectLoopback(backend.getPort());
+    ASSERT_GE(fd, 0);
+    // Handshake example from RFC 6455 section 1.3.
+    sendAll(fd, "GET /api/live HTTP/1.1\r\nHost: coop\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+    std::string data;
+    ASSERT_TRUE(readUntil(fd, data, "{\"topic\":\"pump\",\"data\":{\"active\":true}}"));
+    EXPECT_EQ(data.compare(0, 34, "HTTP/1.1 101 Switching Protocols\r\n"), 0);
+    EXPECT_NE(data.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"), std::string::npos);
+    EXPECT_EQ(backend.getPushConnectionCount(), 1u);
+
+    // Masked ping, then masked close with status 1000.
+    const char ping[] = {'\x89', '\x82', 1, 2, 3, 4, static_cast<char>('h' ^ 1), static_cast<char>('i' ^ 2)};
+    sendAll(fd, std::string(ping, sizeof(ping)));
+    data.clear();
+    ASSERT_TRUE(readUntil(fd, data, std::string("\x8A\x02hi", 4)));
+    const char close[] = {'\x88', '\x82', 0, 0, 0, 0, '\x03', '\xE8'};
+    sendAll(fd, std::string(close, sizeof(close)));
+    data.clear();
+    ASSERT_TRUE(readUntil(fd, data, std::string("\x88\x02\x03\xE8", 4)));
+
+    char byte;
+    EXPECT_EQ(::recv(fd, &byte, 1, 0), 0);
+    ::close(fd);
+    backend.stop();
+}
+
+TEST_F(PushHubTest, SseClientsAreCoalescedToTheirRequestedInterval) {
+    MockWebServer server;
+    PushHub hub(fastConfig());
+    EpollHttpServer backend(server);
+    backend.servePush("/api/live", &hub);
+    ASSERT_TRUE(backend.start(EpollHttpServer::Config()));
+
+    int fd = connectLoopback(backend.getPort());
+    ASSERT_GE(fd, 0);
+    sendAll(fd, "GET /api/live?interval=300 HTTP/1.1\r\nHost: coop\r\n\r\n");
+    std::string data;
+    ASSERT_TRUE(readUntil(fd, data, "\r\n\r\n"));
+    EXPECT_NE(data.find("Content-Type: text/event-stream"), std::string::npos);
+
+    // 50 updates within about 100 ms reach this client as at most two flushes.
+    for (int i = 1; i <= 50; ++i) {
+        hub.publish("sensor/0", "{\"seq\":" + std::to_string(i) + "}");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_TRUE(readUntil(fd, data, "{\"seq\":50}"));
+    EXPECT_LE(countOccurrences(data, "event: sensor/0"), 2u);
+    EXPECT_GE(hub.getStats().coalesced, 48u);
+
+    ::close(fd);
+    backend.stop();
+    EXPECT_EQ(hub.getStats().subscribers, 0u);
+}
+
+// Fan-out latency: time from publish() until every one of N SSE subscribers has the event.
+TEST_F(PushHubTest, MeasuresFanOutLatencyToManySubscribers) {
+    const size_t kSubscribers = 64;
+    const int kRounds = 20;
+
+    MockWebServer server;
+    PushHub::Config config;
+    config.minIntervalMs = 0; // Measure delivery, not coalescing
+    config.maxSubscribers = kSubscribers;
+    PushHub hub(config);
+    EpollHttpServer backend(server);
+    backend.servePush("/api/live", &hub);
+    ASSERT_TRUE(backend.start(EpollHttpServer::Config()));
+
+    std::vector<int> fds;
+    std::vector<std::string> buffers(kSubscribers);
+    for (size_t i = 0; i < kSubscribers; ++i) {
+        int fd = connectLoopback(backend.getPort());
+        ASSERT_GE(fd, 0);
+        sendAll(fd, "GET /api/live HTTP/1.1\r\nHost: coop\r\n\r\n");
+        fds.push_back(fd);
+    }
+    for (size_t i = 0; i < kSubscribers; ++i) {
+        ASSERT_TRUE(readUntil(fds[i], buffers[i], "\r\n\r\n"));
+        buffers[i].clear();
+    }
+    ASSERT_EQ(backend.getPushConnectionCount(), kSubscribers);
+
+    std::vector<double> latenciesUs;
+    std::vector<pollfd> polls(kSubscribers);
+    char chunk[4096];
+    for (int round = 1; round <= kRounds; ++round) {
+        const std::string marker = "{\"round\":" + std::to_string(round) + "}";
+        std::vector<bool> received(kSubscribers, false);
+        size_t remaining = kSubscribers;
+
+        const auto start = std::chrono::steady_clock::now();
+        hub.publish("tick", marker);
+        while (remaining > 0) {
+            for (size_t i = 0; i < kSubscribers; ++i) {
+                polls[i].fd = received[i] ? -1 : fds[i];
+                polls[i].events = POLLIN;
+                polls[i].revents = 0;
+            }
+            ASSERT_GT(::poll(polls.data(), polls.size(), 2000), 0) << "round " << round;
+            for (size_t i = 0; i < kSubscribers; ++i) {
+                if (!(polls[i].revents & POLLIN)) {
+                    continue;
+                }
+                ssize_t n = ::recv(fds[i], chunk, sizeof(chunk), 0);
+                ASSERT_GT(n, 0);
+                buffers[i].append(chunk, static_cast<size_t>(n));
+                if (buffers[i].find(marker) != std::string::npos) {
+                    received[i] = true;
+                    buffers[i].clear();
+                    --remaining;
+                }
+            }
+        }
+        latenciesUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    const double median = latenciesUs[latenciesUs.size() / 2];
+    const double worst = latenciesUs.back();
+    std::printf("fan-out to %zu SSE subscribers: median %.0f us, max %.0f us\n", kSubscribers, median, worst);
+    RecordProperty("fanout_median_us", static_cast<int>(median));
+    RecordProperty("fanout_max_us", static_cast<int>(worst));
+    EXPECT_LT(worst, 500000.0);
+    EXPECT_EQ(hub.getStats().delivered, kSubscribers * kRounds);
+
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    backend.stop();
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "CommonTestFixture.h"
 #include "MockSettingsManager.h"
 #include "TestUtils.h"
@@ -184,3 +189,269 @@ TEST_F(SettingsManagerTest, RawSettingReadWriteRoundTrips) {
     settings.setSettingRaw("raw.key", "raw.value");
     EXPECT_EQ(settings.getSettingRaw("raw.key"), "raw.value");
 }
+
+TEST_F(SettingsManagerTest, TypedAccessValidatesAgainstSchemaRanges) {
+    using Id = MockSettingsManager::SettingId;
+    EXPECT_EQ(settings.get<Id::pumpOnDuration>(), 300u);
+    EXPECT_FLOAT_EQ(settings.get<Id::freezeThreshold>(), 1.1f);
+
+    std::vector<std::string> changes;
+    settings.setSettingsChangeCallback([&](const std::string& k, const std::string& o, const std::string& n) {
+        changes.push_back(k + ":" + o + "->" + n);
+    });
+
+    const uint64_t version = settings.getVersion();
+    EXPECT_FALSE(settings.set<Id::pumpOnDuration>(0));
+    EXPECT_FALSE(settings.set<Id::freezeThreshold>(200.0f));
+    EXPECT_FALSE(settings.set<Id::wifiSSID>(std::string(33, 'x')));
+    EXPECT_EQ(settings.getVersion(), version);
+    EXPECT_FALSE(settings.hasUnsavedChanges());
+
+    EXPECT_TRUE(settings.set<Id::pumpOnDuration>(120));
+    EXPECT_TRUE(settings.set<Id::pumpOnDuration>(120)); // Same value: not a change
+    EXPECT_TRUE(settings.set<Id::lightTimezoneOffset>(-300));
+    EXPECT_EQ(settings.getVersion(), version + 2);
+    EXPECT_TRUE(settings.hasUnsavedChanges());
+    EXPECT_EQ(settings.getSettings().pumpOnDuration, 120u);
+
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0], "pumpOnDuration:300->120");
+    EXPECT_EQ(changes[1], "lightTimezoneOffset:0->-300");
+}
+
+TEST_F(SettingsManagerTest, SchemaKeysShareTypedSlotsThroughStringAccessors) {
+    using Id = MockSettingsManager::SettingId;
+    EXPECT_TRUE(settings.setSettingFloat("freezeThreshold", 2.5f));
+    EXPECT_FLOAT_EQ(settings.get<Id::freezeThreshold>(), 2.5f);
+    EXPECT_FLOAT_EQ(settings.getSettingFloat("freezeThreshold"), 2.5f);
+
+    EXPECT_TRUE(settings.setSettingString("webServerPort", "8080"));
+    EXPECT_EQ(settings.get<Id::webServerPort>(), 8080);
+    EXPECT_EQ(settings.getSettingUInt("webServerPort"), 8080u);
+    EXPECT_EQ(settings.getSettingString("webServerPort"), "8080");
+
+    EXPECT_EQ(settings.getSettingString("pumpEnabled"), "true");
+    EXPECT_TRUE(settings.setSettingBool("pumpEnabled", false));
+    EXPECT_FALSE(settings.getSettings().pumpEnabled);
+
+    // Conversions that do not fit the field are refused.
+    EXPECT_FALSE(settings.setSettingUInt("lightMaxBrightness", 300u));
+    EXPECT_FALSE(settings.setSettingString("webServerPort", "80x"));
+    EXPECT_FALSE(settings.setSettingFloat("pumpPin", 2.5f));
+    EXPECT_FALSE(settings.setSettingString("wifiEnabled", "maybe"));
+    EXPECT_EQ(settings.get<Id::lightMaxBrightness>(), 255);
+    EXPECT_EQ(settings.get<Id::webServerPort>(), 8080);
+
+    // Keys outside the schema are still free-form values.
+    EXPECT_TRUE(settings.setSettingUInt("metrics.heapFree", 1234u));
+    EXPECT_EQ(settings.getSettingUInt("metrics.heapFree"), 1234u);
+}
+
+TEST_F(SettingsManagerTest, SchemaDescribesEveryScalarSetting) {
+    MockSettingsManager::SettingId id;
+    ASSERT_TRUE(MockSettingsManager::findSetting("wifiSSID", id));
+    const MockSettingsManager::SettingInfo& info = MockSettingsManager::getSettingInfo(id);
+    EXPECT_STREQ(info.name, "wifiSSID");
+    EXPECT_EQ(info.type, MockSettingsManager::SettingType::STRING);
+    EXPECT_EQ(info.max, 32.0);
+    EXPECT_FALSE(MockSettingsManager::findSetting("wifi.ssid", id));
+    EXPECT_FALSE(MockSettingsManager::findSetting("emailRecipients", id));
+
+    for (size_t i = 0; i < MockSettingsManager::kSettingCount; ++i) {
+        const char* name = MockSettingsManager::getSettingInfo(static_cast<MockSettingsManager::SettingId>(i)).name;
+        ASSERT_TRUE(MockSettingsManager::findSetting(name, id)) << name;
+        EXPECT_EQ(static_cast<size_t>(id), i);
+    }
+
+    MockSettingsManager::Settings s = settings.getSettings();
+    s.wifiSSID = std::string(40, 'x');
+    s.lightDayStartHour = 30;
+    settings.setSettings(s);
+    std::vector<std::string> errors = settings.getValidationErrors();
+    ASSERT_EQ(errors.size(), 2u);
+    EXPECT_EQ(errors[0], "lightDayStartHour must be between 0 and 23");
+    EXPECT_EQ(errors[1], "wifiSSID must be at most 32 characters");
+}
+
+TEST_F(SettingsManagerTest, JsonRoundTripCoversEverySetting) {
+    MockSettingsManager::Settings s = settings.getSettings();
+    s.pumpEnabled = false;
+    s.freezeThreshold = -3.7f;
+    s.lightTimezoneOffset = -300;
+    s.lightMaxBrightness = 200;
+    s.webServerPort = 8080;
+    s.wifiSSID = "Coop \"North\"\n";
+    s.telegramBotToken = "123:abc";
+    s.openweatherLongitude = -74.006f;
+    s.lastRebootReason = 4000000000u;
+    s.emailRecipients = {"a@example.com", "b@example.com"};
+    settings.setSettings(s);
+
+    const std::string json = settings.serializeToJson();
+    EXPECT_NE(json.find("\"emailRecipients\": [\n    \"a@example.com\",\n    \"b@example.com\"\n  ]"),
+              std::string::npos);
+    // The export keeps the key backups and the UI have always read.
+    EXPECT_NE(json.find("\"pumpFreezeThreshold\": -3.7"), std::string::npos);
+    EXPECT_EQ(json.find("\"freezeThreshold\""), std::string::npos);
+
+    MockSettingsManager copy;
+    ASSERT_TRUE(copy.deserializeFromJson(json));
+    MockSettingsManager::Settings r = copy.getSettings();
+    EXPECT_FALSE(r.pumpEnabled);
+    EXPECT_EQ(r.freezeThreshold, -3.7f);
+    EXPECT_EQ(r.lightTimezoneOffset, -300);
+    EXPECT_EQ(r.lightMaxBrightness, 200);
+    EXPECT_EQ(r.webServerPort, 8080);
+    EXPECT_EQ(r.wifiSSID, "Coop \"North\"\n");
+    EXPECT_EQ(r.telegramBotToken, "123:abc");
+    EXPECT_EQ(r.openweatherLongitude, -74.006f);
+    EXPECT_EQ(r.lastRebootReason, 4000000000u);
+    EXPECT_EQ(r.emailRecipients, s.emailRecipients);
+    EXPECT_EQ(copy.serializeToJson(), json);
+}
+
+TEST_F(SettingsManagerTest, DeserializeIsAllOrNothingWithErrorOffsets) {
+    const std::string json = TestStringUtils::generateInvalidSettingsJson();
+    const uint64_t version = settings.getVersion();
+
+    JsonReader::Error error;
+    EXPECT_FALSE(settings.deserializeFromJson(json, error));
+    EXPECT_STREQ(error.message, "setting out of range");
+    EXPECT_EQ(error.offset, json.find("999"));
+    EXPECT_TRUE(settings.getSettings().pumpEnabled);
+    EXPECT_EQ(settings.getVersion(), version);
+    EXPECT_FALSE(settings.hasUnsavedChanges());
+
+    EXPECT_FALSE(settings.deserializeFromJson("{\"pumpOnDuration\": \"300\"}", error));
+    EXPECT_STREQ(error.message, "wrong type for setting");
+    EXPECT_EQ(error.offset, 19u);
+
+    EXPECT_FALSE(settings.deserializeFromJson("{\"emailRecipients\": [\"a@b\", 3]}", error));
+    EXPECT_STREQ(error.message, "expected a string");
+
+    EXPECT_FALSE(settings.deserializeFromJson("{\"lightEnabled\": false,", error));
+    EXPECT_STREQ(error.message, "expected a key");
+    EXPECT_TRUE(settings.getSettings().lightEnabled);
+}
+
+TEST_F(SettingsManagerTest, DeserializeAppliesCrossFieldRulesToTheResult) {
+    const std::string json = "{\"lightMinBrightness\": 200, \"lightMaxBrightness\": 100}";
+    const uint64_t version = settings.getVersion();
+
+    JsonReader::Error error;
+    EXPECT_FALSE(settings.deserializeFromJson(json, error));
+    EXPECT_STREQ(error.message, "Max brightness must be greater than or equal to min brightness");
+    EXPECT_EQ(error.offset, json.size() - 1);
+    EXPECT_EQ(settings.getVersion(), version);
+    EXPECT_TRUE(settings.validateSettings());
+
+    // The order inside the document does not matter, only the result.
+    EXPECT_TRUE(settings.deserializeFromJson("{\"lightMaxBrightness\": 250, \"lightMinBrightness\": 200}"));
+    EXPECT_EQ(settings.getSettings().lightMinBrightness, 200);
+}
+
+TEST_F(SettingsManagerTest, DeserializeSkipsUnknownKeysAndAcceptsLegacyNames) {
+    ASSERT_TRUE(settings.deserializeFromJson(
+        "{\"future\": {\"nested\": [1, {\"x\": 2}]}, \"pumpFreezeThreshold\": 2.5, \"other\": [],"
+        " \"pumpOffDuration\": 900}"));
+    EXPECT_FLOAT_EQ(settings.getSettings().freezeThreshold, 2.5f);
+    EXPECT_EQ(settings.getSettings().pumpOffDuration, 900u);
+    EXPECT_TRUE(settings.hasUnsavedChanges());
+}
+
+TEST_F(SettingsManagerTest, SnapshotIsPublishedForEveryVersion) {
+    MockSettingsManager::SnapshotRef before = settings.snapshot();
+    ASSERT_TRUE(before);
+    EXPECT_EQ(before->version, settings.getVersion());
+    EXPECT_EQ(settings.snapshot().get(), before.get()); // No change: same snapshot, no copy
+
+    ASSERT_TRUE(settings.setSettingUInt("pumpOnDuration", 120));
+    MockSettingsManager::SnapshotRef after = settings.snapshot();
+    EXPECT_EQ(after->version, settings.getVersion());
+    EXPECT_EQ(after->settings.pumpOnDuration, 120u);
+    EXPECT_EQ(before->settings.pumpOnDuration, 300u); // A held snapshot never changes
+
+    ASSERT_TRUE(settings.deserializeFromJson("{\"wifiSSID\": \"barn\"}"));
+    EXPECT_EQ(settings.snapshot()->settings.wifiSSID, "barn");
+    EXPECT_EQ(settings.snapshot()->version, settings.getVersion());
+}
+
+TEST_F(SettingsManagerTest, SnapshotCellRecyclesOnlyUnheldValues) {
+    SnapshotCell<std::string> cell;
+    cell.publish([](std::string& v) { v = "one"; });
+    SnapshotCell<std::string>::Ref held = cell.load();
+
+    // A held value is never refilled; the rest reuse one spare.
+    for (int i = 0; i < 100; ++i) {
+        cell.publish([i](std::string& v) { v = std::to_string(i); });
+        EXPECT_EQ(*cell.load(), std::to_string(i));
+    }
+    EXPECT_EQ(*held, "one");
+    EXPECT_EQ(cell.nodeCount(), 3u);
+
+    SnapshotCell<std::string>::Ref copy = held;
+    held = SnapshotCell<std::string>::Ref();
+    EXPECT_FALSE(held);
+    EXPECT_EQ(*copy, "one"); // Still pinned by the copy
+    copy = SnapshotCell<std::string>::Ref();
+    cell.publish([](std::string& v) { v = "last"; });
+    cell.publish([](std::string& v) { v = "again"; });
+    EXPECT_EQ(*cell.load(), "again");
+    EXPECT_EQ(cell.nodeCount(), 3u);
+}
+
+TEST_F(SettingsManagerTest, SnapshotReadersSeeWholeVersionsWhileTheOwnerWrites) {
+    // Each write changes several fields together; readers on other threads must only ever
+    // see them agree, and versions must never go backwards.
+    const int kWrites = 5000;
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> torn(0);
+    std::atomic<uint64_t> reads(0);
+
+    auto reader = [&]() {
+        uint64_t lastVersion = 0;
+        uint64_t localReads = 0;
+        while (!done.load()) {
+            MockSettingsManager::SnapshotRef view = settings.snapshot();
+            const MockSettingsManager::Settings& s = view->settings;
+            const std::string tag = std::to_string(s.pumpOnDuration);
+            if (view->version < lastVersion || s.pumpOffDuration != s.pumpOnDuration + 1 ||
+                s.wifiSSID != "net" + tag || s.wifiPassword != "pw" + tag ||
+                (!s.emailRecipients.empty() && s.emailRecipients.back() != tag + "@example.com")) {
+                ++torn;
+            }
+            lastVersion = view->version;
+            ++localReads;
+        }
+        reads += localReads;
+    };
+
+    auto write = [&](int i) {
+        MockSettingsManager::Settings s = settings.getSettings();
+        const std::string tag = std::to_string(i);
+        s.pumpOnDuration = static_cast<uint32_t>(i);
+        s.pumpOffDuration = static_cast<uint32_t>(i + 1);
+        s.wifiSSID = "net" + tag;
+        s.wifiPassword = "pw" + tag;
+        s.emailRecipients.assign(1 + i % 3, tag + "@example.com");
+        settings.setSettings(s);
+    };
+
+    write(1);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.push_back(std::thread(reader));
+    }
+
+    for (int i = 2; i <= kWrites; ++i) {
+        write(i);
+    }
+    done = true;
+    for (std::thread& t : readers) {
+        t.join();
+    }
+
+    EXPECT_EQ(torn.load(), 0u);
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_EQ(settings.snapshot()->settings.pumpOnDuration, static_cast<uint32_t>(kWrites));
+}
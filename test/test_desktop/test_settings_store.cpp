@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "CommonTestFixture.h"
+#include "MockSettingsManager.h"
+#include "SettingsStore.h"
+#include "StorageBackend.h"
+#include "TestUtils.h"
+
+namespace {
+// Cuts the power after `budget` units: every mutating call costs one unit to start plus one
+// per byte written. The write in progress when the budget runs out lands partially and
+// every later call fails, as on a device that lost power.
+class PowerCutStorage : public StorageBackend {
+public:
+    PowerCutStorage(StorageBackend& inner, size_t budget) : inner_(inner), budget_(budget), initial_(budget) {}
+
+    bool isDead() const { return dead_; }
+    size_t spent() const { return initial_ - budget_; }
+
+    bool readFile(const std::string& name, std::string& out) override { return !dead_ && inner_.readFile(name, out); }
+
+    bool writeFile(const std::string& name, const std::string& data) override {
+        size_t n = 0;
+        if (!start(data.size(), n)) {
+            return false;
+        }
+        if (n < data.size()) {
+            inner_.writeFile(name, data.substr(0, n));
+            return false;
+        }
+        return inner_.writeFile(name, data);
+    }
+
+    bool appendFile(const std::string& name, const char* data, size_t length) override {
+        size_t n = 0;
+        if (!start(length, n)) {
+            return false;
+        }
+        if (n < length) {
+            if (n > 0) {
+                inner_.appendFile(name, data, n);
+            }
+            return false;
+        }
+        return inner_.appendFile(name, data, length);
+    }
+
+    bool removeFile(const std::string& name) override {
+        size_t n = 0;
+        return start(0, n) && inner_.removeFile(name);
+    }
+
+    bool renameFile(const std::string& from, const std::string& to) override {
+        size_t n = 0;
+        return start(0, n) && inner_.renameFile(from, to);
+    }
+
+    bool exists(const std::string& name) override { return !dead_ && inner_.exists(name); }
+    size_t fileSize(const std::string& name) override { return dead_ ? 0 : inner_.fileSize(name); }
+    std::vector<std::string> listFiles(const std::string& prefix) override {
+        return dead_ ? std::vector<std::string>() : inner_.listFiles(prefix);
+    }
+
+private:
+    StorageBackend& inner_;
+    size_t budget_;
+    size_t initial_;
+    bool dead_ = false;
+
+    // False if the call never starts; otherwise `allowed` bytes of `length` get through.
+    bool start(size_t length, size_t& allowed) {
+        if (dead_ || budget_ == 0) {
+            dead_ = true;
+            return false;
+        }
+        --budget_;
+        allowed = length <= budget_ ? length : budget_;
+        budget_ -= allowed;
+        if (allowed < length) {
+            dead_ = true;
+        }
+        return true;
+    }
+};
+} // namespace
+
+class SettingsStoreTest : public CommonTestFixture {
+protected:
+    std::string dir;
+
+    void SetUp() override {
+        CommonTestFixture::SetUp();
+        dir = TestFileUtils::createTempDirectory("coop_settings");
+        ASSERT_FALSE(dir.empty());
+    }
+
+    void TearDown() override {
+        TestFileUtils::removeDirectory(dir);
+        CommonTestFixture::TearDown();
+    }
+
+    void clearDir() {
+        FileStorageBackend storage(dir);
+        for (const std::string& name : storage.listFiles("")) {
+            storage.removeFile(name);
+        }
+    }
+
+    static SettingsStore::Config smallConfig() {
+        SettingsStore::Config config;
+        config.maxLogBytes = 160;
+        return config;
+    }
+
+    SettingsStore::Values reboot() {
+        FileStorageBackend storage(dir);
+        SettingsStore store(storage);
+        store.setConfig(smallConfig());
+        store.begin();
+        return store.values();
+    }
+
+    // A run of saves touching one or two keys each, with an erase and a value big enough to
+    // force a compaction on its own.
+    static std::vector<SettingsStore::Values> script() {
+        std::vector<SettingsStore::Values> states;
+        SettingsStore::Values state = {{"pumpEnabled", "true"}, {"freezeThreshold", "1.1"}, {"wifiSSID", "coop"}};
+        states.push_back(state);
+        for (int i = 0; i < 6; ++i) {
+            state["pumpOnDuration"] = std::to_string(60 + i);
+            if (i % 2) {
+                state["lightLatitude"] = std::to_string(40 + i) + ".25";
+            }
+            states.push_back(state);
+        }
+        state.erase("wifiSSID");
+        states.push_back(state);
+        state["emailRecipients"] = "[\"" + std::string(200, 'x') + "@example.com\"]";
+        states.push_back(state);
+        state["pumpEnabled"] = "false";
+        states.push_back(state);
+        return states;
+    }
+};
+
+TEST_F(SettingsStoreTest, SavesOnlyChangedKeysAndReloads) {
+    FileStorageBackend storage(dir);
+    SettingsStore store(storage);
+    ASSERT_TRUE(store.begin());
+    EXPECT_FALSE(store.hasData());
+
+    SettingsStore::Values state = {{"a", "1"}, {"b", "2"}, {"c", "3"}};
+    ASSERT_TRUE(store.save(state));
+    const size_t firstRecord = store.getLogBytes();
+
+    state["b"] = "20";
+    ASSERT_TRUE(store.save(state));
+    EXPECT_LT(store.getLogBytes() - firstRecord, firstRecord); // One key, not three
+
+    ASSERT_TRUE(store.save(state)); // Unchanged: nothing written
+    EXPECT_EQ(store.getStats().recordsAppended, 2u);
+    EXPECT_EQ(store.getSequence(), 2u);
+
+    state.erase("a");
+    ASSERT_TRUE(store.save(state));
+
+    SettingsStore reloaded(storage);
+    ASSERT_TRUE(reloaded.begin());
+    EXPECT_TRUE(reloaded.hasData());
+    EXPECT_EQ(reloaded.values(), state);
+    EXPECT_EQ(reloaded.getSequence(), 3u);
+    EXPECT_EQ(reloaded.getStats().recordsReplayed, 3u);
+}
+
+TEST_F(SettingsStoreTest, CompactionAlternatesSnapshotSlots) {
+    FileStorageBackend storage(dir);
+    SettingsStore store(storage);
+    store.setConfig(smallConfig());
+    store.begin();
+
+    SettingsStore::Values state;
+    for (int i = 0; i < 40; ++i) {
+        state["key" + std::to_string(i % 5)] = std::to_string(i);
+        ASSERT_TRUE(store.save(state));
+        EXPECT_LE(store.getLogBytes(), smallConfig().maxLogBytes);
+    }
+    EXPECT_GE(store.getStats().compactions, 2u);
+    EXPECT_TRUE(storage.exists("settings.a"));
+    EXPECT_TRUE(storage.exists("settings.b"));
+
+    EXPECT_EQ(reboot(), state);
+
+    ASSERT_TRUE(store.compact());
+    EXPECT_EQ(store.getLogBytes(), 0u);
+    EXPECT_FALSE(storage.exists("settings.log"));
+    EXPECT_EQ(reboot(), state);
+}
+
+TEST_F(SettingsStoreTest, TornLogTailIsDroppedAndCompactedAway) {
+    SettingsStore::Values state = {{"a", "1"}};
+    {
+        FileStorageBackend storage(dir);
+        SettingsStore store(storage);
+        store.begin();
+        store.save(state);
+    }
+
+    // Edge: power lost mid-append leaves a half record behind the good one.
+    FileStorageBackend storage(dir);
+    const char garbage[] = {0x40, 0x00, 0x00, 0x00, 0x01, 0x02};
+    storage.appendFile("settings.log", garbage, sizeof(garbage));
+
+    SettingsStore store(storage);
+    ASSERT_TRUE(store.begin());
+    EXPECT_EQ(store.values(), state);
+    EXPECT_EQ(store.getStats().tornTails, 1u);
+    EXPECT_EQ(store.getStats().compactions, 1u);
+    EXPECT_FALSE(storage.exists("settings.log"));
+
+    state["b"] = "2";
+    ASSERT_TRUE(store.save(state));
+    EXPECT_EQ(reboot(), state);
+}
+
+TEST_F(SettingsStoreTest, CorruptNewestSnapshotFallsBackToPreviousOne) {
+    FileStorageBackend storage(dir);
+    SettingsStore store(storage);
+    store.begin();
+    const SettingsStore::Values older = {{"a", "1"}};
+    const SettingsStore::Values newer = {{"a", "2"}};
+    store.save(older);
+    store.compact(); // settings.a
+    store.save(newer);
+    store.compact(); // settings.b
+
+    std::string data;
+    ASSERT_TRUE(storage.readFile("settings.b", data));
+    data[data.size() - 1] ^= 0x01;
+    storage.writeFile("settings.b", data);
+
+    EXPECT_EQ(reboot(), older);
+}
+
+TEST_F(SettingsStoreTest, NoCorruptionAtAnyPowerCut) {
+    const std::vector<SettingsStore::Values> states = script();
+
+    // Runs the script until the power goes; returns how many saves were acknowledged.
+    auto run = [&](PowerCutStorage& storage) {
+        SettingsStore store(storage);
+        store.setConfig(smallConfig());
+        store.begin();
+        size_t acknowledged = 0;
+        for (const SettingsStore::Values& state : states) {
+            if (!store.save(state)) {
+                break;
+            }
+            ++acknowledged;
+        }
+        return acknowledged;
+    };
+
+    size_t total = 0;
+    {
+        FileStorageBackend files(dir);
+        PowerCutStorage storage(files, static_cast<size_t>(-1));
+        ASSERT_EQ(run(storage), states.size());
+        total = storage.spent();
+    }
+
+    for (size_t cut = 0; cut <= total; ++cut) {
+        clearDir();
+        size_t acknowledged = 0;
+        {
+            FileStorageBackend files(dir);
+            PowerCutStorage storage(files, cut);
+            acknowledged = run(storage);
+        }
+
+        // Every acknowledged save survives; the one in flight is all there or not at all.
+        const SettingsStore::Values recovered = reboot();
+        const SettingsStore::Values last = acknowledged ? states[acknowledged - 1] : SettingsStore::Values();
+        if (recovered != last) {
+            ASSERT_LT(acknowledged, states.size()) << "cut at " << cut;
+            ASSERT_EQ(recovered, states[acknowledged]) << "cut at " << cut;
+        }
+
+        // And the store keeps working after recovery.
+        SettingsStore::Values next = recovered;
+        next["after"] = std::to_string(cut);
+        {
+            FileStorageBackend files(dir);
+            SettingsStore store(files);
+            store.setConfig(smallConfig());
+            store.begin();
+            ASSERT_TRUE(store.save(next)) << "cut at " << cut;
+        }
+        ASSERT_EQ(reboot(), next) << "cut at " << cut;
+    }
+}
+
+TEST_F(SettingsStoreTest, SettingsManagerPersistsThroughStore) {
+    FileStorageBackend storage(dir);
+    MockSettingsManager settings;
+    settings.setStorage(&storage);
+    ASSERT_TRUE(settings.loadSettings());
+    EXPECT_FALSE(settings.settingsFileExists());
+
+    ASSERT_TRUE(settings.set<MockSettingsManager::SettingId::freezeThreshold>(1.1f));
+    ASSERT_TRUE(settings.setSettingString("wifiSSID", "Coop \"net\""));
+    ASSERT_TRUE(settings.setSettingString("custom.note", "hello"));
+    MockSettingsManager::Settings s = settings.getSettings();
+    s.emailRecipients = {"a@example.com", "b@example.com"};
+    settings.setSettings(s);
+    ASSERT_TRUE(settings.saveSettings());
+    EXPECT_FALSE(settings.hasUnsavedChanges());
+
+    // Changing one setting appends one small record.
+    const size_t before = settings.getStore()->getLogBytes();
+    ASSERT_TRUE(settings.setSettingUInt("pumpOnDuration", 120));
+    ASSERT_TRUE(settings.saveSettings());
+    EXPECT_LT(settings.getStore()->getLogBytes() - before, 64u);
+
+    MockSettingsManager reloaded;
+    reloaded.setStorage(&storage);
+    ASSERT_TRUE(reloaded.loadSettings());
+    EXPECT_TRUE(reloaded.settingsFileExists());
+    EXPECT_FALSE(reloaded.hasUnsavedChanges());
+    EXPECT_EQ(reloaded.serializeToJson(), settings.serializeToJson());
+    EXPECT_EQ(reloaded.get<MockSettingsManager::SettingId::freezeThreshold>(), 1.1f);
+    EXPECT_EQ(reloaded.getSettingString("custom.note"), "hello");
+
+    ASSERT_TRUE(settings.createBackup("backup.json"));
+    reloaded.resetToDefaults();
+    ASSERT_TRUE(reloaded.restoreBackup("backup.json"));
+    EXPECT_EQ(reloaded.serializeToJson(), settings.serializeToJson());
+    EXPECT_FALSE(reloaded.restoreBackup("missing.json"));
+}
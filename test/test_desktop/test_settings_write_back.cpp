@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "CommonTestFixture.h"
+#include "MockSettingsManager.h"
+#include "SettingsWriteBack.h"
+#include "StorageBackend.h"
+#include "TestUtils.h"
+
+namespace {
+// Temp-dir storage whose writes can be made to fail.
+class FlakyStorage : public FileStorageBackend {
+public:
+    using FileStorageBackend::FileStorageBackend;
+
+    bool failWrites = false;
+
+    bool writeFile(const std::string& name, const std::string& data) override {
+        return !failWrites && FileStorageBackend::writeFile(name, data);
+    }
+    bool appendFile(const std::string& name, const char* data, size_t length) override {
+        return !failWrites && FileStorageBackend::appendFile(name, data, length);
+    }
+};
+} // namespace
+
+class SettingsWriteBackTest : public CommonTestFixture {
+protected:
+    std::string dir;
+    uint64_t now = 1000;
+
+    void SetUp() override {
+        CommonTestFixture::SetUp();
+        dir = TestFileUtils::createTempDirectory("coop_write_back");
+        ASSERT_FALSE(dir.empty());
+    }
+
+    void TearDown() override {
+        TestFileUtils::removeDirectory(dir);
+        CommonTestFixture::TearDown();
+    }
+
+    void attach(SettingsWriteBack& writeBack) {
+        writeBack.setTimeProvider([this]() { return now; });
+    }
+
+    // Advance the clock in `stepMs` steps, polling as a main loop would.
+    void run(SettingsWriteBack& writeBack, uint64_t ms, uint64_t stepMs = 10) {
+        for (uint64_t t = 0; t < ms; t += stepMs) {
+            now += stepMs;
+            writeBack.poll();
+        }
+    }
+};
+
+TEST_F(SettingsWriteBackTest, CoalescesAFormSubmitIntoOneSave) {
+    FileStorageBackend storage(dir);
+    MockSettingsManager settings;
+    settings.setStorage(&storage);
+    settings.loadSettings();
+    SettingsWriteBack writeBack(settings);
+    attach(writeBack);
+
+    // The UI posts twelve fields 50 ms apart, touching pumpOnDuration three times.
+    for (int i = 0; i < 12; ++i) {
+        if (i % 4 == 0) {
+            settings.setSettingUInt("pumpOnDuration", 100 + i);
+        } else {
+            settings.setSettingString("field" + std::to_string(i), "v");
+        }
+        run(writeBack, 50);
+    }
+    EXPECT_TRUE(writeBack.isPending());
+    EXPECT_EQ(writeBack.getStats().flushes, 0u);
+
+    run(writeBack, 1900);
+    EXPECT_TRUE(writeBack.isPending());
+    run(writeBack, 100);
+    EXPECT_FALSE(writeBack.isPending());
+    EXPECT_FALSE(settings.hasUnsavedChanges());
+
+    SettingsWriteBack::Stats stats = writeBack.getStats();
+    EXPECT_EQ(stats.changes, 12u);
+    EXPECT_EQ(stats.flushes, 1u);
+    EXPECT_EQ(stats.quietFlushes, 1u);
+    EXPECT_EQ(stats.writesAvoided, 11u);
+    EXPECT_EQ(stats.lastLatencyMs, 550u + 2000u); // First field seen at 10 ms, the last at 560 ms
+    EXPECT_EQ(settings.getStore()->getStats().recordsAppended, 1u);
+
+    // Nothing new: no more saves.
+    run(writeBack, 5000, 100);
+    EXPECT_EQ(writeBack.getStats().flushes, 1u);
+}
+
+TEST_F(SettingsWriteBackTest, ResetToDefaultsCountsAsOneChange) {
+    MockSettingsManager settings;
+    settings.setSettingUInt("pumpOnDuration", 42);
+    settings.markSaved();
+    SettingsWriteBack writeBack(settings);
+    attach(writeBack);
+
+    settings.resetToDefaults();
+    EXPECT_TRUE(writeBack.flushBeforeReboot());
+    EXPECT_EQ(writeBack.getStats().changes, 1u);
+    EXPECT_EQ(writeBack.getStats().writesAvoided, 0u);
+}
+
+TEST_F(SettingsWriteBackTest, MaxLatencyBoundsAContinuousTrickle) {
+    MockSettingsManager settings;
+    SettingsWriteBack writeBack(settings);
+    attach(writeBack);
+    SettingsWriteBack::Config config;
+    config.quietMs = 1000;
+    config.maxLatencyMs = 5000;
+    writeBack.setConfig(config);
+
+    // A change every 500 ms never leaves a quiet second.
+    for (int i = 0; i < 60; ++i) {
+        settings.setSettingUInt("pumpOnDuration", 100 + i);
+        run(writeBack, 500);
+    }
+    SettingsWriteBack::Stats stats = writeBack.getStats();
+    EXPECT_EQ(stats.quietFlushes, 0u);
+    EXPECT_GE(stats.latencyFlushes, 5u);
+    EXPECT_LE(stats.maxLatencyMs, 5000u);
+    EXPECT_EQ(stats.changes, 60u);
+
+    writeBack.flushBeforeReboot();
+    stats = writeBack.getStats();
+    EXPECT_EQ(stats.writesAvoided + stats.flushes, stats.changes);
+}
+
+TEST_F(SettingsWriteBackTest, FlushBeforeRebootSavesPendingChangesNow) {
+    FileStorageBackend storage(dir);
+    MockSettingsManager settings;
+    settings.setStorage(&storage);
+    settings.loadSettings();
+    SettingsWriteBack writeBack(settings);
+    attach(writeBack);
+
+    EXPECT_TRUE(writeBack.flushBeforeReboot()); // Nothing pending: nothing written
+    EXPECT_EQ(writeBack.getStats().flushes, 0u);
+
+    settings.setSettingUInt("pumpOnDuration", 42);
+    now += 30;
+    EXPECT_TRUE(writeBack.flushBeforeReboot());
+    EXPECT_EQ(writeBack.getStats().rebootFlushes, 1u);
+    EXPECT_EQ(writeBack.getStats().lastLatencyMs, 0u); // Seen and saved in the same call
+
+    MockSettingsManager rebooted;
+    rebooted.setStorage(&storage);
+    rebooted.loadSettings();
+    EXPECT_EQ(rebooted.getSettingUInt("pumpOnDuration"), 42u);
+}
+
+TEST_F(SettingsWriteBackTest, SaveElsewhereCancelsThePendingBatch) {
+    MockSettingsManager settings;
+    SettingsWriteBack writeBack(settings);
+    attach(writeBack);
+    EXPECT_EQ(writeBack.msUntilDue(), std::numeric_limits<uint64_t>::max());
+
+    settings.setSettingBool("pumpEnabled", false);
+    EXPECT_EQ(writeBack.msUntilDue(), 2000u);
+    now += 1500;
+    EXPECT_EQ(writeBack.msUntilDue(), 500u);
+
+    settings.saveSettings();
+    EXPECT_FALSE(writeBack.poll());
+    EXPECT_FALSE(writeBack.isPending());
+    run(writeBack, 3000);
+    EXPECT_EQ(writeBack.getStats().flushes, 0u);
+}
+
+TEST_F(SettingsWriteBackTest, FailedSaveIsRetriedAfterAnotherQuietPeriod) {
+    FlakyStorage storage(dir);
+    MockSettingsManager settings;
+    settings.setStorage(&storage);
+    settings.loadSettings();
+    SettingsWriteBack writeBack(settings);
+    attach(writeBack);
+
+    storage.failWrites = true;
+    settings.setSettingUInt("pumpOnDuration", 77);
+    writeBack.poll();
+    run(writeBack, 2000);
+    EXPECT_EQ(writeBack.getStats().flushErrors, 1u);
+    EXPECT_TRUE(writeBack.isPending());
+
+    run(writeBack, 1000); // No retry inside the quiet period
+    EXPECT_EQ(writeBack.getStats().flushErrors, 1u);
+
+    storage.failWrites = false;
+    run(writeBack, 1000);
+    EXPECT_FALSE(writeBack.isPending());
+    EXPECT_EQ(writeBack.getStats().flushes, 1u);
+    EXPECT_EQ(writeBack.getStats().lastLatencyMs, 4000u);
+}
@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommonTestFixture.h"
+#include "Logger.h"
+#include "MockSettingsManager.h"
+#include "SyslogForwarder.h"
+
+namespace {
+// Split an octet-counted datagram ("<len> <msg><len> <msg>...") back into messages.
+std::vector<std::string> unframe(const std::string& datagram) {
+    std::vector<std::string> messages;
+    size_t pos = 0;
+    while (pos < datagram.size()) {
+        const size_t space = datagram.find(' ', pos);
+        if (space == std::string::npos) {
+            break;
+        }
+        const size_t length = std::stoul(datagram.substr(pos, space - pos));
+        messages.push_back(datagram.substr(space + 1, length));
+        pos = space + 1 + length;
+    }
+    return messages;
+}
+} // namespace
+
+class SyslogForwarderTest : public CommonTestFixture {
+protected:
+    uint64_t nowMs = 0;
+    std::vector<std::string> datagrams;
+    bool transportUp = true;
+
+    void attach(SyslogForwarder& forwarder) {
+        forwarder.setTimeProvider([this]() { return nowMs; });
+        forwarder.setTransport([this](const char* data, size_t length) {
+            if (!transportUp) {
+                return false;
+            }
+            datagrams.push_back(std::string(data, length));
+            return true;
+        });
+    }
+
+    std::vector<std::string> allMessages() const {
+        std::vector<std::string> out;
+        for (const auto& datagram : datagrams) {
+            auto messages = unframe(datagram);
+            out.insert(out.end(), messages.begin(), messages.end());
+        }
+        return out;
+    }
+};
+
+TEST_F(SyslogForwarderTest, FormatsRfc5424Message) {
+    Logger::Entry entry;
+    entry.sequence = 41;
+    entry.timestampMs = 12340;
+    entry.level = Logger::Level::WARN;
+    entry.tag = "pump";
+    entry.message = "dry run detected";
+
+    SyslogForwarder::Config config;
+    EXPECT_EQ(SyslogForwarder::formatMessage(entry, config),
+              "<132>1 - coop-controller coop - pump [meta sequenceId=\"42\" sysUpTime=\"1234\"] dry run detected");
+
+    entry.tag = "";
+    entry.level = Logger::Level::ERROR;
+    EXPECT_EQ(SyslogForwarder::formatMessage(entry, config).substr(0, 42),
+              "<131>1 - coop-controller coop - - [meta se");
+}
+
+TEST_F(SyslogForwarderTest, PacksSeveralMessagesPerDatagram) {
+    Logger logger(64);
+    SyslogForwarder forwarder(logger);
+    attach(forwarder);
+
+    for (int i = 0; i < 5; ++i) {
+        logger.info("reading " + std::to_string(i), "sensor");
+    }
+
+    EXPECT_EQ(forwarder.pump(), 5u);
+    ASSERT_EQ(datagrams.size(), 1u);
+
+    auto messages = allMessages();
+    ASSERT_EQ(messages.size(), 5u);
+    EXPECT_NE(messages[0].find("reading 0"), std::string::npos);
+    EXPECT_NE(messages[4].find("reading 4"), std::string::npos);
+    EXPECT_EQ(forwarder.getBacklog(), 0u);
+    EXPECT_EQ(forwarder.pump(), 0u);
+}
+
+TEST_F(SyslogForwarderTest, SplitsAtDatagramSizeLimit) {
+    Logger logger(64);
+    SyslogForwarder forwarder(logger);
+    SyslogForwarder::Config config;
+    config.maxDatagramBytes = 200;
+    forwarder.setConfig(config);
+    attach(forwarder);
+
+    for (int i = 0; i < 6; ++i) {
+        logger.info("a fairly long message body number " + std::to_string(i), "sensor");
+    }
+
+    EXPECT_EQ(forwarder.pump(), 6u);
+    EXPECT_GT(datagrams.size(), 1u);
+    for (const auto& datagram : datagrams) {
+        EXPECT_LE(datagram.size(), 200u);
+    }
+    EXPECT_EQ(allMessages().size(), 6u);
+    EXPECT_EQ(forwarder.getStats().datagramsSent, datagrams.size());
+}
+
+TEST_F(SyslogForwarderTest, TokenBucketLimitsBursts) {
+    Logger logger(128);
+    SyslogForwarder forwarder(logger);
+    SyslogForwarder::Config config;
+    config.burstMessages = 10;
+    config.messagesPerSecond = 5;
+    config.dropDebugBacklog = 1000;
+    config.dropInfoBacklog = 1000;
+    forwarder.setConfig(config);
+    attach(forwarder);
+
+    for (int i = 0; i < 30; ++i) {
+        logger.info("tick " + std::to_string(i), "burst");
+    }
+
+    EXPECT_EQ(forwarder.pump(), 10u);
+    EXPECT_EQ(forwarder.getStats().rateLimitedPumps, 1u);
+    EXPECT_EQ(forwarder.getBacklog(), 20u);
+
+    nowMs += 1000;
+    EXPECT_EQ(forwarder.pump(), 5u);
+
+    nowMs += 60000; // Refill is capped at the burst size
+    EXPECT_EQ(forwarder.pump(), 10u);
+    EXPECT_EQ(forwarder.getBacklog(), 5u);
+}
+
+TEST_F(SyslogForwarderTest, DropsDebugFirstUnderBackpressure) {
+    Logger logger(256);
+    SyslogForwarder forwarder(logger);
+    SyslogForwarder::Config config;
+    config.dropDebugBacklog = 8;
+    config.dropInfoBacklog = 16;
+    config.maxBatchEntries = 256;
+    config.burstMessages = 1000;
+    forwarder.setConfig(config);
+    attach(forwarder);
+
+    // 10 rounds of DEBUG/INFO/WARN; the oldest entries sit behind the largest backlog.
+    for (int i = 0; i < 10; ++i) {
+        logger.debug("d" + std::to_string(i), "x");
+        logger.info("i" + std::to_string(i), "x");
+        logger.warn("w" + std::to_string(i), "x");
+    }
+
+    forwarder.pump();
+    auto stats = forwarder.getStats();
+
+    // Backlog > 8 sheds DEBUG; backlog > 16 sheds INFO as well. WARN is always kept.
+    EXPECT_GT(stats.droppedDebug, stats.droppedInfo);
+    EXPECT_GT(stats.droppedInfo, 0u);
+    EXPECT_EQ(stats.messagesSent + stats.droppedDebug + stats.droppedInfo, 30u);
+
+    size_t warnings = 0;
+    for (const auto& message : allMessages()) {
+        if (message.compare(0, 5, "<132>") == 0) {
+            ++warnings;
+        }
+    }
+    EXPECT_EQ(warnings, 10u);
+    EXPECT_EQ(forwarder.getBacklog(), 0u);
+}
+
+TEST_F(SyslogForwarderTest, SendFailureRetriesSameEntries) {
+    Logger logger(64);
+    SyslogForwarder forwarder(logger);
+    attach(forwarder);
+
+    logger.info("first", "net");
+    logger.info("second", "net");
+
+    transportUp = false;
+    EXPECT_EQ(forwarder.pump(), 0u);
+    EXPECT_EQ(forwarder.getStats().sendFailures, 1u);
+    EXPECT_EQ(forwarder.getBacklog(), 2u);
+
+    transportUp = true;
+    EXPECT_EQ(forwarder.pump(), 2u);
+    auto messages = allMessages();
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_NE(messages[0].find("first"), std::string::npos);
+}
+
+TEST_F(SyslogForwarderTest, CountsEntriesOverwrittenBeforeForwarding) {
+    Logger logger(4);
+    SyslogForwarder forwarder(logger);
+    attach(forwarder);
+
+    for (int i = 0; i < 10; ++i) {
+        logger.warn("w" + std::to_string(i), "x");
+    }
+
+    EXPECT_EQ(forwarder.pump(), 4u);
+    EXPECT_EQ(forwarder.getStats().entriesMissed, 6u);
+}
+
+TEST_F(SyslogForwarderTest, ConfigureFromSettingsSendsToUdpListener) {
+    int listener = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(listener, 0);
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    ASSERT_EQ(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    socklen_t addrLength = sizeof(addr);
+    ASSERT_EQ(::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addrLength), 0);
+
+    timeval timeout;
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    ::setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    Logger logger(64);
+    SyslogForwarder forwarder(logger);
+
+    MockSettingsManager::Settings settings;
+    EXPECT_TRUE(forwarder.configure(settings));
+    EXPECT_FALSE(forwarder.isEnabled());
+
+    settings.syslogEnabled = true;
+    settings.syslogServer = "127.0.0.1";
+    settings.syslogPort = ntohs(addr.sin_port);
+    ASSERT_TRUE(forwarder.configure(settings));
+    EXPECT_TRUE(forwarder.isEnabled());
+
+    logger.error("coop door jammed", "door");
+    logger.info("retrying", "door");
+    EXPECT_EQ(forwarder.pump(), 2u);
+
+    char buffer[2048];
+    ssize_t received = ::recv(listener, buffer, sizeof(buffer), 0);
+    ::close(listener);
+    ASSERT_GT(received, 0);
+
+    auto messages = unframe(std::string(buffer, static_cast<size_t>(received)));
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0].compare(0, 5, "<131>"), 0);
+    EXPECT_NE(messages[0].find("coop door jammed"), std::string::npos);
+    EXPECT_NE(messages[1].find("retrying"), std::string::npos);
+}
+
+TEST_F(SyslogForwarderTest, BackgroundThreadForwardsConcurrentLogger) {
+    Logger logger(64, Logger::Mode::CONCURRENT);
+    SyslogForwarder forwarder(logger);
+    SyslogForwarder::Config config;
+    config.pollIntervalMs = 5;
+    forwarder.setConfig(config);
+
+    std::mutex received;
+    size_t count = 0;
+    forwarder.setTransport([&](const char* data, size_t length) {
+        std::lock_guard<std::mutex> lock(received);
+        count += unframe(std::string(data, length)).size();
+        return true;
+    });
+
+    ASSERT_TRUE(forwarder.start());
+    for (int i = 0; i < 5; ++i) {
+        logger.warn("bg " + std::to_string(i), "bg");
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(received);
+            if (count == 5) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    forwarder.stop();
+
+    EXPECT_EQ(count, 5u);
+    EXPECT_FALSE(forwarder.isRunning());
+}
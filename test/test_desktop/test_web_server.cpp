@@ -0,0 +1,1169 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "CommonTestFixture.h"
+#include "EpollHttpServer.h"
+#include "HttpRequestParser.h"
+#include "HttpRouter.h"
+#include "Logger.h"
+#include "MockSettingsManager.h"
+#include "MockSystemMetrics.h"
+#include "MockWebServer.h"
+#include "RequestLimiter.h"
+#include "StaticAssetCache.h"
+#include "StorageBackend.h"
+#include "TestUtils.h"
+
+// Counts heap allocations so the in-place request path can be checked for copies.
+namespace {
+std::atomic<size_t> g_heapAllocations{0};
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+class WebServerTest : public CommonTestFixture {
+protected:
+    MockWebServer server{8080};
+
+    void SetUp() override {
+        CommonTestFixture::SetUp();
+        server.begin();
+    }
+
+    static MockWebServer::HttpResponse text(const std::string& body) {
+        return MockWebServer::createTextResponse(body);
+    }
+};
+
+TEST_F(WebServerTest, StaticRoutesDispatchByMethod) {
+    server.onGet("/api/status", [](const MockWebServer::HttpRequest&) { return text("get status"); });
+    server.onPost("/api/status", [](const MockWebServer::HttpRequest& r) { return text("post " + r.body); });
+    server.onGet("/api/settings", [](const MockWebServer::HttpRequest&) { return text("settings"); });
+
+    EXPECT_EQ(server.simulateGet("/api/status").body, "get status");
+    EXPECT_EQ(server.simulatePost("/api/status", "x").body, "post x");
+    EXPECT_EQ(server.simulateGet("/api/settings?verbose=1").body, "settings");
+    EXPECT_EQ(server.simulateGet("/api/stat").statusCode, 404);
+    EXPECT_EQ(server.simulateGet("/api/status/extra").statusCode, 404);
+}
+
+TEST_F(WebServerTest, WrongMethodReturns405WithAllowHeader) {
+    server.onGet("/api/pump", [](const MockWebServer::HttpRequest&) { return text("pump"); });
+    server.onPut("/api/pump", [](const MockWebServer::HttpRequest&) { return text("pump"); });
+
+    auto response = server.simulateDelete("/api/pump");
+    EXPECT_EQ(response.statusCode, 405);
+    EXPECT_EQ(response.headers["Allow"], "GET, PUT");
+}
+
+TEST_F(WebServerTest, TypedPathParametersAreCaptured) {
+    server.onGet("/api/sensors/{index:uint}", [](const MockWebServer::HttpRequest& r) {
+        return text("sensor " + std::to_string(r.getPathParamInt("index")));
+    });
+    server.onGet("/api/sensors/{index:uint}/history/{hours:int}", [](const MockWebServer::HttpRequest& r) {
+        return text(r.getPathParam("index") + ":" + std::to_string(r.getPathParamInt("hours")));
+    });
+    server.onGet("/api/logs/{tag}", [](const MockWebServer::HttpRequest& r) {
+        return text("tag " + r.getPathParam("tag"));
+    });
+
+    EXPECT_EQ(server.simulateGet("/api/sensors/3").body, "sensor 3");
+    EXPECT_EQ(server.simulateGet("/api/sensors/12/history/-24").body, "12:-24");
+    EXPECT_EQ(server.simulateGet("/api/logs/wifi").body, "tag wifi");
+
+    // Type mismatches fall through to 404.
+    EXPECT_EQ(server.simulateGet("/api/sensors/abc").statusCode, 404);
+    EXPECT_EQ(server.simulateGet("/api/sensors/-1").statusCode, 404);
+    EXPECT_EQ(server.simulateGet("/api/sensors/1/history/x").statusCode, 404);
+}
+
+TEST_F(WebServerTest, StaticSegmentsBeatParameters) {
+    server.onGet("/api/sensors/{name}", [](const MockWebServer::HttpRequest& r) {
+        return text("name " + r.getPathParam("name"));
+    });
+    server.onGet("/api/sensors/{index:uint}", [](const MockWebServer::HttpRequest&) { return text("index"); });
+    server.onGet("/api/sensors/summary", [](const MockWebServer::HttpRequest&) { return text("summary"); });
+
+    EXPECT_EQ(server.simulateGet("/api/sensors/summary").body, "summary");
+    EXPECT_EQ(server.simulateGet("/api/sensors/7").body, "index");
+    EXPECT_EQ(server.simulateGet("/api/sensors/sums").body, "name sums");
+}
+
+TEST_F(WebServerTest, RestParameterCapturesRemainingPath) {
+    server.onGet("/files/{path:*}", [](const MockWebServer::HttpRequest& r) {
+        return text(r.getPathParam("path"));
+    });
+
+    EXPECT_EQ(server.simulateGet("/files/css/site.css").body, "css/site.css");
+    EXPECT_EQ(server.simulateGet("/files/").statusCode, 404);
+}
+
+TEST_F(WebServerTest, RejectsMalformedAndDuplicateRoutes) {
+    auto handler = [](const MockWebServer::HttpRequest&) { return text("x"); };
+    EXPECT_TRUE(server.onGet("/api/a/{id:uint}", handler));
+    EXPECT_FALSE(server.onGet("/api/a/{other:uint}", handler)); // Same shape, same method
+    EXPECT_TRUE(server.onPost("/api/a/{id:uint}", handler));
+    EXPECT_FALSE(server.onGet("/api/b{id}", handler));
+    EXPECT_FALSE(server.onGet("/api/b/{id}x", handler));
+    EXPECT_FALSE(server.onGet("/api/b/{id:float}", handler));
+    EXPECT_FALSE(server.onGet("/api/b/{rest:*}/more", handler));
+    EXPECT_FALSE(server.onGet("relative", handler));
+    EXPECT_EQ(server.getRouteCount(), 2u);
+}
+
+TEST(HttpRouterTest, SplitsSharedPrefixesAndBacktracks) {
+    HttpRouter router;
+    ASSERT_TRUE(router.add("GET", "/api/settings", 0));
+    ASSERT_TRUE(router.add("GET", "/api/sensors", 1));
+    ASSERT_TRUE(router.add("GET", "/api/se", 2));
+    ASSERT_TRUE(router.add("GET", "/api/{section}/reset", 3));
+    ASSERT_TRUE(router.add("PATCH", "/api/settings", 4));
+    ASSERT_TRUE(router.add("REPORT", "/api/settings", 5));
+
+    HttpRouter::Match match;
+    ASSERT_TRUE(router.find("GET", "/api/settings", match));
+    EXPECT_EQ(match.route, 0);
+    ASSERT_TRUE(router.find("GET", "/api/sensors", match));
+    EXPECT_EQ(match.route, 1);
+    ASSERT_TRUE(router.find("GET", "/api/se", match));
+    EXPECT_EQ(match.route, 2);
+    ASSERT_TRUE(router.find("PATCH", "/api/settings", match));
+    EXPECT_EQ(match.route, 4);
+    ASSERT_TRUE(router.find("REPORT", "/api/settings", match));
+    EXPECT_EQ(match.route, 5);
+
+    // "/api/settings" is a static prefix of this path, but only the parameter route matches.
+    ASSERT_TRUE(router.find("GET", "/api/settings/reset", match));
+    EXPECT_EQ(match.route, 3);
+    ASSERT_EQ(match.paramCount, 1u);
+    EXPECT_EQ(match.params[0].offset, 5u);
+    EXPECT_EQ(match.params[0].length, 8u);
+
+    EXPECT_FALSE(router.find("DELETE", "/api/settings", match));
+    EXPECT_TRUE(match.pathMatched);
+    EXPECT_EQ(match.allow, "GET, PATCH, REPORT");
+    EXPECT_EQ(router.size(), 6u);
+}
+
+TEST(HttpRequestParserTest, ParsesRequestFedOneByteAtATime) {
+    const std::string raw =
+        "POST /api/settings?apply=1&reboot=0 HTTP/1.1\r\n"
+        "Host: coop.local\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: 11\r\n"
+        "\r\n"
+        "{\"a\":true}\n";
+
+    HttpRequestParser parser;
+    for (size_t i = 1; i < raw.size(); ++i) {
+        ASSERT_EQ(parser.feed(raw.data(), i), HttpRequestParser::Result::NEED_MORE) << i;
+    }
+    ASSERT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+
+    const auto& request = parser.request();
+    EXPECT_EQ(request.method, "POST");
+    EXPECT_EQ(request.url, "/api/settings?apply=1&reboot=0");
+    EXPECT_EQ(request.path, "/api/settings");
+    EXPECT_EQ(request.queryParams.at("apply"), "1");
+    EXPECT_EQ(request.headers.at("Host"), "coop.local");
+    EXPECT_EQ(request.body, "{\"a\":true}\n");
+    EXPECT_EQ(parser.consumed(), raw.size());
+    EXPECT_TRUE(parser.keepAlive());
+}
+
+TEST(HttpRequestParserTest, LeavesPipelinedRequestInBuffer) {
+    const std::string raw = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\nConnection: close\r\n\r\n";
+
+    HttpRequestParser parser;
+    ASSERT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(parser.request().path, "/a");
+    const size_t first = parser.consumed();
+
+    parser.reset();
+    ASSERT_EQ(parser.feed(raw.data() + first, raw.size() - first), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(parser.request().path, "/b");
+    EXPECT_FALSE(parser.keepAlive());
+}
+
+TEST(HttpRequestParserTest, RejectsMalformedAndOversizedRequests) {
+    struct Case {
+        const char* raw;
+        int status;
+    };
+    const Case cases[] = {
+        {"GET\r\n\r\n", 400},
+        {"GET /x HTTP/2.0\r\n\r\n", 505},
+        {"GET x HTTP/1.1\r\n\r\n", 400},
+        {"GET /x HTTP/1.1\r\nBad Header: 1\r\n\r\n", 400},
+        {"POST /x HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", 400},
+        {"POST /x HTTP/1.1\r\nContent-Length: 999999\r\n\r\n", 413},
+        {"POST /x HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", 501},
+        // CR and LF only travel together: no bare CR, no LF inside a header value.
+        {"GET /x HTTP/1.1\rX-A: 1\r\n\r\n", 400},
+        {"GET /x HTTP/1.1\r\nX-A: 1\rX-B: 2\r\n\r\n", 400},
+        {"POST /x HTTP/1.1\r\nX: a\nContent-Length: 5\r\n\r\nhello", 400},
+    };
+
+    for (const auto& c : cases) {
+        HttpRequestParser parser;
+        EXPECT_EQ(parser.feed(c.raw, std::strlen(c.raw)), HttpRequestParser::Result::ERROR) << c.raw;
+        EXPECT_EQ(parser.errorStatus(), c.status) << c.raw;
+    }
+
+    const char nul[] = "GET /x HTTP/1.1\r\nX-A: a\0b\r\n\r\n";
+    HttpRequestParser nulParser;
+    EXPECT_EQ(nulParser.feed(nul, sizeof(nul) - 1), HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(nulParser.errorStatus(), 400);
+
+    HttpRequestParser::Limits limits;
+    limits.maxHeaderBytes = 64;
+    HttpRequestParser parser(limits);
+    const std::string longHead = "GET /x HTTP/1.1\r\nX-Filler: " + std::string(100, 'a');
+    EXPECT_EQ(parser.feed(longHead.data(), longHead.size()), HttpRequestParser::Result::ERROR);
+    EXPECT_EQ(parser.errorStatus(), 431);
+}
+
+TEST_F(WebServerTest, ViewRoutesReadParsedRequestInPlace) {
+    server.onView("PUT", "/api/sensors/{index:uint}", [](const MockWebServer::RequestView& r) {
+        return text(r.pathParam("index").str() + " " + r.header("content-type").str() + " " +
+                    r.queryParam("unit").str() + " " + r.body.str());
+    });
+
+    const std::string raw =
+        "PUT /api/sensors/3?unit=c&unit=f HTTP/1.1\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 4\r\n"
+        "\r\n"
+        "21.5";
+    HttpRequestParser parser;
+    ASSERT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+
+    const MockWebServer::RequestView& view = parser.view();
+    EXPECT_TRUE(view.method.equals("PUT"));
+    EXPECT_EQ(view.path.str(), "/api/sensors/3");
+    EXPECT_EQ(view.query.str(), "unit=c&unit=f");
+    ASSERT_EQ(view.headerCount, 2u);
+    EXPECT_EQ(view.headers[1].name.str(), "Content-Length");
+    EXPECT_GE(view.body.data, raw.data());
+    EXPECT_LT(view.body.data, raw.data() + raw.size()); // Slices point into the receive buffer
+
+    MockWebServer::HttpResponse response = server.handle(parser.view());
+    EXPECT_EQ(response.body, "3 text/plain f 21.5");
+    EXPECT_EQ(parser.view().pathParamInt("index"), 3);
+}
+
+TEST_F(WebServerTest, HandleMaterializesRequestOnlyForCompatibilityHandlers) {
+    server.onGet("/api/logs/{tag}", [](const MockWebServer::HttpRequest& r) {
+        return text(r.getPathParam("tag") + " " + r.headers.at("Host") + " " + r.queryParams.at("level"));
+    });
+    server.onView("GET", "/ping", [](const MockWebServer::RequestView&) {
+        MockWebServer::HttpResponse response;
+        response.statusCode = 204;
+        return response;
+    });
+
+    HttpRequestParser parser;
+    std::string raw = "GET /api/logs/pump?level=warn HTTP/1.1\r\nHost: coop.local\r\n\r\n";
+    ASSERT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(server.handle(parser.view()).body, "pump coop.local warn");
+
+    // A view route reached through the parser makes no copies of the request at all, and
+    // recording it in the history ring allocates nothing either.
+    raw = "GET /ping HTTP/1.1\r\nHost: coop.local\r\nAccept: */*\r\nUser-Agent: bench\r\n\r\n";
+    const size_t before = g_heapAllocations.load();
+    for (int i = 0; i < 1000; ++i) {
+        parser.reset();
+        ASSERT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+        ASSERT_EQ(server.handle(parser.view()).statusCode, 204);
+    }
+    EXPECT_EQ(g_heapAllocations.load(), before);
+    EXPECT_EQ(server.getRequestCount(), 1001u);
+    EXPECT_EQ(server.getRequestHistory().size(), static_cast<size_t>(MOCK_WEB_SERVER_HISTORY_SIZE));
+}
+
+TEST_F(WebServerTest, RequestHistoryIsABoundedRingWithRouteHistograms) {
+    server.onGet("/api/status", [](const MockWebServer::HttpRequest&) { return text("ok"); });
+    server.onPost("/api/settings", [](const MockWebServer::HttpRequest& r) {
+        return r.body.empty() ? MockWebServer::createErrorResponse(400) : text("saved");
+    });
+    server.onGet("/api/slow", [](const MockWebServer::HttpRequest&) {
+        const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(3);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        return text("slow");
+    });
+    server.setRequestHistoryLimit(4);
+
+    // A soak of many requests keeps only the last four summaries.
+    for (int i = 0; i < 10000; ++i) {
+        server.simulateGet("/api/status");
+    }
+    server.simulatePost("/api/settings", "{\"pumpEnabled\":true}");
+    server.simulatePost("/api/settings", "");
+    server.simulateGet("/missing");
+    server.simulateGet("/api/slow");
+
+    const std::vector<MockWebServer::RequestSummary> history = server.getRequestHistory();
+    ASSERT_EQ(history.size(), 4u);
+    EXPECT_EQ(server.getRouteName(history[0].routeId), "POST /api/settings");
+    EXPECT_EQ(history[0].method, HttpRouter::METHOD_POST);
+    EXPECT_EQ(history[0].status, 200);
+    EXPECT_EQ(history[0].requestBytes, 20u);
+    EXPECT_EQ(history[0].responseBytes, 5u);
+    EXPECT_EQ(history[1].status, 400);
+    EXPECT_EQ(history[2].routeId, MockWebServer::kNoRoute);
+    EXPECT_EQ(history[2].status, 404);
+    EXPECT_EQ(server.getRouteName(history[2].routeId), "");
+    EXPECT_EQ(server.getRouteName(history[3].routeId), "GET /api/slow");
+    EXPECT_GE(history[3].latencyMicros, 3000u);
+    EXPECT_LE(history[0].timestampMs, history[3].timestampMs);
+
+    // Aggregates cover every request, in constant memory.
+    const std::vector<MockWebServer::RouteStats> all = server.getAllRouteStats();
+    ASSERT_EQ(all.size(), 3u);
+    EXPECT_EQ(all[0].requests, 10000u);
+    EXPECT_EQ(all[0].statusClasses[1], 10000u);
+    EXPECT_EQ(all[0].responseBytes, 20000u);
+    uint64_t bucketed = 0;
+    for (size_t i = 0; i < MockWebServer::kLatencyBuckets; ++i) {
+        bucketed += all[0].latencyBuckets[i];
+    }
+    EXPECT_EQ(bucketed, 10000u);
+    EXPECT_LE(all[0].latencyPercentileMicros(0.5), all[0].latencyPercentileMicros(0.99));
+    EXPECT_EQ(all[1].statusClasses[1], 1u);
+    EXPECT_EQ(all[1].statusClasses[3], 1u);
+    EXPECT_GE(all[2].latencyPercentileMicros(0.5), 4096u); // Bucket above 3 ms
+    EXPECT_EQ(server.getUnroutedStats().requests, 1u);
+    EXPECT_EQ(server.getUnroutedStats().statusClasses[3], 1u);
+
+    server.setRequestHistoryLimit(0);
+    server.simulateGet("/api/status");
+    EXPECT_TRUE(server.getRequestHistory().empty());
+    EXPECT_EQ(server.getRouteStats("GET", "/api/status").requests, 10001u);
+}
+
+TEST_F(WebServerTest, LegacyMiddlewareSeesMaterializedRequestForMatchedRoutes) {
+    std::string seenPath;
+    int calls = 0;
+    server.addMiddleware([&seenPath, &calls](const MockWebServer::HttpRequest& r) {
+        ++calls;
+        seenPath = r.path;
+        return r.headers.count("Authorization") > 0;
+    });
+    server.onGet("/api/sensors/{index:uint}", [](const MockWebServer::HttpRequest& r) {
+        return text("sensor " + r.getPathParam("index"));
+    });
+
+    HttpRequestParser parser;
+    std::string raw = "GET /api/sensors/7 HTTP/1.1\r\nAuthorization: token\r\n\r\n";
+    ASSERT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(server.handle(parser.view()).body, "sensor 7");
+    EXPECT_EQ(seenPath, "/api/sensors/7");
+
+    parser.reset();
+    raw = "GET /api/sensors/7 HTTP/1.1\r\n\r\n";
+    ASSERT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+    EXPECT_EQ(server.handle(parser.view()).statusCode, 403);
+    EXPECT_EQ(calls, 2);
+
+    // Middleware runs only once a route matched: 404s and 405s never reach the predicate.
+    EXPECT_EQ(server.simulateGet("/api/missing").statusCode, 404);
+    EXPECT_EQ(server.simulatePost("/api/sensors/7").statusCode, 405);
+    EXPECT_EQ(calls, 2);
+}
+
+TEST_F(WebServerTest, MiddlewareChainsAreResolvedPerRoute) {
+    server.onView("GET", "/api/status", [](const MockWebServer::RequestView& r) {
+        return text("status for " + r.attribute("user"));
+    });
+    server.use("auth", [](MockWebServer::MiddlewareContext& context, MockWebServer::HttpResponse& response) {
+        const MockWebServer::Slice token = context.request.header("Authorization");
+        if (token.empty()) {
+            response = MockWebServer::createErrorResponse(401, "Unauthorized");
+            response.headers["WWW-Authenticate"] = "Bearer";
+            return false;
+        }
+        context.attributes["user"] = token.str();
+        return true;
+    }, "/api/");
+    server.use("cors", [](MockWebServer::MiddlewareContext& context, MockWebServer::HttpResponse&) {
+        context.responseHeaders["Access-Control-Allow-Origin"] = "*";
+        return true;
+    }, "/api/");
+    // Registered after use(): still gets the /api/ chain.
+    server.onPost("/api/settings", [](const MockWebServer::HttpRequest& r) { return text("saved " + r.body); });
+    server.onGet("/ping", [](const MockWebServer::HttpRequest&) { return text("pong"); });
+    ASSERT_TRUE(server.useOnRoute("POST", "/api/settings", "validate",
+                                  [](MockWebServer::MiddlewareContext& context, MockWebServer::HttpResponse& response) {
+                                      if (context.request.body.empty()) {
+                                          response = MockWebServer::createErrorResponse(400, "Empty body");
+                                          return false;
+                                      }
+                                      return true;
+                                  }));
+    EXPECT_FALSE(server.useOnRoute("GET", "/api/missing", "x", nullptr));
+
+    MockWebServer::HttpRequest request;
+    request.method = "GET";
+    request.path = "/api/status";
+    request.headers["Authorization"] = "alice";
+    MockWebServer::HttpResponse response = server.simulateRequest(request);
+    EXPECT_EQ(response.body, "status for alice");
+    EXPECT_EQ(response.headers["Access-Control-Allow-Origin"], "*");
+
+    response = server.simulateGet("/api/status");
+    EXPECT_EQ(response.statusCode, 401);
+    EXPECT_EQ(response.headers["WWW-Authenticate"], "Bearer");
+    EXPECT_EQ(response.headers.count("Access-Control-Allow-Origin"), 0u); // Chain stopped before cors
+
+    request.method = "POST";
+    request.path = "/api/settings";
+    EXPECT_EQ(server.simulateRequest(request).statusCode, 400);
+    request.body = "x=1";
+    EXPECT_EQ(server.simulateRequest(request).body, "saved x=1");
+
+    // Paths outside the prefix, and requests that match no route, run no stages.
+    EXPECT_EQ(server.simulateGet("/ping").body, "pong");
+    EXPECT_EQ(server.simulateGet("/api/nothing").statusCode, 404);
+
+    const std::vector<MockWebServer::StageStats> stats = server.getMiddlewareStats();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[0].name, "auth");
+    EXPECT_EQ(stats[0].calls, 4u);
+    EXPECT_EQ(stats[0].stopped, 1u);
+    EXPECT_EQ(stats[1].name, "cors");
+    EXPECT_EQ(stats[1].calls, 3u);
+    EXPECT_EQ(stats[1].stopped, 0u);
+    EXPECT_EQ(stats[2].name, "validate");
+    EXPECT_EQ(stats[2].calls, 2u);
+    EXPECT_EQ(stats[2].stopped, 1u);
+    EXPECT_GE(stats[0].totalNanos, stats[0].maxNanos);
+}
+
+TEST_F(WebServerTest, MiddlewarePrefixesMatchWholeSegments) {
+    auto deny = [](MockWebServer::MiddlewareContext&, MockWebServer::HttpResponse& response) {
+        response = MockWebServer::createErrorResponse(401, "Unauthorized");
+        return false;
+    };
+    server.onGet("/api", [](const MockWebServer::HttpRequest&) { return text("root"); });
+    server.onGet("/api/x", [](const MockWebServer::HttpRequest&) { return text("x"); });
+    server.use("auth", deny, "/api");
+    server.onGet("/apix", [](const MockWebServer::HttpRequest&) { return text("apix"); });
+    server.onGet("/api-legacy/y", [](const MockWebServer::HttpRequest&) { return text("legacy"); });
+    server.use("auth-slash", deny, "/api-legacy/");
+
+    EXPECT_EQ(server.simulateGet("/api").statusCode, 401);
+    EXPECT_EQ(server.simulateGet("/api/x").statusCode, 401);
+    EXPECT_EQ(server.simulateGet("/apix").body, "apix");
+    EXPECT_EQ(server.simulateGet("/api-legacy/y").statusCode, 401);
+    EXPECT_EQ(server.getMiddlewareStats()[0].calls, 2u);
+}
+
+TEST_F(WebServerTest, CachedRoutesRenderOnlyWhenProducerVersionsChange) {
+    MockSystemMetrics metrics;
+    MockSettingsManager settings;
+    metrics.setHeapSize(320000, 200000);
+    int renders = 0;
+    server.onGet("/api/status", [&](const MockWebServer::HttpRequest&) {
+        ++renders;
+        return MockWebServer::createJsonResponse(metrics.toJson());
+    });
+    ASSERT_TRUE(server.cacheRoute("/api/status", [&]() { return metrics.getVersion() + settings.getVersion(); }));
+    EXPECT_FALSE(server.cacheRoute("/api/missing", [&]() { return metrics.getVersion(); }));
+
+    const std::string first = server.simulateGet("/api/status").body;
+    for (int i = 0; i < 9; ++i) {
+        EXPECT_EQ(server.simulateGet("/api/status").body, first);
+    }
+    EXPECT_EQ(renders, 1);
+
+    metrics.setHeapSize(320000, 100000);
+    EXPECT_NE(server.simulateGet("/api/status").body, first);
+    EXPECT_EQ(renders, 2);
+    settings.setSettingBool("pump.enabled", false);
+    server.simulateGet("/api/status");
+    server.simulateGet("/api/status");
+    EXPECT_EQ(renders, 3);
+
+    MockWebServer::RouteStats stats = server.getRouteStats("GET", "/api/status");
+    EXPECT_EQ(stats.requests, 13u);
+    EXPECT_EQ(stats.cacheHits, 10u);
+    EXPECT_EQ(stats.cacheMisses, 3u);
+    EXPECT_NEAR(stats.hitRate(), 10.0 / 13.0, 1e-9);
+    EXPECT_GT(stats.totalNanos, 0u);
+    EXPECT_GE(stats.maxNanos, static_cast<uint64_t>(stats.averageNanos()));
+}
+
+TEST_F(WebServerTest, CachedRoutesAreKeyedByPathAndQuery) {
+    Logger logger(16);
+    logger.info("started", "boot");
+    int renders = 0;
+    server.onView("GET", "/api/logs/{level}", [&](const MockWebServer::RequestView& r) {
+        ++renders;
+        return text(r.pathParam("level").str() + " " + r.queryParam("limit").str() + " " +
+                    std::to_string(logger.size()));
+    });
+    server.onGet("/api/fail", [&](const MockWebServer::HttpRequest&) {
+        ++renders;
+        return MockWebServer::createErrorResponse(500);
+    });
+    ASSERT_TRUE(server.cacheRoute("/api/logs/{level}", [&]() { return logger.getVersion(); }, 2));
+    ASSERT_TRUE(server.cacheRoute("/api/fail", [&]() { return logger.getVersion(); }));
+
+    HttpRequestParser parser;
+    auto get = [&](const std::string& target) {
+        parser.reset();
+        const std::string raw = "GET " + target + " HTTP/1.1\r\n\r\n";
+        EXPECT_EQ(parser.feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+        return server.handle(parser.view()).body;
+    };
+
+    EXPECT_EQ(get("/api/logs/info?limit=5"), "info 5 1");
+    EXPECT_EQ(get("/api/logs/info?limit=10"), "info 10 1");
+    EXPECT_EQ(get("/api/logs/info?limit=5"), "info 5 1");
+    EXPECT_EQ(renders, 2);
+
+    // Two entries per route: a third key replaces the least recently used (limit=10).
+    EXPECT_EQ(get("/api/logs/warn"), "warn  1");
+    EXPECT_EQ(get("/api/logs/info?limit=5"), "info 5 1");
+    EXPECT_EQ(get("/api/logs/info?limit=10"), "info 10 1");
+    EXPECT_EQ(renders, 4);
+
+    logger.warn("fault", "pump");
+    EXPECT_EQ(get("/api/logs/info?limit=10"), "info 10 2");
+    logger.clear();
+    EXPECT_EQ(get("/api/logs/info?limit=10"), "info 10 0");
+    EXPECT_EQ(renders, 6);
+
+    // Errors are never cached.
+    server.simulateGet("/api/fail");
+    server.simulateGet("/api/fail");
+    EXPECT_EQ(renders, 8);
+    EXPECT_EQ(server.getRouteStats("GET", "/api/fail").cacheHits, 0u);
+    EXPECT_EQ(server.getRouteStats("GET", "/api/logs/{level}").cacheHits, 2u);
+}
+
+TEST_F(WebServerTest, StreamedResponsesAreDrainedForSimulatedRequestsAndNeverCached) {
+    Logger logger(8, Logger::Mode::SINGLE_THREADED, 16 * 1024);
+    for (int i = 0; i < 50; ++i) {
+        logger.infof("pump", "cycle %d complete", i);
+    }
+
+    size_t renders = 0;
+    server.onGet("/api/logs/export", [&](const MockWebServer::HttpRequest&) {
+        ++renders;
+        std::shared_ptr<Logger::JsonCursor> cursor(new Logger::JsonCursor());
+        return MockWebServer::createStreamResponse([&logger, cursor](std::string& chunk, size_t maxBytes) {
+            return logger.exportToJson(*cursor, chunk, maxBytes);
+        });
+    });
+    server.cacheRoute("/api/logs/export", [&logger]() { return logger.getVersion(); });
+
+    MockWebServer::HttpResponse response = server.simulateGet("/api/logs/export");
+    EXPECT_EQ(response.statusCode, 200);
+    EXPECT_FALSE(response.stream);
+    EXPECT_EQ(response.body, logger.exportToJson());
+    EXPECT_EQ(response.headers["Content-Type"], "application/json");
+
+    EXPECT_EQ(server.simulateGet("/api/logs/export").body, response.body);
+    EXPECT_EQ(renders, 2u);
+}
+
+TEST_F(WebServerTest, StreamedResponsesAreCountedWhenTheBodyEnds) {
+    server.onGet("/api/export", [](const MockWebServer::HttpRequest&) {
+        std::shared_ptr<int> pieces(new int(0));
+        return MockWebServer::createStreamResponse([pieces](std::string& chunk, size_t) {
+            chunk.append(1000, 'x');
+            return ++*pieces < 5;
+        });
+    });
+
+    EXPECT_EQ(server.simulateGet("/api/export").body.size(), 5000u);
+    EXPECT_EQ(server.simulateGet("/api/export").body.size(), 5000u);
+
+    const MockWebServer::RouteStats stats = server.getRouteStats("GET", "/api/export");
+    EXPECT_EQ(stats.requests, 2u);
+    EXPECT_EQ(stats.responseBytes, 10000u);
+    EXPECT_EQ(stats.statusClasses[1], 2u);
+    const std::vector<MockWebServer::RequestSummary> history = server.getRequestHistory();
+    ASSERT_FALSE(history.empty());
+    EXPECT_EQ(history.back().responseBytes, 5000u);
+    EXPECT_EQ(history.back().status, 200);
+    EXPECT_EQ(server.getRouteName(history.back().routeId), "GET /api/export");
+}
+
+TEST_F(WebServerTest, ThrowingStreamEndsTheBodyAndReleasesItsSlot) {
+    RequestLimiter::Config config;
+    config.requestsPerSecond = 0;
+    config.maxInFlight = 1;
+    RequestLimiter limiter(config);
+    server.limitRequests(&limiter);
+    bool partial = false;
+    server.onGet("/api/export", [&partial](const MockWebServer::HttpRequest&) {
+        std::shared_ptr<bool> started(new bool(false));
+        return MockWebServer::createStreamResponse([&partial, started](std::string& chunk, size_t) -> bool {
+            if (partial && !*started) {
+                *started = true;
+                chunk += "[1,2";
+                return true;
+            }
+            throw std::runtime_error("export failed");
+        });
+    });
+
+    // Nothing produced: a 500, as for a throwing handler.
+    MockWebServer::HttpResponse response = server.simulateGet("/api/export");
+    EXPECT_EQ(response.statusCode, 500);
+    EXPECT_NE(response.body.find("export failed"), std::string::npos);
+    EXPECT_EQ(limiter.getInFlight(), 0u);
+
+    // Part of the body produced: the client keeps what it got.
+    partial = true;
+    response = server.simulateGet("/api/export");
+    EXPECT_EQ(response.statusCode, 200);
+    EXPECT_EQ(response.body, "[1,2");
+    EXPECT_EQ(limiter.getInFlight(), 0u);
+
+    EXPECT_EQ(limiter.getStats().admitted, 2u);
+    const MockWebServer::RouteStats stats = server.getRouteStats("GET", "/api/export");
+    EXPECT_EQ(stats.statusClasses[4], 1u);
+    EXPECT_EQ(stats.responseBytes, response.body.size() + std::string("Internal Server Error: export failed").size());
+}
+
+TEST_F(WebServerTest, RequestLimiterThrottlesEachClientSeparately) {
+    uint64_t now = 1000;
+    RequestLimiter::Config config;
+    config.requestsPerSecond = 2;
+    config.burst = 3;
+    config.maxInFlight = 0;
+    RequestLimiter limiter(config);
+    limiter.setTimeProvider([&now]() { return now; });
+    server.limitRequests(&limiter);
+    server.onGet("/api/status", [](const MockWebServer::HttpRequest&) { return text("ok"); });
+
+    auto get = [this](const std::string& ip) {
+        MockWebServer::HttpRequest request;
+        request.method = "GET";
+        request.path = "/api/status";
+        request.clientIP = ip;
+        return server.simulateRequest(request);
+    };
+
+    // A polling tab spends its burst, then is refused; another client is unaffected.
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(get("192.168.1.20").statusCode, 200) << i;
+    }
+    MockWebServer::HttpResponse refused = get("192.168.1.20");
+    EXPECT_EQ(refused.statusCode, 429);
+    EXPECT_EQ(refused.headers["Retry-After"], "1");
+    EXPECT_EQ(get("192.168.1.21").statusCode, 200);
+
+    // Two tokens per second: one more request after 500 ms.
+    now += 500;
+    EXPECT_EQ(get("192.168.1.20").statusCode, 200);
+    EXPECT_EQ(get("192.168.1.20").statusCode, 429);
+
+    // Unrouted requests are not admitted through the limiter at all.
+    EXPECT_EQ(server.simulateGet("/missing").statusCode, 404);
+
+    RequestLimiter::Stats stats = limiter.getStats();
+    EXPECT_EQ(stats.admitted, 5u);
+    EXPECT_EQ(stats.rateLimited, 2u);
+    EXPECT_EQ(stats.inFlight, 0u); // simulateRequest() delivers immediately
+    EXPECT_EQ(stats.clients, 2u);
+
+    // The table forgets the least recently seen client when full.
+    for (int i = 0; i < REQUEST_LIMITER_MAX_CLIENTS; ++i) {
+        now += 1;
+        get("10.0.0." + std::to_string(i));
+    }
+    EXPECT_EQ(limiter.getStats().clientsEvicted, 2u);
+}
+
+TEST_F(WebServerTest, RequestLimiterBudgetsUndeliveredResponses) {
+    RequestLimiter::Config config;
+    config.requestsPerSecond = 0;
+    config.maxInFlight = 2;
+    RequestLimiter limiter(config);
+    server.limitRequests(&limiter);
+    int handled = 0;
+    server.onView("GET", "/api/status", [&handled](const MockWebServer::RequestView&) {
+        ++handled;
+        return text("ok");
+    });
+
+    // Three clients whose responses the transport has not delivered yet.
+    HttpRequestParser parsers[3];
+    const std::string raw = "GET /api/status HTTP/1.1\r\n\r\n";
+    int statuses[3];
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(parsers[i].feed(raw.data(), raw.size()), HttpRequestParser::Result::COMPLETE);
+        parsers[i].view().clientIP = MockWebServer::Slice(i == 0 ? "10.0.0.1" : i == 1 ? "10.0.0.2" : "10.0.0.3");
+        statuses[i] = server.handle(parsers[i].view()).statusCode;
+    }
+    EXPECT_EQ(statuses[0], 200);
+    EXPECT_EQ(statuses[1], 200);
+    EXPECT_EQ(statuses[2], 429);
+    EXPECT_EQ(handled, 2);
+    EXPECT_TRUE(parsers[0].view().holdsSlot());
+    EXPECT_FALSE(parsers[2].view().holdsSlot());
+    EXPECT_EQ(limiter.getInFlight(), 2u);
+
+    server.releaseSlots(1);
+    EXPECT_EQ(server.handle(parsers[2].view()).statusCode, 200);
+    server.releaseSlots(2);
+
+    RequestLimiter::Stats stats = limiter.getStats();
+    EXPECT_EQ(stats.admitted, 3u);
+    EXPECT_EQ(stats.overBudget, 1u);
+    EXPECT_EQ(stats.inFlight, 0u);
+    EXPECT_EQ(stats.peakInFlight, 2u);
+    EXPECT_DOUBLE_EQ(stats.averageDepth(), 2.0 / 3.0); // Depths 0, 1, 1
+}
+
+class StaticAssetCacheTest : public WebServerTest {
+protected:
+    std::string dir;
+    std::unique_ptr<FileStorageBackend> storage;
+
+    void SetUp() override {
+        WebServerTest::SetUp();
+        dir = TestFileUtils::createTempDirectory("coop_assets");
+        ASSERT_FALSE(dir.empty());
+        storage.reset(new FileStorageBackend(dir));
+        // The UI build emits each file with its precompressed variants; contents only
+        // need to differ here.
+        storage->writeFile("app.js", "console.log('coop dashboard');");
+        storage->writeFile("app.js.gz", "GZ:app.js");
+        storage->writeFile("app.js.br", "BR:app.js");
+        storage->writeFile("index.html", "<!doctype html><div id=app></div>");
+        storage->writeFile("index.html.gz", "GZ:index");
+    }
+
+    void TearDown() override {
+        TestFileUtils::removeDirectory(dir);
+        WebServerTest::TearDown();
+    }
+
+    static MockWebServer::HttpRequest get(const std::string& path, const std::map<std::string, std::string>& headers = {}) {
+        MockWebServer::HttpRequest request;
+        request.method = "GET";
+        request.path = path;
+        request.url = path;
+        request.headers = headers;
+        return request;
+    }
+};
+
+TEST_F(StaticAssetCacheTest, NegotiatesPrecompressedVariants) {
+    StaticAssetCache assets(*storage);
+    EXPECT_EQ(assets.addAll("/"), 2u);
+    server.serveAssets(&assets);
+
+    MockWebServer::HttpResponse response = server.simulateRequest(get("/app.js", {{"Accept-Encoding", "gzip, deflate, br"}}));
+    EXPECT_EQ(response.statusCode, 200);
+    EXPECT_EQ(response.body, "BR:app.js");
+    EXPECT_EQ(response.headers["Content-Encoding"], "br");
+    EXPECT_EQ(response.headers["Vary"], "Accept-Encoding");
+    EXPECT_EQ(response.headers["Content-Type"], "application/javascript");
+    EXPECT_EQ(response.headers["ETag"], assets.getETag("/app.js", StaticAssetCache::ENCODING_BROTLI));
+
+    response = server.simulateRequest(get("/app.js", {{"Accept-Encoding", "br;q=0, gzip;q=0.5"}}));
+    EXPECT_EQ(response.body, "GZ:app.js");
+    response = server.simulateRequest(get("/app.js", {{"Accept-Encoding", "identity"}}));
+    EXPECT_EQ(response.body, "console.log('coop dashboard');");
+    EXPECT_EQ(response.headers.count("Content-Encoding"), 0u);
+    response = server.simulateGet("/"); // No Accept-Encoding: identity
+    EXPECT_EQ(response.body, "<!doctype html><div id=app></div>");
+    EXPECT_EQ(response.headers["Content-Type"], "text/html; charset=utf-8");
+
+    // Only a gzip variant remains acceptable, but there is no brotli index.html.
+    response = server.simulateRequest(get("/index.html", {{"Accept-Encoding", "br, *;q=0"}}));
+    EXPECT_EQ(response.statusCode, 406);
+
+    EXPECT_EQ(server.simulateGet("/missing.js").statusCode, 404);
+    EXPECT_EQ(server.simulatePost("/app.js").statusCode, 405);
+
+    // Distinct strong ETags per representation.
+    EXPECT_NE(assets.getETag("/app.js", StaticAssetCache::ENCODING_GZIP),
+              assets.getETag("/app.js", StaticAssetCache::ENCODING_IDENTITY));
+}
+
+TEST_F(StaticAssetCacheTest, RevalidationAnswers304WithoutReadingStorage) {
+    StaticAssetCache assets(*storage);
+    ASSERT_TRUE(assets.add("/app.js", "app.js", "", "public, max-age=60"));
+    server.serveAssets(&assets);
+
+    const std::string etag = assets.getETag("/app.js", StaticAssetCache::ENCODING_GZIP);
+    ASSERT_EQ(etag.size(), 10u);
+    MockWebServer::HttpResponse response =
+        server.simulateRequest(get("/app.js", {{"Accept-Encoding", "gzip"}, {"If-None-Match", "\"0\", W/" + etag}}));
+    EXPECT_EQ(response.statusCode, 304);
+    EXPECT_TRUE(response.body.empty());
+    EXPECT_EQ(response.headers["ETag"], etag);
+    EXPECT_EQ(response.headers["Cache-Control"], "public, max-age=60");
+
+    // The gzip ETag does not validate the brotli representation.
+    response = server.simulateRequest(get("/app.js", {{"Accept-Encoding", "br"}, {"If-None-Match", etag}}));
+    EXPECT_EQ(response.statusCode, 200);
+
+    StaticAssetCache::Stats stats = assets.getStats();
+    EXPECT_EQ(stats.notModified, 1u);
+    EXPECT_EQ(stats.flashReads, 1u);
+    EXPECT_EQ(stats.requests, 2u);
+}
+
+TEST_F(StaticAssetCacheTest, ServesSingleByteRanges) {
+    StaticAssetCache assets(*storage);
+    ASSERT_TRUE(assets.add("/app.js", "app.js"));
+    server.serveAssets(&assets);
+    const std::string etag = assets.getETag("/app.js", StaticAssetCache::ENCODING_IDENTITY);
+
+    MockWebServer::HttpResponse response = server.simulateRequest(get("/app.js", {{"Range", "bytes=0-6"}}));
+    EXPECT_EQ(response.statusCode, 206);
+    EXPECT_EQ(response.body, "console");
+    EXPECT_EQ(response.headers["Content-Range"], "bytes 0-6/30");
+
+    response = server.simulateRequest(get("/app.js", {{"Range", "bytes=-3"}}));
+    EXPECT_EQ(response.body, "');");
+    response = server.simulateRequest(get("/app.js", {{"Range", "bytes=26-"}, {"If-Range", etag}}));
+    EXPECT_EQ(response.body, "d');");
+    response = server.simulateRequest(get("/app.js", {{"Range", "bytes=8-100"}}));
+    EXPECT_EQ(response.headers["Content-Range"], "bytes 8-29/30");
+
+    response = server.simulateRequest(get("/app.js", {{"Range", "bytes=30-"}}));
+    EXPECT_EQ(response.statusCode, 416);
+    EXPECT_EQ(response.headers["Content-Range"], "bytes */30");
+
+    // A stale If-Range, multiple ranges and malformed ranges all get the whole body.
+    EXPECT_EQ(server.simulateRequest(get("/app.js", {{"Range", "bytes=0-3"}, {"If-Range", "\"stale\""}})).statusCode, 200);
+    EXPECT_EQ(server.simulateRequest(get("/app.js", {{"Range", "bytes=0-1,4-5"}})).statusCode, 200);
+    EXPECT_EQ(server.simulateRequest(get("/app.js", {{"Range", "bytes=5-2"}})).statusCode, 200);
+    EXPECT_EQ(assets.getStats().partial, 4u);
+}
+
+TEST_F(StaticAssetCacheTest, KeepsRecentlyServedVariantsWithinBudget) {
+    StaticAssetCache assets(*storage, 40);
+    ASSERT_TRUE(assets.add("/app.js", "app.js"));
+    ASSERT_TRUE(assets.add("/index.html", "index.html"));
+    server.serveAssets(&assets);
+
+    server.simulateGet("/app.js");    // 30 bytes: read and cached
+    server.simulateGet("/app.js");    // From RAM
+    server.simulateGet("/index.html"); // 33 bytes: evicts app.js
+    server.simulateGet("/app.js");    // Read again, evicting index.html
+
+    StaticAssetCache::Stats stats = assets.getStats();
+    EXPECT_EQ(stats.flashReads, 3u);
+    EXPECT_EQ(stats.memoryHits, 1u);
+    EXPECT_EQ(stats.cachedBytes, 30u);
+
+    // Over budget entirely: served straight from storage each time.
+    StaticAssetCache tiny(*storage, 16);
+    ASSERT_TRUE(tiny.add("/app.js", "app.js"));
+    server.serveAssets(&tiny);
+    EXPECT_EQ(server.simulateGet("/app.js").body.size(), 30u);
+    EXPECT_EQ(server.simulateGet("/app.js").body.size(), 30u);
+    EXPECT_EQ(tiny.getStats().flashReads, 2u);
+    EXPECT_EQ(tiny.getStats().cachedBytes, 0u);
+}
+
+namespace {
+// receiveBuffer > 0 shrinks the socket's receive buffer, to make a non-reading client push back.
+int connectLoopback(uint16_t port, int receiveBuffer = 0) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && receiveBuffer > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    }
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    timeval timeout;
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+// Read until `count` complete responses (by Content-Length) have arrived or the peer closes.
+std::string readResponses(int fd, size_t count) {
+    std::string data;
+    size_t complete = 0;
+    size_t pos = 0;
+    char buffer[4096];
+    while (complete < count) {
+        const size_t headEnd = data.find("\r\n\r\n", pos);
+        if (headEnd != std::string::npos) {
+            const size_t lengthAt = data.find("Content-Length: ", pos);
+            const size_t length = std::stoul(data.substr(lengthAt + 16));
+            if (data.size() >= headEnd + 4 + length) {
+                pos = headEnd + 4 + length;
+                ++complete;
+                continue;
+            }
+        }
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            break;
+        }
+        data.append(buffer, static_cast<size_t>(n));
+    }
+    return data;
+}
+
+// Decodes the chunked body starting at `pos`; returns the offset past it, or npos if incomplete.
+size_t decodeChunked(const std::string& data, size_t pos, std::string& body, size_t& chunks) {
+    for (;;) {
+        const size_t lineEnd = data.find("\r\n", pos);
+        if (lineEnd == std::string::npos) {
+            return std::string::npos;
+        }
+        const size_t size = std::stoul(data.substr(pos, lineEnd - pos), nullptr, 16);
+        if (size == 0) {
+            return data.compare(lineEnd, 4, "\r\n\r\n") == 0 ? lineEnd + 4 : std::string::npos;
+        }
+        if (data.size() < lineEnd + 2 + size + 2) {
+            return std::string::npos;
+        }
+        body.append(data, lineEnd + 2, size);
+        ++chunks;
+        pos = lineEnd + 2 + size + 2;
+    }
+}
+} // namespace
+
+TEST_F(WebServerTest, EpollBackendServesPipelinedKeepAliveRequests) {
+    server.onGet("/api/status", [](const MockWebServer::HttpRequest&) {
+        return MockWebServer::createJsonResponse("{\"ok\":true}");
+    });
+    server.onGet("/api/sensors/{index:uint}", [](const MockWebServer::HttpRequest& r) {
+        return text("sensor " + r.getPathParam("index") + " from " + r.clientIP);
+    });
+    server.onPost("/api/echo", [](const MockWebServer::HttpRequest& r) { return text(r.body); });
+
+    EpollHttpServer backend(server);
+    ASSERT_TRUE(backend.start(EpollHttpServer::Config()));
+    ASSERT_NE(backend.getPort(), 0);
+
+    int fd = connectLoopback(backend.getPort());
+    ASSERT_GE(fd, 0);
+
+    // Three pipelined requests in one write, the last split across two writes.
+    sendAll(fd, "GET /api/status HTTP/1.1\r\nHost: x\r\n\r\n"
+                "GET /api/sensors/2 HTTP/1.1\r\nHost: x\r\n\r\n"
+                "POST /api/echo HTTP/1.1\r\nContent-Length: 5\r\n\r\nhe");
+    sendAll(fd, "llo");
+    std::string responses = readResponses(fd, 3);
+
+    const size_t first = responses.find("HTTP/1.1 200 OK");
+    const size_t second = responses.find("sensor 2 from 127.0.0.1");
+    const size_t third = responses.rfind("hello");
+    EXPECT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    ASSERT_NE(third, std::string::npos);
+    EXPECT_LT(first, second);
+    EXPECT_LT(second, third);
+    EXPECT_NE(responses.find("Connection: keep-alive"), std::string::npos);
+
+    // Same connection, 404 and then an explicit close.
+    sendAll(fd, "GET /missing HTTP/1.1\r\nConnection: close\r\n\r\n");
+    responses = readResponses(fd, 1);
+    EXPECT_EQ(responses.compare(0, 22, "HTTP/1.1 404 Not Found"), 0);
+    EXPECT_NE(responses.find("Connection: close"), std::string::npos);
+
+    char byte;
+    EXPECT_EQ(::recv(fd, &byte, 1, 0), 0); // Server closed
+    ::close(fd);
+
+    backend.stop();
+    EpollHttpServer::Stats stats = backend.getStats();
+    EXPECT_EQ(stats.requestsServed, 4u);
+    EXPECT_EQ(stats.connectionsAccepted, 1u);
+}
+
+TEST_F(WebServerTest, EpollBackendHoldsSlotsUntilResponsesAreWritten) {
+    RequestLimiter::Config config;
+    config.requestsPerSecond = 0;
+    config.maxInFlight = 2;
+    RequestLimiter limiter(config);
+    server.limitRequests(&limiter);
+    server.onGet("/api/status", [](const MockWebServer::HttpRequest&) { return text("ok"); });
+
+    EpollHttpServer backend(server);
+    ASSERT_TRUE(backend.start(EpollHttpServer::Config()));
+    int fd = connectLoopback(backend.getPort());
+    ASSERT_GE(fd, 0);
+
+    // Four pipelined requests are answered before any response is written, so only two fit.
+    std::string pipeline;
+    for (int i = 0; i < 4; ++i) {
+        pipeline += "GET /api/status HTTP/1.1\r\nHost: x\r\n\r\n";
+    }
+    sendAll(fd, pipeline);
+    std::string responses = readResponses(fd, 4);
+    EXPECT_EQ(responses.find("HTTP/1.1 200 OK"), 0u);
+    const size_t refused = responses.find("HTTP/1.1 429 Too Many Requests");
+    ASSERT_NE(refused, std::string::npos);
+    EXPECT_GT(refused, responses.rfind("HTTP/1.1 200 OK"));
+    EXPECT_NE(responses.find("Retry-After: 1"), std::string::npos);
+
+    // Once written, the slots are free again.
+    sendAll(fd, "GET /api/status HTTP/1.1\r\nHost: x\r\n\r\n");
+    EXPECT_EQ(readResponses(fd, 1).compare(0, 15, "HTTP/1.1 200 OK"), 0);
+    ::close(fd);
+    backend.stop();
+
+    RequestLimiter::Stats stats = limiter.getStats();
+    EXPECT_EQ(stats.admitted, 3u);
+    EXPECT_EQ(stats.overBudget, 2u);
+    EXPECT_EQ(stats.peakInFlight, 2u);
+    EXPECT_EQ(stats.inFlight, 0u);
+}
+
+TEST_F(WebServerTest, EpollBackendAnswersParseErrorsAndCloses) {
+    EpollHttpServer backend(server);
+    ASSERT_TRUE(backend.start(EpollHttpServer::Config()));
+
+    int fd = connectLoopback(backend.getPort());
+    ASSERT_GE(fd, 0);
+    sendAll(fd, "BROKEN\r\n\r\n");
+    std::string response = readResponses(fd, 1);
+    ::close(fd);
+    backend.stop();
+
+    EXPECT_EQ(response.compare(0, 24, "HTTP/1.1 400 Bad Request"), 0);
+    EXPECT_EQ(backend.getStats().parseErrors, 1u);
+}
+
+TEST_F(WebServerTest, EpollBackendStreamsChunkedBodiesAtTheReadersPace) {
+    const size_t kPieces = 4096;
+    std::atomic<size_t> pulls{0};
+    server.onGet("/api/export", [&](const MockWebServer::HttpRequest&) {
+        pulls.store(0);
+        std::shared_ptr<size_t> produced(new size_t(0));
+        return MockWebServer::createStreamResponse(
+            [&pulls, produced, kPieces](std::string& chunk, size_t maxBytes) {
+                pulls.fetch_add(1);
+                chunk.append(maxBytes, static_cast<char>('a' + *produced % 26));
+                return ++*produced < kPieces;
+            },
+            "text/csv");
+    });
+    server.onGet("/api/status", [](const MockWebServer::HttpRequest&) { return text("after"); });
+
+    EpollHttpServer::Config config;
+    config.streamChunkBytes = 1024;
+    EpollHttpServer backend(server);
+    ASSERT_TRUE(backend.start(config));
+
+    int fd = connectLoopback(backend.getPort(), 4096);
+    ASSERT_GE(fd, 0);
+
+    // A second request pipelined behind the stream must wait for it.
+    sendAll(fd, "GET /api/export HTTP/1.1\r\nHost: x\r\n\r\nGET /api/status HTTP/1.1\r\nHost: x\r\n\r\n");
+
+    // Nobody is reading: the generator stops once the socket buffers are full.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_LT(pulls.load(), kPieces / 2);
+
+    std::string data;
+    std::string body;
+    size_t chunks = 0;
+    size_t end = std::string::npos;
+    char buffer[16 * 1024];
+    while (end == std::string::npos || data.find("after", end) == std::string::npos) {
+        const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        ASSERT_GT(n, 0);
+        data.append(buffer, static_cast<size_t>(n));
+        const size_t headEnd = data.find("\r\n\r\n");
+        if (end == std::string::npos && headEnd != std::string::npos) {
+            body.clear();
+            chunks = 0;
+            end = decodeChunked(data, headEnd + 4, body, chunks);
+        }
+    }
+    ::close(fd);
+
+    const std::string head = data.substr(0, data.find("\r\n\r\n"));
+    EXPECT_NE(head.find("Transfer-Encoding: chunked"), std::string::npos);
+    EXPECT_EQ(head.find("Content-Length"), std::string::npos);
+    EXPECT_NE(head.find("Content-Type: text/csv"), std::string::npos);
+    EXPECT_EQ(body.size(), kPieces * 1024);
+    EXPECT_EQ(chunks, kPieces);
+    EXPECT_EQ(body.substr(1024 * 27, 3), "bbb");
+    EXPECT_EQ(data.compare(end, 15, "HTTP/1.1 200 OK"), 0);
+
+    // HTTP/1.0 cannot decode chunks: the body runs to the end of the connection.
+    fd = connectLoopback(backend.getPort());
+    ASSERT_GE(fd, 0);
+    sendAll(fd, "GET /api/export HTTP/1.0\r\n\r\n");
+    data.clear();
+    for (ssize_t n; (n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0;) {
+        data.append(buffer, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    backend.stop();
+
+    const size_t headEnd = data.find("\r\n\r\n");
+    ASSERT_NE(headEnd, std::string::npos);
+    EXPECT_EQ(data.find("Transfer-Encoding"), std::string::npos);
+    EXPECT_NE(data.find("Connection: close"), std::string::npos);
+    EXPECT_EQ(data.size() - headEnd - 4, kPieces * 1024);
+
+    EpollHttpServer::Stats stats = backend.getStats();
+    EXPECT_EQ(stats.streamsStarted, 2u);
+    EXPECT_EQ(stats.streamChunks, 2 * kPieces);
+    EXPECT_EQ(stats.requestsServed, 3u);
+
+    // Route stats see the generated bodies, not the empty head-time response.
+    const MockWebServer::RouteStats routeStats = server.getRouteStats("GET", "/api/export");
+    EXPECT_EQ(routeStats.requests, 2u);
+    EXPECT_EQ(routeStats.responseBytes, 2 * kPieces * 1024);
+}
@@ -7,6 +7,9 @@
 #include <mutex>
 #include <cstdlib>
 #include <stdexcept>
+#include <cstdio>
+#include <dirent.h>
+#include <unistd.h>
 
 // TestTimeUtils implementation
 TestTimeUtils::SimulatedTime& TestTimeUtils::getSimulatedTime() {
@@ -607,4 +610,34 @@ std::string TestStringUtils::generateTestPath(size_t depth) {
     }
     
     return "/" + path;
-}
\ No newline at end of file
+}
+
+std::string TestFileUtils::createTempDirectory(const std::string& prefix) {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string pattern = std::string(tmp ? tmp : "/tmp") + "/" + prefix + "_XXXXXX";
+    std::vector<char> buffer(pattern.begin(), pattern.end());
+    buffer.push_back('\0');
+
+    if (!mkdtemp(buffer.data())) {
+        return std::string();
+    }
+    return std::string(buffer.data());
+}
+
+void TestFileUtils::removeDirectory(const std::string& path) {
+    if (path.empty()) {
+        return;
+    }
+
+    DIR* dir = opendir(path.c_str());
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                std::remove((path + "/" + name).c_str());
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(path.c_str());
+}
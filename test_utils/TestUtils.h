@@ -166,6 +166,14 @@ private:
     static std::random_device& getRandomDevice();
 };
 
+class TestFileUtils {
+public:
+    // Scratch directory under the system temp dir; returns an empty string on failure.
+    static std::string createTempDirectory(const std::string& prefix = "coop_test");
+    // Removes the files in a flat directory and the directory itself.
+    static void removeDirectory(const std::string& path);
+};
+
 // Utility macro for test assertions
 #ifdef UNIT_TEST
     #define TEST_ASSERT_TRUE(condition) TestAssertUtils::assertTrue(condition, "Assertion failed: " #condition)